@@ -100,13 +100,13 @@ public:
 	virtual void initContent() {
 
 		// just here for testing
-		auto mv1 = new MeshVisual("debug_box", "debug_texture");
-		mv1->getData().Center = glm::vec3(0, 0, 0.5);
-		auto prepId = m_re->addToPrepareVisual(mv1);
+		auto mv1 = std14::make_unique<MeshVisual>("debug_box", "debug_texture");
+		auto prepId = m_re->addToPrepareVisual(mv1.get());
 
 		auto boxEntity = std14::make_unique<PositionedEntity>();
 		auto boxEntityPtr = boxEntity.get();
 		boxEntity->addVisualPlaceholder(prepId);
+		boxEntity->takeVisualOwnership(std::move(mv1));
 		m_entityEngine.addEntity(std::move(boxEntity));
 
 	}
@@ -4,10 +4,9 @@
 #include <SpheresEngine/Log.h>
 #include <SpheresEngine/VectorTypesGvr.h>
 
-std::vector<InputSource::UserInputPair> DaydreamControllerSource::readInput() {
-	auto tmpInput = m_inputs;
+void DaydreamControllerSource::readInput(std::vector<UserInputPair> & inputs) {
+	inputs.insert(inputs.end(), m_inputs.begin(), m_inputs.end());
 	m_inputs.clear();
-	return tmpInput;
 }
 
 
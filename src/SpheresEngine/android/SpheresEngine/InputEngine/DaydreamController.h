@@ -25,7 +25,7 @@ public:
 	/**
 	 * Will return SDL Keyboard and mouse input
 	 */
-	std::vector<UserInputPair> readInput() override;
+	void readInput(std::vector<UserInputPair> & inputs) override;
 
 	/**
 	 * Queries the GVR for new controller input. This needs to be called
@@ -68,8 +68,11 @@ TargetData VREyeTarget::beforeRenderToTarget(VisualDataExtractContainer & vd,  s
     // offset by the total camera position,
     // lookAt of Camera data is ignored on purpose as this is VR and
     // the user decides where to look
+    // and blend between the last two logic steps
     td.CameraMatrix = glm::translate( androidVrBackend->getLeftRightEyeView()[m_eyeNumber],
-                                       vd.CameraData.Position.toGlm() );
+                                       glm::mix(vd.CameraData.PreviousPosition.toGlm(),
+                                                vd.CameraData.Position.toGlm(),
+                                                vd.Interpolation) );
 
 
 /*
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <SpheresEngine/Log.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+class FrameArena;
+
+/**
+ * Deleter for objects created in a FrameArena. Only the destructor is called,
+ * the memory is given back when the arena is reset. The destructor is called
+ * via the pointer type, so polymorphic objects need a virtual destructor, as
+ * with std::unique_ptr.
+ */
+struct ArenaDeleter {
+	/**
+	 * The arena the object was created in, used to track the live objects
+	 */
+	FrameArena * Arena = nullptr;
+
+	/**
+	 * Destroy the object
+	 */
+	template<class T>
+	void operator()(T * p) const;
+};
+
+/**
+ * Owning pointer to an object in a FrameArena. Pointers to derived classes
+ * convert to pointers to base classes, like with uniq<T>.
+ */
+template<class T>
+using ArenaPtr = std::unique_ptr<T, ArenaDeleter>;
+
+/**
+ * Bump allocator for data which only lives during one logic tick, for example
+ * the input actions. Allocating moves a pointer forward in a memory block and
+ * reset() rewinds it at the end of the tick.
+ *
+ * If a tick needs more memory than the current block holds, further blocks
+ * are allocated and merged into one larger block with the next reset(). Once
+ * the arena has grown to the peak memory needed by a tick, allocating from it
+ * does no heap allocations anymore.
+ */
+class FrameArena: boost::noncopyable {
+public:
+
+	/**
+	 * Create an arena, the first block is allocated with the first
+	 * allocation
+	 */
+	explicit FrameArena(size_t initialBytes = 16 * 1024) :
+			m_nextBlockBytes(initialBytes) {
+	}
+
+	/**
+	 * Return memory for size bytes with the alignment. The memory stays valid
+	 * until the next reset().
+	 */
+	void * allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		if (!m_blocks.empty()) {
+			auto & block = m_blocks.back();
+			const auto begin = alignUp(m_used, block.Memory.get(), alignment);
+			if (begin + size <= block.Size) {
+				m_used = begin + size;
+				return block.Memory.get() + begin;
+			}
+		}
+
+		// the new block always fits the request including its alignment
+		addBlock(size + alignment);
+		auto & block = m_blocks.back();
+		const auto begin = alignUp(0, block.Memory.get(), alignment);
+		m_used = begin + size;
+		return block.Memory.get() + begin;
+	}
+
+	/**
+	 * Construct an object in the arena. The object is destroyed when the
+	 * returned pointer goes out of scope, which must happen before reset().
+	 */
+	template<class T, class ... Args>
+	ArenaPtr<T> create(Args && ... args) {
+		auto memory = allocate(sizeof(T), alignof(T));
+		auto object = new (memory) T(std::forward<Args>(args)...);
+		m_liveObjects++;
+		ArenaDeleter deleter;
+		deleter.Arena = this;
+		return ArenaPtr<T>(object, deleter);
+	}
+
+	/**
+	 * Give all memory back to the arena. All objects created with create()
+	 * must have been destroyed before.
+	 */
+	void reset() {
+		if (m_liveObjects != 0) {
+			logging::Fatal() << "FrameArena reset while " << m_liveObjects
+					<< " objects are still alive";
+		}
+
+		// merge the blocks, so the next tick fits into one block
+		if (m_blocks.size() > 1) {
+			const auto capacity = getCapacity();
+			m_blocks.clear();
+			m_nextBlockBytes = capacity;
+			addBlock(capacity);
+		}
+		m_used = 0;
+	}
+
+	/**
+	 * Number of bytes in all blocks
+	 */
+	size_t getCapacity() const {
+		size_t capacity = 0;
+		for (auto const& block : m_blocks) {
+			capacity += block.Size;
+		}
+		return capacity;
+	}
+
+	/**
+	 * Number of objects created with create() and not destroyed yet
+	 */
+	size_t getLiveObjects() const {
+		return m_liveObjects;
+	}
+
+	/**
+	 * Called by the ArenaDeleter when an object has been destroyed
+	 */
+	void objectDestroyed() {
+		m_liveObjects--;
+	}
+
+private:
+
+	/**
+	 * One memory block of the arena
+	 */
+	struct Block {
+		/**
+		 * The memory of the block
+		 */
+		std::unique_ptr<char[]> Memory;
+
+		/**
+		 * Size of the block in bytes
+		 */
+		size_t Size;
+	};
+
+	/**
+	 * Return the first offset at or after offset which is aligned
+	 */
+	static size_t alignUp(size_t offset, char const* base, size_t alignment) {
+		const auto address = reinterpret_cast<uintptr_t>(base) + offset;
+		const auto aligned = (address + alignment - 1) / alignment * alignment;
+		return offset + size_t(aligned - address);
+	}
+
+	/**
+	 * Add a block which holds at least minBytes
+	 */
+	void addBlock(size_t minBytes) {
+		const auto size = (minBytes > m_nextBlockBytes) ? minBytes : m_nextBlockBytes;
+		Block block;
+		block.Memory.reset(new char[size]);
+		block.Size = size;
+		m_blocks.push_back(std::move(block));
+		m_nextBlockBytes = 2 * size;
+	}
+
+	/**
+	 * All blocks, allocations are done from the last one
+	 */
+	std::vector<Block> m_blocks;
+
+	/**
+	 * Bytes used in the last block
+	 */
+	size_t m_used = 0;
+
+	/**
+	 * Minimal size of the next block
+	 */
+	size_t m_nextBlockBytes;
+
+	/**
+	 * Number of objects created and not destroyed yet
+	 */
+	size_t m_liveObjects = 0;
+};
+
+template<class T>
+void ArenaDeleter::operator()(T * p) const {
+	p->~T();
+	if (Arena) {
+		Arena->objectDestroyed();
+	}
+}
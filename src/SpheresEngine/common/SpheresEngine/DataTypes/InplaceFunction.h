@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Callable wrapper like std::function, but the callable is stored within the
+ * object if it fits into TCapacity bytes. Lambdas which capture a few
+ * pointers are stored without a heap allocation, so a list of InplaceFunction
+ * keeps all callables in one contiguous block of memory. Larger callables are
+ * moved to the heap.
+ *
+ * InplaceFunction can be moved but not copied, so callables which capture
+ * move-only objects can be stored as well.
+ */
+template<class TSignature, size_t TCapacity = 6 * sizeof(void *)>
+class InplaceFunction;
+
+/**
+ * Specialization which splits the signature into return and argument types
+ */
+template<class R, class ... Args, size_t TCapacity>
+class InplaceFunction<R(Args...), TCapacity> {
+public:
+
+	/**
+	 * Create an empty function which must not be called
+	 */
+	InplaceFunction() = default;
+
+	/**
+	 * Store a callable, within the object if it is small enough
+	 */
+	template<class TFunc, class = typename std::enable_if<
+			!std::is_same<typename std::decay<TFunc>::type, InplaceFunction>::value>::type>
+	InplaceFunction(TFunc && f) {
+		typedef typename std::decay<TFunc>::type Stored;
+		typedef typename std::conditional<fitsInline<Stored>(),
+				InlineOperations<Stored>, HeapOperations<Stored>>::type StoredOperations;
+		StoredOperations::create(&m_storage, std::forward<TFunc>(f));
+		m_operations = &StoredOperations::Table;
+	}
+
+	/**
+	 * Take over the callable of another function, which is empty afterwards
+	 */
+	InplaceFunction(InplaceFunction && other) noexcept {
+		moveFrom(other);
+	}
+
+	/**
+	 * Take over the callable of another function, which is empty afterwards
+	 */
+	InplaceFunction & operator=(InplaceFunction && other) noexcept {
+		if (this != &other) {
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	InplaceFunction(InplaceFunction const&) = delete;
+	InplaceFunction & operator=(InplaceFunction const&) = delete;
+
+	~InplaceFunction() {
+		reset();
+	}
+
+	/**
+	 * Call the stored callable
+	 */
+	R operator()(Args ... args) const {
+		return m_operations->Invoke(&m_storage, std::forward<Args>(args)...);
+	}
+
+	/**
+	 * Returns true if a callable is stored
+	 */
+	explicit operator bool() const {
+		return m_operations != nullptr;
+	}
+
+	/**
+	 * Returns true if the callable is stored within this object
+	 */
+	bool isInline() const {
+		return m_operations && m_operations->Inline;
+	}
+
+	/**
+	 * Destroy the stored callable
+	 */
+	void reset() {
+		if (m_operations) {
+			m_operations->Destroy(&m_storage);
+			m_operations = nullptr;
+		}
+	}
+
+private:
+
+	/**
+	 * Memory which holds the callable or the pointer to it
+	 */
+	typedef typename std::aligned_storage<TCapacity,
+			alignof(std::max_align_t)>::type Storage;
+
+	/**
+	 * Functions to handle one type of stored callable
+	 */
+	struct Operations {
+		/**
+		 * Call the stored callable
+		 */
+		R (*Invoke)(void *, Args&&...);
+
+		/**
+		 * Move the stored callable to new storage and destroy the old one
+		 */
+		void (*Move)(void * from, void * to);
+
+		/**
+		 * Destroy the stored callable
+		 */
+		void (*Destroy)(void *);
+
+		/**
+		 * True if the callable is stored in the storage itself
+		 */
+		bool Inline;
+	};
+
+	/**
+	 * Returns true if a callable of type TFunc is stored within the object
+	 */
+	template<class TFunc>
+	static constexpr bool fitsInline() {
+		return (sizeof(TFunc) <= TCapacity)
+				&& (alignof(Storage) % alignof(TFunc) == 0)
+				&& std::is_nothrow_move_constructible<TFunc>::value;
+	}
+
+	/**
+	 * Operations for callables stored within the storage
+	 */
+	template<class TFunc>
+	struct InlineOperations {
+		template<class TArg>
+		static void create(void * storage, TArg && f) {
+			new (storage) TFunc(std::forward<TArg>(f));
+		}
+
+		static R invoke(void * storage, Args&&... args) {
+			return (*static_cast<TFunc *>(storage))(std::forward<Args>(args)...);
+		}
+
+		static void move(void * from, void * to) {
+			auto f = static_cast<TFunc *>(from);
+			new (to) TFunc(std::move(*f));
+			f->~TFunc();
+		}
+
+		static void destroy(void * storage) {
+			static_cast<TFunc *>(storage)->~TFunc();
+		}
+
+		static const Operations Table;
+	};
+
+	/**
+	 * Operations for callables which are too large and stored on the heap,
+	 * the storage holds the pointer to them
+	 */
+	template<class TFunc>
+	struct HeapOperations {
+		template<class TArg>
+		static void create(void * storage, TArg && f) {
+			*static_cast<TFunc **>(storage) = new TFunc(std::forward<TArg>(f));
+		}
+
+		static R invoke(void * storage, Args&&... args) {
+			return (**static_cast<TFunc **>(storage))(std::forward<Args>(args)...);
+		}
+
+		static void move(void * from, void * to) {
+			*static_cast<TFunc **>(to) = *static_cast<TFunc **>(from);
+		}
+
+		static void destroy(void * storage) {
+			delete *static_cast<TFunc **>(storage);
+		}
+
+		static const Operations Table;
+	};
+
+	/**
+	 * Take over the callable of other
+	 */
+	void moveFrom(InplaceFunction & other) {
+		if (other.m_operations) {
+			other.m_operations->Move(&other.m_storage, &m_storage);
+			m_operations = other.m_operations;
+			other.m_operations = nullptr;
+		}
+	}
+
+	/**
+	 * Holds the callable, mutable so callables which change their state can
+	 * be called via a const function like with std::function
+	 */
+	mutable Storage m_storage;
+
+	/**
+	 * Operations for the type of the stored callable, nullptr if empty
+	 */
+	Operations const* m_operations = nullptr;
+};
+
+template<class R, class ... Args, size_t TCapacity>
+template<class TFunc>
+const typename InplaceFunction<R(Args...), TCapacity>::Operations InplaceFunction<
+		R(Args...), TCapacity>::InlineOperations<TFunc>::Table = {
+		&InlineOperations<TFunc>::invoke, &InlineOperations<TFunc>::move,
+		&InlineOperations<TFunc>::destroy, true };
+
+template<class R, class ... Args, size_t TCapacity>
+template<class TFunc>
+const typename InplaceFunction<R(Args...), TCapacity>::Operations InplaceFunction<
+		R(Args...), TCapacity>::HeapOperations<TFunc>::Table = {
+		&HeapOperations<TFunc>::invoke, &HeapOperations<TFunc>::move,
+		&HeapOperations<TFunc>::destroy, false };
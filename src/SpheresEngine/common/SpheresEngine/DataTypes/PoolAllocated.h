@@ -0,0 +1,194 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * Hands out memory blocks of one fixed size. Freed blocks are kept in a free
+ * list and handed out again, the memory is only returned to the system when
+ * the pool is destroyed. New blocks are allocated in chunks, so once the pool
+ * has grown to the peak number of blocks in use, no more heap allocations are
+ * done.
+ */
+class FixedSizePool: boost::noncopyable {
+public:
+
+	/**
+	 * Number of blocks allocated at once when the free list is empty
+	 */
+	static constexpr size_t BlocksPerChunk = 64;
+
+	/**
+	 * Create a pool for blocks of blockSize bytes
+	 */
+	explicit FixedSizePool(size_t blockSize) :
+			m_blockSize(roundUp(blockSize)) {
+	}
+
+	~FixedSizePool() {
+		for (auto chunk : m_chunks) {
+			::operator delete(chunk);
+		}
+	}
+
+	/**
+	 * Size of the blocks handed out by this pool
+	 */
+	size_t getBlockSize() const {
+		return m_blockSize;
+	}
+
+	/**
+	 * Return a block of memory with getBlockSize() bytes
+	 */
+	void * allocate() {
+		std::lock_guard<std::mutex> lock(m_access);
+		if (!m_free) {
+			grow();
+		}
+		auto block = m_free;
+		m_free = block->Next;
+		m_blocksInUse++;
+		return block;
+	}
+
+	/**
+	 * Give a block back to the pool
+	 */
+	void free(void * p) {
+		std::lock_guard<std::mutex> lock(m_access);
+		auto block = static_cast<FreeBlock *>(p);
+		block->Next = m_free;
+		m_free = block;
+		m_blocksInUse--;
+	}
+
+	/**
+	 * Number of blocks handed out and not freed yet
+	 */
+	size_t getBlocksInUse() const {
+		std::lock_guard<std::mutex> lock(m_access);
+		return m_blocksInUse;
+	}
+
+	/**
+	 * Number of blocks allocated by this pool
+	 */
+	size_t getCapacity() const {
+		std::lock_guard<std::mutex> lock(m_access);
+		return m_chunks.size() * BlocksPerChunk;
+	}
+
+private:
+
+	/**
+	 * Entry of the free list, stored within the free block itself
+	 */
+	struct FreeBlock {
+		/**
+		 * Next free block, nullptr at the end of the list
+		 */
+		FreeBlock * Next;
+	};
+
+	/**
+	 * Round the block size up so every block is aligned like the memory
+	 * returned by operator new
+	 */
+	static size_t roundUp(size_t size) {
+		constexpr size_t alignment = alignof(std::max_align_t);
+		const size_t minSize = (size < sizeof(FreeBlock)) ? sizeof(FreeBlock) : size;
+		return (minSize + alignment - 1) / alignment * alignment;
+	}
+
+	/**
+	 * Allocate a new chunk and add its blocks to the free list
+	 */
+	void grow() {
+		auto chunk = static_cast<char *>(::operator new(
+				m_blockSize * BlocksPerChunk));
+		m_chunks.push_back(chunk);
+		for (size_t i = BlocksPerChunk; i > 0; i--) {
+			auto block = reinterpret_cast<FreeBlock *>(chunk
+					+ (i - 1) * m_blockSize);
+			block->Next = m_free;
+			m_free = block;
+		}
+	}
+
+	/**
+	 * Size of each block in bytes
+	 */
+	const size_t m_blockSize;
+
+	/**
+	 * First entry of the free list
+	 */
+	FreeBlock * m_free = nullptr;
+
+	/**
+	 * All chunks allocated, freed when the pool is destroyed
+	 */
+	std::vector<char *> m_chunks;
+
+	/**
+	 * Number of blocks handed out
+	 */
+	size_t m_blocksInUse = 0;
+
+	/**
+	 * Protects the free list, entities can be created by multiple threads
+	 */
+	mutable std::mutex m_access;
+};
+
+/**
+ * Derive a class from PoolAllocated to allocate all its instances from a
+ * FixedSizePool, for example entities and aspects which are spawned and
+ * removed often:
+ *
+ * class Projectile: public PositionedEntity, public PoolAllocated<Projectile>
+ *
+ * The instances can still be owned by a std::unique_ptr to a base class, as
+ * long as the base class has a virtual destructor. Subclasses of TDerived
+ * which are larger than TDerived use the regular heap.
+ */
+template<class TDerived>
+class PoolAllocated {
+public:
+
+	/**
+	 * Allocate the memory for one instance from the pool
+	 */
+	static void * operator new(size_t size) {
+		if (size != sizeof(TDerived)) {
+			return ::operator new(size);
+		}
+		return getPool().allocate();
+	}
+
+	/**
+	 * Return the memory of one instance to the pool
+	 */
+	static void operator delete(void * p, size_t size) {
+		if (size != sizeof(TDerived)) {
+			::operator delete(p);
+			return;
+		}
+		getPool().free(p);
+	}
+
+	/**
+	 * The pool shared by all instances of TDerived
+	 */
+	static FixedSizePool & getPool() {
+		// never destroyed, so instances can still be deleted during the
+		// destruction of other static objects
+		static FixedSizePool * pool = new FixedSizePool(sizeof(TDerived));
+		return *pool;
+	}
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+/**
+ * Vector-like container which never destroys its entries when it is cleared.
+ *
+ * clear() only resets the number of used entries and the next call to next()
+ * or push_back() hands out the already constructed entry in this slot again.
+ * If an entry is assigned to, the memory already owned by the entry (for example
+ * by strings or vectors within the entry) can be reused. If the container is
+ * filled with the same amount of similar entries every time, no heap allocations
+ * happen once the first round has been completed.
+ */
+template<class TData>
+class RecycleVector {
+public:
+
+	/**
+	 * Iterator over the used entries of the container
+	 */
+	typedef typename std::vector<TData>::iterator iterator;
+
+	/**
+	 * Const iterator over the used entries of the container
+	 */
+	typedef typename std::vector<TData>::const_iterator const_iterator;
+
+	/**
+	 * Return a reference to the next free slot of this container. The slot
+	 * still holds the content of the last round which should be fully
+	 * overwritten by the caller.
+	 */
+	TData & next() {
+		if (m_size == m_entries.size()) {
+			m_entries.emplace_back();
+		}
+		m_size++;
+		return m_entries[m_size - 1];
+	}
+
+	/**
+	 * Copy one entry into the next free slot of this container
+	 */
+	void push_back(TData const& entry) {
+		next() = entry;
+	}
+
+	/**
+	 * Copy one entry into the next free slot of this container
+	 */
+	void emplace_back(TData const& entry) {
+		push_back(entry);
+	}
+
+	/**
+	 * Mark all entries as unused. The entries are not destroyed and will be
+	 * reused by next calls to next() or push_back()
+	 */
+	void clear() {
+		m_size = 0;
+	}
+
+	/**
+	 * Set the number of used entries. Entries which become used again still
+	 * hold the content of the last round and should be overwritten by the
+	 * caller.
+	 */
+	void resize(size_t size) {
+		reserve(size);
+		m_size = size;
+	}
+
+	/**
+	 * Create enough entries so size entries can be added without allocating
+	 * memory for the entry storage
+	 */
+	void reserve(size_t size) {
+		while (m_entries.size() < size) {
+			m_entries.emplace_back();
+		}
+	}
+
+	/**
+	 * Number of used entries
+	 */
+	size_t size() const {
+		return m_size;
+	}
+
+	/**
+	 * Number of constructed entries, used or not
+	 */
+	size_t capacity() const {
+		return m_entries.size();
+	}
+
+	/**
+	 * Returns true if no entry is used
+	 */
+	bool empty() const {
+		return m_size == 0;
+	}
+
+	/**
+	 * Return one of the used entries
+	 */
+	TData & operator[](size_t index) {
+		assert(index < m_size);
+		return m_entries[index];
+	}
+
+	/**
+	 * Return one of the used entries
+	 */
+	TData const& operator[](size_t index) const {
+		assert(index < m_size);
+		return m_entries[index];
+	}
+
+	/**
+	 * Return iterator to the first used entry
+	 */
+	iterator begin() {
+		return m_entries.begin();
+	}
+
+	/**
+	 * Return const iterator to the first used entry
+	 */
+	const_iterator begin() const {
+		return m_entries.begin();
+	}
+
+	/**
+	 * Return iterator behind the last used entry
+	 */
+	iterator end() {
+		return m_entries.begin() + m_size;
+	}
+
+	/**
+	 * Return const iterator behind the last used entry
+	 */
+	const_iterator end() const {
+		return m_entries.begin() + m_size;
+	}
+
+private:
+
+	/**
+	 * All entries which have been constructed so far
+	 */
+	std::vector<TData> m_entries;
+
+	/**
+	 * Number of entries in m_entries which are in use
+	 */
+	size_t m_size = 0;
+};
@@ -0,0 +1,432 @@
+#pragma once
+
+#include <SpheresEngine/VectorTypes.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Uniform grid of cubic cells which stores points identified by a small
+ * integer id, for example the slot of an entity in the ComponentStorage.
+ * Only the occupied cells are stored, in a hash map, so the grid covers an
+ * unbounded space.
+ *
+ * The queries only visit the cells overlapping the queried volume, so their
+ * cost depends on the number of points near the query and not on the total
+ * number of points. Queries overlapping more cells than are occupied check
+ * the occupied cells instead. The cell size should be in the range of the
+ * typical query radius.
+ *
+ * The queries append to a list given by the caller and do not allocate once
+ * that list has grown. Queries can run on multiple threads at the same time,
+ * as long as no point is inserted, moved or removed.
+ */
+class SpatialHashGrid {
+public:
+
+	/**
+	 * Identifies one point in the grid
+	 */
+	typedef uint32_t Id;
+
+	/**
+	 * Create a grid with cells of edge length cellSize
+	 */
+	explicit SpatialHashGrid(float cellSize) :
+			m_cellSize(cellSize), m_inverseCellSize(1.0f / cellSize) {
+	}
+
+	/**
+	 * Edge length of the cells
+	 */
+	float getCellSize() const {
+		return m_cellSize;
+	}
+
+	/**
+	 * Number of points stored
+	 */
+	size_t size() const {
+		return m_count;
+	}
+
+	/**
+	 * Returns true if a point with the id is stored
+	 */
+	bool contains(Id id) const {
+		return (id < m_entries.size()) && m_entries[id].Stored;
+	}
+
+	/**
+	 * Position of a stored point
+	 */
+	Vector3 const& getPosition(Id id) const {
+		return m_entries[id].Position;
+	}
+
+	/**
+	 * Store a point or move it, if it is already stored
+	 */
+	void insert(Id id, Vector3 const& position) {
+		if (id >= m_entries.size()) {
+			m_entries.resize(id + 1);
+		}
+		auto & entry = m_entries[id];
+		const auto cell = cellKey(position);
+		entry.Position = position;
+
+		if (entry.Stored) {
+			if (entry.Cell == cell) {
+				return;
+			}
+			removeFromCell(id);
+		} else {
+			entry.Stored = true;
+			m_count++;
+		}
+
+		auto & ids = m_cells[cell];
+		entry.Cell = cell;
+		entry.IndexInCell = uint32_t(ids.size());
+		ids.push_back(id);
+	}
+
+	/**
+	 * Remove a point, ids which are not stored are ignored
+	 */
+	void remove(Id id) {
+		if (!contains(id)) {
+			return;
+		}
+		removeFromCell(id);
+		m_entries[id].Stored = false;
+		m_count--;
+	}
+
+	/**
+	 * Append the ids of all points within the radius around the center
+	 */
+	void queryRadius(Vector3 const& center, float radius,
+			std::vector<Id> & result) const {
+		const float radiusSquared = radius * radius;
+		forEachCell(
+				Vector3(center.x() - radius, center.y() - radius,
+						center.z() - radius),
+				Vector3(center.x() + radius, center.y() + radius,
+						center.z() + radius),
+				[&](std::vector<Id> const& ids) {
+					for (auto id : ids) {
+						if (distanceSquared(m_entries[id].Position, center) <= radiusSquared) {
+							result.push_back(id);
+						}
+					}
+				});
+	}
+
+	/**
+	 * Append the ids of all points within the axis-aligned box
+	 */
+	void queryBox(Vector3 const& min, Vector3 const& max,
+			std::vector<Id> & result) const {
+		forEachCell(min, max, [&](std::vector<Id> const& ids) {
+			for (auto id : ids) {
+				auto const& p = m_entries[id].Position;
+				if ((p.x() >= min.x()) && (p.x() <= max.x())
+						&& (p.y() >= min.y()) && (p.y() <= max.y())
+						&& (p.z() >= min.z()) && (p.z() <= max.z())) {
+					result.push_back(id);
+				}
+			}
+		});
+	}
+
+	/**
+	 * Append the ids of the count points closest to the center, ordered by
+	 * their distance. Fewer ids are appended if the grid holds fewer points.
+	 *
+	 * The cells are visited in growing shells around the cell of the center,
+	 * until no cell outside the visited ones can hold a closer point. If the
+	 * next shell has more cells than are occupied, all occupied cells are
+	 * searched instead.
+	 */
+	void queryNearest(Vector3 const& center, size_t count,
+			std::vector<Id> & result) const {
+		if ((count == 0) || (m_count == 0)) {
+			return;
+		}
+
+		// the found points are kept as a max-heap by distance at the end of
+		// the result, so the farthest one can be replaced
+		const auto first = result.size();
+		auto farther = [this, &center] (Id a, Id b) {
+			return distanceSquared(m_entries[a].Position, center)
+			< distanceSquared(m_entries[b].Position, center);
+		};
+		size_t visited = 0;
+		auto consider = [&](std::vector<Id> const& ids) {
+			for (auto id : ids) {
+				visited++;
+				if (result.size() - first < count) {
+					result.push_back(id);
+					std::push_heap(result.begin() + first, result.end(), farther);
+				} else if (farther(id, result[first])) {
+					std::pop_heap(result.begin() + first, result.end(), farther);
+					result.back() = id;
+					std::push_heap(result.begin() + first, result.end(), farther);
+				}
+			}
+		};
+
+		const auto centerCell = cellCoordinates(center);
+		for (int32_t shell = 0;; shell++) {
+			const auto side = size_t(2 * shell + 1);
+			if ((shell > 0) && (side * side * side > m_cells.size())) {
+				// the points are far apart, checking all of them is cheaper
+				result.resize(first);
+				for (auto const& cell : m_cells) {
+					consider(cell.second);
+				}
+				break;
+			}
+
+			forEachCellInShell(centerCell, shell, consider);
+
+			if (visited == m_count) {
+				break;
+			}
+			// all points outside of the visited shells are at least this far
+			// away from the center
+			if (result.size() - first == count) {
+				const float outside = float(shell) * m_cellSize;
+				if (distanceSquared(m_entries[result[first]].Position, center)
+						<= outside * outside) {
+					break;
+				}
+			}
+		}
+
+		std::sort_heap(result.begin() + first, result.end(), farther);
+	}
+
+private:
+
+	/**
+	 * Integer coordinates of a cell
+	 */
+	struct CellCoordinates {
+		int32_t X;
+		int32_t Y;
+		int32_t Z;
+	};
+
+	/**
+	 * One stored point, indexed by its id
+	 */
+	struct Entry {
+		/**
+		 * Position of the point
+		 */
+		Vector3 Position;
+
+		/**
+		 * Key of the cell holding the point
+		 */
+		uint64_t Cell = 0;
+
+		/**
+		 * Index of the id in the list of the cell
+		 */
+		uint32_t IndexInCell = 0;
+
+		/**
+		 * False for ids which are not stored
+		 */
+		bool Stored = false;
+	};
+
+	/**
+	 * Squared distance between two positions
+	 */
+	static float distanceSquared(Vector3 const& a, Vector3 const& b) {
+		const float dx = a.x() - b.x();
+		const float dy = a.y() - b.y();
+		const float dz = a.z() - b.z();
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	/**
+	 * Cell coordinates of a position
+	 */
+	CellCoordinates cellCoordinates(Vector3 const& position) const {
+		return CellCoordinates { toCell(position.x()), toCell(position.y()),
+				toCell(position.z()) };
+	}
+
+	/**
+	 * Cell coordinate of one position component. Coordinates outside of the
+	 * range which fits into the key are put into the outermost cells, NaN
+	 * into cell 0. Converting them to an integer would be undefined.
+	 */
+	int32_t toCell(float v) const {
+		const float cell = std::floor(v * m_inverseCellSize);
+		if (std::isnan(cell)) {
+			return 0;
+		}
+		if (cell <= float(MinCell)) {
+			return MinCell;
+		}
+		if (cell >= float(MaxCell)) {
+			return MaxCell;
+		}
+		return int32_t(cell);
+	}
+
+	/**
+	 * Smallest cell coordinate which fits into the 21 bits of the key
+	 */
+	static constexpr int32_t MinCell = -(1 << 20);
+
+	/**
+	 * Largest cell coordinate which fits into the 21 bits of the key
+	 */
+	static constexpr int32_t MaxCell = (1 << 20) - 1;
+
+	/**
+	 * Pack the cell coordinates with 21 bits each into one key
+	 */
+	static uint64_t packKey(int32_t x, int32_t y, int32_t z) {
+		const uint64_t mask = (uint64_t(1) << 21) - 1;
+		return (uint64_t(uint32_t(x)) & mask)
+				| ((uint64_t(uint32_t(y)) & mask) << 21)
+				| ((uint64_t(uint32_t(z)) & mask) << 42);
+	}
+
+	/**
+	 * Key of the cell holding a position
+	 */
+	uint64_t cellKey(Vector3 const& position) const {
+		const auto c = cellCoordinates(position);
+		return packKey(c.X, c.Y, c.Z);
+	}
+
+	/**
+	 * Remove an id from the list of its cell, the last id of the cell takes
+	 * its place
+	 */
+	void removeFromCell(Id id) {
+		auto & entry = m_entries[id];
+		auto & ids = m_cells[entry.Cell];
+		const auto last = ids.back();
+		ids[entry.IndexInCell] = last;
+		m_entries[last].IndexInCell = entry.IndexInCell;
+		ids.pop_back();
+	}
+
+	/**
+	 * Call f with the id list of each occupied cell at the coordinates
+	 */
+	template<class TFunc>
+	void visitCell(int32_t x, int32_t y, int32_t z, TFunc & f) const {
+		auto it = m_cells.find(packKey(x, y, z));
+		if ((it != m_cells.end()) && !it->second.empty()) {
+			f(it->second);
+		}
+	}
+
+	/**
+	 * Cell coordinates packed into a key
+	 */
+	static CellCoordinates unpackKey(uint64_t key) {
+		// move the 21 bits to the top, so the sign is restored by the shift
+		auto unpack = [key] (int shift) {
+			return int32_t(int64_t(key << (43 - shift)) >> 43);
+		};
+		return CellCoordinates { unpack(0), unpack(21), unpack(42) };
+	}
+
+	/**
+	 * Call f with the id list of each occupied cell overlapping the box. If
+	 * the box overlaps more cells than are occupied, the occupied cells are
+	 * checked instead.
+	 */
+	template<class TFunc>
+	void forEachCell(Vector3 const& min, Vector3 const& max, TFunc f) const {
+		const auto low = cellCoordinates(min);
+		const auto high = cellCoordinates(max);
+		if ((low.X > high.X) || (low.Y > high.Y) || (low.Z > high.Z)) {
+			return;
+		}
+
+		const auto volume = uint64_t(high.X - low.X + 1)
+				* uint64_t(high.Y - low.Y + 1) * uint64_t(high.Z - low.Z + 1);
+		if (volume > m_cells.size()) {
+			for (auto const& cell : m_cells) {
+				const auto c = unpackKey(cell.first);
+				if (!cell.second.empty() && (c.X >= low.X) && (c.X <= high.X)
+						&& (c.Y >= low.Y) && (c.Y <= high.Y) && (c.Z >= low.Z)
+						&& (c.Z <= high.Z)) {
+					f(cell.second);
+				}
+			}
+			return;
+		}
+
+		for (auto z = low.Z; z <= high.Z; z++) {
+			for (auto y = low.Y; y <= high.Y; y++) {
+				for (auto x = low.X; x <= high.X; x++) {
+					visitCell(x, y, z, f);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Call f with the id list of each occupied cell whose largest coordinate
+	 * distance to the center cell is shell
+	 */
+	template<class TFunc>
+	void forEachCellInShell(CellCoordinates const& center, int32_t shell,
+			TFunc f) const {
+		for (auto dz = -shell; dz <= shell; dz++) {
+			for (auto dy = -shell; dy <= shell; dy++) {
+				const bool onFace = (std::abs(dz) == shell)
+						|| (std::abs(dy) == shell);
+				// inside the shell only the two cells on the x faces belong
+				// to it
+				const auto step = onFace ? 1 : std::max(2 * shell, 1);
+				for (auto dx = -shell; dx <= shell; dx += step) {
+					visitCell(center.X + dx, center.Y + dy, center.Z + dz, f);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Edge length of the cells
+	 */
+	const float m_cellSize;
+
+	/**
+	 * 1 / m_cellSize
+	 */
+	const float m_inverseCellSize;
+
+	/**
+	 * Ids of the points in each occupied cell. Cells which become empty are
+	 * kept to reuse their memory.
+	 */
+	std::unordered_map<uint64_t, std::vector<Id>> m_cells;
+
+	/**
+	 * Position and cell of each point, indexed by the id
+	 */
+	std::vector<Entry> m_entries;
+
+	/**
+	 * Number of points stored
+	 */
+	size_t m_count = 0;
+};
@@ -0,0 +1,290 @@
+#include <SpheresEngine/EntityEngine/AspectScheduler.h>
+
+#include <SpheresEngine/EntityEngine/Entity.h>
+#include <SpheresEngine/Threading/JobSystem.h>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+constexpr uint32_t EntityData::Transform;
+constexpr uint32_t EntityData::Visuals;
+constexpr uint32_t EntityData::Physics;
+constexpr uint32_t EntityData::Animation;
+constexpr uint32_t EntityData::FirstCustom;
+constexpr uint32_t SharedData::Input;
+constexpr uint32_t SharedData::Scene;
+constexpr uint32_t SharedData::FirstCustom;
+constexpr size_t AspectScheduler::TasksPerJob;
+
+namespace {
+
+/**
+ * The phases in which one piece of data has been accessed so far, stored as
+ * phase + 1 so zero means not accessed yet
+ */
+struct DataState {
+	size_t ReadEnd = 0;
+	size_t WriteEnd = 0;
+};
+
+/**
+ * Identifies one piece of data: the entity (nullptr for shared data or entity
+ * data of all entities), the data bit and whether it is shared data
+ */
+typedef std::tuple<Entity const*, uint32_t, bool> DataKey;
+
+/**
+ * Tracks the data accessed by the functions already assigned to phases
+ */
+class ConflictTracker {
+public:
+
+	/**
+	 * Earliest phase in which a function with the access can run
+	 */
+	size_t earliestPhase(Entity const* owner, DataAccess const& access) const {
+		size_t phase = m_barrierEnd;
+		forEachBit(access.EntityReads | access.EntityWrites,
+				[&](uint32_t bit) {
+					const bool writes = (access.EntityWrites & bit) != 0;
+					phase = std::max(phase, constraint(DataKey(owner, bit, false), writes));
+					// function accessing the data of all entities
+					phase = std::max(phase, constraint(DataKey(nullptr, bit, false), writes));
+				});
+		forEachBit(access.SharedReads | access.SharedWrites,
+				[&](uint32_t bit) {
+					const bool writes = (access.SharedWrites & bit) != 0;
+					phase = std::max(phase, constraint(DataKey(nullptr, bit, true), writes));
+				});
+		return phase;
+	}
+
+	/**
+	 * Record the access of a function assigned to a phase
+	 */
+	void record(Entity const* owner, DataAccess const& access, size_t phase) {
+		forEachBit(access.EntityReads | access.EntityWrites,
+				[&](uint32_t bit) {
+					update(DataKey(owner, bit, false), (access.EntityWrites & bit) != 0, phase);
+				});
+		forEachBit(access.SharedReads | access.SharedWrites,
+				[&](uint32_t bit) {
+					update(DataKey(nullptr, bit, true), (access.SharedWrites & bit) != 0, phase);
+				});
+	}
+
+	/**
+	 * Record a function which runs alone in its phase, all later functions
+	 * run in later phases
+	 */
+	void recordBarrier(size_t phase) {
+		m_barrierEnd = phase + 1;
+	}
+
+private:
+
+	template<class TFunc>
+	static void forEachBit(uint32_t bits, TFunc f) {
+		while (bits != 0) {
+			const uint32_t bit = bits & (~bits + 1);
+			f(bit);
+			bits &= ~bit;
+		}
+	}
+
+	size_t constraint(DataKey const& key, bool writes) const {
+		auto it = m_states.find(key);
+		if (it == m_states.end()) {
+			return 0;
+		}
+		// reads only need to run after the last write, writes also after
+		// the last read
+		return writes ?
+				std::max(it->second.ReadEnd, it->second.WriteEnd) :
+				it->second.WriteEnd;
+	}
+
+	void update(DataKey const& key, bool writes, size_t phase) {
+		auto & state = m_states[key];
+		if (writes) {
+			state.WriteEnd = std::max(state.WriteEnd, phase + 1);
+		} else {
+			state.ReadEnd = std::max(state.ReadEnd, phase + 1);
+		}
+	}
+
+	std::map<DataKey, DataState> m_states;
+
+	size_t m_barrierEnd = 0;
+};
+
+}
+
+AspectScheduler::subscribed_id AspectScheduler::addTask(Entity * owner,
+		DataAccess const& access, TaskFunction func) {
+	std::lock_guard<std::mutex> lg(m_access);
+
+	subscribed_id id = m_nextId;
+	if (m_freeIds.empty()) {
+		m_nextId++;
+	} else {
+		id = m_freeIds.back();
+		m_freeIds.pop_back();
+	}
+
+	Task task { id, owner, access, std::move(func) };
+	if (m_running) {
+		m_addedTasks.push_back(std::move(task));
+	} else {
+		m_tasks.push_back(std::move(task));
+		m_phasesDirty = true;
+	}
+	return id;
+}
+
+void AspectScheduler::unsubscribe(subscribed_id id) {
+	std::lock_guard<std::mutex> lg(m_access);
+	if (m_running) {
+		m_removedIds.push_back(id);
+		return;
+	}
+	removeTask(id);
+}
+
+bool AspectScheduler::removeTask(subscribed_id id) {
+	auto matches = [id]( Task const& t ) {return t.Id == id;};
+
+	auto it = std::find_if(m_tasks.begin(), m_tasks.end(), matches);
+	if (it != m_tasks.end()) {
+		m_tasks.erase(it);
+		m_phasesDirty = true;
+	} else {
+		auto added = std::find_if(m_addedTasks.begin(), m_addedTasks.end(),
+				matches);
+		if (added == m_addedTasks.end()) {
+			return false;
+		}
+		m_addedTasks.erase(added);
+	}
+	m_freeIds.push_back(id);
+	return true;
+}
+
+void AspectScheduler::applyDeferred() {
+	for (auto & task : m_addedTasks) {
+		m_tasks.push_back(std::move(task));
+		m_phasesDirty = true;
+	}
+	m_addedTasks.clear();
+
+	for (auto id : m_removedIds) {
+		removeTask(id);
+	}
+	m_removedIds.clear();
+}
+
+size_t AspectScheduler::getTaskCount() const {
+	std::lock_guard<std::mutex> lg(m_access);
+	// removed ids might be unknown or listed twice, so only count the
+	// tasks which survive the next applyDeferred
+	auto isKept = [this]( Task const& t ) {
+		return std::find(m_removedIds.begin(), m_removedIds.end(), t.Id)
+				== m_removedIds.end();
+	};
+	return size_t(std::count_if(m_tasks.begin(), m_tasks.end(), isKept))
+			+ size_t(
+					std::count_if(m_addedTasks.begin(), m_addedTasks.end(),
+							isKept));
+}
+
+size_t AspectScheduler::getPhaseCount() {
+	std::lock_guard<std::mutex> lg(m_access);
+	if (m_phasesDirty) {
+		buildPhases();
+	}
+	return m_phases.size();
+}
+
+void AspectScheduler::buildPhases() {
+	m_phases.clear();
+	ConflictTracker tracker;
+
+	for (uint32_t i = 0; i < m_tasks.size(); i++) {
+		auto const& task = m_tasks[i];
+		auto phase = tracker.earliestPhase(task.Owner, task.Access);
+
+		const bool exclusive = (task.Owner == nullptr)
+				&& ((task.Access.EntityReads | task.Access.EntityWrites) != 0);
+		if (exclusive) {
+			// might access any entity, so it runs after all phases so far
+			phase = std::max(phase, m_phases.size());
+		}
+
+		if (phase >= m_phases.size()) {
+			m_phases.resize(phase + 1);
+		}
+		m_phases[phase].Tasks.push_back(i);
+		m_phases[phase].Exclusive = exclusive;
+
+		if (exclusive) {
+			tracker.recordBarrier(phase);
+		} else {
+			tracker.record(task.Owner, task.Access, phase);
+		}
+	}
+	m_phasesDirty = false;
+}
+
+void AspectScheduler::run(float deltaTime, JobSystem * jobs,
+		ComponentStorage & storage) {
+	{
+		std::lock_guard<std::mutex> lg(m_access);
+		if (m_phasesDirty) {
+			buildPhases();
+		}
+		m_running = true;
+	}
+
+	for (auto const& phase : m_phases) {
+		runPhase(phase, deltaTime, jobs, storage);
+	}
+
+	std::lock_guard<std::mutex> lg(m_access);
+	m_running = false;
+	applyDeferred();
+}
+
+void AspectScheduler::runPhase(Phase const& phase, float deltaTime,
+		JobSystem * jobs, ComponentStorage & storage) {
+	const auto taskCount = phase.Tasks.size();
+	if (phase.Exclusive || !jobs || (taskCount <= TasksPerJob)) {
+		for (auto index : phase.Tasks) {
+			m_tasks[index].Func(deltaTime);
+		}
+		return;
+	}
+
+	storage.setDeferredMarking(true);
+	// only capture one pointer, so the job function does not allocate
+	struct PhaseRun {
+		AspectScheduler * Scheduler;
+		Phase const* RunPhase;
+		float DeltaTime;
+	} phaseRun { this, &phase, deltaTime };
+	jobs->parallelFor(0, taskCount, TasksPerJob,
+			[&phaseRun] (size_t begin, size_t end) {
+				auto const& tasks = phaseRun.Scheduler->m_tasks;
+				for (size_t i = begin; i < end; i++) {
+					tasks[phaseRun.RunPhase->Tasks[i]].Func(phaseRun.DeltaTime);
+				}
+			});
+	storage.setDeferredMarking(false);
+
+	for (auto index : phase.Tasks) {
+		auto owner = m_tasks[index].Owner;
+		if (owner && (owner->getComponents() == &storage)) {
+			storage.applyDeferredMarks(owner->getComponentSlot());
+		}
+	}
+}
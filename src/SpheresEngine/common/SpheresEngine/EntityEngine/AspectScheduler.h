@@ -0,0 +1,307 @@
+#pragma once
+
+#include <SpheresEngine/DataTypes/InplaceFunction.h>
+#include <SpheresEngine/Signals.h>
+
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class ComponentStorage;
+class Entity;
+class JobSystem;
+
+/**
+ * Data of one entity which an aspect can read or write during the time step
+ */
+struct EntityData {
+	/**
+	 * Position and rotation of the entity
+	 */
+	static constexpr uint32_t Transform = 1u << 0;
+
+	/**
+	 * The data of the visuals attached to the entity
+	 */
+	static constexpr uint32_t Visuals = 1u << 1;
+
+	/**
+	 * The physics body of the entity
+	 */
+	static constexpr uint32_t Physics = 1u << 2;
+
+	/**
+	 * The animations running on the entity
+	 */
+	static constexpr uint32_t Animation = 1u << 3;
+
+	/**
+	 * First bit which can be used for game specific data of the entity
+	 */
+	static constexpr uint32_t FirstCustom = 1u << 8;
+};
+
+/**
+ * Data shared by all entities which an aspect can read or write during the
+ * time step
+ */
+struct SharedData {
+	/**
+	 * The input actions of the InputEngine
+	 */
+	static constexpr uint32_t Input = 1u << 0;
+
+	/**
+	 * The list of entities, written when entities are added or removed
+	 */
+	static constexpr uint32_t Scene = 1u << 1;
+
+	/**
+	 * First bit which can be used for game specific shared data
+	 */
+	static constexpr uint32_t FirstCustom = 1u << 8;
+};
+
+/**
+ * The data an aspect reads and writes during the time step. Two aspects
+ * conflict if one of them writes data the other one reads or writes, the
+ * entity data only conflicts if both aspects belong to the same entity.
+ */
+class DataAccess {
+public:
+
+	/**
+	 * Add EntityData bits which are read
+	 */
+	DataAccess & readsEntity(uint32_t data) {
+		EntityReads |= data;
+		return *this;
+	}
+
+	/**
+	 * Add EntityData bits which are written
+	 */
+	DataAccess & writesEntity(uint32_t data) {
+		EntityWrites |= data;
+		return *this;
+	}
+
+	/**
+	 * Add SharedData bits which are read
+	 */
+	DataAccess & readsShared(uint32_t data) {
+		SharedReads |= data;
+		return *this;
+	}
+
+	/**
+	 * Add SharedData bits which are written
+	 */
+	DataAccess & writesShared(uint32_t data) {
+		SharedWrites |= data;
+		return *this;
+	}
+
+	/**
+	 * EntityData bits read
+	 */
+	uint32_t EntityReads = 0;
+
+	/**
+	 * EntityData bits written
+	 */
+	uint32_t EntityWrites = 0;
+
+	/**
+	 * SharedData bits read
+	 */
+	uint32_t SharedReads = 0;
+
+	/**
+	 * SharedData bits written
+	 */
+	uint32_t SharedWrites = 0;
+};
+
+/**
+ * Executes the time step functions of aspects which declared the data they
+ * access. The functions are grouped into phases: the functions within one
+ * phase do not conflict and are executed in parallel on a JobSystem, the
+ * phases run one after the other. A function which conflicts with functions
+ * subscribed before it is put into a later phase, so conflicting functions
+ * always run in the order of their subscription and the result does not
+ * depend on the number of threads.
+ *
+ * Functions without an owning entity which access entity data might touch any
+ * entity, they run alone in their own phase.
+ *
+ * Changes to the ComponentStorage done by the functions are collected per slot
+ * while a phase runs and applied after it, so aspects may move their own
+ * entity. Anything else a function accesses must be declared and must be safe
+ * to use from multiple threads for the functions which do not conflict.
+ */
+class AspectScheduler: public slots::SlotBase {
+public:
+
+	/**
+	 * Function executed every time step with the time passed
+	 */
+	typedef InplaceFunction<void(float)> TaskFunction;
+
+	/**
+	 * Number of functions of one phase which are executed as one job
+	 */
+	static constexpr size_t TasksPerJob = 32;
+
+	/**
+	 * Add a function which is executed every time step. The owner is the
+	 * entity whose data is declared in the EntityData bits of the access.
+	 * Can be called while the functions are executed, the new function then
+	 * runs from the next time step on.
+	 */
+	template<class TFunc>
+	subscribed_id subscribe(Entity * owner, DataAccess const& access,
+			TFunc && f) {
+		return addTask(owner, access, TaskFunction(std::forward<TFunc>(f)));
+	}
+
+	/**
+	 * Remove a function. If called while the functions are executed, the
+	 * function is removed once all phases are done.
+	 */
+	void unsubscribe(subscribed_id id) override;
+
+	/**
+	 * Execute all functions. The phases are distributed over the job system,
+	 * or executed on the calling thread if jobs is nullptr.
+	 */
+	void run(float deltaTime, JobSystem * jobs, ComponentStorage & storage);
+
+	/**
+	 * Number of subscribed functions
+	 */
+	size_t getTaskCount() const;
+
+	/**
+	 * Number of phases the functions are grouped into
+	 */
+	size_t getPhaseCount();
+
+private:
+
+	/**
+	 * One subscribed function
+	 */
+	struct Task {
+		/**
+		 * Id returned by subscribe
+		 */
+		subscribed_id Id;
+
+		/**
+		 * The entity whose data the function accesses, can be nullptr
+		 */
+		Entity * Owner;
+
+		/**
+		 * The data the function accesses
+		 */
+		DataAccess Access;
+
+		/**
+		 * The function to execute
+		 */
+		TaskFunction Func;
+	};
+
+	/**
+	 * Functions which are executed together
+	 */
+	struct Phase {
+		/**
+		 * Indices of the functions in m_tasks
+		 */
+		std::vector<uint32_t> Tasks;
+
+		/**
+		 * True if the phase holds one function which might access the data
+		 * of all entities
+		 */
+		bool Exclusive = false;
+	};
+
+	/**
+	 * Store a new function
+	 */
+	subscribed_id addTask(Entity * owner, DataAccess const& access,
+			TaskFunction func);
+
+	/**
+	 * Group the functions into phases
+	 */
+	void buildPhases();
+
+	/**
+	 * Execute all functions of one phase
+	 */
+	void runPhase(Phase const& phase, float deltaTime, JobSystem * jobs,
+			ComponentStorage & storage);
+
+	/**
+	 * Remove a function from the lists, returns false if the id is unknown
+	 */
+	bool removeTask(subscribed_id id);
+
+	/**
+	 * Add the functions subscribed and drop the ones unsubscribed while
+	 * the functions were executed
+	 */
+	void applyDeferred();
+
+	/**
+	 * All subscribed functions in the order of their subscription
+	 */
+	std::vector<Task> m_tasks;
+
+	/**
+	 * Functions subscribed while the functions were executed
+	 */
+	std::vector<Task> m_addedTasks;
+
+	/**
+	 * The phases, rebuilt when functions are added or removed
+	 */
+	std::vector<Phase> m_phases;
+
+	/**
+	 * True if the phases need to be rebuilt
+	 */
+	bool m_phasesDirty = false;
+
+	/**
+	 * True while run() executes the functions
+	 */
+	bool m_running = false;
+
+	/**
+	 * Functions unsubscribed while the functions were executed
+	 */
+	std::vector<subscribed_id> m_removedIds;
+
+	/**
+	 * Ids of removed functions which can be reused
+	 */
+	std::vector<subscribed_id> m_freeIds;
+
+	/**
+	 * The next id which has never been used
+	 */
+	subscribed_id m_nextId = 0;
+
+	/**
+	 * Protects the subscriptions, aspects executed in parallel might add or
+	 * remove functions
+	 */
+	mutable std::mutex m_access;
+};
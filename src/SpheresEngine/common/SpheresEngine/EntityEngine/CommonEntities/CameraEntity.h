@@ -26,6 +26,21 @@ public:
 	virtual void extractData(VisualDataExtractContainer & cont) {
 		cont.CameraData.LookAt = m_lookAt;
 		cont.CameraData.Position = getPosition();
+
+		// no previous state before the first step, so nothing to interpolate
+		cont.CameraData.PreviousLookAt =
+				m_previousLookAt.isValid() ? m_previousLookAt.get() : m_lookAt;
+		cont.CameraData.PreviousPosition =
+				m_previousPosition.isValid() ?
+						m_previousPosition.get() : getPosition();
+	}
+
+	/**
+	 * Store position and look-at point before the next logic step
+	 */
+	void storePreviousState() override {
+		m_previousLookAt = m_lookAt;
+		m_previousPosition = getPosition();
 	}
 
 private:
@@ -33,5 +48,15 @@ private:
 	 * Stores the position to look at
 	 */
 	Vector3 m_lookAt;
+
+	/**
+	 * Look-at point after the previous logic step
+	 */
+	util::ValidValue<Vector3> m_previousLookAt;
+
+	/**
+	 * Position after the previous logic step
+	 */
+	util::ValidValue<Vector3> m_previousPosition;
 };
 
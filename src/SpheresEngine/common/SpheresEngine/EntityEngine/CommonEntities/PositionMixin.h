@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SpheresEngine/VectorTypes.h>
+#include <SpheresEngine/EntityEngine/ComponentStorage.h>
 
 // for GLM_GTX_transform to be available
 #define GLM_ENABLE_EXPERIMENTAL
@@ -9,6 +10,9 @@
 /**
  * A Mixin class which can be derived from when creating new entity classes. It stores
  * position and provides related convenience methods.
+ *
+ * Once bound to a ComponentStorage, the position is kept in the storage's dense
+ * array instead of this class.
  */
 class PositionMixin {
 public:
@@ -17,21 +21,27 @@ public:
 	 * return the stored position
 	 */
 	Vector3 getPosition() const {
-		return m_position;
+		return m_storage ? m_storage->getPosition(m_slot) : m_position;
 	}
 
 	/**
 	 * set the position stored in this Mixin
 	 */
 	void setPosition(Vector3 pos) {
-		m_position = pos;
+		if (m_storage) {
+			m_storage->setPosition(m_slot, pos);
+		} else {
+			m_position = pos;
+		}
 	}
 
 	/**
 	 * Relatively move the position
 	 */
 	void move(Vector3 movDelta) {
-		m_position += movDelta;
+		auto position = getPosition();
+		position += movDelta;
+		setPosition(position);
 	}
 
 	/**
@@ -41,21 +51,44 @@ public:
 	void rotateAround(Vector3 rotationCenter, Vector3 intialRotationPosition,
 			Vector3 rotateAroundThisVector, float angleInRad) {
 
-		m_position = rotationCenter;
+		auto position = rotationCenter;
 		rotateAroundThisVector.normalize();
 
 		auto rotatedVec = glm::rotate(intialRotationPosition.toGlm(),
 				glm::degrees(angleInRad),
 				glm::normalize(rotateAroundThisVector.toGlm()));
 
-		m_position.setX(m_position.x() + rotatedVec.x);
-		m_position.setY(m_position.y() + rotatedVec.y);
-		m_position.setZ(m_position.z() + rotatedVec.z);
+		position.setX(position.x() + rotatedVec.x);
+		position.setY(position.y() + rotatedVec.y);
+		position.setZ(position.z() + rotatedVec.z);
+		setPosition(position);
+	}
+
+protected:
+
+	/**
+	 * Keep the position in a slot of the component storage from now on. The
+	 * slot must already contain the current position.
+	 */
+	void bindPosition(ComponentStorage & storage, ComponentSlot slot) {
+		m_storage = &storage;
+		m_slot = slot;
 	}
 
 private:
 	/**
-	 * Stores the position of this mixin
+	 * Stores the position of this mixin, as long as it is not bound to a
+	 * component storage
 	 */
 	Vector3 m_position = Vector3::zero();
+
+	/**
+	 * The storage holding the position, if bound
+	 */
+	ComponentStorage * m_storage = nullptr;
+
+	/**
+	 * Slot of the position in the storage
+	 */
+	ComponentSlot m_slot = 0;
 };
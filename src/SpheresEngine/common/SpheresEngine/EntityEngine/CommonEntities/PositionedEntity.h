@@ -8,7 +8,12 @@
 #include "CollisionMixin.h"
 
 /**
- * This is a game entity which can be positioned and rotated in 3d space
+ * This is a game entity which can be positioned and rotated in 3d space.
+ *
+ * When added to the EntityEngine, position, rotation and visuals are moved to
+ * the engine's ComponentStorage, which then extracts the render data instead of
+ * extractData(). Derived classes which extract additional data need to
+ * override bindComponents() and return false.
  */
 class PositionedEntity: public PositionMixin,
 		public RotationMixIn,
@@ -21,17 +26,68 @@ public:
 	 * all the visuals added to this entity
 	 */
 	virtual void extractData(VisualDataExtractContainer & cont) {
+		if (getComponents()) {
+			const auto eo = getComponents()->getExtractOffset(
+					getComponentSlot());
+			for (auto & v : getVisuals()) {
+				v->extractData(cont, eo);
+			}
+			return;
+		}
+
 		ExtractOffset eo;
 
 		// store the offset coming from the entity location and rotation
 		eo.Position = getPosition();
 		eo.Rotation = getRotation();
 
+		// no previous state before the first step, so nothing to interpolate
+		eo.PreviousPosition =
+				m_previousPosition.isValid() ?
+						m_previousPosition.get() : eo.Position;
+		eo.PreviousRotation =
+				m_previousRotation.isValid() ?
+						m_previousRotation.get() : eo.Rotation;
+
 		for (auto & v : getVisuals()) {
 			v->extractData(cont, eo);
 		}
 	}
 
+	/**
+	 * Store position and rotation before the next logic step
+	 */
+	void storePreviousState() override {
+		// the component storage stores the previous state of all its slots
+		if (getComponents()) {
+			return;
+		}
+		m_previousPosition = getPosition();
+		m_previousRotation = getRotation();
+	}
+
+	/**
+	 * Move position, rotation and the visuals into the component storage
+	 */
+	bool bindComponents(ComponentStorage & storage) override {
+		const auto slot = storage.createTransform(getPosition(), getRotation());
+		bindPosition(storage, slot);
+		bindRotation(storage, slot);
+		bindVisuals(storage, slot);
+		return true;
+	}
+
+private:
+
+	/**
+	 * Position after the previous logic step
+	 */
+	util::ValidValue<Vector3> m_previousPosition;
+
+	/**
+	 * Rotation after the previous logic step
+	 */
+	util::ValidValue<Quaternion> m_previousRotation;
 };
 
 class PositionedCollisionEntity: public PositionedEntity, public CollisionMixin {
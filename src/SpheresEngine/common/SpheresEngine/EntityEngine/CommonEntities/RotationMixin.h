@@ -1,10 +1,14 @@
 #pragma once
 
 #include <SpheresEngine/VectorTypes.h>
+#include <SpheresEngine/EntityEngine/ComponentStorage.h>
 
 /**
  * A Mixin class which can be derived from when creating new entity classes.
  * This MixIn represents one rotation via quaternions.
+ *
+ * Once bound to a ComponentStorage, the rotation is kept in the storage's dense
+ * array instead of this class.
  */
 class RotationMixIn {
 public:
@@ -13,14 +17,18 @@ public:
 	 * return the stored rotation
 	 */
 	Quaternion getRotation() const {
-		return m_quat;
+		return m_storage ? m_storage->getRotation(m_slot) : m_quat;
 	}
 
 	/**
 	 * set the rotation stored in this Mixin
 	 */
 	void setRotation(Quaternion quat) {
-		m_quat = quat;
+		if (m_storage) {
+			m_storage->setRotation(m_slot, quat);
+		} else {
+			m_quat = quat;
+		}
 	}
 
 	/**
@@ -29,20 +37,42 @@ public:
 	 */
 	void rotate(Vector3 rotateAroundThisVector, float angleInRad) {
 		auto dg = glm::degrees(angleInRad);
-		m_quat = glm::rotate(m_quat, dg, rotateAroundThisVector.toGlm());
+		setRotation(glm::rotate(getRotation(), dg, rotateAroundThisVector.toGlm()));
 	}
 
 	/**
 	 * reset the rotation to unity
 	 */
 	void resetRotation() {
-		m_quat = Quaternion(glm::vec3(0.0f, 0.0f, 0.0f));
+		setRotation(Quaternion(glm::vec3(0.0f, 0.0f, 0.0f)));
+	}
+
+protected:
+
+	/**
+	 * Keep the rotation in a slot of the component storage from now on. The
+	 * slot must already contain the current rotation.
+	 */
+	void bindRotation(ComponentStorage & storage, ComponentSlot slot) {
+		m_storage = &storage;
+		m_slot = slot;
 	}
 
 private:
 
 	/**
-	 * Store the rotation as quaternion
+	 * Store the rotation as quaternion, as long as it is not bound to a
+	 * component storage
 	 */
 	Quaternion m_quat = Quaternion(glm::vec3(0.0f, 0.0f, 0.0f));
+
+	/**
+	 * The storage holding the rotation, if bound
+	 */
+	ComponentStorage * m_storage = nullptr;
+
+	/**
+	 * Slot of the rotation in the storage
+	 */
+	ComponentSlot m_slot = 0;
 };
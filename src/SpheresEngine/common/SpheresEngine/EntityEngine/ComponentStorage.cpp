@@ -0,0 +1,212 @@
+#include <SpheresEngine/EntityEngine/ComponentStorage.h>
+
+#include <SpheresEngine/Visuals/MeshVisual.h>
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+#include <SpheresEngine/Visuals/VisualDataExtract.h>
+
+#include <algorithm>
+
+constexpr size_t ComponentStorage::HistoryLength;
+constexpr uint32_t ComponentStorage::NoHandle;
+
+ComponentSlot ComponentStorage::createTransform(Vector3 position,
+		Quaternion rotation) {
+	if (!m_releasedSlots.empty()) {
+		const auto slot = m_releasedSlots.back();
+		m_releasedSlots.pop_back();
+		m_positions[slot] = position;
+		m_rotations[slot] = rotation;
+		m_previousPositions[slot] = position;
+		m_previousRotations[slot] = rotation;
+		markDataChanged(slot);
+		return slot;
+	}
+
+	const auto slot = ComponentSlot(m_positions.size());
+	m_positions.push_back(position);
+	m_rotations.push_back(rotation);
+	m_previousPositions.push_back(position);
+	m_previousRotations.push_back(rotation);
+	m_changedIn.push_back(0);
+	m_dataChangedIn.push_back(0);
+	m_moved.push_back(false);
+	m_spatialChanged.push_back(0);
+	m_deferredMoved.push_back(0);
+	m_deferredChanged.push_back(0);
+	m_firstMesh.push_back(NoHandle);
+	m_firstParticles.push_back(NoHandle);
+	markDataChanged(slot);
+	return slot;
+}
+
+void ComponentStorage::addVisual(ComponentSlot slot, VisualAbstract * visual) {
+	if (auto mesh = dynamic_cast<MeshVisual *>(visual)) {
+		m_meshVisuals.push_back( { slot, mesh, m_firstMesh[slot] });
+		m_firstMesh[slot] = uint32_t(m_meshVisuals.size() - 1);
+	} else if (auto particles = dynamic_cast<ParticleSystemVisual *>(visual)) {
+		m_particleVisuals.push_back( { slot, particles, m_firstParticles[slot] });
+		m_firstParticles[slot] = uint32_t(m_particleVisuals.size() - 1);
+	} else {
+		m_otherVisuals.push_back( { slot, visual, NoHandle });
+	}
+	visual->setChangeListener(this, slot);
+	markDataChanged(slot);
+}
+
+template<class TVisual>
+void ComponentStorage::removeHandles(ComponentSlot slot,
+		std::vector<VisualHandle<TVisual>> & handles,
+		std::vector<uint32_t> & first) {
+	while (first[slot] != NoHandle) {
+		const auto h = first[slot];
+		first[slot] = handles[h].NextInSlot;
+		handles[h].Visual->setChangeListener(nullptr, 0);
+
+		const auto last = uint32_t(handles.size() - 1);
+		if (h != last) {
+			// move the last handle into the gap and fix the list of its slot
+			handles[h] = handles[last];
+			const auto movedSlot = handles[h].Slot;
+			if (first[movedSlot] == last) {
+				first[movedSlot] = h;
+			} else {
+				auto prev = first[movedSlot];
+				while (handles[prev].NextInSlot != last) {
+					prev = handles[prev].NextInSlot;
+				}
+				handles[prev].NextInSlot = h;
+			}
+			// the entry of the moved visual has a new index
+			markDataChanged(movedSlot);
+		}
+		handles.pop_back();
+	}
+}
+
+void ComponentStorage::releaseSlot(ComponentSlot slot) {
+	removeHandles(slot, m_meshVisuals, m_firstMesh);
+	removeHandles(slot, m_particleVisuals, m_firstParticles);
+
+	for (auto const& h : m_otherVisuals) {
+		if (h.Slot == slot) {
+			h.Visual->setChangeListener(nullptr, 0);
+		}
+	}
+	m_otherVisuals.erase(
+			std::remove_if(m_otherVisuals.begin(), m_otherVisuals.end(),
+					[slot] (VisualHandle<VisualAbstract> const& h) {
+						return h.Slot == slot;
+					}), m_otherVisuals.end());
+
+	m_releasedSlots.push_back(slot);
+}
+
+void ComponentStorage::storePreviousState() {
+	for (auto slot : m_movedSlots) {
+		m_previousPositions[slot] = m_positions[slot];
+		m_previousRotations[slot] = m_rotations[slot];
+		m_moved[slot] = false;
+		// the interpolation of the slot changes, so extract it once more
+		markChanged(slot);
+	}
+	m_movedSlots.clear();
+}
+
+size_t ComponentStorage::extractSlot(ComponentSlot slot,
+		VisualDataExtractContainer & cont) const {
+	size_t written = 0;
+	for (auto h = m_firstMesh[slot]; h != NoHandle;
+			h = m_meshVisuals[h].NextInSlot) {
+		extractMesh(h, cont);
+		written++;
+	}
+	for (auto h = m_firstParticles[slot]; h != NoHandle;
+			h = m_particleVisuals[h].NextInSlot) {
+		extractParticles(h, cont);
+		written++;
+	}
+	return written;
+}
+
+void ComponentStorage::extractTransform(ComponentSlot slot,
+		VisualTransform & t) const {
+	t.Center = m_positions[slot].toGlm();
+	t.Rotation = m_rotations[slot];
+	t.PreviousCenter = m_previousPositions[slot].toGlm();
+	t.PreviousRotation = m_previousRotations[slot];
+}
+
+void ComponentStorage::extractMesh(uint32_t handle,
+		VisualDataExtractContainer & cont) const {
+	auto const& h = m_meshVisuals[handle];
+
+	// the qualified call is resolved at compile time. Copying the visual
+	// data is the expensive part, most entries only moved and only their
+	// transform is written.
+	if (cont.MeshVisualChangeTicks[handle] < m_dataChangedIn[h.Slot]) {
+		h.Visual->MeshVisual::extractDataTo(cont.MeshVisuals[handle]);
+	}
+	extractTransform(h.Slot, cont.MeshTransforms[handle]);
+	cont.MeshVisualChangeTicks[handle] = m_changedIn[h.Slot];
+}
+
+void ComponentStorage::extractParticles(uint32_t handle,
+		VisualDataExtractContainer & cont) const {
+	auto const& h = m_particleVisuals[handle];
+	h.Visual->ParticleSystemVisual::extractDataTo(
+			cont.ParticleSystems[handle], getExtractOffset(h.Slot));
+}
+
+void ComponentStorage::extractVisualData(VisualDataExtractContainer & cont) {
+	m_extractTick++;
+	auto & changedNow = m_history[m_extractTick % HistoryLength];
+	changedNow.swap(m_pendingSlots);
+	m_pendingSlots.clear();
+
+	const auto filledIn = cont.ExtractTick;
+	const bool fullRewrite = (filledIn == 0) || (filledIn >= m_extractTick)
+			|| (m_extractTick - filledIn > HistoryLength);
+
+	// entries appended behind the ones of this storage during the last fill
+	// are dropped. The entries of new visuals and of visuals which were moved
+	// to a new index by a removal belong to changed slots.
+	cont.MeshVisuals.resize(m_meshVisuals.size());
+	cont.MeshTransforms.resize(m_meshVisuals.size());
+	cont.ParticleSystems.resize(m_particleVisuals.size());
+	cont.MeshVisualChangeTicks.resize(m_meshVisuals.size());
+
+	size_t written = 0;
+	if (fullRewrite) {
+		if (filledIn >= m_extractTick) {
+			// not filled by this storage, none of the entries can be kept
+			std::fill(cont.MeshVisualChangeTicks.begin(),
+					cont.MeshVisualChangeTicks.end(), 0);
+		}
+		// walk the handles in order instead of the visuals of each slot
+		for (uint32_t h = 0; h < m_meshVisuals.size(); h++) {
+			extractMesh(h, cont);
+		}
+		for (uint32_t h = 0; h < m_particleVisuals.size(); h++) {
+			extractParticles(h, cont);
+		}
+		written = m_meshVisuals.size() + m_particleVisuals.size();
+	} else {
+		for (auto tick = filledIn + 1; tick <= m_extractTick; tick++) {
+			for (auto slot : m_history[tick % HistoryLength]) {
+				// a slot changed multiple times is only written for the
+				// last change
+				if (m_changedIn[slot] == tick) {
+					written += extractSlot(slot, cont);
+				}
+			}
+		}
+	}
+
+	for (auto const& h : m_otherVisuals) {
+		h.Visual->extractData(cont, getExtractOffset(h.Slot));
+		written++;
+	}
+
+	cont.ExtractTick = m_extractTick;
+	cont.ChangedEntries = written;
+}
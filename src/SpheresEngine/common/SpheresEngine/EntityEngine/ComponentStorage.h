@@ -0,0 +1,431 @@
+#pragma once
+
+#include <SpheresEngine/VectorTypes.h>
+#include <SpheresEngine/Visuals/VisualBase.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class MeshVisual;
+class ParticleSystemVisual;
+struct VisualDataExtractContainer;
+struct VisualTransform;
+
+/**
+ * Index of the components of one entity in the ComponentStorage
+ */
+typedef uint32_t ComponentSlot;
+
+/**
+ * Dense storage of the components all entities in the EntityEngine share:
+ * position, rotation and the handles to their visuals.
+ *
+ * Each component type is stored in its own contiguous array, so the per-tick
+ * passes (storing the previous state and extracting the render data) are
+ * linear loops over memory instead of virtual calls on every entity and
+ * visual. Entities access their components via the slot they got when they
+ * were bound to this storage.
+ *
+ * Changes to the position, rotation or visual data of a slot are tracked, so
+ * the extraction only rewrites the entries of the slots which changed since
+ * the extract container was filled the last time. Static entities cost
+ * nothing per tick.
+ */
+class ComponentStorage: public VisualChangeListener, boost::noncopyable {
+public:
+
+	/**
+	 * Number of extractions for which the changed slots are remembered. A
+	 * container which was filled longer ago is rewritten completely.
+	 */
+	static constexpr size_t HistoryLength = 8;
+
+	/**
+	 * Marks the end of the list of visuals of a slot
+	 */
+	static constexpr uint32_t NoHandle = std::numeric_limits<uint32_t>::max();
+
+	/**
+	 * Handle which connects a visual with the slot of its entity
+	 */
+	template<class TVisual>
+	struct VisualHandle {
+		/**
+		 * Slot of the entity the visual belongs to
+		 */
+		ComponentSlot Slot;
+
+		/**
+		 * The visual, not owned by the storage
+		 */
+		TVisual * Visual;
+
+		/**
+		 * Index of the next handle of the same type and slot, NoHandle if
+		 * this is the last one
+		 */
+		uint32_t NextInSlot;
+	};
+
+	/**
+	 * Create a new slot holding a position and rotation. The previous state
+	 * is initialized with the same values, so there is nothing to interpolate
+	 * before the first logic step. Released slots are reused.
+	 */
+	ComponentSlot createTransform(Vector3 position, Quaternion rotation);
+
+	/**
+	 * Remove all visuals attached to a slot and release it, so it can be
+	 * reused by createTransform(). The visual handles of other slots are
+	 * moved to fill the gaps, so the extracted entries stay dense.
+	 */
+	void releaseSlot(ComponentSlot slot);
+
+	/**
+	 * Number of slots created, including the released ones
+	 */
+	size_t size() const {
+		return m_positions.size();
+	}
+
+	/**
+	 * Number of released slots waiting to be reused
+	 */
+	size_t getReleasedCount() const {
+		return m_releasedSlots.size();
+	}
+
+	/**
+	 * Number of mesh and particle system visuals attached to all slots
+	 */
+	size_t getVisualCount() const {
+		return m_meshVisuals.size() + m_particleVisuals.size()
+				+ m_otherVisuals.size();
+	}
+
+	/**
+	 * Position stored in a slot
+	 */
+	Vector3 const& getPosition(ComponentSlot slot) const {
+		return m_positions[slot];
+	}
+
+	/**
+	 * Set the position stored in a slot
+	 */
+	void setPosition(ComponentSlot slot, Vector3 const& position) {
+		m_positions[slot] = position;
+		markMoved(slot);
+	}
+
+	/**
+	 * Rotation stored in a slot
+	 */
+	Quaternion const& getRotation(ComponentSlot slot) const {
+		return m_rotations[slot];
+	}
+
+	/**
+	 * Set the rotation stored in a slot
+	 */
+	void setRotation(ComponentSlot slot, Quaternion const& rotation) {
+		m_rotations[slot] = rotation;
+		markMoved(slot);
+	}
+
+	/**
+	 * Mark the visuals of a slot to be extracted again
+	 */
+	void markChanged(ComponentSlot slot) {
+		if (m_deferMarks) {
+			m_deferredChanged[slot] = 1;
+			return;
+		}
+		if (m_changedIn[slot] != m_extractTick + 1) {
+			m_changedIn[slot] = m_extractTick + 1;
+			m_pendingSlots.push_back(slot);
+		}
+	}
+
+	/**
+	 * Called by the visuals attached to this storage, the key is the slot
+	 */
+	void visualChanged(uint32_t key) override {
+		markDataChanged(ComponentSlot(key));
+	}
+
+	/**
+	 * Number of the last extraction in which the data of a slot changed
+	 */
+	uint64_t getChangedIn(ComponentSlot slot) const {
+		return m_changedIn[slot];
+	}
+
+	/**
+	 * Position and rotation of a slot, current and after the previous logic
+	 * step, as used by the visual extraction
+	 */
+	ExtractOffset getExtractOffset(ComponentSlot slot) const {
+		ExtractOffset eo;
+		eo.Position = m_positions[slot];
+		eo.Rotation = m_rotations[slot];
+		eo.PreviousPosition = m_previousPositions[slot];
+		eo.PreviousRotation = m_previousRotations[slot];
+		return eo;
+	}
+
+	/**
+	 * Attach a visual to the entity in a slot. Mesh and particle system
+	 * visuals are stored in their own arrays and extracted without a
+	 * virtual call.
+	 */
+	void addVisual(ComponentSlot slot, VisualAbstract * visual);
+
+	/**
+	 * Store the current positions and rotations as the state of the previous
+	 * logic step. Only the slots which moved during the last step are
+	 * touched, all others already hold the same previous and current state.
+	 */
+	void storePreviousState();
+
+	/**
+	 * Extract the render data of all visuals attached to a slot. If the
+	 * container was filled by one of the last HistoryLength extractions, only
+	 * the entries of the slots which changed since then are rewritten. Visuals
+	 * of other types are appended to the container on every extraction.
+	 */
+	void extractVisualData(VisualDataExtractContainer & cont);
+
+	/**
+	 * Slots moved since the spatial index was updated the last time, each
+	 * slot at most once
+	 */
+	std::vector<ComponentSlot> const& getSpatialChanges() const {
+		return m_spatialChanges;
+	}
+
+	/**
+	 * Called by the spatial index once it moved the changed slots
+	 */
+	void clearSpatialChanges() {
+		for (auto slot : m_spatialChanges) {
+			m_spatialChanged[slot] = 0;
+		}
+		m_spatialChanges.clear();
+	}
+
+	/**
+	 * While enabled, changes of a slot are only flagged in a per-slot array
+	 * instead of being added to the shared lists. Aspects running in
+	 * parallel can then change the components of different slots at the same
+	 * time. The flags are moved to the lists by applyDeferredMarks().
+	 */
+	void setDeferredMarking(bool defer) {
+		m_deferMarks = defer;
+	}
+
+	/**
+	 * Apply the changes of a slot flagged while the marking was deferred
+	 */
+	void applyDeferredMarks(ComponentSlot slot) {
+		if (m_deferredMoved[slot]) {
+			m_deferredMoved[slot] = 0;
+			markMoved(slot);
+		}
+		if (m_deferredChanged[slot]) {
+			m_deferredChanged[slot] = 0;
+			markDataChanged(slot);
+		}
+	}
+
+private:
+
+	/**
+	 * Mark the visual data of a slot as changed, the entries of its visuals
+	 * are copied completely with the next extraction. Otherwise only their
+	 * position and rotation are written.
+	 */
+	void markDataChanged(ComponentSlot slot) {
+		if (m_deferMarks) {
+			m_deferredChanged[slot] = 1;
+			return;
+		}
+		m_dataChangedIn[slot] = m_extractTick + 1;
+		markChanged(slot);
+	}
+
+	/**
+	 * Mark a slot as moved, so its previous state is updated with the next
+	 * logic step
+	 */
+	void markMoved(ComponentSlot slot) {
+		if (m_deferMarks) {
+			m_deferredMoved[slot] = 1;
+			return;
+		}
+		markChanged(slot);
+		if (!m_moved[slot]) {
+			m_moved[slot] = true;
+			m_movedSlots.push_back(slot);
+		}
+		if (!m_spatialChanged[slot]) {
+			m_spatialChanged[slot] = 1;
+			m_spatialChanges.push_back(slot);
+		}
+	}
+
+	/**
+	 * Remove the handles of a slot from one of the handle arrays. The last
+	 * handle is moved into each gap and the data of its slot marked as
+	 * changed.
+	 */
+	template<class TVisual>
+	void removeHandles(ComponentSlot slot,
+			std::vector<VisualHandle<TVisual>> & handles,
+			std::vector<uint32_t> & first);
+
+	/**
+	 * Write the entries of all mesh and particle system visuals of a slot
+	 * and return the number of entries written
+	 */
+	size_t extractSlot(ComponentSlot slot, VisualDataExtractContainer & cont) const;
+
+	/**
+	 * Write the position and rotation of a slot, current and after the
+	 * previous logic step, to the transform of an extracted visual
+	 */
+	void extractTransform(ComponentSlot slot, VisualTransform & t) const;
+
+	/**
+	 * Write the transform of one mesh visual, the visual data is only copied
+	 * if it changed since the entry was written
+	 */
+	void extractMesh(uint32_t handle, VisualDataExtractContainer & cont) const;
+
+	/**
+	 * Write the entry of one particle system visual
+	 */
+	void extractParticles(uint32_t handle,
+			VisualDataExtractContainer & cont) const;
+
+	/**
+	 * Number of extractions done so far
+	 */
+	uint64_t m_extractTick = 0;
+
+	/**
+	 * Number of the extraction in which the data of each slot changed the
+	 * last time
+	 */
+	std::vector<uint64_t> m_changedIn;
+
+	/**
+	 * Number of the extraction in which the visual data of each slot
+	 * changed the last time, not counting changes of the position and
+	 * rotation
+	 */
+	std::vector<uint64_t> m_dataChangedIn;
+
+	/**
+	 * Slots changed since the last extraction, each slot at most once
+	 */
+	std::vector<ComponentSlot> m_pendingSlots;
+
+	/**
+	 * The slots changed in each of the last extractions, indexed by the
+	 * extraction number modulo HistoryLength
+	 */
+	std::array<std::vector<ComponentSlot>, HistoryLength> m_history;
+
+	/**
+	 * True for each slot which is in the list of moved slots
+	 */
+	std::vector<bool> m_moved;
+
+	/**
+	 * Slots moved since the previous state was stored
+	 */
+	std::vector<ComponentSlot> m_movedSlots;
+
+	/**
+	 * 1 for each slot which is in the list of spatial changes
+	 */
+	std::vector<uint8_t> m_spatialChanged;
+
+	/**
+	 * Slots moved since the spatial index was updated. Kept apart from
+	 * m_movedSlots, which is cleared at the beginning of each logic step.
+	 */
+	std::vector<ComponentSlot> m_spatialChanges;
+
+	/**
+	 * True while the marking of changes is deferred
+	 */
+	bool m_deferMarks = false;
+
+	/**
+	 * Slots moved while the marking was deferred. Stored separately from
+	 * the other changes, so aspects writing the transform and the visuals of
+	 * the same slot in parallel do not write the same memory.
+	 */
+	std::vector<uint8_t> m_deferredMoved;
+
+	/**
+	 * Slots changed while the marking was deferred
+	 */
+	std::vector<uint8_t> m_deferredChanged;
+
+	/**
+	 * Slots released and not reused yet
+	 */
+	std::vector<ComponentSlot> m_releasedSlots;
+
+	/**
+	 * Index of the first mesh visual handle of each slot
+	 */
+	std::vector<uint32_t> m_firstMesh;
+
+	/**
+	 * Index of the first particle system visual handle of each slot
+	 */
+	std::vector<uint32_t> m_firstParticles;
+
+	/**
+	 * Position of each slot
+	 */
+	std::vector<Vector3> m_positions;
+
+	/**
+	 * Rotation of each slot
+	 */
+	std::vector<Quaternion> m_rotations;
+
+	/**
+	 * Position of each slot after the previous logic step
+	 */
+	std::vector<Vector3> m_previousPositions;
+
+	/**
+	 * Rotation of each slot after the previous logic step
+	 */
+	std::vector<Quaternion> m_previousRotations;
+
+	/**
+	 * All mesh visuals
+	 */
+	std::vector<VisualHandle<MeshVisual>> m_meshVisuals;
+
+	/**
+	 * All particle system visuals
+	 */
+	std::vector<VisualHandle<ParticleSystemVisual>> m_particleVisuals;
+
+	/**
+	 * Visuals of other types, these are extracted with a virtual call
+	 */
+	std::vector<VisualHandle<VisualAbstract>> m_otherVisuals;
+};
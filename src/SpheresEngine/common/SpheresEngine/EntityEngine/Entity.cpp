@@ -1,45 +1,66 @@
 #include <SpheresEngine/EntityEngine/Entity.h>
 
+#include <algorithm>
 #include <memory>
 
 void Entity::addVisual(VisualAbstract * visual) {
 	m_visuals.push_back(visual);
+	if (m_components) {
+		m_components->addVisual(m_componentSlot, visual);
+	}
+	if (m_visualIndex) {
+		m_visualIndex->addVisual(visual);
+	}
 }
 
-void Entity::addVisualPlaceholder(PrepareVisualId id) {
-	m_visualsPrepare.push_back(id);
+void Entity::bindVisuals(ComponentStorage & storage, ComponentSlot slot) {
+	m_components = &storage;
+	m_componentSlot = slot;
+	for (auto v : m_visuals) {
+		m_components->addVisual(m_componentSlot, v);
+	}
 }
 
-void Entity::updatePreparedVisuals(RenderEngine::PrepareVisualList const& vis) {
-	if (m_visualsPrepare.size() == 0)
-		return;
+void Entity::registerVisuals(VisualIndex & index) {
+	m_visualIndex = &index;
+	for (auto id : m_visualsPrepare) {
+		m_visualIndex->addPlaceholder(id, this);
+	}
+	for (auto v : m_visuals) {
+		m_visualIndex->addVisual(v);
+	}
+}
 
-	std::vector<PrepareVisualId> addedIds;
-	for (auto const& v : vis) {
-		for (auto vp : m_visualsPrepare) {
-			if (vp == v.first) {
-				this->addVisual(v.second);
-				addedIds.push_back(vp);
-				logging::Info() << "Prepared visual of type "
-						<< v.second->getType() << " added to Entity";
-			}
+void Entity::detach() {
+	if (m_components) {
+		m_components->releaseSlot(m_componentSlot);
+		m_components = nullptr;
+	}
+	if (m_visualIndex) {
+		for (auto id : m_visualsPrepare) {
+			m_visualIndex->removePlaceholder(id);
 		}
-
+		for (auto v : m_visuals) {
+			m_visualIndex->removeVisual(v);
+		}
+		m_visualIndex = nullptr;
 	}
+}
 
-	// remove all ids of visuals which have been added
-	for (auto v : addedIds) {
-		auto it = std::remove(m_visualsPrepare.begin(), m_visualsPrepare.end(),
-				v);
-		m_visualsPrepare.erase(it, m_visualsPrepare.end());
+void Entity::addVisualPlaceholder(PrepareVisualId id) {
+	m_visualsPrepare.push_back(id);
+	if (m_visualIndex) {
+		m_visualIndex->addPlaceholder(id, this);
 	}
 }
 
-void Entity::updateVisuals(std::vector<RendererVisualChange> const& vcs) {
-	// propagate to children
-	for (auto const& vc : vcs) {
-		for (auto const& v : m_visuals) {
-			v->update(vc);
-		}
+void Entity::addPreparedVisual(PrepareVisualId id, VisualAbstract * visual) {
+	auto it = std::find(m_visualsPrepare.begin(), m_visualsPrepare.end(), id);
+	if (it == m_visualsPrepare.end()) {
+		logging::Error() << "Entity does not wait for the visual with prepare id "
+				<< id;
+		return;
 	}
+	m_visualsPrepare.erase(it);
+	addVisual(visual);
 }
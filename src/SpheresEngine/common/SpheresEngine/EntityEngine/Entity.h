@@ -4,6 +4,9 @@
 #include <boost/noncopyable.hpp>
 #include <SpheresEngine/Visuals/VisualDataExtract.h>
 #include <SpheresEngine/RenderEngine/RenderEngine.h>
+#include <SpheresEngine/EntityEngine/ComponentStorage.h>
+#include <SpheresEngine/EntityEngine/EntityHandle.h>
+#include <SpheresEngine/EntityEngine/VisualIndex.h>
 
 #include <SpheresEngine/StateEngine/Aspect.h>
 
@@ -15,6 +18,21 @@
 class Entity: private boost::noncopyable {
 public:
 
+	/**
+	 * The EntityEngine assigns the handle and detaches removed entities
+	 */
+	friend class EntityEngine;
+
+	/**
+	 * The AspectScheduler applies the component changes of parallel aspects
+	 */
+	friend class AspectScheduler;
+
+	/**
+	 * The SpatialIndex stores the entities by their component slot
+	 */
+	friend class SpatialIndex;
+
 	virtual ~Entity() = default;
 
 	/**
@@ -38,6 +56,25 @@ public:
 		}
 	}
 
+	/**
+	 * Called before each logic step to store the state the step starts
+	 * with, so the rendering can interpolate between the last two states.
+	 * Entities which have a position need to implement this.
+	 */
+	virtual void storePreviousState() {
+	}
+
+	/**
+	 * Called when the entity is added to the EntityEngine. Entities which keep
+	 * their render state in the engine's dense component storage bind to it
+	 * and return true, their visuals are then extracted by the storage and
+	 * neither extractData() nor storePreviousState() are called by the engine
+	 * anymore. The default implementation keeps the per-entity calls.
+	 */
+	virtual bool bindComponents(ComponentStorage &) {
+		return false;
+	}
+
 	/**
 	 * Add a visual to this entity
 	 */
@@ -50,16 +87,33 @@ public:
 	void addVisualPlaceholder(PrepareVisualId id);
 
 	/**
-	 * A list of visuals which have been prepared during the last cycle by the render
-	 * engine and now be added to the Entity.
+	 * The entity takes over the ownership of the visual and deletes it when
+	 * the entity is destroyed. This is independent of adding the visual, so
+	 * the ownership can be taken while the visual is still being prepared.
+	 */
+	void takeVisualOwnership(uniq<VisualAbstract> visual) {
+		m_ownedVisuals.push_back(std::move(visual));
+	}
+
+	/**
+	 * The visual with the placeholder id has been prepared by the render
+	 * engine and is now added to the Entity
 	 */
-	void updatePreparedVisuals(RenderEngine::PrepareVisualList const&);
+	void addPreparedVisual(PrepareVisualId id, VisualAbstract * visual);
 
 	/**
-	 * Data contained in visuals has been updated and now this entity needs to update
-	 * its saves visuals.
+	 * Ids of the visuals which are still being prepared by the render engine
 	 */
-	void updateVisuals(std::vector<RendererVisualChange> const&);
+	VisualPrepareList const& getVisualPlaceholders() const {
+		return m_visualsPrepare;
+	}
+
+	/**
+	 * Called when the entity is added to the EntityEngine. Registers the
+	 * placeholders and visuals of this entity with the index, the ones added
+	 * later are registered as well.
+	 */
+	void registerVisuals(VisualIndex & index);
 
 	/**
 	 * Return a pointer to the first visual stored by this entity
@@ -95,8 +149,51 @@ public:
 		return m_aspects;
 	}
 
+	/**
+	 * The handle assigned by the EntityEngine, unassigned as long as the
+	 * entity has not been added
+	 */
+	EntityHandle getHandle() const {
+		return m_handle;
+	}
+
+protected:
+
+	/**
+	 * Register all visuals of this entity with a slot of the component
+	 * storage, visuals added later are registered as well
+	 */
+	void bindVisuals(ComponentStorage & storage, ComponentSlot slot);
+
+	/**
+	 * The component storage this entity is bound to, nullptr if not bound
+	 */
+	ComponentStorage * getComponents() const {
+		return m_components;
+	}
+
+	/**
+	 * The slot of this entity in the component storage
+	 */
+	ComponentSlot getComponentSlot() const {
+		return m_componentSlot;
+	}
+
 private:
 
+	/**
+	 * Remove the visuals and placeholders of this entity from the component
+	 * storage and the visual index, called before a removed entity is
+	 * destroyed
+	 */
+	void detach();
+
+	/**
+	 * Visuals owned by this entity, destroyed after the aspects which might
+	 * still reference them
+	 */
+	std::vector<uniq<VisualAbstract>> m_ownedVisuals;
+
 	/**
 	 * List of all visuals which have been fully loaded
 	 */
@@ -112,5 +209,25 @@ private:
 	 * Aspects associated with this entity
 	 */
 	AspectBaseListUniq m_aspects;
+
+	/**
+	 * The component storage the visuals are registered with, if bound
+	 */
+	ComponentStorage * m_components = nullptr;
+
+	/**
+	 * Slot of this entity in the component storage
+	 */
+	ComponentSlot m_componentSlot = 0;
+
+	/**
+	 * The index the placeholders and visuals are registered with, if any
+	 */
+	VisualIndex * m_visualIndex = nullptr;
+
+	/**
+	 * Handle of this entity in the EntityEngine
+	 */
+	EntityHandle m_handle;
 };
 
@@ -10,30 +10,172 @@
 
 #include "Entity.h"
 
+EntityHandle EntityEngine::addEntity(uniq<Entity> ent,
+		EntityList * managedList) {
+	if (managedList) {
+		managedList->push_back(ent.get());
+	}
+
+	// records of removed entities are reused, their generation has been
+	// incremented so old handles do not resolve to the new entity
+	uint32_t index;
+	if (!m_freeRecords.empty()) {
+		index = m_freeRecords.back();
+		m_freeRecords.pop_back();
+	} else {
+		index = uint32_t(m_records.size());
+		m_records.emplace_back();
+	}
+	auto & record = m_records[index];
+	record.Ent = ent.get();
+	record.Position = m_entities.size();
+
+	EntityHandle handle;
+	handle.Index = index;
+	handle.Generation = record.Generation;
+	ent->m_handle = handle;
+
+	// entities which cannot use the component storage are extracted
+	// one by one
+	if (!ent->bindComponents(m_components)) {
+		m_unboundEntities.push_back(ent.get());
+	}
+	m_spatialIndex.addEntity(ent.get());
+	ent->registerVisuals(m_visualIndex);
+
+	m_entities.push_back(std::move(ent));
+	return handle;
+}
+
+void EntityEngine::removeEntity(EntityHandle handle) {
+	if (!getEntity(handle)) {
+		return;
+	}
+	auto & record = m_records[handle.Index];
+	if (!record.RemovalPending) {
+		record.RemovalPending = true;
+		m_pendingRemovals.push_back(handle);
+	}
+}
+
+void EntityEngine::flushRemovals() {
+	// subscribers of OnEntityRemoved might request more removals, which are
+	// handled in the same flush
+	for (size_t i = 0; i < m_pendingRemovals.size(); i++) {
+		const auto handle = m_pendingRemovals[i];
+		auto ent = m_records[handle.Index].Ent;
+		OnEntityRemoved.signal(ent);
+
+		// the render engine does not need to prepare the visuals anymore, the
+		// owned ones are kept until the render thread is done with them
+		auto const& placeholders = ent->getVisualPlaceholders();
+		if (!placeholders.empty()) {
+			m_droppedPrepares.insert(m_droppedPrepares.end(),
+					placeholders.begin(), placeholders.end());
+			if (!ent->m_ownedVisuals.empty()) {
+				RemovedVisuals removed;
+				removed.Pending = placeholders;
+				removed.Visuals = std::move(ent->m_ownedVisuals);
+				m_removedVisuals.push_back(std::move(removed));
+			}
+		}
+		m_spatialIndex.removeEntity(ent);
+		ent->detach();
+
+		auto unbound = std::find(m_unboundEntities.begin(),
+				m_unboundEntities.end(), ent);
+		if (unbound != m_unboundEntities.end()) {
+			m_unboundEntities.erase(unbound);
+		}
+
+		// fill the gap with the last entity
+		const auto position = m_records[handle.Index].Position;
+		uniq<Entity> owned = std::move(m_entities[position]);
+		if (position != m_entities.size() - 1) {
+			m_entities[position] = std::move(m_entities.back());
+			m_records[m_entities[position]->m_handle.Index].Position = position;
+		}
+		m_entities.pop_back();
+
+		auto & record = m_records[handle.Index];
+		record.Ent = nullptr;
+		record.Generation++;
+		record.RemovalPending = false;
+		m_freeRecords.push_back(handle.Index);
+
+		// destroys the aspects, which unsubscribe from all signals
+		owned.reset();
+	}
+	m_pendingRemovals.clear();
+}
+
 void EntityEngine::extractVisualData(VisualDataExtractContainer & ex) {
-	for (auto & e : getEntities()) {
+	m_components.extractVisualData(ex);
+
+	// the entities which are not bound to the storage append their entries
+	// on every extraction
+	const auto storedEntries = ex.MeshVisuals.size() + ex.ParticleSystems.size();
+	for (auto e : m_unboundEntities) {
 		e->extractData(ex);
 	}
+	ex.ChangedEntries += ex.MeshVisuals.size() + ex.ParticleSystems.size()
+			- storedEntries;
 }
 
 void EntityEngine::step(float deltaTime) {
+	// keep the state before this step for the render interpolation
+	m_components.storePreviousState();
+	for (auto e : m_unboundEntities) {
+		e->storePreviousState();
+	}
+	// entities moved outside of the step are queried at their new position
+	m_spatialIndex.update(m_components);
+
 	OnTimeStep.signal(deltaTime);
+	ParallelTimeStep.run(deltaTime, m_jobs, m_components);
+
+	flushRemovals();
+	// queries between the steps see the positions after this step
+	m_spatialIndex.update(m_components);
 }
 
 void EntityEngine::updateVisuals(
 		std::vector<RendererVisualChange> const& prepList) {
-	// an update does not happen often, mostly when files are changed
-	for (auto & e : getEntities()) {
-		e->updateVisuals(prepList);
+	for (auto const& vc : prepList) {
+		if (vc.EventType
+				== RendererVisualChange::EventTypeEnum::ShaderProgramReload) {
+			for (auto v : m_visualIndex.getVisualsWithShader(
+					vc.ShaderProgramName)) {
+				v->update(vc);
+			}
+		}
 	}
 }
 
 void EntityEngine::updatePreparedVisuals(
-		RenderEngine::PrepareVisualList prepList) {
-	// todo: could be optimized by having a list of visuals which still needs prepared visuals
+		RenderEngine::PrepareVisualList const& prepList) {
+	for (auto const& prepared : prepList) {
+		auto entity = m_visualIndex.takePlaceholder(prepared.first);
+		if (entity) {
+			entity->addPreparedVisual(prepared.first, prepared.second);
+			continue;
+		}
 
-	for (auto & e : getEntities()) {
-		e->updatePreparedVisuals(prepList);
+		// the entity has been removed, destroy its visuals once none of them
+		// is being prepared anymore
+		for (auto it = m_removedVisuals.begin(); it != m_removedVisuals.end();
+				it++) {
+			auto & pending = it->Pending;
+			auto itId = std::find(pending.begin(), pending.end(),
+					prepared.first);
+			if (itId != pending.end()) {
+				pending.erase(itId);
+				if (pending.empty()) {
+					m_removedVisuals.erase(it);
+				}
+				break;
+			}
+		}
 	}
 }
 
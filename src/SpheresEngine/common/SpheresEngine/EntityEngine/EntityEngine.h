@@ -4,8 +4,10 @@
 #include <memory>
 
 #include <boost/noncopyable.hpp>
+#include <SpheresEngine/EntityEngine/AspectScheduler.h>
 #include <SpheresEngine/EntityEngine/Entity.h>
 #include <SpheresEngine/EntityEngine/EntityList.h>
+#include <SpheresEngine/EntityEngine/SpatialIndex.h>
 #include <SpheresEngine/Signals.h>
 #include <SpheresEngine/Util.h>
 
@@ -18,27 +20,60 @@ class RenderEngine;
  * entity are executed each time step and ensures the visual updates are properly propagated
  * to entity visuals.
  * Furthermore, it extracts the visual data for rendering from all added entities.
+ *
+ * Entities are removed at the end of the time step in which the removal was
+ * requested, so aspects can remove entities (including their own) while the
+ * step is executed.
  */
 class EntityEngine final : boost::noncopyable {
 public:
 
 	/**
-	 * Add a new entity to be managed by this engine
+	 * Add a new entity to be managed by this engine. The returned handle can
+	 * be used to remove the entity and stays safe to use after the removal.
+	 * The managedList is not updated when the entity is removed.
 	 */
-	void addEntity(uniq<Entity> ent,
-			EntityList * managedList = nullptr) {
-		if (managedList) {
-			managedList->push_back(ent.get());
-		}
+	EntityHandle addEntity(uniq<Entity> ent,
+			EntityList * managedList = nullptr);
 
-		//todo: register with physics engine
+	/**
+	 * Request the removal of an entity. The entity is detached and destroyed
+	 * at the end of the current time step, or with the next call to
+	 * flushRemovals(). Handles of already removed entities are ignored.
+	 */
+	void removeEntity(EntityHandle handle);
 
+	/**
+	 * Detach and destroy all entities whose removal was requested. Called at
+	 * the end of each time step.
+	 */
+	void flushRemovals();
 
-		m_entities.push_back(std::move(ent));
+	/**
+	 * Return the entity referenced by the handle, or nullptr if the entity
+	 * has been removed
+	 */
+	Entity * getEntity(EntityHandle handle) const {
+		if (handle.Index >= m_records.size()) {
+			return nullptr;
+		}
+		auto const& record = m_records[handle.Index];
+		return (record.Generation == handle.Generation) ? record.Ent : nullptr;
 	}
 
 	/**
-	 * Get the const list of all added entities
+	 * Return the prepare ids of the visuals of removed entities, these
+	 * visuals do not need to be prepared anymore. The list is cleared.
+	 */
+	std::vector<PrepareVisualId> popDroppedPrepares() {
+		std::vector<PrepareVisualId> dropped;
+		dropped.swap(m_droppedPrepares);
+		return dropped;
+	}
+
+	/**
+	 * Get the const list of all added entities. The order of the entities
+	 * changes when entities are removed.
 	 */
 	EntityListUniq const& getEntities() const {
 		return m_entities;
@@ -51,6 +86,28 @@ public:
 		return m_entities;
 	}
 
+	/**
+	 * Get the dense storage of the entity components
+	 */
+	ComponentStorage const& getComponents() const {
+		return m_components;
+	}
+
+	/**
+	 * Get the index to find the entities near a position. Only entities
+	 * bound to the component storage are indexed.
+	 */
+	SpatialIndex const& getSpatialIndex() const {
+		return m_spatialIndex;
+	}
+
+	/**
+	 * Get the index of the placeholders and visuals of all added entities
+	 */
+	VisualIndex const& getVisualIndex() const {
+		return m_visualIndex;
+	}
+
 	/**
 	 * execute one time step on this engine
 	 * @param deltaTime the passed time since the last call to step()
@@ -59,9 +116,10 @@ public:
 
 	/**
 	 * Propagate the prepared visuals to the entities which hold handles
-	 * to visual ids
+	 * to visual ids. Visuals of removed entities are destroyed if the
+	 * entity owned them.
 	 */
-	void updatePreparedVisuals(RenderEngine::PrepareVisualList prepList);
+	void updatePreparedVisuals(RenderEngine::PrepareVisualList const& prepList);
 
 	/**
 	 * Update the data within one visual. This can be used to write back data
@@ -70,24 +128,145 @@ public:
 	void updateVisuals(std::vector<RendererVisualChange> const& prepList);
 
 	/**
-	 * Extract the render data of the visual of all added entities
+	 * Extract the render data of the visual of all added entities. If the
+	 * container is not cleared before, only the entries which changed since
+	 * it was filled the last time are rewritten.
 	 */
 	void extractVisualData(VisualDataExtractContainer & ex);
 
 	/**
 	 * This signal is called every simulation time step. This slot can be used
-	 * by aspects who need to execute code on every time step.
+	 * by aspects who need to execute code on every time step. Aspects which
+	 * are added to many entities should subscribe a member function with
+	 * subscribeBatched(), so all of them are called in one loop.
 	 */
 
 	typedef slots::Slot<float> OnTimeStep_slot;
 
 	OnTimeStep_slot OnTimeStep;
 
+	/**
+	 * Time step functions of aspects which declared the data they access.
+	 * They are executed after the subscribers of OnTimeStep, the ones which
+	 * do not conflict in parallel on the job system set with setJobSystem().
+	 */
+	AspectScheduler ParallelTimeStep;
+
+	/**
+	 * Set the job system used to execute the functions of ParallelTimeStep,
+	 * nullptr to execute them on the calling thread
+	 */
+	void setJobSystem(JobSystem * jobs) {
+		m_jobs = jobs;
+	}
+
+	/**
+	 * This signal is called for each removed entity right before it is
+	 * detached and destroyed. Can be used to unregister the entity from other
+	 * engines.
+	 */
+	typedef slots::Slot<Entity *> OnEntityRemoved_slot;
+
+	OnEntityRemoved_slot OnEntityRemoved;
+
 private:
 
+	/**
+	 * Entry of the handle table
+	 */
+	struct EntityRecord {
+		/**
+		 * The entity, nullptr if the record is free
+		 */
+		Entity * Ent = nullptr;
+
+		/**
+		 * Incremented each time the entity of this record is removed
+		 */
+		uint32_t Generation = 1;
+
+		/**
+		 * Index of the entity in m_entities
+		 */
+		size_t Position = 0;
+
+		/**
+		 * True if the entity is in the list of pending removals
+		 */
+		bool RemovalPending = false;
+	};
+
+	/**
+	 * Owned visuals of removed entities which are still being prepared by
+	 * the render engine. They are destroyed once all of them came back.
+	 */
+	struct RemovedVisuals {
+		/**
+		 * Prepare ids which did not come back yet
+		 */
+		std::vector<PrepareVisualId> Pending;
+
+		/**
+		 * The visuals owned by the removed entity
+		 */
+		std::vector<uniq<VisualAbstract>> Visuals;
+	};
+
+	/**
+	 * Handle table, indexed by EntityHandle::Index
+	 */
+	std::vector<EntityRecord> m_records;
+
+	/**
+	 * Indices of the free records in m_records
+	 */
+	std::vector<uint32_t> m_freeRecords;
+
+	/**
+	 * Entities whose removal has been requested
+	 */
+	std::vector<EntityHandle> m_pendingRemovals;
+
+	/**
+	 * Prepare ids of the visuals of removed entities which were still being
+	 * prepared, see popDroppedPrepares()
+	 */
+	std::vector<PrepareVisualId> m_droppedPrepares;
+
+	/**
+	 * Visuals of removed entities waiting for their preparation to finish
+	 */
+	std::vector<RemovedVisuals> m_removedVisuals;
+
 	/**
 	 * List of all entities added to this engine
 	 */
 	EntityListUniq m_entities;
+
+	/**
+	 * Entities which did not bind to the component storage and need to be
+	 * extracted with their virtual methods
+	 */
+	EntityList m_unboundEntities;
+
+	/**
+	 * Positions, rotations and visuals of all bound entities
+	 */
+	ComponentStorage m_components;
+
+	/**
+	 * Positions of all bound entities for proximity queries
+	 */
+	SpatialIndex m_spatialIndex;
+
+	/**
+	 * Job system to execute ParallelTimeStep, not owned
+	 */
+	JobSystem * m_jobs = nullptr;
+
+	/**
+	 * Finds the entities and visuals affected by changes of the render thread
+	 */
+	VisualIndex m_visualIndex;
 };
 
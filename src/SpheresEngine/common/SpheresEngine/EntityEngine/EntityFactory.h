@@ -56,12 +56,14 @@ public:
 		auto entity = std14::make_unique<TEntity>();
 
 		for (auto meshConf : meshConfigs) {
-			auto mesh_visual = new MeshVisual(meshConf.MeshFileName,
-					meshConf.TextureName);
+			auto mesh_visual = std14::make_unique<MeshVisual>(
+					meshConf.MeshFileName, meshConf.TextureName);
 			mesh_visual->getData().Visible = true;
-			auto prepId_mesh = m_engines.render.addToPrepareVisual(mesh_visual);
+			auto prepId_mesh = m_engines.render.addToPrepareVisual(
+					mesh_visual.get());
 
 			entity->addVisualPlaceholder(prepId_mesh);
+			entity->takeVisualOwnership(std::move(mesh_visual));
 		}
 
 		if (collisionShape.isValid()) {
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+/**
+ * Reference to an entity added to the EntityEngine which can be kept after
+ * the entity has been removed. The EntityEngine reuses the record of a removed
+ * entity for new entities and increments its generation, so resolving an
+ * outdated handle returns nullptr instead of a different entity.
+ */
+struct EntityHandle {
+	/**
+	 * Marks a handle which does not reference any entity
+	 */
+	static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+	/**
+	 * Index of the entity record in the EntityEngine
+	 */
+	uint32_t Index = InvalidIndex;
+
+	/**
+	 * Generation of the record when the entity was added
+	 */
+	uint32_t Generation = 0;
+
+	/**
+	 * Returns true if this handle has been assigned to an entity, the entity
+	 * might have been removed in the meantime
+	 */
+	bool isAssigned() const {
+		return Index != InvalidIndex;
+	}
+
+	/**
+	 * Two handles are equal if they reference the same entity
+	 */
+	bool operator==(EntityHandle const& other) const {
+		return (Index == other.Index) && (Generation == other.Generation);
+	}
+
+	/**
+	 * Two handles are different if they reference different entities
+	 */
+	bool operator!=(EntityHandle const& other) const {
+		return !(*this == other);
+	}
+};
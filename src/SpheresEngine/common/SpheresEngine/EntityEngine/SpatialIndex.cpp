@@ -0,0 +1,80 @@
+#include <SpheresEngine/EntityEngine/SpatialIndex.h>
+
+#include <SpheresEngine/EntityEngine/Entity.h>
+
+constexpr float SpatialIndex::DefaultCellSize;
+
+namespace {
+
+/**
+ * Slots found by a query before they are translated to entities. One list
+ * per thread, so aspects running in parallel can query at the same time.
+ */
+std::vector<SpatialHashGrid::Id> & querySlots() {
+	static thread_local std::vector<SpatialHashGrid::Id> slots;
+	slots.clear();
+	return slots;
+}
+
+}
+
+void SpatialIndex::addEntity(Entity * ent) {
+	auto storage = ent->getComponents();
+	if (!storage) {
+		return;
+	}
+	const auto slot = ent->getComponentSlot();
+	if (slot >= m_entities.size()) {
+		m_entities.resize(slot + 1, nullptr);
+	}
+	m_entities[slot] = ent;
+	m_grid.insert(slot, storage->getPosition(slot));
+}
+
+void SpatialIndex::removeEntity(Entity * ent) {
+	if (!ent->getComponents()) {
+		return;
+	}
+	const auto slot = ent->getComponentSlot();
+	m_entities[slot] = nullptr;
+	m_grid.remove(slot);
+}
+
+void SpatialIndex::update(ComponentStorage & storage) {
+	for (auto slot : storage.getSpatialChanges()) {
+		// slots released since they moved are not indexed anymore
+		if ((slot < m_entities.size()) && m_entities[slot]) {
+			m_grid.insert(slot, storage.getPosition(slot));
+		}
+	}
+	storage.clearSpatialChanges();
+}
+
+void SpatialIndex::queryRadius(Vector3 const& center, float radius,
+		std::vector<Entity *> & result) const {
+	auto & slots = querySlots();
+	m_grid.queryRadius(center, radius, slots);
+	appendEntities(slots, result);
+}
+
+void SpatialIndex::queryBox(Vector3 const& min, Vector3 const& max,
+		std::vector<Entity *> & result) const {
+	auto & slots = querySlots();
+	m_grid.queryBox(min, max, slots);
+	appendEntities(slots, result);
+}
+
+void SpatialIndex::queryNearest(Vector3 const& center, size_t count,
+		std::vector<Entity *> & result) const {
+	auto & slots = querySlots();
+	m_grid.queryNearest(center, count, slots);
+	appendEntities(slots, result);
+}
+
+void SpatialIndex::appendEntities(
+		std::vector<SpatialHashGrid::Id> const& slots,
+		std::vector<Entity *> & result) const {
+	for (auto slot : slots) {
+		result.push_back(m_entities[slot]);
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <SpheresEngine/DataTypes/SpatialHashGrid.h>
+#include <SpheresEngine/EntityEngine/ComponentStorage.h>
+#include <SpheresEngine/VectorTypes.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+class Entity;
+
+/**
+ * Finds the entities near a position. The index holds the position of each
+ * entity bound to the ComponentStorage in a SpatialHashGrid, keyed by the
+ * component slot. Entities which are not bound to the storage, like the
+ * camera, are not indexed.
+ *
+ * Moved entities are put into their new cell by update(), which the
+ * EntityEngine calls at the beginning and the end of each time step. During
+ * the step the queries use the positions of the step's beginning, so the
+ * results do not depend on the order in which aspects move their entities.
+ * As nothing is changed during the step, aspects running in parallel can
+ * query the index at the same time.
+ */
+class SpatialIndex: boost::noncopyable {
+public:
+
+	/**
+	 * Edge length of the grid cells, in the range of typical query radii
+	 */
+	static constexpr float DefaultCellSize = 4.0f;
+
+	/**
+	 * Create an empty index
+	 */
+	explicit SpatialIndex(float cellSize = DefaultCellSize) :
+			m_grid(cellSize) {
+	}
+
+	/**
+	 * Add an entity which is bound to the storage, with its current
+	 * position. Unbound entities are ignored.
+	 */
+	void addEntity(Entity * ent);
+
+	/**
+	 * Remove an entity before it is detached from the storage
+	 */
+	void removeEntity(Entity * ent);
+
+	/**
+	 * Move the entities whose slots moved since the last update into their
+	 * new cells
+	 */
+	void update(ComponentStorage & storage);
+
+	/**
+	 * Append all entities within the radius around the center
+	 */
+	void queryRadius(Vector3 const& center, float radius,
+			std::vector<Entity *> & result) const;
+
+	/**
+	 * Append all entities within the axis-aligned box
+	 */
+	void queryBox(Vector3 const& min, Vector3 const& max,
+			std::vector<Entity *> & result) const;
+
+	/**
+	 * Append the count entities closest to the center, ordered by their
+	 * distance
+	 */
+	void queryNearest(Vector3 const& center, size_t count,
+			std::vector<Entity *> & result) const;
+
+	/**
+	 * Number of indexed entities
+	 */
+	size_t size() const {
+		return m_grid.size();
+	}
+
+	/**
+	 * The grid holding the positions, its ids are the component slots. Can be
+	 * used to query the slots directly, for example to read the positions
+	 * from the storage without touching the entities.
+	 */
+	SpatialHashGrid const& getGrid() const {
+		return m_grid;
+	}
+
+	/**
+	 * The entity bound to a slot of the grid
+	 */
+	Entity * getEntity(ComponentSlot slot) const {
+		return m_entities[slot];
+	}
+
+private:
+
+	/**
+	 * Append the entities of the slots found by a query
+	 */
+	void appendEntities(std::vector<SpatialHashGrid::Id> const& slots,
+			std::vector<Entity *> & result) const;
+
+	/**
+	 * Positions of the indexed entities
+	 */
+	SpatialHashGrid m_grid;
+
+	/**
+	 * The indexed entity of each slot, nullptr for released slots
+	 */
+	std::vector<Entity *> m_entities;
+};
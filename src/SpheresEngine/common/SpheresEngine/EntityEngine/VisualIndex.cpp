@@ -0,0 +1,43 @@
+#include <SpheresEngine/EntityEngine/VisualIndex.h>
+
+#include <algorithm>
+
+void VisualIndex::addPlaceholder(PrepareVisualId id, Entity * entity) {
+	m_placeholders[id] = entity;
+}
+
+Entity * VisualIndex::takePlaceholder(PrepareVisualId id) {
+	auto it = m_placeholders.find(id);
+	if (it == m_placeholders.end()) {
+		return nullptr;
+	}
+	auto entity = it->second;
+	m_placeholders.erase(it);
+	return entity;
+}
+
+void VisualIndex::addVisual(VisualAbstract * visual) {
+	const auto shaderName = visual->getShaderProgramName();
+	if (!shaderName.empty()) {
+		m_shaderVisuals[shaderName].push_back(visual);
+	}
+}
+
+void VisualIndex::removeVisual(VisualAbstract * visual) {
+	auto it = m_shaderVisuals.find(visual->getShaderProgramName());
+	if (it == m_shaderVisuals.end()) {
+		return;
+	}
+	auto & visuals = it->second;
+	visuals.erase(std::remove(visuals.begin(), visuals.end(), visual),
+			visuals.end());
+}
+
+std::vector<VisualAbstract *> const& VisualIndex::getVisualsWithShader(
+		std::string const& shaderProgramName) const {
+	auto it = m_shaderVisuals.find(shaderProgramName);
+	if (it == m_shaderVisuals.end()) {
+		return m_noVisuals;
+	}
+	return it->second;
+}
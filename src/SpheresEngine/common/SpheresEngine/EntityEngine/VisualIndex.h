@@ -0,0 +1,79 @@
+#pragma once
+
+#include <SpheresEngine/Visuals/VisualBase.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Entity;
+
+/**
+ * Lookup tables which connect the changes reported by the render thread with
+ * the entities and visuals they affect. Without them, every prepared visual
+ * and every shader reload would have to be checked against all entities.
+ */
+class VisualIndex: boost::noncopyable {
+public:
+
+	/**
+	 * Remember which entity waits for the visual with the prepare id
+	 */
+	void addPlaceholder(PrepareVisualId id, Entity * entity);
+
+	/**
+	 * Return the entity waiting for the visual with the prepare id and remove
+	 * the entry. Returns nullptr if no entity waits for this id.
+	 */
+	Entity * takePlaceholder(PrepareVisualId id);
+
+	/**
+	 * Forget the entity waiting for the prepare id
+	 */
+	void removePlaceholder(PrepareVisualId id) {
+		m_placeholders.erase(id);
+	}
+
+	/**
+	 * Number of prepare ids entities are waiting for
+	 */
+	size_t getPlaceholderCount() const {
+		return m_placeholders.size();
+	}
+
+	/**
+	 * Index a visual by the name of its shader program. Visuals without a
+	 * shader program are not indexed.
+	 */
+	void addVisual(VisualAbstract * visual);
+
+	/**
+	 * Remove a visual from the index
+	 */
+	void removeVisual(VisualAbstract * visual);
+
+	/**
+	 * All indexed visuals which used the shader program when they were added
+	 */
+	std::vector<VisualAbstract *> const& getVisualsWithShader(
+			std::string const& shaderProgramName) const;
+
+private:
+
+	/**
+	 * The entity waiting for each prepare id
+	 */
+	std::unordered_map<PrepareVisualId, Entity *> m_placeholders;
+
+	/**
+	 * Visuals grouped by the name of their shader program
+	 */
+	std::unordered_map<std::string, std::vector<VisualAbstract *>> m_shaderVisuals;
+
+	/**
+	 * Returned for shader programs no visual uses
+	 */
+	const std::vector<VisualAbstract *> m_noVisuals;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+/**
+ * Accumulator which converts the passed wall time into a number of logic
+ * steps with a fixed duration.
+ *
+ * The time which does not fill a complete step is kept for the next call and
+ * its fraction of one step is available as interpolation factor to blend
+ * between the last two logic states. If the logic can not keep up, at most
+ * maxStepsPerAdvance steps are computed for one call and the remaining time
+ * is dropped, so a slow logic step does not cause more and more steps to be
+ * computed (spiral of death).
+ */
+class FixedTimestep {
+public:
+
+	/**
+	 * Create the accumulator
+	 * @param stepRate number of logic steps per second
+	 * @param maxStepsPerAdvance the maximum number of steps to catch up in one call
+	 */
+	FixedTimestep(float stepRate, size_t maxStepsPerAdvance = 5) :
+			m_stepDuration(1.0f / stepRate), m_maxStepsPerAdvance(
+					maxStepsPerAdvance) {
+		assert(stepRate > 0.0f);
+		assert(maxStepsPerAdvance > 0);
+	}
+
+	/**
+	 * Add the passed wall time in seconds and return the number of steps
+	 * which need to be computed now
+	 */
+	size_t advance(float passedTime) {
+		m_accumulator += passedTime;
+
+		size_t steps = 0;
+		while (m_accumulator >= m_stepDuration) {
+			m_accumulator -= m_stepDuration;
+			steps++;
+		}
+
+		if (steps > m_maxStepsPerAdvance) {
+			m_droppedSteps += steps - m_maxStepsPerAdvance;
+			steps = m_maxStepsPerAdvance;
+		}
+
+		return steps;
+	}
+
+	/**
+	 * Duration of one logic step in seconds
+	 */
+	float getStepDuration() const {
+		return m_stepDuration;
+	}
+
+	/**
+	 * The fraction of one step which has passed since the last step, in
+	 * the range [0,1)
+	 */
+	float getInterpolation() const {
+		return m_accumulator / m_stepDuration;
+	}
+
+	/**
+	 * Number of steps which have been dropped in total because the logic
+	 * did not keep up
+	 */
+	size_t getDroppedSteps() const {
+		return m_droppedSteps;
+	}
+
+private:
+
+	/**
+	 * Duration of one logic step in seconds
+	 */
+	const float m_stepDuration;
+
+	/**
+	 * Maximum number of steps to be computed within one call to advance()
+	 */
+	const size_t m_maxStepsPerAdvance;
+
+	/**
+	 * Passed time which has not been used by a step yet
+	 */
+	float m_accumulator = 0.0f;
+
+	/**
+	 * Number of steps dropped in total
+	 */
+	size_t m_droppedSteps = 0;
+};
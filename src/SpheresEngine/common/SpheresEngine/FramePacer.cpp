@@ -0,0 +1,101 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#if defined(__unix__)
+#include <time.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+/**
+ * Lower bound of the spin window, even a perfect sleep needs some spinning
+ * to hit the deadline precisely
+ */
+const std::chrono::microseconds MinimumSpinWindow(50);
+
+/**
+ * Upper bound of the spin window, to not burn a complete frame spinning on
+ * a heavily loaded system
+ */
+const std::chrono::microseconds MaximumSpinWindow(2000);
+
+/**
+ * Sleep until the absolute point in time
+ */
+void sleepUntil(FramePacer::Clock::time_point target) {
+#if defined(__unix__) && defined(TIMER_ABSTIME)
+	// steady_clock is implemented with CLOCK_MONOTONIC on Linux and Android,
+	// sleeping until an absolute time of this clock does not accumulate
+	// the delays of interrupted or late wake-ups
+	const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			target.time_since_epoch()).count();
+	timespec ts;
+	ts.tv_sec = nanos / 1000000000;
+	ts.tv_nsec = nanos % 1000000000;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+	}
+#else
+	std::this_thread::sleep_until(target);
+#endif
+}
+
+}
+
+FramePacer::FramePacer(float period) :
+		m_period(
+				std::chrono::duration_cast<Clock::duration>(
+						std::chrono::duration<float>(period))), m_spinWindow(
+				MinimumSpinWindow) {
+	assert(period > 0.0f);
+	start();
+}
+
+void FramePacer::start() {
+	m_deadline = Clock::now();
+	m_frameStart = m_deadline;
+}
+
+float FramePacer::waitForNextFrame() {
+	m_deadline += m_period;
+
+	auto now = Clock::now();
+	const auto sleepTarget = m_deadline - m_spinWindow;
+	if (now < sleepTarget) {
+		sleepUntil(sleepTarget);
+		now = Clock::now();
+		calibrate(now - sleepTarget);
+	}
+	while (now < m_deadline) {
+		now = Clock::now();
+	}
+
+	const auto lateness = now - m_deadline;
+	m_statistics.add(std::chrono::duration<float>(lateness).count());
+
+	// don't run a burst of frames to catch up if we fell behind too far
+	if (lateness > m_period) {
+		m_deadline = now;
+	}
+
+	const float passed =
+			std::chrono::duration<float>(now - m_frameStart).count();
+	m_frameStart = now;
+	return passed;
+}
+
+void FramePacer::calibrate(Clock::duration oversleep) {
+	const float nanos = float(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(oversleep).count());
+	m_averageOversleep = 0.9f * m_averageOversleep + 0.1f * std::max(nanos, 0.0f);
+
+	// spin long enough to cover most of the wake-up jitter, not only its average
+	const auto window = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::nanoseconds(long(2.0f * m_averageOversleep)));
+	m_spinWindow = std::min<Clock::duration>(
+			std::max<Clock::duration>(window, MinimumSpinWindow),
+			MaximumSpinWindow);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <SpheresEngine/Performance/PacingStatistics.h>
+
+#include <boost/noncopyable.hpp>
+#include <chrono>
+
+/**
+ * Runs a loop with a fixed period and precise start times.
+ *
+ * The deadline of each frame is computed from the deadline of the previous
+ * frame (next = previous + period), so the time needed by the loop body and
+ * inaccurate wake-ups do not add up to a drift. To reach the deadline
+ * precisely, the thread sleeps until shortly before the deadline and spins
+ * the remaining time. The spin window is calibrated from the observed
+ * oversleeping of the operating system.
+ *
+ * If the loop falls behind by more than one period, the deadlines are
+ * resynchronized to the current time instead of running a burst of frames
+ * to catch up.
+ */
+class FramePacer: boost::noncopyable {
+public:
+
+	/**
+	 * Clock used for all deadlines
+	 */
+	typedef std::chrono::steady_clock Clock;
+
+	/**
+	 * Create the pacer
+	 * @param period duration of one frame in seconds
+	 */
+	FramePacer(float period);
+
+	/**
+	 * Start the schedule, the first deadline is one period after this call
+	 */
+	void start();
+
+	/**
+	 * Wait until the deadline of the next frame and return the time in
+	 * seconds which has passed since the previous frame started
+	 */
+	float waitForNextFrame();
+
+	/**
+	 * Duration of one frame in seconds
+	 */
+	float getPeriod() const {
+		return std::chrono::duration<float>(m_period).count();
+	}
+
+	/**
+	 * The time before a deadline which is spent spinning instead of sleeping
+	 */
+	Clock::duration getSpinWindow() const {
+		return m_spinWindow;
+	}
+
+	/**
+	 * Histogram of the pacing errors of all frames so far
+	 */
+	PacingStatistics const& getStatistics() const {
+		return m_statistics;
+	}
+
+private:
+
+	/**
+	 * Adapt the spin window to the time the last sleep overshot its target
+	 */
+	void calibrate(Clock::duration oversleep);
+
+	/**
+	 * Duration of one frame
+	 */
+	Clock::duration m_period;
+
+	/**
+	 * The deadline of the last frame
+	 */
+	Clock::time_point m_deadline;
+
+	/**
+	 * The time the last frame actually started
+	 */
+	Clock::time_point m_frameStart;
+
+	/**
+	 * Time before the deadline which is spent spinning
+	 */
+	Clock::duration m_spinWindow;
+
+	/**
+	 * Moving average of the oversleeping in nanoseconds
+	 */
+	float m_averageOversleep = 0.0f;
+
+	/**
+	 * Pacing errors of all frames
+	 */
+	PacingStatistics m_statistics;
+};
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <SpheresEngine/InputEngine/UserId.h>
+#include <SpheresEngine/Log.h>
 
-#include <vector>
+#include <array>
+#include <cstddef>
 
 /**
  * An input which has been transformed into an action which
@@ -12,6 +14,13 @@
 class InputAction {
 public:
 
+	/**
+	 * Maximum number of users one action can be related to. The users are
+	 * stored within the action, so creating an action in the FrameArena of the
+	 * InputEngine does not allocate
+	 */
+	static constexpr size_t MaxUsers = 4;
+
 	/**
 	 * virtual dtor to support overriding
 	 */
@@ -21,7 +30,20 @@ public:
 	 * add a user which is related to this input action
 	 */
 	void addUser(UserId id) {
-		m_users.push_back(id);
+		if (m_userCount == MaxUsers) {
+			logging::Error() << "InputAction already has " << m_userCount
+					<< " users, ignoring additional user";
+			return;
+		}
+		m_users[m_userCount] = id;
+		m_userCount++;
+	}
+
+	/**
+	 * Returns the number of users related to this input action
+	 */
+	size_t getUserCount() const {
+		return m_userCount;
 	}
 
 	/**
@@ -42,7 +64,12 @@ private:
 	/*
 	 * the user or users which this action is related to
 	 */
-	std::vector<UserId> m_users;
+	std::array<UserId, MaxUsers> m_users;
+
+	/*
+	 * Number of entries used in m_users
+	 */
+	size_t m_userCount = 0;
 
 	/*
 	 * Store is the action has been handlend by any aspect
@@ -1,20 +1,20 @@
 #include "InputEngine.h"
 
 void InputEngine::process() {
-	std::vector < std::pair<UserId, Input> > allInputs;
+	// the list keeps its capacity, so reading the input does not allocate
+	m_inputs.clear();
 
 	for (auto & source : m_sources) {
 		if (!source->isEnabled()) {
 			source->enableSource();
 		}
 
-		auto input = source->readInput();
-		allInputs.insert(allInputs.end(), input.begin(), input.end());
+		source->readInput(m_inputs);
 	}
 
-	for (auto & input : allInputs) {
+	for (auto const& input : m_inputs) {
 		for (auto & trans : m_transformers) {
-			auto inpAction = trans->transform(input.second);
+			auto inpAction = trans->transform(input.second, m_frameArena);
 			// can also be nullptr if there is no useful transform
 			if (inpAction) {
 				inpAction->addUser(input.first);
@@ -4,6 +4,7 @@
 #include <SpheresEngine/InputEngine/Input.h>
 #include <SpheresEngine/InputEngine/InputTransformer.h>
 #include <SpheresEngine/InputEngine/InputSource.h>
+#include <SpheresEngine/DataTypes/FrameArena.h>
 #include <SpheresEngine/Signals.h>
 #include <SpheresEngine/Util.h>
 
@@ -20,9 +21,10 @@ class InputEngine {
 public:
 
 	/**
-	 * typedef to store owning of input actions
+	 * typedef to store owning of input actions, the actions themselves are
+	 * stored in the frame arena of this engine
 	 */
-	typedef std::vector<uniq<InputAction>> InputActionList;
+	typedef std::vector<ArenaPtr<InputAction>> InputActionList;
 
 	/**
 	 * add a new input source to retrieve user input from.
@@ -54,10 +56,21 @@ public:
 	}
 
 	/**
-	 * clear the list of input actions that have been buffered
+	 * clear the list of input actions that have been buffered and reset the
+	 * frame arena
 	 */
 	void clearInputActions() {
 		m_inputActions.clear();
+		m_frameArena.reset();
+	}
+
+	/**
+	 * Arena for transient objects which only live until the next call to
+	 * clearInputActions(), like the input actions of one tick. Objects
+	 * created in the arena must be destroyed before that call
+	 */
+	FrameArena & getFrameArena() {
+		return m_frameArena;
 	}
 
 	/**
@@ -77,9 +90,21 @@ private:
 	 */
 	std::vector<uniq<InputTransformer>> m_transformers;
 
+	/**
+	 * Holds the input actions and other transient objects of one tick,
+	 * declared before m_inputActions so it is destroyed after the actions
+	 */
+	FrameArena m_frameArena;
+
 	/**
 	 * The input actions which have been generated by the transformers since the
 	 * last call to clearInputActions()
 	 */
 	InputActionList m_inputActions;
+
+	/**
+	 * The inputs read from all sources during the last call to process(),
+	 * kept as member to reuse its memory
+	 */
+	std::vector<InputSource::UserInputPair> m_inputs;
 };
@@ -2,6 +2,9 @@
 
 #include <SpheresEngine/InputEngine/Input.h>
 
+#include <utility>
+#include <vector>
+
 /**
  * Base class to implement an Input source for various input hardware (mouse, magic
  * wand etc.)
@@ -22,10 +25,10 @@ public:
 	/**
 	 * Needs to be implemented by inheriting classes to
 	 * provided the input read out from the hardware
-	 * @return a list of user and input pairs read out from
-	 * 		   the hardware
+	 * @param inputs the user and input pairs read out from the hardware
+	 * 		   are appended to this list, which is reused by the caller
 	 */
-	virtual std::vector<UserInputPair> readInput() = 0;
+	virtual void readInput(std::vector<UserInputPair> & inputs) = 0;
 
 	/**
 	 * Will be called before the first readInput call
@@ -2,9 +2,7 @@
 
 #include <SpheresEngine/InputEngine/Input.h>
 #include <SpheresEngine/InputEngine/InputAction.h>
-#include <SpheresEngine/Util.h>
-
-#include <memory>
+#include <SpheresEngine/DataTypes/FrameArena.h>
 
 /**
  * Base class to implement a hardware-dependent Input (for example mouse movement)
@@ -20,8 +18,11 @@ public:
 
 	/**
 	 * This method needs to be overwritten by actual implementations
-	 * and returns the generated input action from one input.
+	 * and returns the generated input action from one input. The action is
+	 * created in the arena, which is reset by the InputEngine once the actions
+	 * of the tick have been cleared.
 	 */
-	virtual uniq<InputAction> transform(Input ip) = 0;
+	virtual ArenaPtr<InputAction> transform(Input const& ip,
+			FrameArena & arena) = 0;
 
 };
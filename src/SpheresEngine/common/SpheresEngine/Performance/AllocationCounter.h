@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Counts the heap allocations done by each thread.
+ *
+ * The counter is only incremented if the global operator new replacement in
+ * AllocationCounterHook.cpp has been compiled into the executable. Otherwise all
+ * counts will stay zero.
+ */
+class AllocationCounter {
+public:
+
+	/**
+	 * Called by the operator new replacement for every allocation done by the
+	 * current thread
+	 */
+	static void countAllocation() {
+		threadCounter()++;
+	}
+
+	/**
+	 * Return the number of heap allocations the calling thread has done so far.
+	 * To get the allocations done by a code section, compute the difference
+	 * of this value before and after the section.
+	 */
+	static size_t threadAllocations() {
+		return threadCounter();
+	}
+
+private:
+
+	/**
+	 * Storage of the per-thread counter
+	 */
+	static size_t & threadCounter() {
+		static thread_local size_t counter = 0;
+		return counter;
+	}
+};
@@ -0,0 +1,43 @@
+#include <SpheresEngine/Performance/AllocationCounter.h>
+
+#include <cstdlib>
+#include <new>
+
+/**
+ * Replaces the global operator new and delete to count all heap allocations
+ * with the AllocationCounter.
+ *
+ * This file is not part of the engine library, it must be added to the
+ * sources of each executable which counts allocations. Defining the operators
+ * in their own compilation unit keeps the compiler from inlining them into
+ * the callers.
+ */
+
+void * operator new(std::size_t size) {
+	AllocationCounter::countAllocation();
+	void * p = std::malloc(size == 0 ? 1 : size);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void * operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+
+void operator delete(void * p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void * p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void * p, std::size_t) noexcept {
+	std::free(p);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+namespace util {
+
+/**
+ * Quote a string for JSON output. Quotes, backslashes and all control
+ * characters are escaped, so the result is always a valid JSON string.
+ */
+inline std::string quoteJson(std::string const& s) {
+	const char hexDigits[] = "0123456789abcdef";
+
+	std::string quoted = "\"";
+	quoted.reserve(s.size() + 2);
+	for (char c : s) {
+		switch (c) {
+		case '"':
+			quoted += "\\\"";
+			break;
+		case '\\':
+			quoted += "\\\\";
+			break;
+		case '\b':
+			quoted += "\\b";
+			break;
+		case '\f':
+			quoted += "\\f";
+			break;
+		case '\n':
+			quoted += "\\n";
+			break;
+		case '\r':
+			quoted += "\\r";
+			break;
+		case '\t':
+			quoted += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				quoted += "\\u00";
+				quoted += hexDigits[(c >> 4) & 0xf];
+				quoted += hexDigits[c & 0xf];
+			} else {
+				quoted += c;
+			}
+		}
+	}
+	return quoted + "\"";
+}
+
+}
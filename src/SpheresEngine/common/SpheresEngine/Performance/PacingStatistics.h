@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+/**
+ * Histogram of the pacing error of a frame loop, the time by which a frame
+ * started later than its scheduled deadline.
+ *
+ * The buckets are fixed, so adding a sample never allocates memory and can
+ * be done for every frame. Percentiles are reported as the upper bound of the
+ * bucket which contains them.
+ */
+class PacingStatistics {
+public:
+
+	/**
+	 * Number of histogram buckets, the last one collects all samples above
+	 * the largest bucket bound
+	 */
+	static constexpr size_t BucketCount = 10;
+
+	/**
+	 * Add the pacing error of one frame in seconds
+	 */
+	void add(float errorSeconds) {
+		const float error = (errorSeconds > 0.0f) ? errorSeconds : 0.0f;
+		size_t bucket = 0;
+		while ((bucket < BucketCount - 1) && (error > getBucketBound(bucket))) {
+			bucket++;
+		}
+		m_buckets[bucket]++;
+		m_count++;
+		m_sum += error;
+		if (error > m_max) {
+			m_max = error;
+		}
+	}
+
+	/**
+	 * Remove all samples
+	 */
+	void clear() {
+		*this = PacingStatistics();
+	}
+
+	/**
+	 * Number of samples added
+	 */
+	size_t getCount() const {
+		return m_count;
+	}
+
+	/**
+	 * Mean pacing error in seconds
+	 */
+	float getMean() const {
+		return (m_count == 0) ? 0.0f : float(m_sum / double(m_count));
+	}
+
+	/**
+	 * Largest pacing error in seconds
+	 */
+	float getMax() const {
+		return m_max;
+	}
+
+	/**
+	 * Number of samples in one bucket
+	 */
+	size_t getBucket(size_t bucket) const {
+		return m_buckets[bucket];
+	}
+
+	/**
+	 * Upper bound of a bucket in seconds. The last bucket has no upper bound
+	 * and returns the largest error seen.
+	 */
+	float getBucketBound(size_t bucket) const {
+		static const std::array<float, BucketCount - 1> bounds = { { 10e-6f,
+				25e-6f, 50e-6f, 100e-6f, 250e-6f, 500e-6f, 1e-3f, 2e-3f, 5e-3f } };
+		return (bucket < bounds.size()) ? bounds[bucket] : m_max;
+	}
+
+	/**
+	 * Returns the pacing error in seconds which is not exceeded by the
+	 * given fraction (0.0 to 1.0) of all frames
+	 */
+	float getPercentile(float fraction) const {
+		if (m_count == 0) {
+			return 0.0f;
+		}
+		// rank of the sample, with some slack for the float precision of fraction
+		const size_t rank = std::max<size_t>(1,
+				size_t(std::ceil(double(fraction) * double(m_count) - 1.0e-3)));
+		size_t cumulated = 0;
+		for (size_t bucket = 0; bucket < BucketCount; bucket++) {
+			cumulated += m_buckets[bucket];
+			if (cumulated >= rank) {
+				// a bucket bound can never be larger than the largest sample
+				return (getBucketBound(bucket) < m_max) ?
+						getBucketBound(bucket) : m_max;
+			}
+		}
+		return m_max;
+	}
+
+	/**
+	 * Format the statistics and the histogram into a human readable,
+	 * multi-line string. All times are given in microseconds.
+	 */
+	std::string toString() const {
+		std::stringstream sout;
+		sout << "frames " << m_count << " mean " << toMicro(getMean())
+				<< " us p50 " << toMicro(getPercentile(0.5f)) << " us p99 "
+				<< toMicro(getPercentile(0.99f)) << " us max "
+				<< toMicro(getMax()) << " us";
+		for (size_t bucket = 0; bucket < BucketCount; bucket++) {
+			sout << std::endl;
+			if (bucket < BucketCount - 1) {
+				sout << "  <= " << toMicro(getBucketBound(bucket)) << " us: ";
+			} else {
+				sout << "   > " << toMicro(getBucketBound(bucket - 1)) << " us: ";
+			}
+			sout << m_buckets[bucket];
+		}
+		return sout.str();
+	}
+
+private:
+
+	/**
+	 * Convert seconds to rounded microseconds for the output
+	 */
+	static long toMicro(float seconds) {
+		return long(seconds * 1.0e6f + 0.5f);
+	}
+
+	/**
+	 * Number of samples in each bucket
+	 */
+	std::array<size_t, BucketCount> m_buckets { { } };
+
+	/**
+	 * Total number of samples
+	 */
+	size_t m_count = 0;
+
+	/**
+	 * Sum of all samples in seconds
+	 */
+	double m_sum = 0.0;
+
+	/**
+	 * Largest sample in seconds
+	 */
+	float m_max = 0.0f;
+};
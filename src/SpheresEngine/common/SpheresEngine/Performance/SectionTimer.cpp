@@ -1,30 +1,282 @@
 #include <SpheresEngine/Performance/SectionTimer.h>
+#include <SpheresEngine/Performance/JsonQuote.h>
 
 SectionRepo GlobalTimingRepo::Rep;
 
 #ifdef DESCENT_PROFILE
 
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
-void SectionRepo::storeResult(std::string const& name, Duration dr) {
-	m_durations[name].push( dr );
+namespace {
+
+/**
+ * Hands out a unique number for each SectionRepo instance, starting at 1
+ * because 0 marks an empty thread cache
+ */
+uint64_t nextRepoInstance() {
+	static std::atomic<uint64_t> instances(0);
+	return ++instances;
+}
+
+}
+
+constexpr size_t SectionThreadLog::Capacity;
+constexpr size_t SectionThreadLog::MaxSections;
+constexpr const char * SectionRepo::OverflowSectionName;
+
+SectionThreadLog::SectionThreadLog(std::thread::id threadId, size_t number) :
+		m_events(new SectionEvent[Capacity]), m_threadId(threadId), m_number(
+				number) {
+}
+
+std::vector<SectionEvent> SectionThreadLog::snapshot() const {
+	const auto written = m_written.load(std::memory_order_acquire);
+	auto begin = m_clearedAt.load(std::memory_order_acquire);
+	if (written > Capacity) {
+		begin = std::max<uint64_t>(begin, written - Capacity);
+	}
+
+	std::vector<SectionEvent> events;
+	events.reserve(written - begin);
+	for (auto i = begin; i < written; i++) {
+		events.push_back(m_events[i % Capacity]);
+	}
+
+	// the owning thread might have overwritten the oldest events while they
+	// were copied, including the slot of the event which is written right now
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const auto writtenAfter = m_written.load(std::memory_order_relaxed);
+	if (writtenAfter + 1 > Capacity + begin) {
+		const auto overwritten = std::min<uint64_t>(events.size(),
+				writtenAfter + 1 - Capacity - begin);
+		events.erase(events.begin(), events.begin() + overwritten);
+	}
+	return events;
+}
+
+SectionRepo::SectionRepo() :
+		m_instance(nextRepoInstance()) {
+}
+
+SectionRepo::~SectionRepo() {
+	// the cache of the destroying thread would otherwise point to a dangling
+	// log, the caches of other threads are ignored due to the instance number
+	auto & cache = threadCache();
+	if (cache.Instance == m_instance) {
+		cache = ThreadCache();
+	}
+}
+
+SectionId SectionRepo::intern(std::string const& name) {
+	std::lock_guard<std::mutex> lock(m_access);
+	auto it = m_ids.find(name);
+	if (it != m_ids.end()) {
+		return it->second;
+	}
+
+	// the last id is shared by all names which do not fit anymore
+	const auto overflowId = SectionId(SectionThreadLog::MaxSections - 1);
+	if (m_names.size() >= overflowId) {
+		logging::Error() << "Cannot intern section " << name << ", only "
+				<< overflowId << " sections are supported, it is timed as "
+				<< OverflowSectionName;
+		if (m_names.size() == overflowId) {
+			m_names.push_back(OverflowSectionName);
+		}
+		m_ids[name] = overflowId;
+		return overflowId;
+	}
+	const auto id = SectionId(m_names.size());
+	m_names.push_back(name);
+	m_ids[name] = id;
+	return id;
+}
+
+std::string SectionRepo::sectionName(SectionId id) const {
+	std::lock_guard<std::mutex> lock(m_access);
+	return m_names.at(id);
+}
+
+void SectionRepo::setThreadName(std::string const& name) {
+	const auto number = threadLog().getNumber();
+	std::lock_guard<std::mutex> lock(m_access);
+	m_threadNames[number] = name;
+}
+
+SectionThreadLog & SectionRepo::registerThread() {
+	std::lock_guard<std::mutex> lock(m_access);
+	const auto threadId = std::this_thread::get_id();
+	auto it = std::find_if(m_logs.begin(), m_logs.end(),
+			[threadId] (std::unique_ptr<SectionThreadLog> const& log) {
+				return log->getThreadId() == threadId;
+			});
+
+	SectionThreadLog * log;
+	if (it != m_logs.end()) {
+		log = it->get();
+	} else {
+		m_logs.emplace_back(new SectionThreadLog(threadId, m_logs.size() + 1));
+		log = m_logs.back().get();
+	}
+
+	auto & cache = threadCache();
+	cache.Instance = m_instance;
+	cache.Log = log;
+	return *log;
+}
+
+std::vector<std::pair<size_t, std::vector<SectionEvent>>> SectionRepo::snapshots() const {
+	std::vector<std::pair<size_t, std::vector<SectionEvent>>> result;
+	for (auto const& log : m_logs) {
+		result.emplace_back(log->getNumber(), log->snapshot());
+	}
+	return result;
+}
+
+void SectionRepo::setWarmupSamples(size_t samples) {
+	std::lock_guard<std::mutex> lock(m_access);
+	m_warmupSamples = samples;
+}
+
+std::vector<SectionStatistics> SectionRepo::statistics() const {
+	std::lock_guard<std::mutex> lock(m_access);
+
+	// durations of each section in microseconds, the index is the section id
+	std::vector<std::vector<float>> durations(m_names.size());
+	for (auto const& thread : snapshots()) {
+		for (auto const& event : thread.second) {
+			if (event.Occurrence >= m_warmupSamples) {
+				durations[event.Id].push_back(float(event.Duration) * 1.0e-3f);
+			}
+		}
+	}
+
+	std::vector<SectionStatistics> result;
+	for (size_t id = 0; id < durations.size(); id++) {
+		auto & sorted = durations[id];
+		if (sorted.empty()) {
+			continue;
+		}
+		std::sort(sorted.begin(), sorted.end());
+
+		double sum = 0.0;
+		for (auto d : sorted) {
+			sum += d;
+		}
+
+		// nearest-rank percentile
+		auto percentile = [&sorted] (float fraction) {
+			const size_t rank = size_t(std::ceil(fraction * sorted.size()));
+			return sorted[std::max<size_t>(rank, 1) - 1];
+		};
+
+		SectionStatistics stats;
+		stats.Name = m_names[id];
+		stats.Count = sorted.size();
+		stats.Min = sorted.front();
+		stats.Mean = float(sum / double(sorted.size()));
+		stats.P50 = percentile(0.5f);
+		stats.P99 = percentile(0.99f);
+		stats.Max = sorted.back();
+		result.push_back(stats);
+	}
+
+	std::sort(result.begin(), result.end(),
+			[] (SectionStatistics const& a, SectionStatistics const& b) {
+				return a.Name < b.Name;
+			});
+	return result;
+}
+
+std::string SectionRepo::chromeTrace() const {
+	std::lock_guard<std::mutex> lock(m_access);
+	const auto threads = snapshots();
+
+	// timestamps are written relative to the first event
+	int64_t origin = 0;
+	bool hasOrigin = false;
+	for (auto const& thread : threads) {
+		for (auto const& event : thread.second) {
+			if (!hasOrigin || (event.Start < origin)) {
+				origin = event.Start;
+				hasOrigin = true;
+			}
+		}
+	}
+
+	std::stringstream sout;
+	sout << std::fixed << std::setprecision(3);
+	sout << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	auto separator = [&first, &sout] () {
+		sout << (first ? "\n" : ",\n");
+		first = false;
+	};
+
+	for (auto const& thread : threads) {
+		auto name = m_threadNames.find(thread.first);
+		if (name != m_threadNames.end()) {
+			separator();
+			sout << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+					<< thread.first << ",\"args\":{\"name\":"
+					<< util::quoteJson(name->second) << "}}";
+		}
+		for (auto const& event : thread.second) {
+			separator();
+			// complete events, the trace viewers derive the nesting from the
+			// start and duration
+			sout << "{\"name\":" << util::quoteJson(m_names[event.Id])
+					<< ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.first
+					<< ",\"ts\":" << double(event.Start - origin) * 1.0e-3
+					<< ",\"dur\":" << double(event.Duration) * 1.0e-3
+					<< ",\"args\":{\"depth\":" << event.Depth << "}}";
+		}
+	}
+	sout << "\n]}\n";
+	return sout.str();
+}
+
+bool SectionRepo::writeChromeTrace(std::string const& filename) const {
+	std::ofstream ofs(filename, std::ofstream::out | std::ofstream::trunc);
+	if (!ofs) {
+		logging::Error() << "Cannot open file " << filename << " to write the trace";
+		return false;
+	}
+	ofs << chromeTrace();
+	return bool(ofs);
 }
 
 void SectionRepo::report() {
+	std::lock_guard<std::mutex> lock(m_access);
+
+	// most recent event of each section, the index is the section id
+	std::vector<SectionEvent> last(m_names.size());
+	std::vector<bool> hasLast(m_names.size(), false);
+	for (auto const& thread : snapshots()) {
+		for (auto const& event : thread.second) {
+			last[event.Id] = event;
+			hasLast[event.Id] = true;
+		}
+	}
+
+	// nested sections are already contained in their parent
 	size_t overallMs = 0;
-	for (auto const& it : m_durations) {
-		if ( it.second.hasEntries()) {
-			overallMs += it.second.last().count();
+	for (size_t id = 0; id < last.size(); id++) {
+		if (hasLast[id] && (last[id].Depth == 0)) {
+			overallMs += size_t(last[id].Duration / 1000);
 		}
 	}
 
-	for (auto const& it : m_durations) {
-		if ( it.second.hasEntries()) {
-			const float ratioOfAll = float(it.second.last().count()) / float(overallMs);
-			logging::Info() << std::setprecision(2) << "Comp: " << it.first << "\t\t" << ratioOfAll
-			<< " :: " << it.second.last().count();
+	for (size_t id = 0; id < last.size(); id++) {
+		if (hasLast[id]) {
+			const float ratioOfAll = float(last[id].Duration / 1000) / float(overallMs);
+			logging::Info() << std::setprecision(2) << "Comp: " << m_names[id] << "\t\t" << ratioOfAll
+			<< " :: " << last[id].Duration / 1000;
 		}
 	}
 
@@ -38,16 +290,24 @@ void SectionRepo::clearFile( std::string const& filename) {
 }
 
 void SectionRepo::dumpFile( std::string const& filename) {
+	std::lock_guard<std::mutex> lock(m_access);
 	std::ofstream ofs (filename, std::ofstream::out | std::ofstream::app);
 	if (!ofs) {
 		logging::Error() << "Cannot open file " << filename << " to dump performance data";
 		return;
 	}
-	for (auto const& it : m_durations) {
-		ofs << it.first;
-		for (int i = -it.second.size()+1; i <= 0; i++ ) {
-			// 0 gives the most recent added , -n the n-th recent
-			ofs << ":" << it.second.get(i).count();
+
+	// durations of each section in microseconds, the index is the section id
+	std::vector<std::vector<int64_t>> durations(m_names.size());
+	for (auto const& thread : snapshots()) {
+		for (auto const& event : thread.second) {
+			durations[event.Id].push_back(event.Duration / 1000);
+		}
+	}
+	for (size_t id = 0; id < durations.size(); id++) {
+		ofs << m_names[id];
+		for (auto d : durations[id]) {
+			ofs << ":" << d;
 		}
 		ofs << std::endl;
 	}
@@ -55,7 +315,10 @@ void SectionRepo::dumpFile( std::string const& filename) {
 }
 
 void SectionRepo::clear() {
-	m_durations.clear();
+	std::lock_guard<std::mutex> lock(m_access);
+	for (auto & log : m_logs) {
+		log->clear();
+	}
 }
 
 #endif
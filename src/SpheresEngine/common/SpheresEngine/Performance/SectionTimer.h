@@ -1,23 +1,321 @@
 #pragma once
 
-#include <unordered_map>
 #include <boost/noncopyable.hpp>
-#include <SpheresEngine/DataTypes/RingBuffer.h>
 #include <SpheresEngine/Log.h>
+#include <SpheresEngine/Performance/BranchPredict.h>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Summary of all durations measured for one section, all times are
+ * given in microseconds
+ */
+struct SectionStatistics {
+	/**
+	 * Name of the section
+	 */
+	std::string Name;
+
+	/**
+	 * Number of durations the statistics are computed from
+	 */
+	size_t Count = 0;
+
+	/**
+	 * Shortest duration
+	 */
+	float Min = 0.0f;
+
+	/**
+	 * Mean duration
+	 */
+	float Mean = 0.0f;
+
+	/**
+	 * Median duration
+	 */
+	float P50 = 0.0f;
+
+	/**
+	 * Duration which is not exceeded by 99 percent of the measurements
+	 */
+	float P99 = 0.0f;
+
+	/**
+	 * Longest duration
+	 */
+	float Max = 0.0f;
+};
+
+/**
+ * Id of an interned section name. The name is interned once and the id is
+ * kept in a static, so timing a section never needs to copy or hash its name:
+ *
+ * static const auto section = GlobalTimingRepo::Rep.intern("physics");
+ * SectionTimer tm(GlobalTimingRepo::Rep, section);
+ */
+typedef uint16_t SectionId;
 
 #ifdef DESCENT_PROFILE
-// todo: average of the last n measurements
+
+/**
+ * One measured execution of a section
+ */
+struct SectionEvent {
+	/**
+	 * Start time in nanoseconds of the steady clock
+	 */
+	int64_t Start;
+
+	/**
+	 * Duration in nanoseconds
+	 */
+	int64_t Duration;
+
+	/**
+	 * How often this section was executed by the thread before
+	 */
+	uint32_t Occurrence;
+
+	/**
+	 * The section which was executed
+	 */
+	SectionId Id;
+
+	/**
+	 * Number of sections which were open on the thread when this section
+	 * started
+	 */
+	uint16_t Depth;
+};
+
+/**
+ * Ring buffer of the section events recorded by one thread.
+ *
+ * Only the owning thread writes to the log, so recording an event needs no
+ * lock. Other threads can copy the events at any time, events which are
+ * overwritten while copying are dropped from the copy.
+ */
+class SectionThreadLog: boost::noncopyable {
+public:
+
+	/**
+	 * Number of events kept per thread, the oldest events are overwritten
+	 */
+	static constexpr size_t Capacity = 64 * 1024;
+
+	/**
+	 * Maximum number of distinct section names
+	 */
+	static constexpr size_t MaxSections = 1024;
+
+	/**
+	 * Create the log for a thread, the number is used to identify the thread
+	 * in the trace output
+	 */
+	SectionThreadLog(std::thread::id threadId, size_t number);
+
+	/**
+	 * Mark the start of a section and return the nesting depth of the section
+	 */
+	uint16_t enter() {
+		return m_depth++;
+	}
+
+	/**
+	 * Mark the end of a section
+	 */
+	void leave() {
+		m_depth--;
+	}
+
+	/**
+	 * Current nesting depth of the sections
+	 */
+	uint16_t getDepth() const {
+		return m_depth;
+	}
+
+	/**
+	 * Add one event, may only be called by the owning thread
+	 */
+	void record(SectionId id, uint16_t depth, int64_t start, int64_t duration) {
+		const auto index = m_written.load(std::memory_order_relaxed);
+		auto & event = m_events[index % Capacity];
+		event.Start = start;
+		event.Duration = duration;
+		event.Occurrence = m_occurrences[id]++;
+		event.Id = id;
+		event.Depth = depth;
+		m_written.store(index + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Copy all events recorded since the last clear which have not been
+	 * overwritten yet, the oldest event first
+	 */
+	std::vector<SectionEvent> snapshot() const;
+
+	/**
+	 * Drop all events recorded so far. The occurrence count of the sections
+	 * is kept, so cleared warm-up events are not counted twice.
+	 */
+	void clear() {
+		m_clearedAt.store(m_written.load(std::memory_order_acquire),
+				std::memory_order_release);
+	}
+
+	/**
+	 * Id of the thread writing to this log
+	 */
+	std::thread::id getThreadId() const {
+		return m_threadId;
+	}
+
+	/**
+	 * Number which identifies this thread in the trace output
+	 */
+	size_t getNumber() const {
+		return m_number;
+	}
+
+private:
+
+	/**
+	 * Ring buffer storage of the events
+	 */
+	std::unique_ptr<SectionEvent[]> m_events;
+
+	/**
+	 * Number of events written since the log was created
+	 */
+	std::atomic<uint64_t> m_written { 0 };
+
+	/**
+	 * Value of m_written when the log was cleared the last time
+	 */
+	std::atomic<uint64_t> m_clearedAt { 0 };
+
+	/**
+	 * Number of executions of each section on this thread
+	 */
+	std::array<uint32_t, MaxSections> m_occurrences { { } };
+
+	/**
+	 * Current nesting depth
+	 */
+	uint16_t m_depth = 0;
+
+	/**
+	 * Id of the writing thread
+	 */
+	std::thread::id m_threadId;
+
+	/**
+	 * Number of the thread in the trace output
+	 */
+	size_t m_number;
+};
+
+/**
+ * Collects the section timings of all threads.
+ *
+ * Each thread records into its own SectionThreadLog, so timing a section
+ * does neither lock nor allocate. Only the first section timed by a thread
+ * and the evaluation methods lock the repository.
+ */
 class SectionRepo: boost::noncopyable {
 public:
-	// store up to 1k performance entries
-	typedef std::chrono::microseconds Duration;
-	typedef RingBuffer<Duration, 10000> Durations;
+	/**
+	 * Clock used for all section timings
+	 */
+	typedef std::chrono::steady_clock Clock;
 
-	void storeResult(std::string const& name, Duration dr);
+	/**
+	 * Resolution of the stored durations
+	 */
+	typedef std::chrono::nanoseconds Duration;
+
+	SectionRepo();
+
+	~SectionRepo();
+
+	/**
+	 * Name of the section shared by all names interned after
+	 * SectionThreadLog::MaxSections - 1 names
+	 */
+	static constexpr const char * OverflowSectionName = "<overflow>";
+
+	/**
+	 * Return the id of a section name, the same name always gets the same id
+	 */
+	SectionId intern(std::string const& name);
+
+	/**
+	 * Return the name of an interned section
+	 */
+	std::string sectionName(SectionId id) const;
+
+	/**
+	 * Name the calling thread in the trace output
+	 */
+	void setThreadName(std::string const& name);
+
+	/**
+	 * Log of the calling thread, created when the thread times its first
+	 * section
+	 */
+	SectionThreadLog & threadLog() {
+		auto & cache = threadCache();
+		if (GCC_LIKELY(cache.Instance == m_instance)) {
+			return *cache.Log;
+		}
+		return registerThread();
+	}
+
+	/**
+	 * Store a duration measured by the calling thread
+	 */
+	void storeResult(SectionId id, Clock::time_point start, Duration duration) {
+		auto & log = threadLog();
+		log.record(id, log.getDepth(), start.time_since_epoch().count(),
+				duration.count());
+	}
 
 	void report();
 
+	/**
+	 * The first samples durations of each section on each thread are not
+	 * included in the statistics, so the start-up of the program does not
+	 * distort the results
+	 */
+	void setWarmupSamples(size_t samples);
+
+	/**
+	 * Compute the statistics of all sections, sorted by section name
+	 */
+	std::vector<SectionStatistics> statistics() const;
+
+	/**
+	 * Format all recorded events as Chrome trace event JSON, which can be
+	 * loaded into chrome://tracing or the Perfetto UI
+	 */
+	std::string chromeTrace() const;
+
+	/**
+	 * Write the Chrome trace event JSON to a file. Returns false if the file
+	 * could not be written.
+	 */
+	bool writeChromeTrace(std::string const& filename) const;
+
 	void clearFile( std::string const& filename);
 
 	void dumpFile( std::string const& filename);
@@ -25,27 +323,112 @@ public:
 	void clear();
 
 private:
-	std::unordered_map<std::string, Durations> m_durations;
+
+	/**
+	 * The thread log last used by a thread
+	 */
+	struct ThreadCache {
+		/**
+		 * Instance number of the repository the log belongs to
+		 */
+		uint64_t Instance = 0;
+
+		/**
+		 * The log of the thread in this repository
+		 */
+		SectionThreadLog * Log = nullptr;
+	};
+
+	/**
+	 * Storage of the per-thread cache
+	 */
+	static ThreadCache & threadCache() {
+		static thread_local ThreadCache cache;
+		return cache;
+	}
+
+	/**
+	 * Find or create the log of the calling thread and update its cache
+	 */
+	SectionThreadLog & registerThread();
+
+	/**
+	 * Copy the events of all threads, the thread number is stored alongside
+	 */
+	std::vector<std::pair<size_t, std::vector<SectionEvent>>> snapshots() const;
+
+	/**
+	 * Unique number of this repository, so the thread caches never confuse
+	 * the logs of a destroyed repository with a new one
+	 */
+	const uint64_t m_instance;
+
+	/**
+	 * Protects the section names and the list of thread logs
+	 */
+	mutable std::mutex m_access;
+
+	/**
+	 * Number of samples of each section which are not part of the statistics
+	 */
+	size_t m_warmupSamples = 0;
+
+	/**
+	 * Interned section names, the index is the section id
+	 */
+	std::vector<std::string> m_names;
+
+	/**
+	 * Lookup of the section ids by name
+	 */
+	std::unordered_map<std::string, SectionId> m_ids;
+
+	/**
+	 * Logs of all threads which timed a section
+	 */
+	std::vector<std::unique_ptr<SectionThreadLog>> m_logs;
+
+	/**
+	 * Thread names by thread number
+	 */
+	std::unordered_map<size_t, std::string> m_threadNames;
 };
 
+/**
+ * Measures the time from construction to destruction and stores it as one
+ * event of a section. Timers can be nested.
+ */
 class SectionTimer: boost::noncopyable {
 public:
+	/**
+	 * Start timing an interned section
+	 */
+	SectionTimer(SectionRepo & rep, SectionId section) :
+			m_log(rep.threadLog()), m_section(section), m_depth(m_log.enter()), m_startTime(
+					SectionRepo::Clock::now()) {
+	}
+
+	/**
+	 * Start timing a section by name. The name needs to be interned on each
+	 * call, so prefer the constructor with an interned section id.
+	 */
 	SectionTimer(SectionRepo & rep, std::string const& sectionName) :
-	m_repo(rep), m_sectionName(sectionName) {
-		m_startTime = std::chrono::high_resolution_clock::now();
+			SectionTimer(rep, rep.intern(sectionName)) {
 	}
 
 	~SectionTimer() {
-		auto endTime = std::chrono::high_resolution_clock::now();
-		m_repo.storeResult(m_sectionName,
-				std::chrono::duration_cast < std::chrono::microseconds > (endTime - m_startTime));
+		const auto endTime = SectionRepo::Clock::now();
+		m_log.leave();
+		m_log.record(m_section, m_depth,
+				m_startTime.time_since_epoch().count(),
+				(endTime - m_startTime).count());
 	}
 
 private:
-	SectionRepo & m_repo;
-	std::string m_sectionName;
-	std::chrono::high_resolution_clock::time_point m_startTime;
-
+	SectionThreadLog & m_log;
+	const SectionId m_section;
+	const uint16_t m_depth;
+	SectionRepo::Clock::time_point m_startTime;
 };
 
 #else
@@ -56,6 +439,19 @@ private:
  */
 class SectionRepo: boost::noncopyable {
 public:
+	/**
+	 * all sections share the same id
+	 */
+	SectionId intern(std::string const&) {
+		return 0;
+	}
+
+	/**
+	 * do nothing
+	 */
+	void setThreadName(std::string const&) {
+	}
+
 	/**
 	 * do nothing
 	 */
@@ -76,6 +472,28 @@ public:
 
 	}
 
+	/**
+	 * do nothing
+	 */
+	void setWarmupSamples(size_t) {
+
+	}
+
+	/**
+	 * No statistics available
+	 */
+	std::vector<SectionStatistics> statistics() const {
+		return {};
+	}
+
+	/**
+	 * No trace available
+	 */
+	bool writeChromeTrace(std::string const&) const {
+		logging::Error() << "Profiling is not enabled in this build, no trace written";
+		return false;
+	}
+
 	/**
 	 * do nothing
 	 */
@@ -90,6 +508,12 @@ public:
  */
 class SectionTimer: boost::noncopyable {
 public:
+	/**
+	 * do nothing
+	 */
+	SectionTimer(SectionRepo &, SectionId) {
+	}
+
 	/**
 	 * do nothing
 	 */
@@ -11,6 +11,12 @@ PhysicsEngine::PhysicsEngine() {
 			m_overlapPair.get(), m_solver.get(), m_collisionConfig.get());
 }
 
+PhysicsEngine::~PhysicsEngine() {
+	for (auto & body : m_bodies) {
+		m_world->removeRigidBody(body.second.Body.get());
+	}
+}
+
 void PhysicsEngine::addEntity(Entity * et) {
 	// ensure this entity supports either physics or collisions
 	CollisionMixin * cmixin = dynamic_cast<CollisionMixin*>(et);
@@ -20,10 +26,9 @@ void PhysicsEngine::addEntity(Entity * et) {
 	}
 
 	if (cmixin->getShapeSource() == CollisionMixin::ShapeSource::Box) {
-		btCollisionShape* shape = new btBoxShape(
+		PhysicsBody pb;
+		pb.Shape = std14::make_unique<btBoxShape>(
 				BulletUtil::toBullet(cmixin->getBoxSize()));
-		// todo: make sure the collision shape is stored and cleaned up later
-		//collisionShapes.push_back(groundShape);
 
 		btTransform groundTransform;
 		groundTransform.setIdentity();
@@ -34,14 +39,15 @@ void PhysicsEngine::addEntity(Entity * et) {
 		btVector3 localInertia(0, 0, 0);
 
 		//using motionstate is optional, it provides interpolation capabilities, and only synchronizes 'active' objects
-		btDefaultMotionState* myMotionState = new btDefaultMotionState(
+		pb.MotionState = std14::make_unique<btDefaultMotionState>(
 				groundTransform);
-		btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, myMotionState,
-				shape, localInertia);
-		btRigidBody* body = new btRigidBody(rbInfo);
+		btRigidBody::btRigidBodyConstructionInfo rbInfo(mass,
+				pb.MotionState.get(), pb.Shape.get(), localInertia);
+		pb.Body = std14::make_unique<btRigidBody>(rbInfo);
 
 		//add the body to the dynamics world
-		m_world->addRigidBody(body);
+		m_world->addRigidBody(pb.Body.get());
+		m_bodies[et] = std::move(pb);
 
 		logging::Info() << "PhysicsEntity of shape box registered";
 	} else {
@@ -49,3 +55,12 @@ void PhysicsEngine::addEntity(Entity * et) {
 	}
 
 }
+
+void PhysicsEngine::removeEntity(Entity * et) {
+	auto it = m_bodies.find(et);
+	if (it == m_bodies.end()) {
+		return;
+	}
+	m_world->removeRigidBody(it->second.Body.get());
+	m_bodies.erase(it);
+}
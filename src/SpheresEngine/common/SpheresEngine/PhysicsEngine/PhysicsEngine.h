@@ -5,6 +5,7 @@
 #include <btBulletDynamicsCommon.h>
 
 #include <memory>
+#include <unordered_map>
 
 class BulletUtil {
 public:
@@ -31,6 +32,11 @@ public:
 
 	explicit PhysicsEngine();
 
+	/**
+	 * Removes all bodies from the world before it is destroyed
+	 */
+	~PhysicsEngine();
+
 	/**
 	 * not implemented atm.
 	 */
@@ -42,8 +48,41 @@ public:
 	 */
 	void addEntity(Entity * et);
 
+	/**
+	 * Remove the body of an entity from the simulation. Entities which have
+	 * not been added are ignored.
+	 */
+	void removeEntity(Entity * et);
+
+	/**
+	 * Number of entities in the simulation
+	 */
+	size_t getEntityCount() const {
+		return m_bodies.size();
+	}
+
 private:
 
+	/**
+	 * The bullet objects created for one entity
+	 */
+	struct PhysicsBody {
+		/**
+		 * Collision shape of the body
+		 */
+		std::unique_ptr<btCollisionShape> Shape;
+
+		/**
+		 * Motion state of the body
+		 */
+		std::unique_ptr<btDefaultMotionState> MotionState;
+
+		/**
+		 * The rigid body added to the world
+		 */
+		std::unique_ptr<btRigidBody> Body;
+	};
+
 	// the order of the following members is important so the bullet objects
 	// are destroyed reverse order of dependency
 	std::unique_ptr<btDiscreteDynamicsWorld> m_world;
@@ -51,4 +90,9 @@ private:
 	std::unique_ptr<btDbvtBroadphase> m_overlapPair;
 	std::unique_ptr<btCollisionDispatcher> m_dispatcher;
 	std::unique_ptr<btDefaultCollisionConfiguration> m_collisionConfig;
+
+	/**
+	 * Bodies of all entities in the simulation
+	 */
+	std::unordered_map<Entity *, PhysicsBody> m_bodies;
 };
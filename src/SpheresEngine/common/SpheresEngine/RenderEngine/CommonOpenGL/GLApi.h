@@ -0,0 +1,505 @@
+#pragma once
+
+#include <SpheresEngine/RenderEngine/OpenGLInclude.h>
+
+/**
+ * Interface to all OpenGL calls issued by the platform-independent render
+ * code (renderers, targets, textures and the shader and mesh backends).
+ *
+ * The calls are dispatched via the GLApi which is current on the calling
+ * thread, see GLSupport::api(). By default, this forwards to the OpenGL
+ * driver, but a render backend can make its own implementation current,
+ * for example to record the calls without a GPU.
+ */
+class GLApi {
+public:
+
+	/**
+	 * support dtor overwrite by inherited classes
+	 */
+	virtual ~GLApi() = default;
+
+	/** see glUseProgram */
+	virtual void useProgram(GLuint program) = 0;
+
+	/** see glActiveTexture */
+	virtual void activeTexture(GLenum texture) = 0;
+
+	/** see glGenTextures */
+	virtual void genTextures(GLsizei n, GLuint * textures) = 0;
+
+	/** see glBindTexture */
+	virtual void bindTexture(GLenum target, GLuint texture) = 0;
+
+	/** see glTexParameteri */
+	virtual void texParameteri(GLenum target, GLenum pname, GLint param) = 0;
+
+	/** see glTexImage2D */
+	virtual void texImage2D(GLenum target, GLint level, GLint internalFormat,
+			GLsizei width, GLsizei height, GLint border, GLenum format,
+			GLenum type, const GLvoid * data) = 0;
+
+	/** see glGenBuffers */
+	virtual void genBuffers(GLsizei n, GLuint * buffers) = 0;
+
+	/** see glDeleteBuffers */
+	virtual void deleteBuffers(GLsizei n, const GLuint * buffers) = 0;
+
+	/** see glBindBuffer */
+	virtual void bindBuffer(GLenum target, GLuint buffer) = 0;
+
+	/** see glBufferData */
+	virtual void bufferData(GLenum target, GLsizeiptr size,
+			const GLvoid * data, GLenum usage) = 0;
+
+	/** see glBufferSubData */
+	virtual void bufferSubData(GLenum target, GLintptr offset,
+			GLsizeiptr size, const GLvoid * data) = 0;
+
+	/** see glCopyBufferSubData */
+	virtual void copyBufferSubData(GLenum readTarget, GLenum writeTarget,
+			GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) = 0;
+
+	/** see glBindBufferBase */
+	virtual void bindBufferBase(GLenum target, GLuint index,
+			GLuint buffer) = 0;
+
+	/** see glMapBufferRange */
+	virtual GLvoid * mapBufferRange(GLenum target, GLintptr offset,
+			GLsizeiptr length, GLbitfield access) = 0;
+
+	/** see glUnmapBuffer */
+	virtual GLboolean unmapBuffer(GLenum target) = 0;
+
+	/** see glFenceSync, returns 0 if fences are not supported */
+	virtual GLsync fenceSync(GLenum condition, GLbitfield flags) = 0;
+
+	/** see glClientWaitSync */
+	virtual GLenum clientWaitSync(GLsync sync, GLbitfield flags,
+			GLuint64 timeout) = 0;
+
+	/** see glDeleteSync */
+	virtual void deleteSync(GLsync sync) = 0;
+
+	/** see glGenVertexArrays */
+	virtual void genVertexArrays(GLsizei n, GLuint * arrays) = 0;
+
+	/** see glBindVertexArray */
+	virtual void bindVertexArray(GLuint array) = 0;
+
+	/** see glEnableVertexAttribArray */
+	virtual void enableVertexAttribArray(GLuint index) = 0;
+
+	/** see glDisableVertexAttribArray */
+	virtual void disableVertexAttribArray(GLuint index) = 0;
+
+	/** see glVertexAttribPointer */
+	virtual void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+			GLboolean normalized, GLsizei stride, const GLvoid * pointer) = 0;
+
+	/** see glVertexAttribDivisor */
+	virtual void vertexAttribDivisor(GLuint index, GLuint divisor) = 0;
+
+	/** see glDrawArrays */
+	virtual void drawArrays(GLenum mode, GLint first, GLsizei count) = 0;
+
+	/** see glDrawArraysInstanced */
+	virtual void drawArraysInstanced(GLenum mode, GLint first, GLsizei count,
+			GLsizei instanceCount) = 0;
+
+	/** see glEnable */
+	virtual void enable(GLenum cap) = 0;
+
+	/** see glDisable */
+	virtual void disable(GLenum cap) = 0;
+
+	/** see glBeginTransformFeedback */
+	virtual void beginTransformFeedback(GLenum primitiveMode) = 0;
+
+	/** see glEndTransformFeedback */
+	virtual void endTransformFeedback() = 0;
+
+	/** see glClear */
+	virtual void clear(GLbitfield mask) = 0;
+
+	/** see glReadPixels */
+	virtual void readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
+			GLenum format, GLenum type, GLvoid * data) = 0;
+
+	/** see glCreateShader */
+	virtual GLuint createShader(GLenum type) = 0;
+
+	/** see glShaderSource */
+	virtual void shaderSource(GLuint shader, GLsizei count,
+			const GLchar * const * source, const GLint * length) = 0;
+
+	/** see glCompileShader */
+	virtual void compileShader(GLuint shader) = 0;
+
+	/** see glGetShaderiv */
+	virtual void getShaderiv(GLuint shader, GLenum pname, GLint * params) = 0;
+
+	/** see glGetShaderInfoLog */
+	virtual void getShaderInfoLog(GLuint shader, GLsizei maxLength,
+			GLsizei * length, GLchar * infoLog) = 0;
+
+	/** see glCreateProgram */
+	virtual GLuint createProgram() = 0;
+
+	/** see glAttachShader */
+	virtual void attachShader(GLuint program, GLuint shader) = 0;
+
+	/** see glTransformFeedbackVaryings */
+	virtual void transformFeedbackVaryings(GLuint program, GLsizei count,
+			const GLchar * const * varyings, GLenum bufferMode) = 0;
+
+	/** see glLinkProgram */
+	virtual void linkProgram(GLuint program) = 0;
+
+	/** see glGetProgramiv */
+	virtual void getProgramiv(GLuint program, GLenum pname,
+			GLint * params) = 0;
+
+	/** see glGetActiveUniform */
+	virtual void getActiveUniform(GLuint program, GLuint index,
+			GLsizei bufSize, GLsizei * length, GLint * size, GLenum * type,
+			GLchar * name) = 0;
+
+	/** see glGetActiveAttrib */
+	virtual void getActiveAttrib(GLuint program, GLuint index,
+			GLsizei bufSize, GLsizei * length, GLint * size, GLenum * type,
+			GLchar * name) = 0;
+
+	/** see glGetAttribLocation */
+	virtual GLint getAttribLocation(GLuint program, const GLchar * name) = 0;
+
+	/** see glGetUniformLocation */
+	virtual GLint getUniformLocation(GLuint program, const GLchar * name) = 0;
+
+	/** see glGetUniformBlockIndex */
+	virtual GLuint getUniformBlockIndex(GLuint program,
+			const GLchar * uniformBlockName) = 0;
+
+	/** see glUniformBlockBinding */
+	virtual void uniformBlockBinding(GLuint program, GLuint uniformBlockIndex,
+			GLuint uniformBlockBinding) = 0;
+
+	/** see glUniform1i */
+	virtual void uniform1i(GLint location, GLint v0) = 0;
+
+	/** see glUniform1f */
+	virtual void uniform1f(GLint location, GLfloat v0) = 0;
+
+	/** see glUniform3f */
+	virtual void uniform3f(GLint location, GLfloat v0, GLfloat v1,
+			GLfloat v2) = 0;
+
+	/** see glUniformMatrix4fv */
+	virtual void uniformMatrix4fv(GLint location, GLsizei count,
+			GLboolean transpose, const GLfloat * value) = 0;
+
+	/** see glGetError */
+	virtual GLenum getError() = 0;
+};
+
+/**
+ * GLApi implementation which forwards every call to the OpenGL driver
+ */
+class GLApiDriver: public GLApi {
+public:
+
+	/** forward to driver */
+	void useProgram(GLuint program) override {
+		glUseProgram(program);
+	}
+
+	/** forward to driver */
+	void activeTexture(GLenum texture) override {
+		glActiveTexture(texture);
+	}
+
+	/** forward to driver */
+	void genTextures(GLsizei n, GLuint * textures) override {
+		glGenTextures(n, textures);
+	}
+
+	/** forward to driver */
+	void bindTexture(GLenum target, GLuint texture) override {
+		glBindTexture(target, texture);
+	}
+
+	/** forward to driver */
+	void texParameteri(GLenum target, GLenum pname, GLint param) override {
+		glTexParameteri(target, pname, param);
+	}
+
+	/** forward to driver */
+	void texImage2D(GLenum target, GLint level, GLint internalFormat,
+			GLsizei width, GLsizei height, GLint border, GLenum format,
+			GLenum type, const GLvoid * data) override {
+		glTexImage2D(target, level, internalFormat, width, height, border,
+				format, type, data);
+	}
+
+	/** forward to driver */
+	void genBuffers(GLsizei n, GLuint * buffers) override {
+		glGenBuffers(n, buffers);
+	}
+
+	/** forward to driver */
+	void deleteBuffers(GLsizei n, const GLuint * buffers) override {
+		glDeleteBuffers(n, buffers);
+	}
+
+	/** forward to driver */
+	void bindBuffer(GLenum target, GLuint buffer) override {
+		glBindBuffer(target, buffer);
+	}
+
+	/** forward to driver */
+	void bufferData(GLenum target, GLsizeiptr size, const GLvoid * data,
+			GLenum usage) override {
+		glBufferData(target, size, data, usage);
+	}
+
+	/** forward to driver */
+	void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+			const GLvoid * data) override {
+		glBufferSubData(target, offset, size, data);
+	}
+
+	/** forward to driver */
+	void copyBufferSubData(GLenum readTarget, GLenum writeTarget,
+			GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+					override {
+		glCopyBufferSubData(readTarget, writeTarget, readOffset, writeOffset,
+				size);
+	}
+
+	/** forward to driver */
+	void bindBufferBase(GLenum target, GLuint index, GLuint buffer) override {
+		glBindBufferBase(target, index, buffer);
+	}
+
+	/** forward to driver */
+	GLvoid * mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
+			GLbitfield access) override {
+		return glMapBufferRange(target, offset, length, access);
+	}
+
+	/** forward to driver */
+	GLboolean unmapBuffer(GLenum target) override {
+		return glUnmapBuffer(target);
+	}
+
+	/** forward to driver, fences are core since OpenGL 3.2 and OpenGL ES 3 */
+	GLsync fenceSync(GLenum condition, GLbitfield flags) override {
+#ifdef __glew_h__
+		if (!GLEW_VERSION_3_2 && !GLEW_ARB_sync) {
+			return 0;
+		}
+#endif
+		return glFenceSync(condition, flags);
+	}
+
+	/** forward to driver */
+	GLenum clientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+			override {
+		return glClientWaitSync(sync, flags, timeout);
+	}
+
+	/** forward to driver */
+	void deleteSync(GLsync sync) override {
+		glDeleteSync(sync);
+	}
+
+	/** forward to driver */
+	void genVertexArrays(GLsizei n, GLuint * arrays) override {
+		glGenVertexArrays(n, arrays);
+	}
+
+	/** forward to driver */
+	void bindVertexArray(GLuint array) override {
+		glBindVertexArray(array);
+	}
+
+	/** forward to driver */
+	void enableVertexAttribArray(GLuint index) override {
+		glEnableVertexAttribArray(index);
+	}
+
+	/** forward to driver */
+	void disableVertexAttribArray(GLuint index) override {
+		glDisableVertexAttribArray(index);
+	}
+
+	/** forward to driver */
+	void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+			GLboolean normalized, GLsizei stride, const GLvoid * pointer)
+					override {
+		glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+	}
+
+	/** forward to driver */
+	void vertexAttribDivisor(GLuint index, GLuint divisor) override {
+		glVertexAttribDivisor(index, divisor);
+	}
+
+	/** forward to driver */
+	void drawArrays(GLenum mode, GLint first, GLsizei count) override {
+		glDrawArrays(mode, first, count);
+	}
+
+	/** forward to driver */
+	void drawArraysInstanced(GLenum mode, GLint first, GLsizei count,
+			GLsizei instanceCount) override {
+		glDrawArraysInstanced(mode, first, count, instanceCount);
+	}
+
+	/** forward to driver */
+	void enable(GLenum cap) override {
+		glEnable(cap);
+	}
+
+	/** forward to driver */
+	void disable(GLenum cap) override {
+		glDisable(cap);
+	}
+
+	/** forward to driver */
+	void beginTransformFeedback(GLenum primitiveMode) override {
+		glBeginTransformFeedback(primitiveMode);
+	}
+
+	/** forward to driver */
+	void endTransformFeedback() override {
+		glEndTransformFeedback();
+	}
+
+	/** forward to driver */
+	void clear(GLbitfield mask) override {
+		glClear(mask);
+	}
+
+	/** forward to driver */
+	void readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
+			GLenum format, GLenum type, GLvoid * data) override {
+		glReadPixels(x, y, width, height, format, type, data);
+	}
+
+	/** forward to driver */
+	GLuint createShader(GLenum type) override {
+		return glCreateShader(type);
+	}
+
+	/** forward to driver */
+	void shaderSource(GLuint shader, GLsizei count,
+			const GLchar * const * source, const GLint * length) override {
+		glShaderSource(shader, count, source, length);
+	}
+
+	/** forward to driver */
+	void compileShader(GLuint shader) override {
+		glCompileShader(shader);
+	}
+
+	/** forward to driver */
+	void getShaderiv(GLuint shader, GLenum pname, GLint * params) override {
+		glGetShaderiv(shader, pname, params);
+	}
+
+	/** forward to driver */
+	void getShaderInfoLog(GLuint shader, GLsizei maxLength, GLsizei * length,
+			GLchar * infoLog) override {
+		glGetShaderInfoLog(shader, maxLength, length, infoLog);
+	}
+
+	/** forward to driver */
+	GLuint createProgram() override {
+		return glCreateProgram();
+	}
+
+	/** forward to driver */
+	void attachShader(GLuint program, GLuint shader) override {
+		glAttachShader(program, shader);
+	}
+
+	/** forward to driver */
+	void transformFeedbackVaryings(GLuint program, GLsizei count,
+			const GLchar * const * varyings, GLenum bufferMode) override {
+		glTransformFeedbackVaryings(program, count, varyings, bufferMode);
+	}
+
+	/** forward to driver */
+	void linkProgram(GLuint program) override {
+		glLinkProgram(program);
+	}
+
+	/** forward to driver */
+	void getProgramiv(GLuint program, GLenum pname, GLint * params) override {
+		glGetProgramiv(program, pname, params);
+	}
+
+	/** forward to driver */
+	void getActiveUniform(GLuint program, GLuint index, GLsizei bufSize,
+			GLsizei * length, GLint * size, GLenum * type, GLchar * name)
+					override {
+		glGetActiveUniform(program, index, bufSize, length, size, type, name);
+	}
+
+	/** forward to driver */
+	void getActiveAttrib(GLuint program, GLuint index, GLsizei bufSize,
+			GLsizei * length, GLint * size, GLenum * type, GLchar * name)
+					override {
+		glGetActiveAttrib(program, index, bufSize, length, size, type, name);
+	}
+
+	/** forward to driver */
+	GLint getAttribLocation(GLuint program, const GLchar * name) override {
+		return glGetAttribLocation(program, name);
+	}
+
+	/** forward to driver */
+	GLint getUniformLocation(GLuint program, const GLchar * name) override {
+		return glGetUniformLocation(program, name);
+	}
+
+	/** forward to driver */
+	GLuint getUniformBlockIndex(GLuint program,
+			const GLchar * uniformBlockName) override {
+		return glGetUniformBlockIndex(program, uniformBlockName);
+	}
+
+	/** forward to driver */
+	void uniformBlockBinding(GLuint program, GLuint uniformBlockIndex,
+			GLuint uniformBlockBinding) override {
+		glUniformBlockBinding(program, uniformBlockIndex, uniformBlockBinding);
+	}
+
+	/** forward to driver */
+	void uniform1i(GLint location, GLint v0) override {
+		glUniform1i(location, v0);
+	}
+
+	/** forward to driver */
+	void uniform1f(GLint location, GLfloat v0) override {
+		glUniform1f(location, v0);
+	}
+
+	/** forward to driver */
+	void uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+			override {
+		glUniform3f(location, v0, v1, v2);
+	}
+
+	/** forward to driver */
+	void uniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose,
+			const GLfloat * value) override {
+		glUniformMatrix4fv(location, count, transpose, value);
+	}
+
+	/** forward to driver */
+	GLenum getError() override {
+		return glGetError();
+	}
+};
@@ -0,0 +1,246 @@
+#include "GLApiRecorder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+/**
+ * Split the source into words, semicolons, commas and brackets separate
+ * words as well. Curly braces are kept as tokens of their own.
+ */
+std::vector<std::string> tokenize(std::string const& source) {
+	std::vector<std::string> tokens;
+	std::string current;
+	for (char c : source) {
+		if (std::isspace(static_cast<unsigned char>(c)) || (c == ';')
+				|| (c == ',') || (c == '(') || (c == ')') || (c == '[')
+				|| (c == '{') || (c == '}')) {
+			if (!current.empty()) {
+				tokens.push_back(current);
+				current.clear();
+			}
+			if ((c == '{') || (c == '}')) {
+				tokens.push_back(std::string(1, c));
+			}
+		} else {
+			current += c;
+		}
+	}
+	if (!current.empty()) {
+		tokens.push_back(current);
+	}
+	return tokens;
+}
+
+/**
+ * Add the name declared after the qualifier at position i, skipping the
+ * precision and the type. Arrays are named by their first element, like the
+ * driver reports them.
+ */
+void addDeclaration(std::vector<std::string> const& tokens, size_t i,
+		std::vector<std::string> & names) {
+	size_t n = i + 1;
+	if ((n < tokens.size())
+			&& ((tokens[n] == "lowp") || (tokens[n] == "mediump")
+					|| (tokens[n] == "highp"))) {
+		n++;
+	}
+	// the type comes first
+	n++;
+	if (n >= tokens.size()) {
+		return;
+	}
+	// the size of an array follows the opening bracket
+	auto name = tokens[n];
+	if ((n + 1 < tokens.size()) && !tokens[n + 1].empty()
+			&& (tokens[n + 1].back() == ']')) {
+		name += "[0]";
+	}
+	if (std::find(names.begin(), names.end(), name) == names.end()) {
+		names.push_back(name);
+	}
+}
+
+}
+
+std::string GLRecordingStats::toString() const {
+	std::stringstream sout;
+	const auto perFrame = [this] (size_t counter) {
+		return (Frames == 0) ? 0.0 : double(counter) / double(Frames);
+	};
+
+	sout << "frames " << Frames << std::endl;
+	sout << "  draw calls " << DrawCalls << " (" << perFrame(DrawCalls)
+			<< " per frame)" << std::endl;
+	sout << "  drawn instances " << DrawnInstances << " ("
+			<< perFrame(DrawnInstances) << " per frame)" << std::endl;
+	sout << "  drawn vertices " << DrawnVertices << " ("
+			<< perFrame(DrawnVertices) << " per frame)" << std::endl;
+	sout << "  state changes " << StateChanges << " ("
+			<< perFrame(StateChanges) << " per frame)" << std::endl;
+	sout << "  uniform updates " << UniformUpdates << " ("
+			<< perFrame(UniformUpdates) << " per frame)" << std::endl;
+	sout << "  queries " << Queries << " (" << perFrame(Queries)
+			<< " per frame)" << std::endl;
+	sout << "  uploads " << Uploads << " (" << perFrame(Uploads)
+			<< " per frame)" << std::endl;
+	sout << "  uploaded bytes " << UploadedBytes << " ("
+			<< perFrame(UploadedBytes) << " per frame)" << std::endl;
+	sout << "  buffer allocations " << BufferAllocations << std::endl;
+	sout << "  objects created " << ObjectsCreated << std::endl;
+	sout << "  clears " << Clears << std::endl;
+	sout << "  other calls " << OtherCalls;
+	return sout.str();
+}
+
+void GLApiRecorder::texImage2D(GLenum, GLint, GLint, GLsizei width,
+		GLsizei height, GLint, GLenum format, GLenum, const GLvoid * data) {
+	if (!data) {
+		m_stats.BufferAllocations++;
+		return;
+	}
+
+	// all textures are loaded with one byte per color channel
+	const size_t channels = (format == GL_RGB) ? 3 : 4;
+	recordUpload(GLsizeiptr(width) * GLsizeiptr(height) * channels);
+}
+
+void GLApiRecorder::getShaderiv(GLuint, GLenum pname, GLint * params) {
+	m_stats.Queries++;
+	*params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+void GLApiRecorder::getShaderInfoLog(GLuint, GLsizei maxLength,
+		GLsizei * length, GLchar * infoLog) {
+	m_stats.Queries++;
+	if (length) {
+		*length = 0;
+	}
+	if (maxLength > 0) {
+		infoLog[0] = 0;
+	}
+}
+
+void GLApiRecorder::getProgramiv(GLuint program, GLenum pname,
+		GLint * params) {
+	m_stats.Queries++;
+	auto const& recorded = m_programs[program];
+	const auto maxLength = [] (std::vector<std::string> const& names) {
+		size_t length = 0;
+		for (auto const& n : names) {
+			length = std::max(length, n.size() + 1);
+		}
+		return GLint(length);
+	};
+
+	if (pname == GL_LINK_STATUS) {
+		*params = GL_TRUE;
+	} else if (pname == GL_ACTIVE_UNIFORMS) {
+		*params = GLint(recorded.Uniforms.size());
+	} else if (pname == GL_ACTIVE_ATTRIBUTES) {
+		*params = GLint(recorded.Attributes.size());
+	} else if (pname == GL_ACTIVE_UNIFORM_MAX_LENGTH) {
+		*params = maxLength(recorded.Uniforms);
+	} else if (pname == GL_ACTIVE_ATTRIBUTE_MAX_LENGTH) {
+		*params = maxLength(recorded.Attributes);
+	} else {
+		*params = 0;
+	}
+}
+
+void GLApiRecorder::shaderSource(GLuint shader, GLsizei count,
+		const GLchar * const * string, const GLint * length) {
+	m_stats.OtherCalls++;
+	auto & source = m_shaders[shader].Source;
+	source.clear();
+	for (GLsizei i = 0; i < count; i++) {
+		if (length && (length[i] >= 0)) {
+			source.append(string[i], size_t(length[i]));
+		} else {
+			source.append(string[i]);
+		}
+	}
+}
+
+void GLApiRecorder::linkProgram(GLuint program) {
+	m_stats.OtherCalls++;
+	auto & recorded = m_programs[program];
+	recorded.Uniforms.clear();
+	recorded.Attributes.clear();
+	recorded.UniformBlocks.clear();
+	for (auto shader : recorded.Shaders) {
+		auto const& recordedShader = m_shaders[shader];
+		const auto tokens = tokenize(recordedShader.Source);
+		const bool vertexShader = (recordedShader.Type == GL_VERTEX_SHADER);
+		for (size_t i = 0; i < tokens.size(); i++) {
+			if ((tokens[i] == "uniform") && (i + 2 < tokens.size())
+					&& (tokens[i + 2] == "{")) {
+				// a uniform block, its members are uniforms as well
+				recorded.UniformBlocks.push_back(tokens[i + 1]);
+				for (i += 3; (i + 1 < tokens.size()) && (tokens[i] != "}");
+						i += 2) {
+					if (std::find(recorded.Uniforms.begin(),
+							recorded.Uniforms.end(), tokens[i + 1])
+							== recorded.Uniforms.end()) {
+						recorded.Uniforms.push_back(tokens[i + 1]);
+					}
+				}
+			} else if (tokens[i] == "uniform") {
+				addDeclaration(tokens, i, recorded.Uniforms);
+			} else if (vertexShader
+					&& ((tokens[i] == "in") || (tokens[i] == "attribute"))) {
+				addDeclaration(tokens, i, recorded.Attributes);
+			}
+		}
+	}
+}
+
+void GLApiRecorder::getActiveUniform(GLuint program, GLuint index,
+		GLsizei bufSize, GLsizei * length, GLint * size, GLenum * type,
+		GLchar * name) {
+	getActiveName(m_programs[program].Uniforms, index, bufSize, length, size,
+			type, name);
+}
+
+void GLApiRecorder::getActiveAttrib(GLuint program, GLuint index,
+		GLsizei bufSize, GLsizei * length, GLint * size, GLenum * type,
+		GLchar * name) {
+	getActiveName(m_programs[program].Attributes, index, bufSize, length,
+			size, type, name);
+}
+
+void GLApiRecorder::getActiveName(std::vector<std::string> const& names,
+		GLuint index, GLsizei bufSize, GLsizei * length, GLint * size,
+		GLenum * type, GLchar * name) {
+	m_stats.Queries++;
+	const std::string active = (index < names.size()) ? names[index] : "";
+	const size_t copied = std::min(active.size(),
+			size_t(std::max(bufSize - 1, 0)));
+	if (bufSize > 0) {
+		std::memcpy(name, active.data(), copied);
+		name[copied] = 0;
+	}
+	if (length) {
+		*length = GLsizei(copied);
+	}
+	*size = 1;
+	*type = GL_FLOAT;
+}
+
+GLint GLApiRecorder::getAttribLocation(GLuint program, const GLchar * name) {
+	m_stats.Queries++;
+	auto const& attributes = m_programs[program].Attributes;
+	auto it = std::find(attributes.begin(), attributes.end(), name);
+	return (it == attributes.end()) ? -1 : GLint(it - attributes.begin());
+}
+
+GLuint GLApiRecorder::getUniformBlockIndex(GLuint program,
+		const GLchar * uniformBlockName) {
+	m_stats.Queries++;
+	auto const& blocks = m_programs[program].UniformBlocks;
+	auto it = std::find(blocks.begin(), blocks.end(), uniformBlockName);
+	return (it == blocks.end()) ? GL_INVALID_INDEX : GLuint(it - blocks.begin());
+}
@@ -0,0 +1,566 @@
+#pragma once
+
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLApi.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Counters of the OpenGL calls recorded by the GLApiRecorder
+ */
+struct GLRecordingStats {
+
+	/**
+	 * Number of frames presented
+	 */
+	size_t Frames = 0;
+
+	/**
+	 * Number of draw calls, instanced or not
+	 */
+	size_t DrawCalls = 0;
+
+	/**
+	 * Number of instances drawn, one for each non-instanced draw call
+	 */
+	size_t DrawnInstances = 0;
+
+	/**
+	 * Number of vertices drawn, summed over all instances
+	 */
+	size_t DrawnVertices = 0;
+
+	/**
+	 * Calls which change the binding or configuration state, for example
+	 * binding buffers, textures and programs or setting vertex attributes
+	 */
+	size_t StateChanges = 0;
+
+	/**
+	 * Calls which set the value of a shader uniform
+	 */
+	size_t UniformUpdates = 0;
+
+	/**
+	 * Calls which query information from OpenGL, for example uniform
+	 * locations or errors
+	 */
+	size_t Queries = 0;
+
+	/**
+	 * Calls which transfer buffer or texture data to the GPU
+	 */
+	size_t Uploads = 0;
+
+	/**
+	 * Bytes transferred by all uploads
+	 */
+	size_t UploadedBytes = 0;
+
+	/**
+	 * Buffer storage allocated without transferring data, for example when
+	 * orphaning a buffer
+	 */
+	size_t BufferAllocations = 0;
+
+	/**
+	 * Number of OpenGL objects created
+	 */
+	size_t ObjectsCreated = 0;
+
+	/**
+	 * Number of framebuffer clears
+	 */
+	size_t Clears = 0;
+
+	/**
+	 * Calls not covered by one of the other counters, for example shader
+	 * compilation
+	 */
+	size_t OtherCalls = 0;
+
+	/**
+	 * Format the counters and their average per frame into a human readable,
+	 * multi-line string
+	 */
+	std::string toString() const;
+};
+
+/**
+ * GLApi implementation which does not need a GPU. All calls are counted and
+ * then dropped, only the state of the vertex attributes is kept. Object ids are handed out in increasing order and shaders
+ * always compile and link successfully, so the complete render code can be
+ * run and benchmarked without a display. Mapped buffer ranges always read
+ * as zero.
+ *
+ * The uniform and attribute declarations of the shader sources are kept, so
+ * the active uniforms, attributes and uniform blocks of a linked program can
+ * be queried.
+ */
+class GLApiRecorder: public GLApi {
+public:
+
+	/**
+	 * State of one vertex attribute location
+	 */
+	struct RecordedAttribute {
+		/**
+		 * True if the location has been enabled
+		 */
+		bool Enabled = false;
+
+		/**
+		 * True if a pointer has been set for the location
+		 */
+		bool PointerSet = false;
+
+		/**
+		 * Type of the data set with the last pointer
+		 */
+		GLenum Type = 0;
+
+		/**
+		 * Divisor set last
+		 */
+		GLuint Divisor = 0;
+	};
+
+	/**
+	 * State of the vertex attribute at the location, the default state if
+	 * the location has never been used
+	 */
+	RecordedAttribute getAttribute(GLuint location) const {
+		auto it = m_attributes.find(location);
+		return (it == m_attributes.end()) ? RecordedAttribute() : it->second;
+	}
+
+	/**
+	 * Counters of all calls recorded so far
+	 */
+	GLRecordingStats const& getStats() const {
+		return m_stats;
+	}
+
+	/**
+	 * Reset all counters to zero
+	 */
+	void resetStats() {
+		m_stats = GLRecordingStats();
+	}
+
+	/**
+	 * Count the end of a frame
+	 */
+	void recordFrame() {
+		m_stats.Frames++;
+	}
+
+	/** record call */
+	void useProgram(GLuint) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void activeTexture(GLenum) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void genTextures(GLsizei n, GLuint * textures) override {
+		generateIds(n, textures);
+	}
+
+	/** record call */
+	void bindTexture(GLenum, GLuint) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void texParameteri(GLenum, GLenum, GLint) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void texImage2D(GLenum target, GLint level, GLint internalFormat,
+			GLsizei width, GLsizei height, GLint border, GLenum format,
+			GLenum type, const GLvoid * data) override;
+
+	/** record call */
+	void genBuffers(GLsizei n, GLuint * buffers) override {
+		generateIds(n, buffers);
+	}
+
+	/** record call */
+	void deleteBuffers(GLsizei, const GLuint *) override {
+		m_stats.OtherCalls++;
+	}
+
+	/** record call */
+	void bindBuffer(GLenum, GLuint) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void bufferData(GLenum, GLsizeiptr size, const GLvoid * data, GLenum)
+			override {
+		if (data) {
+			recordUpload(size);
+		} else {
+			m_stats.BufferAllocations++;
+		}
+	}
+
+	/** record call */
+	void bufferSubData(GLenum, GLintptr, GLsizeiptr size, const GLvoid *)
+			override {
+		recordUpload(size);
+	}
+
+	/** record call, the data does not leave the GPU */
+	void copyBufferSubData(GLenum, GLenum, GLintptr, GLintptr, GLsizeiptr)
+			override {
+		m_stats.OtherCalls++;
+	}
+
+	/** record call */
+	void bindBufferBase(GLenum, GLuint, GLuint) override {
+		m_stats.StateChanges++;
+	}
+
+	/**
+	 * record call, the returned memory is only valid until the buffer is
+	 * unmapped and its content is dropped
+	 */
+	GLvoid * mapBufferRange(GLenum, GLintptr, GLsizeiptr length,
+			GLbitfield access) override {
+		m_mapped.assign(size_t(length), 0);
+		m_mappedAccess = access;
+		return m_mapped.data();
+	}
+
+	/**
+	 * record call, a range mapped for writing counts as upload and one
+	 * mapped for reading as query
+	 */
+	GLboolean unmapBuffer(GLenum) override {
+		if (m_mappedAccess & GL_MAP_WRITE_BIT) {
+			recordUpload(GLsizeiptr(m_mapped.size()));
+		} else {
+			m_stats.Queries++;
+		}
+		m_mapped.clear();
+		return GL_TRUE;
+	}
+
+	/** record call, the fences are numbered like the other objects */
+	GLsync fenceSync(GLenum, GLbitfield) override {
+		m_stats.OtherCalls++;
+		return reinterpret_cast<GLsync>(uintptr_t(m_nextId++));
+	}
+
+	/** record call, all fences are signaled at once */
+	GLenum clientWaitSync(GLsync, GLbitfield, GLuint64) override {
+		m_stats.Queries++;
+		return GL_ALREADY_SIGNALED;
+	}
+
+	/** record call */
+	void deleteSync(GLsync) override {
+		m_stats.OtherCalls++;
+	}
+
+	/** record call */
+	void genVertexArrays(GLsizei n, GLuint * arrays) override {
+		generateIds(n, arrays);
+	}
+
+	/** record call */
+	void bindVertexArray(GLuint) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void enableVertexAttribArray(GLuint index) override {
+		m_stats.StateChanges++;
+		m_attributes[index].Enabled = true;
+	}
+
+	/** record call */
+	void disableVertexAttribArray(GLuint index) override {
+		m_stats.StateChanges++;
+		m_attributes[index].Enabled = false;
+	}
+
+	/** record call */
+	void vertexAttribPointer(GLuint index, GLint, GLenum type, GLboolean,
+			GLsizei, const GLvoid *) override {
+		m_stats.StateChanges++;
+		m_attributes[index].PointerSet = true;
+		m_attributes[index].Type = type;
+	}
+
+	/** record call */
+	void vertexAttribDivisor(GLuint index, GLuint divisor) override {
+		m_stats.StateChanges++;
+		m_attributes[index].Divisor = divisor;
+	}
+
+	/** record call */
+	void drawArrays(GLenum, GLint, GLsizei count) override {
+		m_stats.DrawCalls++;
+		m_stats.DrawnInstances++;
+		m_stats.DrawnVertices += size_t(count);
+	}
+
+	/** record call */
+	void drawArraysInstanced(GLenum, GLint, GLsizei count,
+			GLsizei instanceCount) override {
+		m_stats.DrawCalls++;
+		m_stats.DrawnInstances += instanceCount;
+		m_stats.DrawnVertices += size_t(count) * size_t(instanceCount);
+	}
+
+	/** record call */
+	void enable(GLenum) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void disable(GLenum) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void beginTransformFeedback(GLenum) override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void endTransformFeedback() override {
+		m_stats.StateChanges++;
+	}
+
+	/** record call */
+	void clear(GLbitfield) override {
+		m_stats.Clears++;
+	}
+
+	/** record call, the pixel data is not touched */
+	void readPixels(GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, GLvoid *)
+			override {
+		m_stats.Queries++;
+	}
+
+	/** record call */
+	GLuint createShader(GLenum type) override {
+		GLuint id;
+		generateIds(1, &id);
+		m_shaders[id].Type = type;
+		return id;
+	}
+
+	/** record call and keep the source for linking */
+	void shaderSource(GLuint shader, GLsizei count,
+			const GLchar * const * string, const GLint * length) override;
+
+	/** record call */
+	void compileShader(GLuint) override {
+		m_stats.OtherCalls++;
+	}
+
+	/** record call, the compilation is always successful */
+	void getShaderiv(GLuint shader, GLenum pname, GLint * params) override;
+
+	/** record call, the log is always empty */
+	void getShaderInfoLog(GLuint shader, GLsizei maxLength, GLsizei * length,
+			GLchar * infoLog) override;
+
+	/** record call */
+	GLuint createProgram() override {
+		GLuint id;
+		generateIds(1, &id);
+		return id;
+	}
+
+	/** record call */
+	void attachShader(GLuint program, GLuint shader) override {
+		m_stats.OtherCalls++;
+		m_programs[program].Shaders.push_back(shader);
+	}
+
+	/** record call */
+	void transformFeedbackVaryings(GLuint, GLsizei, const GLchar * const *,
+			GLenum) override {
+		m_stats.OtherCalls++;
+	}
+
+	/** record call and collect the declarations of the attached shaders */
+	void linkProgram(GLuint program) override;
+
+	/** record call, linking is always successful */
+	void getProgramiv(GLuint program, GLenum pname, GLint * params) override;
+
+	/** record call, the type is always GL_FLOAT */
+	void getActiveUniform(GLuint program, GLuint index, GLsizei bufSize,
+			GLsizei * length, GLint * size, GLenum * type, GLchar * name)
+					override;
+
+	/** record call, the type is always GL_FLOAT */
+	void getActiveAttrib(GLuint program, GLuint index, GLsizei bufSize,
+			GLsizei * length, GLint * size, GLenum * type, GLchar * name)
+					override;
+
+	/**
+	 * record call, the attributes are located in order of their
+	 * declaration
+	 */
+	GLint getAttribLocation(GLuint program, const GLchar * name) override;
+
+	/** record call, all uniforms are at location 0 */
+	GLint getUniformLocation(GLuint, const GLchar *) override {
+		m_stats.Queries++;
+		return 0;
+	}
+
+	/** record call, the blocks are numbered in order of their declaration */
+	GLuint getUniformBlockIndex(GLuint program,
+			const GLchar * uniformBlockName) override;
+
+	/** record call */
+	void uniformBlockBinding(GLuint, GLuint, GLuint) override {
+		m_stats.OtherCalls++;
+	}
+
+	/** record call */
+	void uniform1i(GLint, GLint) override {
+		m_stats.UniformUpdates++;
+	}
+
+	/** record call */
+	void uniform1f(GLint, GLfloat) override {
+		m_stats.UniformUpdates++;
+	}
+
+	/** record call */
+	void uniform3f(GLint, GLfloat, GLfloat, GLfloat) override {
+		m_stats.UniformUpdates++;
+	}
+
+	/** record call */
+	void uniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat *)
+			override {
+		m_stats.UniformUpdates++;
+	}
+
+	/** record call, there never is an error */
+	GLenum getError() override {
+		m_stats.Queries++;
+		return GL_NO_ERROR;
+	}
+
+private:
+
+	/**
+	 * Source of a shader
+	 */
+	struct RecordedShader {
+		/**
+		 * GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+		 */
+		GLenum Type = 0;
+
+		/**
+		 * The source code set with shaderSource()
+		 */
+		std::string Source;
+	};
+
+	/**
+	 * Shaders and declarations of a program
+	 */
+	struct RecordedProgram {
+		/**
+		 * Ids of the attached shaders
+		 */
+		std::vector<GLuint> Shaders;
+
+		/**
+		 * Names of the uniforms declared by the shaders, set when linked
+		 */
+		std::vector<std::string> Uniforms;
+
+		/**
+		 * Names of the vertex shader inputs, set when linked
+		 */
+		std::vector<std::string> Attributes;
+
+		/**
+		 * Names of the uniform blocks declared by the shaders, set when
+		 * linked
+		 */
+		std::vector<std::string> UniformBlocks;
+	};
+
+	/**
+	 * Copy the name of entry index of the list into name like the driver
+	 */
+	void getActiveName(std::vector<std::string> const& names, GLuint index,
+			GLsizei bufSize, GLsizei * length, GLint * size, GLenum * type,
+			GLchar * name);
+
+	/**
+	 * Hand out n new object ids
+	 */
+	void generateIds(GLsizei n, GLuint * ids) {
+		for (GLsizei i = 0; i < n; i++) {
+			ids[i] = m_nextId++;
+		}
+		m_stats.ObjectsCreated += n;
+	}
+
+	/**
+	 * Count one upload of size bytes
+	 */
+	void recordUpload(GLsizeiptr size) {
+		m_stats.Uploads++;
+		m_stats.UploadedBytes += size;
+	}
+
+	/**
+	 * Counters of all recorded calls
+	 */
+	GLRecordingStats m_stats;
+
+	/**
+	 * All shaders created so far
+	 */
+	std::unordered_map<GLuint, RecordedShader> m_shaders;
+
+	/**
+	 * All programs which had shaders attached
+	 */
+	std::unordered_map<GLuint, RecordedProgram> m_programs;
+
+	/**
+	 * State of the vertex attribute locations used so far
+	 */
+	std::unordered_map<GLuint, RecordedAttribute> m_attributes;
+
+	/**
+	 * Memory handed out for the currently mapped buffer range
+	 */
+	std::vector<char> m_mapped;
+
+	/**
+	 * Access flags the current range was mapped with
+	 */
+	GLbitfield m_mappedAccess = 0;
+
+	/**
+	 * The next object id to hand out, 0 is never used by OpenGL
+	 */
+	GLuint m_nextId = 1;
+};
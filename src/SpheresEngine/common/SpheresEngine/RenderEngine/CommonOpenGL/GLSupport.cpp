@@ -0,0 +1,22 @@
+#include "GLSupport.h"
+
+namespace {
+
+/**
+ * The GLApi made current on this thread, nullptr to use the driver
+ */
+thread_local GLApi * t_currentApi = nullptr;
+
+}
+
+GLApi & GLSupport::api() {
+	if (t_currentApi) {
+		return *t_currentApi;
+	}
+	static GLApiDriver driverApi;
+	return driverApi;
+}
+
+void GLSupport::makeCurrent(GLApi * api) {
+	t_currentApi = api;
+}
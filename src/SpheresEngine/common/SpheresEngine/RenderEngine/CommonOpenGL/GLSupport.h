@@ -2,6 +2,7 @@
 
 #include <SpheresEngine/Log.h>
 #include <SpheresEngine/RenderEngine/OpenGLInclude.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLApi.h>
 #include <array>
 #include <string>
 
@@ -16,12 +17,24 @@
 
 namespace GLSupport {
 
+/**
+ * Returns the GLApi which is current on the calling thread. If no GLApi has
+ * been made current, the calls are forwarded to the OpenGL driver.
+ */
+GLApi & api();
+
+/**
+ * Make a GLApi current on the calling thread, the caller keeps the ownership.
+ * Pass nullptr to forward to the OpenGL driver again.
+ */
+void makeCurrent(GLApi * api);
+
 /**
  * Method which can be called after every OpenGL API call to check for an error in
  * the OpenGL state machine
  */
 inline void checkGLError(std::string const& previousCall) {
-	for (GLint error = glGetError(); error; error = glGetError()) {
+	for (GLint error = api().getError(); error; error = api().getError()) {
 		logging::Fatal() << "glError: after " << previousCall << ": " << error;
 	}
 }
@@ -1,14 +1,17 @@
 #include <SpheresEngine/RenderEngine/CommonOpenGL/MeshBackend.h>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderBackend.h>
-#include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderBackend.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
 #include <SpheresEngine/RenderEngine/RenderBackendBase.h>
 #include "../../Log.h"
 
+#include <glm/mat4x4.hpp>
+
 #include <cstring>
 #include <ostream>
 
 Mesh MeshBackend::loadMesh(std::string name, Texture &,
 		ShaderProgram & shaderProg) {
+	auto & gl = GLSupport::api();
 
 	auto it = m_loadedMeshes.find(name);
 	if (it != m_loadedMeshes.end())
@@ -29,14 +32,92 @@ Mesh MeshBackend::loadMesh(std::string name, Texture &,
 
 	// make and bind the VBO
 	// holds the vertex data on the GPU
-	glGenBuffers(1, &gVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, gVBO);
+	gl.genBuffers(1, &gVBO);
+	gl.bindBuffer(GL_ARRAY_BUFFER, gVBO);
 
 	// Put the three triangle vertices into the VBO
 	const auto facesData = meshData.asXYZUVNormals();
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * facesData.size(),
+	gl.bufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * facesData.size(),
 			facesData.data(), GL_STATIC_DRAW);
 
+	setupVertexAttributes(shaderProg);
+
+	// unbind the VBO and VAO
+	gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+	m_renderBackend.ext_glBindVertexArray(0);
+
+	// used by the renderer to drop meshes outside of the view
+	Vector3 boundsCenter;
+	float boundsRadius;
+	meshData.computeBoundingSphere(boundsCenter, boundsRadius);
+
+	auto m = Mesh(gVAO, meshData.getVertexCount(), boundsCenter.toGlm(),
+			boundsRadius);
+	m_loadedMeshes[name] = m;
+	m_vertexBuffers[name] = gVBO;
+
+	logging::Info() << "Mesh with name '" << name << "' loaded";
+	return m;
+}
+
+GLuint MeshBackend::loadInstancedMesh(std::string name,
+		ShaderProgram & shaderProg) {
+	auto & gl = GLSupport::api();
+
+	auto it = m_instancedVertexArrays.find(name);
+	if (it != m_instancedVertexArrays.end())
+		return it->second;
+
+	// the instanced vertex array reads the vertices of the regular mesh
+	auto itBuffer = m_vertexBuffers.find(name);
+	if (itBuffer == m_vertexBuffers.end()) {
+		logging::Error() << "Mesh with name '" << name
+				<< "' needs to be loaded before its instanced version";
+		return 0;
+	}
+	const auto instanceBuffer = getInstanceBuffer();
+
+	GLuint gVAO;
+	m_renderBackend.ext_glGenVertexArrays(1, &gVAO);
+	m_renderBackend.ext_glBindVertexArray(gVAO);
+
+	gl.bindBuffer(GL_ARRAY_BUFFER, itBuffer->second);
+	setupVertexAttributes(shaderProg);
+
+	// a mat4 attribute occupies four consecutive locations, one for each
+	// column, which advance once per instance
+	gl.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	const GLint instanceModel = shaderProg.getAttribLocation(
+			ShaderVariables::InstanceModel);
+	for (GLuint column = 0; column < 4; column++) {
+		const GLuint location = GLuint(instanceModel) + column;
+		gl.enableVertexAttribArray(location);
+		gl.vertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE,
+				sizeof(glm::mat4),
+				(const GLvoid*) (column * sizeof(glm::vec4)));
+		gl.vertexAttribDivisor(location, 1);
+	}
+
+	gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+	m_renderBackend.ext_glBindVertexArray(0);
+
+	m_instancedVertexArrays[name] = gVAO;
+
+	logging::Info() << "Instanced mesh with name '" << name << "' loaded";
+	return gVAO;
+}
+
+GLuint MeshBackend::getInstanceBuffer() {
+	if (m_instanceBuffer == 0) {
+		auto & gl = GLSupport::api();
+		gl.genBuffers(1, &m_instanceBuffer);
+	}
+	return m_instanceBuffer;
+}
+
+void MeshBackend::setupVertexAttributes(ShaderProgram & shaderProg) {
+	auto & gl = GLSupport::api();
+
 	// connect the xyz to the "vert" attribute of the vertex shader with the uv and
 	// normal information and dump it all in one buffer. This buffer has 8 entries/vertex
 	// xyz + uz + 3dim normals
@@ -47,8 +128,9 @@ Mesh MeshBackend::loadMesh(std::string name, Texture &,
 	auto combinedBufferSize = combinedBufferEntryCount * sizeof(GLfloat);
 
 	// pass on vertex position
-	glEnableVertexAttribArray(shaderProg.getAttribLocation("vert"));
-	glVertexAttribPointer(shaderProg.getAttribLocation("vert"),	// vertex pos
+	const GLint vert = shaderProg.getAttribLocation(ShaderVariables::Vertex);
+	gl.enableVertexAttribArray(vert);
+	gl.vertexAttribPointer(vert,	// vertex pos
 	3,	// will be three (x,y,z) numbers
 			GL_FLOAT,	// of float
 			GL_FALSE,	// not normalized
@@ -56,29 +138,22 @@ Mesh MeshBackend::loadMesh(std::string name, Texture &,
 			NULL);
 
 	// pass on vertex texture coordinates
-	glEnableVertexAttribArray(shaderProg.getAttribLocation("vertTexCoord"));
-	glVertexAttribPointer(shaderProg.getAttribLocation("vertTexCoord"),	// uv coords
+	const GLint vertTexCoord = shaderProg.getAttribLocation(
+			ShaderVariables::VertexTexCoord);
+	gl.enableVertexAttribArray(vertTexCoord);
+	gl.vertexAttribPointer(vertTexCoord,	// uv coords
 	2,	// will have two entries
 			GL_FLOAT, GL_TRUE, combinedBufferSize,
 			/* The offset within the buffer is 3, because the xyz coords come first*/
 			(const GLvoid*) (3 * sizeof(GLfloat)));
 
 	// pass on vertex normals
-	glEnableVertexAttribArray(
-			shaderProg.getAttribLocation("normals_modelspace"));
-	glVertexAttribPointer(shaderProg.getAttribLocation("normals_modelspace"),
+	const GLint normals = shaderProg.getAttribLocation(
+			ShaderVariables::VertexNormal);
+	gl.enableVertexAttribArray(normals);
+	gl.vertexAttribPointer(normals,
 	// 3 dim normal vector
 	3, GL_FLOAT, GL_FALSE, combinedBufferSize,
 	// offset within buffer is 3 (xyz pos) + 2 (uv) = 5
 	(const GLvoid*) (5 * sizeof(GLfloat)));
-
-	// unbind the VBO and VAO
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	m_renderBackend.ext_glBindVertexArray(0);
-
-	auto m = Mesh(gVAO, meshData.getVertexCount());
-	m_loadedMeshes[name] = m;
-
-	logging::Info() << "Mesh with name '" << name << "' loaded";
-	return m;
 }
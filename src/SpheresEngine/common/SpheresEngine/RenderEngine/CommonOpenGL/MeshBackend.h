@@ -28,7 +28,47 @@ public:
 	 */
 	Mesh loadMesh(std::string name, Texture &, ShaderProgram &);
 
+	/**
+	 * Setup a second vertex array for a mesh loaded with loadMesh() which
+	 * reads one model matrix per instance from the instance buffer, so
+	 * multiple copies of the mesh can be drawn with one instanced draw call.
+	 * The shader program needs a mat4 attribute named "instanceModel". The
+	 * vertex array is cached like the mesh itself.
+	 * @return the id of the vertex array, 0 if the mesh is not loaded
+	 */
+	GLuint loadInstancedMesh(std::string name, ShaderProgram &);
+
+	/**
+	 * The buffer the model matrices of the instanced vertex arrays are
+	 * read from, created on first use. Renderers stream the matrices into
+	 * it before each instanced draw call.
+	 */
+	GLuint getInstanceBuffer();
+
 private:
+
+	/**
+	 * Connect the xyz, uv and normal data of the currently bound vertex
+	 * buffer to the attributes of the shader program
+	 */
+	void setupVertexAttributes(ShaderProgram & shaderProg);
+
+	/**
+	 * Vertex buffers of all loaded meshes, shared with their instanced
+	 * vertex arrays
+	 */
+	std::unordered_map<std::string, GLuint> m_vertexBuffers;
+
+	/**
+	 * Caches for the instanced vertex arrays of the loaded meshes
+	 */
+	std::unordered_map<std::string, GLuint> m_instancedVertexArrays;
+
+	/**
+	 * Buffer holding the per-instance model matrices, 0 until created
+	 */
+	GLuint m_instanceBuffer = 0;
+
 	/**
 	 * Caches for all loaded meshes
 	 */
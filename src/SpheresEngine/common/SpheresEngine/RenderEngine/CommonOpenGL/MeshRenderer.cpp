@@ -11,8 +11,53 @@
 #include <glm/gtc/quaternion.hpp>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/MeshRenderer.h>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/MeshBackend.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
 #include <SpheresEngine/RenderEngine/RenderBackendBase.h>
 #include <SpheresEngine/RenderEngine/Targets/RenderTargetBase.h>
+#include <SpheresEngine/RenderEngine/Frustum.h>
+
+#include <limits>
+
+constexpr size_t MeshRenderer::MinInstanceCount;
+
+namespace {
+
+/**
+ * Fraction of the screen height covered by a sphere, one if the camera is
+ * within the sphere
+ */
+float screenSize(glm::vec3 const& center, float radius,
+		TargetData const& td) {
+	const auto viewCenter = td.CameraMatrix * glm::vec4(center, 1.0f);
+	const float depth = -viewCenter.z;
+	if (depth <= radius) {
+		return 1.0f;
+	}
+	// the projected radius in normalized device coordinates, which span two
+	// units over the screen height
+	return radius * td.ProjectionMatrix[1][1] / depth;
+}
+
+/**
+ * True if the mesh did not move during the last logic step, its model matrix
+ * does not depend on the interpolation then
+ */
+bool isStatic(VisualTransform const& t) {
+	return (t.Center == t.PreviousCenter) && (t.Rotation == t.PreviousRotation);
+}
+
+/**
+ * True if both draw calls need the same shader program, texture and vertex
+ * array. The sort key alone is not enough, large ids are cut off in it.
+ */
+bool sameState(DrawItem const& a, MeshVisualData const& ma, DrawItem const& b,
+		MeshVisualData const& mb) {
+	return (a.Key == b.Key) && (a.VertexArrayObjectId == b.VertexArrayObjectId)
+			&& (ma.TextureId == mb.TextureId)
+			&& (ma.Shader.getId() == mb.Shader.getId());
+}
+
+}
 
 bool MeshRenderer::prepare(VisualAbstract & vd, RenderBackendBase & backend,
 		ResourceEngine & re) {
@@ -32,48 +77,239 @@ bool MeshRenderer::prepare(VisualAbstract & vd, RenderBackendBase & backend,
 	auto mesh = backend.getMeshBackend().loadMesh(pMeshVisual->getMeshName(),
 			*tex, shaderProg);
 
-	pMeshVisual->getData().VertexArrayObjectId = mesh.getVao();
-	pMeshVisual->getData().Shader = shaderProg;
-	pMeshVisual->getData().VertexCount = mesh.getVertexCount();
-	pMeshVisual->getData().TextureId = tex->getID();
+	auto & data = pMeshVisual->getData();
+	data.VertexArrayObjectId = mesh.getVao();
+	data.Shader = shaderProg;
+	data.VertexCount = mesh.getVertexCount();
+	data.TextureId = tex->getID();
+	data.BoundsCenter = mesh.getBoundsCenter();
+	data.BoundsRadius = mesh.getBoundsRadius();
+
+	// instancing is optional, platforms without instanced draw calls do not
+	// define the shader program
+	const bool instanced = backend.getShaderBackend().hasProgramDefinition(
+			"default_instanced");
+	data.InstancedVertexArrayObjectId = 0;
+	if (instanced) {
+		data.InstancedShader = backend.getShaderBackend().loadProgram(
+				"default_instanced");
+		data.InstancedVertexArrayObjectId =
+				backend.getMeshBackend().loadInstancedMesh(
+						pMeshVisual->getMeshName(), data.InstancedShader);
+	}
+
+	// the simplified meshes are culled with the bounds of the full mesh
+	data.LevelOfDetailCount = 0;
+	for (auto const& lod : pMeshVisual->getLevelsOfDetail()) {
+		auto lodMesh = backend.getMeshBackend().loadMesh(lod.MeshName, *tex,
+				shaderProg);
+		auto & lodData = data.LevelsOfDetail[data.LevelOfDetailCount];
+		lodData.VertexArrayObjectId = lodMesh.getVao();
+		lodData.VertexCount = lodMesh.getVertexCount();
+		lodData.MaxScreenSize = lod.MaxScreenSize;
+		lodData.InstancedVertexArrayObjectId = 0;
+		if (instanced) {
+			lodData.InstancedVertexArrayObjectId =
+					backend.getMeshBackend().loadInstancedMesh(lod.MeshName,
+							data.InstancedShader);
+		}
+		data.LevelOfDetailCount++;
+	}
 
 	// integrate !
 	return true;
 }
 
+void MeshRenderer::cullMeshes(VisualDataExtractContainer const& c,
+		Frustum const& frustum) {
+	// entries which did not change since the last culled container hold the
+	// same data, if they are static their model matrix and bounds are kept
+	const bool sameSource = (c.ExtractTick != 0)
+			&& (c.ExtractTick >= m_culledTick);
+	const auto cached = sameSource ? m_static.size() : 0;
+	const auto count = c.MeshVisuals.size();
+	m_static.resize(count);
+	m_modelMatrices.resize(count);
+	m_boundsX.resize(count);
+	m_boundsY.resize(count);
+	m_boundsZ.resize(count);
+	m_boundsRadius.resize(count);
+	m_inFrustum.resize(count);
+
+	for (size_t i = 0; i < count; i++) {
+		if ((i < cached) && m_static[i]
+				&& !c.meshVisualChangedSince(i, m_culledTick)) {
+			continue;
+		}
+		auto const& t = c.MeshTransforms[i];
+		m_static[i] = isStatic(t);
+
+		// blend between the last two logic steps
+		glm::mat4 model_mat = glm::translate(glm::mat4(),
+				-t.interpolateCenter(c.Interpolation));
+		// rotation first (on the right) to act on the origin coords of the model
+		// and then translate into global coords.
+		model_mat = model_mat
+				* glm::mat4_cast(t.interpolateRotation(c.Interpolation));
+
+		auto const& m = c.MeshVisuals[i];
+		m_modelMatrices[i] = model_mat;
+
+		const auto center = model_mat * glm::vec4(m.BoundsCenter, 1.0f);
+		m_boundsX[i] = center.x;
+		m_boundsY[i] = center.y;
+		m_boundsZ[i] = center.z;
+		// meshes without bounds are always drawn
+		m_boundsRadius[i] =
+				(m.BoundsRadius < 0.0f) ?
+						std::numeric_limits<float>::infinity() : m.BoundsRadius;
+	}
+	m_culledTick = c.ExtractTick;
+
+	frustum.cullSpheres(m_boundsX.data(), m_boundsY.data(), m_boundsZ.data(),
+			m_boundsRadius.data(), count, m_inFrustum.data());
+}
+
 std::vector<RendererVisualChange> MeshRenderer::render(
 		RenderBackendBase & backend, VisualDataExtractContainer const & c,
 		TargetData const& td) {
+	auto & gl = GLSupport::api();
 
-	for (auto & m : c.MeshVisuals) {
+	cullMeshes(c, Frustum(td.ProjectionMatrix * td.CameraMatrix));
+	m_culledCount = 0;
+
+	// collect the draw calls of all meshes in view
+	m_queue.clear();
+	for (size_t i = 0; i < c.MeshVisuals.size(); i++) {
+		auto const& m = c.MeshVisuals[i];
 		if (!m.Visible)
 			continue;
-		glUseProgram(m.Shader.getId());
+		if (!m_inFrustum[i]) {
+			m_culledCount++;
+			continue;
+		}
 
-		// set the texture unit to use explicitly, cause Android VR is also using textures
-		// to draw on
-		glActiveTexture (GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, m.TextureId);
+		// use the simplest mesh whose screen size limit is not reached
+		DrawItem item;
+		item.Index = uint32_t(i);
+		item.VertexArrayObjectId = m.VertexArrayObjectId;
+		item.VertexCount = m.VertexCount;
+		item.InstancedVertexArrayObjectId = m.InstancedVertexArrayObjectId;
+		if (m.LevelOfDetailCount > 0) {
+			const float size = screenSize(
+					glm::vec3(m_boundsX[i], m_boundsY[i], m_boundsZ[i]),
+					m_boundsRadius[i], td);
+			for (size_t l = 0; l < m.LevelOfDetailCount; l++) {
+				auto const& lod = m.LevelsOfDetail[l];
+				if (size >= lod.MaxScreenSize) {
+					break;
+				}
+				item.VertexArrayObjectId = lod.VertexArrayObjectId;
+				item.VertexCount = lod.VertexCount;
+				item.InstancedVertexArrayObjectId =
+						lod.InstancedVertexArrayObjectId;
+			}
+		}
+		item.Key = RenderQueue::makeKey(m.Shader.getId(), m.TextureId,
+				item.VertexArrayObjectId);
+		m_queue.add(item);
+	}
+	m_queue.sort();
 
-		m.Shader.setUniform("tex", 0);
+	// only change the state which differs from the previous draw call
+	GLuint boundProgram = 0;
+	GLuint boundTexture = 0;
+	GLuint boundVertexArray = 0;
+	auto const& items = m_queue.getItems();
+	size_t groupBegin = 0;
+	while (groupBegin < items.size()) {
+		auto const& item = items[groupBegin];
+		auto const& m = c.MeshVisuals[item.Index];
 
-		m.Shader.setUniform("projection", td.ProjectionMatrix);
-		m.Shader.setUniform("camera", td.CameraMatrix);
+		// after sorting, the meshes with the same state follow each other
+		size_t groupEnd = groupBegin + 1;
+		while ((groupEnd < items.size())
+				&& sameState(item, m, items[groupEnd],
+						c.MeshVisuals[items[groupEnd].Index])) {
+			groupEnd++;
+		}
+		const size_t groupSize = groupEnd - groupBegin;
 
-		glm::mat4 model_mat = glm::translate(glm::mat4(), -m.Center);
-		// rotation first (on the right) to act on the origin coords of the model
-		// and then translate into global coords.
-		model_mat = model_mat * glm::mat4_cast(m.Rotation);
-		m.Shader.setUniform("model", model_mat);
+		const bool instanced = (item.InstancedVertexArrayObjectId != 0)
+				&& (m.InstancedShader.getId() != 0)
+				&& (groupSize >= MinInstanceCount);
+		auto const& shader = instanced ? m.InstancedShader : m.Shader;
+		const GLuint vertexArray =
+				instanced ?
+						item.InstancedVertexArrayObjectId :
+						item.VertexArrayObjectId;
+
+		const bool first = (groupBegin == 0);
+		if (first || (boundProgram != shader.getId())) {
+			boundProgram = shader.getId();
+			gl.useProgram(boundProgram);
+			// the uniforms are stored per program, so they are set once
+			// for each program change
+			shader.setUniform(ShaderVariables::Texture, 0);
+			if (!shader.usesTargetData()) {
+				shader.setUniform(ShaderVariables::Projection,
+						td.ProjectionMatrix);
+				shader.setUniform(ShaderVariables::Camera, td.CameraMatrix);
+			}
+		}
+
+		if (first || (boundTexture != m.TextureId)) {
+			// set the texture unit to use explicitly, cause Android VR is
+			// also using textures to draw on
+			if (first) {
+				gl.activeTexture(GL_TEXTURE0);
+			}
+			boundTexture = m.TextureId;
+			gl.bindTexture(GL_TEXTURE_2D, boundTexture);
+		}
 
-		backend.ext_glBindVertexArray(m.VertexArrayObjectId);
+		if (first || (boundVertexArray != vertexArray)) {
+			boundVertexArray = vertexArray;
+			backend.ext_glBindVertexArray(boundVertexArray);
+		}
 
-		// draw the VAO
-		glDrawArrays(GL_TRIANGLES, 0, m.VertexCount);
+		if (instanced) {
+			m_instanceMatrices.clear();
+			for (size_t i = groupBegin; i < groupEnd; i++) {
+				m_instanceMatrices.push_back(m_modelMatrices[items[i].Index]);
+			}
+
+			// the instanced vertex arrays read the model matrices from this
+			// buffer
+			const GLsizeiptr size = GLsizeiptr(
+					m_instanceMatrices.size() * sizeof(glm::mat4));
+			gl.bindBuffer(GL_ARRAY_BUFFER,
+					backend.getMeshBackend().getInstanceBuffer());
+			// Buffer orphaning, so the driver does not need to wait for the
+			// previous draw call reading the buffer
+			gl.bufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+			gl.bufferSubData(GL_ARRAY_BUFFER, 0, size,
+					m_instanceMatrices.data());
+			gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+			gl.drawArraysInstanced(GL_TRIANGLES, 0, item.VertexCount,
+					GLsizei(groupSize));
+		} else {
+			for (size_t i = groupBegin; i < groupEnd; i++) {
+				shader.setUniform(ShaderVariables::Model,
+						m_modelMatrices[items[i].Index]);
+				// draw the VAO
+				gl.drawArrays(GL_TRIANGLES, 0, items[i].VertexCount);
+			}
+		}
+
+		groupBegin = groupEnd;
+	}
 
+	if (!items.empty()) {
 		// unbind the VAO
 		backend.ext_glBindVertexArray(0);
-		glUseProgram(0);
+		gl.useProgram(0);
 	}
 
 	// this renderer will never do any changes
@@ -1,13 +1,43 @@
 #pragma once
 
 #include <SpheresEngine/RenderEngine/VisualRendererBase.h>
+#include <SpheresEngine/RenderEngine/RenderQueue.h>
+
+#include <glm/mat4x4.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class Frustum;
 
 /**
  * This class takes care of setting up meshes and rendering them for every frame
+ *
+ * Before the draw calls are submitted for a target, the bounding spheres of
+ * all meshes are tested against the view frustum of the target and the meshes
+ * outside of it are dropped. Visuals with simplified meshes are drawn with
+ * the level of detail matching their size on the screen.
+ *
+ * The draw calls of the remaining meshes are sorted by shader program,
+ * texture and vertex array, and the OpenGL state is only changed between
+ * two draw calls if it differs. Programs reading the "TargetData" uniform
+ * block get the camera and projection from the buffer bound by the
+ * RenderEngine, only the model matrix is set per draw call.
+ *
+ * If the "default_instanced" shader program is defined, all meshes of one
+ * group sharing the same state are drawn with one instanced draw call. Their
+ * model matrices are streamed into the instance buffer of the mesh backend
+ * once per group, so thousands of copies of a mesh cost a few draw calls.
  */
 class MeshRenderer: public VisualRendererBase {
 public:
 
+	/**
+	 * Groups with fewer meshes are drawn with one draw call per mesh, as the
+	 * upload of the model matrices costs more than it saves
+	 */
+	static constexpr size_t MinInstanceCount = 4;
+
 	/*
 	 * Ensures the texture and shader program for this mesh are properly loaded before
 	 * rendering
@@ -21,4 +51,78 @@ public:
 	 */
 	std::vector<RendererVisualChange> render(RenderBackendBase &,
 			VisualDataExtractContainer const&, TargetData const&) override;
+
+	/**
+	 * Number of visible meshes which were outside of the view frustum during
+	 * the last call to render()
+	 */
+	size_t getCulledCount() const {
+		return m_culledCount;
+	}
+
+private:
+
+	/**
+	 * Compute the model matrix and the bounding sphere in world coordinates
+	 * of all meshes and test the spheres against the frustum. The values of
+	 * static meshes which did not change since the last call are kept.
+	 */
+	void cullMeshes(VisualDataExtractContainer const& c,
+			Frustum const& frustum);
+
+	/**
+	 * Extraction number of the container culled last, zero if it was not
+	 * filled by an extraction
+	 */
+	uint64_t m_culledTick = 0;
+
+	/**
+	 * 1 for each mesh which did not move in the container culled last
+	 */
+	std::vector<uint8_t> m_static;
+
+	/**
+	 * Model matrix of each mesh for the current frame
+	 */
+	std::vector<glm::mat4> m_modelMatrices;
+
+	/**
+	 * x coordinate of the bounding sphere center of each mesh
+	 */
+	std::vector<float> m_boundsX;
+
+	/**
+	 * y coordinate of the bounding sphere center of each mesh
+	 */
+	std::vector<float> m_boundsY;
+
+	/**
+	 * z coordinate of the bounding sphere center of each mesh
+	 */
+	std::vector<float> m_boundsZ;
+
+	/**
+	 * Radius of the bounding sphere of each mesh
+	 */
+	std::vector<float> m_boundsRadius;
+
+	/**
+	 * 1 for each mesh which is inside the frustum
+	 */
+	std::vector<uint8_t> m_inFrustum;
+
+	/**
+	 * Model matrices of the meshes in the group currently drawn instanced
+	 */
+	std::vector<glm::mat4> m_instanceMatrices;
+
+	/**
+	 * Draw calls of the meshes in view, sorted by their state
+	 */
+	RenderQueue m_queue;
+
+	/**
+	 * Meshes dropped by the last call to render()
+	 */
+	size_t m_culledCount = 0;
 };
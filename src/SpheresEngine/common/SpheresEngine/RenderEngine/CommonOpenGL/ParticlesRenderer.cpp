@@ -1,8 +1,10 @@
 #include "ParticlesRenderer.h"
 
 #include <SpheresEngine/RenderEngine/RenderBackendBase.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
 #include <SpheresEngine/RenderEngine/Targets/RenderTargetBase.h>
 #include <SpheresEngine/RenderEngine/RendererVisualChange.h>
+#include <SpheresEngine/Util.h>
 
 #include <glm/glm.hpp>
 #include <glm/vec3.hpp> // glm::vec3
@@ -10,8 +12,12 @@
 #include <glm/mat4x4.hpp> // glm::mat4
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstring>
+#include <mutex>
+
 bool ParticlesRenderer::prepare(VisualAbstract &vd,
 		RenderBackendBase & renderBackend, ResourceEngine &) {
+	auto & gl = GLSupport::api();
 	VisualAbstract * pVd = &vd;
 
 	auto pPartVisual = dynamic_cast<ParticleSystemVisual*>(pVd);
@@ -29,9 +35,9 @@ bool ParticlesRenderer::prepare(VisualAbstract &vd,
 		static const GLfloat g_vertex_buffer_data[] = { -psize, -psize, 0.0f,
 				psize, -psize, 0.0f, -psize, psize, 0.0f, psize, psize, 0.0f, };
 		GLuint billboard_vertex_buffer;
-		glGenBuffers(1, &billboard_vertex_buffer);
-		glBindBuffer(GL_ARRAY_BUFFER, billboard_vertex_buffer);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data),
+		gl.genBuffers(1, &billboard_vertex_buffer);
+		gl.bindBuffer(GL_ARRAY_BUFFER, billboard_vertex_buffer);
+		gl.bufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data),
 				g_vertex_buffer_data, GL_STATIC_DRAW);
 		m_protoVertex.setValue(billboard_vertex_buffer);
 	}
@@ -39,25 +45,36 @@ bool ParticlesRenderer::prepare(VisualAbstract &vd,
 	auto shaderProg = renderBackend.getShaderBackend().loadProgram("particles");
 	pPartVisual->getData().Shader = shaderProg;
 
-	// The VBO containing the positions and sizes of the particles
-	GLuint particles_position_buffer;
-	glGenBuffers(1, &particles_position_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, particles_position_buffer);
-	// Initialize with empty (NULL) buffer : it will be updated later, each frame.
-	glBufferData(GL_ARRAY_BUFFER,
-			pPartVisual->getParticleCount() * 4 * sizeof(GLfloat), NULL,
-			GL_STREAM_DRAW);
-	pPartVisual->getData().vertexPositionBuffer = particles_position_buffer;
-
-	// The VBO containing the colors of the particles
-	GLuint particles_color_buffer;
-	glGenBuffers(1, &particles_color_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, particles_color_buffer);
-	// Initialize with empty (NULL) buffer : it will be updated later, each frame.
-	glBufferData(GL_ARRAY_BUFFER,
-			pPartVisual->getParticleCount() * 4 * sizeof(GLubyte), NULL,
-			GL_STREAM_DRAW);
-	pPartVisual->getData().vertexColorBuffer = particles_color_buffer;
+	auto & data = pPartVisual->getData();
+	auto const& simulationProgram = data.SimulationProgramName;
+	if (!simulationProgram.empty()) {
+		auto & shaderBackend = renderBackend.getShaderBackend();
+		if (shaderBackend.hasProgramDefinition(simulationProgram)) {
+			data.SimulationShader = shaderBackend.loadProgram(simulationProgram);
+		}
+		if (!data.hasGpuSimulation()) {
+			logging::Error() << "Simulation program " << simulationProgram
+					<< " not available, simulating the particles on the CPU";
+		}
+	}
+
+	// The VBOs containing the positions and sizes and the colors of the
+	// particles, they are written when the particles are rendered
+	const auto particleCount = pPartVisual->getParticleCount();
+	auto streamed = std14::make_unique<StreamedParticles>();
+	streamed->Lifetime = data.Lifetime;
+	streamed->Handoff = data.Handoff.get();
+	streamed->Positions.reserve(particleCount * 4 * sizeof(GLfloat));
+	streamed->Colors.reserve(particleCount * 4 * sizeof(GLubyte));
+	pPartVisual->getData().vertexPositionBuffer = streamed->Positions.getId();
+	pPartVisual->getData().vertexColorBuffer = streamed->Colors.getId();
+	if (data.hasGpuSimulation()) {
+		// storage is allocated when the particles are uploaded
+		gl.genBuffers(2, streamed->SimulatedPositions.data());
+		gl.genBuffers(2, streamed->SimulatedVelocities.data());
+	}
+	// nothing uploaded yet
+	m_streamed[streamed->Positions.getId()] = std::move(streamed);
 
 	logging::Info() << "Registered particle system with "
 			<< pPartVisual->getParticleCount() << " particles";
@@ -67,50 +84,76 @@ bool ParticlesRenderer::prepare(VisualAbstract &vd,
 
 std::vector<RendererVisualChange> ParticlesRenderer::render(RenderBackendBase &,
 		VisualDataExtractContainer const& c, TargetData const& td) {
+	auto & gl = GLSupport::api();
+	releaseDestroyed();
+
 	for (auto & particles : c.ParticleSystems) {
-		glUseProgram(particles.Shader.getId());
+		// systems which have not been prepared have no buffers to draw from
+		auto it = m_streamed.find(particles.vertexPositionBuffer);
+		if ((it == m_streamed.end())
+				|| (it->second->Handoff != particles.Handoff.get())) {
+			particles.markRendered();
+			continue;
+		}
+		auto & streamed = *it->second;
+
+		// the GPU simulation runs before the particles are drawn, only
+		// added particles need to be uploaded
+		GLuint positionBuffer = particles.vertexPositionBuffer;
+		if (particles.hasGpuSimulation()) {
+			if (streamed.SimulatedCount != particles.getParticleCount()) {
+				uploadSimulationState(streamed, particles);
+			}
+			simulate(streamed, particles);
+			readBack(streamed, particles);
+			positionBuffer = streamed.SimulatedPositions[streamed.Current];
+		}
+
+		gl.useProgram(particles.Shader.getId());
 
-		particles.Shader.setUniform("projection", td.ProjectionMatrix);
-		particles.Shader.setUniform("camera", td.CameraMatrix);
+		// otherwise read from the buffer bound for the target
+		if (!particles.Shader.usesTargetData()) {
+			particles.Shader.setUniform(ShaderVariables::Projection,
+					td.ProjectionMatrix);
+			particles.Shader.setUniform(ShaderVariables::Camera,
+					td.CameraMatrix);
+		}
 
-		glm::mat4 model_mat = glm::translate(glm::mat4(), particles.Center);
+		// blend between the last two logic steps
+		glm::mat4 model_mat = glm::translate(glm::mat4(),
+				particles.interpolateCenter(c.Interpolation));
 
 		// todo: apply rotation
 
-		particles.Shader.setUniform("model", model_mat);
+		particles.Shader.setUniform(ShaderVariables::Model, model_mat);
 
 		particles.Shader.applyUserValues(particles.UserData);
 		//backend.ext_glBindVertexArray(m.VertexArrayObjectId);
 
-		// dowload new position data
-		// todo: don't do this every frame !?!
-
 		GLsizei particleCount = particles.getParticleCount();
 
 		// only download if the there actually was a CPU-side change to the particles
-		if (particles.Updated) {
-			glBindBuffer(GL_ARRAY_BUFFER, particles.vertexPositionBuffer);
-			glBufferData(GL_ARRAY_BUFFER, particleCount * 4 * sizeof(GLfloat),
-			NULL,
-			GL_STREAM_DRAW); // Buffer orphaning, a common way to improve streaming perf. See above link for details.
-			const auto posSizeBuffer = particles.getPosSizeBuffer();
-			glBufferSubData(GL_ARRAY_BUFFER, 0,
-					particleCount * sizeof(GLfloat) * 4, posSizeBuffer);
-
-			glBindBuffer(GL_ARRAY_BUFFER, particles.vertexColorBuffer);
-			glBufferData(GL_ARRAY_BUFFER, particleCount * 4 * sizeof(GLubyte),
-			NULL,
-			GL_STREAM_DRAW); // Buffer orphaning, a common way to improve streaming perf. See above link for details.
-			const auto colorBuffer = particles.getColorBuffer();
-			glBufferSubData(GL_ARRAY_BUFFER, 0,
-					particleCount * sizeof(GLubyte) * 4, colorBuffer);
+		// since the last upload, the colors only if they changed as well
+		if (!particles.hasGpuSimulation()
+				&& (streamed.Version != particles.Version)) {
+			streamed.Version = particles.Version;
+			streamed.PositionOffset = streamed.Positions.upload(
+					particles.getPosSizeBuffer(),
+					particleCount * sizeof(GLfloat) * 4);
+		}
+		if (streamed.ColorVersion != particles.ColorVersion) {
+			streamed.ColorVersion = particles.ColorVersion;
+			streamed.ColorOffset = streamed.Colors.upload(
+					particles.getColorBuffer(),
+					particleCount * sizeof(GLubyte) * 4);
 		}
 
 		// set up the arttributes for shader execution
-		const auto attribVert = particles.Shader.getAttribLocation("vert");
-		glEnableVertexAttribArray(attribVert);
-		glBindBuffer(GL_ARRAY_BUFFER, m_protoVertex.get());
-		glVertexAttribPointer(attribVert, // attribute. No particular reason for 0, but must match the layout in the shader.
+		const auto attribVert = particles.Shader.getAttribLocation(
+				ShaderVariables::Vertex);
+		gl.enableVertexAttribArray(attribVert);
+		gl.bindBuffer(GL_ARRAY_BUFFER, m_protoVertex.get());
+		gl.vertexAttribPointer(attribVert, // attribute. No particular reason for 0, but must match the layout in the shader.
 				3, // size
 				GL_FLOAT, // type
 				GL_FALSE, // normalized?
@@ -118,47 +161,221 @@ std::vector<RendererVisualChange> ParticlesRenderer::render(RenderBackendBase &,
 				(void*) 0 // array buffer offset
 				);
 
-		// 2nd attribute buffer : positions of particles' centers
+		// 2nd attribute buffer : positions of particles' centers, the
+		// simulation buffers hold the particles at their start
+		const GLintptr positionOffset = particles.hasGpuSimulation() ?
+				0 : streamed.PositionOffset;
 		const auto attribVertPos = particles.Shader.getAttribLocation(
-				"vertInstanceCenter");
-		glEnableVertexAttribArray(attribVertPos);
-		glBindBuffer(GL_ARRAY_BUFFER, particles.vertexPositionBuffer);
-		glVertexAttribPointer(attribVertPos, // attribute. No particular reason for 1, but must match the layout in the shader.
+				ShaderVariables::InstanceCenter);
+		gl.enableVertexAttribArray(attribVertPos);
+		gl.bindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+		gl.vertexAttribPointer(attribVertPos, // attribute. No particular reason for 1, but must match the layout in the shader.
 				4, // size : x + y + z + size => 4
 				GL_FLOAT, // type
 				GL_FALSE, // normalized?
 				0, // stride
-				(void*) 0 // array buffer offset
+				(void*) positionOffset // array buffer offset
 				);
 
 		// 3rd attribute buffer : particles' colors
 		const auto attribVertColor = particles.Shader.getAttribLocation(
-				"vertInstanceColor");
-		glEnableVertexAttribArray(attribVertColor);
-		glBindBuffer(GL_ARRAY_BUFFER, particles.vertexColorBuffer);
-		glVertexAttribPointer(2, // attribute. No particular reason for 1, but must match the layout in the shader.
+				ShaderVariables::InstanceColor);
+		gl.enableVertexAttribArray(attribVertColor);
+		gl.bindBuffer(GL_ARRAY_BUFFER, particles.vertexColorBuffer);
+		gl.vertexAttribPointer(attribVertColor, // attribute. Resolved from the shader like the others.
 				4, // size : r + g + b + a => 4
 				GL_UNSIGNED_BYTE, // type
 				GL_TRUE, // normalized? *** YES, this means that the unsigned char[4] will be accessible with a vec4 (floats) in the shader ***
 				0, // stride
-				(void*) 0 // array buffer offset
+				(void*) streamed.ColorOffset // array buffer offset
 				);
 
-		glVertexAttribDivisor(attribVert, 0); // particles vertices : always reuse the same 4 vertices -> 0
-		glVertexAttribDivisor(attribVertPos, 1); // positions : one per quad (its center) -> 1
-		glVertexAttribDivisor(attribVertColor, 1); // positions : one per quad (its center) -> 1
+		gl.vertexAttribDivisor(attribVert, 0); // particles vertices : always reuse the same 4 vertices -> 0
+		gl.vertexAttribDivisor(attribVertPos, 1); // positions : one per quad (its center) -> 1
+		gl.vertexAttribDivisor(attribVertColor, 1); // positions : one per quad (its center) -> 1
 
 		// ! todo: draw the array which is supplied within particles
-		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, particleCount);
+		gl.drawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, particleCount);
 		// draw the VAO
 		//glDrawArrays(GL_TRIANGLES, 0, m.VertexCount);
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		gl.bindBuffer(GL_ARRAY_BUFFER, 0);
 		// unbind the VAO
 		//backend.ext_glBindVertexArray(0);
-		glUseProgram(0);
+		gl.useProgram(0);
+
+		// the particles have been copied to the GPU
+		particles.markRendered();
 	}
 
 	return std::vector<RendererVisualChange>();
 }
 
+void ParticlesRenderer::releaseDestroyed() {
+	auto & gl = GLSupport::api();
+	for (auto it = m_streamed.begin(); it != m_streamed.end();) {
+		auto & streamed = *it->second;
+		if (!streamed.Lifetime.expired()) {
+			++it;
+			continue;
+		}
+
+		// data extracted before the system was destroyed is not drawn
+		// anymore, see StreamedParticles::Handoff
+		streamed.Positions.release();
+		streamed.Colors.release();
+		if (streamed.SimulatedPositions[0] != 0) {
+			gl.deleteBuffers(2, streamed.SimulatedPositions.data());
+			gl.deleteBuffers(2, streamed.SimulatedVelocities.data());
+		}
+		it = m_streamed.erase(it);
+	}
+}
+
+void ParticlesRenderer::uploadSimulationState(StreamedParticles & streamed,
+		ParticleSystemExtractData const& particles) {
+	auto & gl = GLSupport::api();
+	const auto count = particles.getParticleCount();
+	const auto kept = streamed.SimulatedCount;
+	const auto size = count * 4 * sizeof(GLfloat);
+
+	if ((kept == 0) || (count < kept)) {
+		// nothing to keep, upload all particles
+		particles.Particles->interleaveVelocities(m_velocities);
+
+		// the other buffers only need storage for the next simulation step
+		for (size_t i = 0; i < streamed.SimulatedPositions.size(); i++) {
+			const bool current = (i == streamed.Current);
+			gl.bindBuffer(GL_ARRAY_BUFFER, streamed.SimulatedPositions[i]);
+			gl.bufferData(GL_ARRAY_BUFFER, size,
+					current ? particles.getPosSizeBuffer() : NULL,
+					GL_DYNAMIC_COPY);
+			gl.bindBuffer(GL_ARRAY_BUFFER, streamed.SimulatedVelocities[i]);
+			gl.bufferData(GL_ARRAY_BUFFER, size,
+					current ? m_velocities.data() : NULL, GL_DYNAMIC_COPY);
+		}
+		gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+		streamed.SimulatedCount = count;
+		streamed.SimulationTime = particles.SimulationTime;
+		return;
+	}
+
+	// the CPU copy of the simulated particles is outdated, copy their GPU
+	// state to the other buffers and append the added particles
+	const auto keptSize = kept * 4 * sizeof(GLfloat);
+	const auto addedSize = size - keptSize;
+	particles.Particles->interleaveVelocities(m_velocities, kept);
+	const auto next = 1 - streamed.Current;
+
+	const auto append = [&] (std::array<GLuint, 2> const& buffers,
+			const GLvoid * added) {
+		gl.bindBuffer(GL_COPY_WRITE_BUFFER, buffers[next]);
+		gl.bufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_DYNAMIC_COPY);
+		gl.bindBuffer(GL_COPY_READ_BUFFER, buffers[streamed.Current]);
+		gl.copyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+				keptSize);
+		gl.bufferSubData(GL_COPY_WRITE_BUFFER, keptSize, addedSize, added);
+
+		// the old state only needs storage for the next simulation step
+		gl.bufferData(GL_COPY_READ_BUFFER, size, NULL, GL_DYNAMIC_COPY);
+	};
+	append(streamed.SimulatedPositions,
+			particles.getPosSizeBuffer() + 4 * kept);
+	append(streamed.SimulatedVelocities, m_velocities.data());
+	gl.bindBuffer(GL_COPY_READ_BUFFER, 0);
+	gl.bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	streamed.Current = next;
+	streamed.SimulatedCount = count;
+}
+
+void ParticlesRenderer::simulate(StreamedParticles & streamed,
+		ParticleSystemExtractData const& particles) {
+	auto & gl = GLSupport::api();
+	const float deltaT = float(
+			particles.SimulationTime - streamed.SimulationTime);
+	const GLsizei particleCount = particles.getParticleCount();
+	if ((deltaT <= 0.0f) || (particleCount == 0)) {
+		return;
+	}
+	streamed.SimulationTime = particles.SimulationTime;
+
+	auto const& simulation = particles.SimulationShader;
+	const auto next = 1 - streamed.Current;
+
+	gl.useProgram(simulation.getId());
+	simulation.setUniform(ShaderVariables::SimulationDeltaT, deltaT);
+
+	// read the current state ...
+	const auto attribPositionSize = simulation.getAttribLocation(
+			ShaderVariables::SimulationPositionSize);
+	const auto attribVelocity = simulation.getAttribLocation(
+			ShaderVariables::SimulationVelocity);
+	gl.enableVertexAttribArray(attribPositionSize);
+	gl.bindBuffer(GL_ARRAY_BUFFER, streamed.SimulatedPositions[streamed.Current]);
+	gl.vertexAttribPointer(attribPositionSize, 4, GL_FLOAT, GL_FALSE, 0,
+			(void*) 0);
+	gl.vertexAttribDivisor(attribPositionSize, 0);
+	gl.enableVertexAttribArray(attribVelocity);
+	gl.bindBuffer(GL_ARRAY_BUFFER, streamed.SimulatedVelocities[streamed.Current]);
+	gl.vertexAttribPointer(attribVelocity, 4, GL_FLOAT, GL_FALSE, 0, (void*) 0);
+	gl.vertexAttribDivisor(attribVelocity, 0);
+
+	// ... and capture the next one, nothing is rasterized
+	gl.bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0,
+			streamed.SimulatedPositions[next]);
+	gl.bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 1,
+			streamed.SimulatedVelocities[next]);
+	gl.enable(GL_RASTERIZER_DISCARD);
+	gl.beginTransformFeedback(GL_POINTS);
+	gl.drawArrays(GL_POINTS, 0, particleCount);
+	gl.endTransformFeedback();
+	gl.disable(GL_RASTERIZER_DISCARD);
+	gl.bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	gl.bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 1, 0);
+
+	gl.disableVertexAttribArray(attribPositionSize);
+	gl.disableVertexAttribArray(attribVelocity);
+	gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	streamed.Current = next;
+}
+
+void ParticlesRenderer::readBack(StreamedParticles const& streamed,
+		ParticleSystemExtractData const& particles) {
+	auto & readback = *particles.Readback;
+	std::lock_guard<std::mutex> lock(readback.Mutex);
+	if (!readback.Requested) {
+		return;
+	}
+	readback.Requested = false;
+
+	auto & gl = GLSupport::api();
+	const auto valueCount = particles.getParticleCount() * 4;
+	const auto copyFromBuffer =
+			[&gl, valueCount] (GLuint buffer, std::vector<GLfloat> & target) {
+				target.assign(valueCount, 0.0f);
+				if (valueCount == 0) {
+					return;
+				}
+				gl.bindBuffer(GL_ARRAY_BUFFER, buffer);
+				// waits until the simulation step has been completed
+				auto source = gl.mapBufferRange(GL_ARRAY_BUFFER, 0,
+						valueCount * sizeof(GLfloat), GL_MAP_READ_BIT);
+				if (!source) {
+					logging::Error() << "Cannot map particle buffer for readback";
+					return;
+				}
+				std::memcpy(target.data(), source, valueCount * sizeof(GLfloat));
+				gl.unmapBuffer(GL_ARRAY_BUFFER);
+			};
+
+	copyFromBuffer(streamed.SimulatedPositions[streamed.Current],
+			readback.PositionSizes);
+	copyFromBuffer(streamed.SimulatedVelocities[streamed.Current],
+			readback.Velocities);
+	gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	readback.Completed = true;
+}
@@ -1,6 +1,12 @@
 #pragma once
 
 #include <SpheresEngine/RenderEngine/VisualRendererBase.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/StreamingBuffer.h>
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 /**
  * This renderer prepares and renders complex particle systems using
@@ -17,15 +23,124 @@ public:
 			override;
 
 	/**
-	 * re-download the particle data, if they have been updated, selects the
+	 * re-download the particle data, if their version changed, selects the
 	 * correct shader and renders the particles
 	 */
 	std::vector<RendererVisualChange> render(RenderBackendBase &,
 			VisualDataExtractContainer const&, TargetData const&) override;
 
 private:
+	/**
+	 * GPU copy of the particles of one particle system
+	 */
+	struct StreamedParticles {
+		/**
+		 * Expires when the particle system is destroyed
+		 */
+		std::weak_ptr<const bool> Lifetime;
+
+		/**
+		 * Handoff of the particle system, only compared to tell apart data
+		 * extracted from a destroyed system whose buffer id got reused
+		 */
+		ParticleHandoff const* Handoff = nullptr;
+
+		/**
+		 * Version of the particles uploaded last
+		 */
+		size_t Version = 0;
+
+		/**
+		 * Version of the colors uploaded last
+		 */
+		size_t ColorVersion = 0;
+
+		/**
+		 * Holds the positions and sizes of the particles
+		 */
+		StreamingBuffer Positions;
+
+		/**
+		 * Holds the colors of the particles
+		 */
+		StreamingBuffer Colors;
+
+		/**
+		 * Offset of the last uploaded positions in their buffer
+		 */
+		GLintptr PositionOffset = 0;
+
+		/**
+		 * Offset of the last uploaded colors in their buffer
+		 */
+		GLintptr ColorOffset = 0;
+
+		/**
+		 * Positions and sizes of the GPU simulation, one buffer is read and
+		 * the other one written by each simulation step
+		 */
+		std::array<GLuint, 2> SimulatedPositions { };
+
+		/**
+		 * Velocities and lifetimes of the GPU simulation, read and written
+		 * like the positions
+		 */
+		std::array<GLuint, 2> SimulatedVelocities { };
+
+		/**
+		 * Index of the buffers holding the current GPU simulation state
+		 */
+		size_t Current = 0;
+
+		/**
+		 * Number of particles in the GPU simulation state
+		 */
+		size_t SimulatedCount = 0;
+
+		/**
+		 * Seconds simulated on the GPU so far
+		 */
+		double SimulationTime = 0.0;
+	};
+
+	/**
+	 * Free the GPU buffers of all particle systems which have been destroyed
+	 */
+	void releaseDestroyed();
+
+	/**
+	 * Upload the particles added since the last upload to the GPU
+	 * simulation, the particles simulated so far keep their GPU state
+	 */
+	void uploadSimulationState(StreamedParticles & streamed,
+			ParticleSystemExtractData const& particles);
+
+	/**
+	 * Advance the GPU simulation to the simulation time of the particles
+	 * with transform feedback
+	 */
+	void simulate(StreamedParticles & streamed,
+			ParticleSystemExtractData const& particles);
+
+	/**
+	 * Copy the current GPU simulation state to the CPU, if requested
+	 */
+	void readBack(StreamedParticles const& streamed,
+			ParticleSystemExtractData const& particles);
+
 	/**
 	 * the one vertex which will be drawn instanced for all particle systems
 	 */
 	util::ValidValue<GLuint> m_protoVertex;
+
+	/**
+	 * The uploaded particles of each particle system, identified by its
+	 * position buffer id
+	 */
+	std::unordered_map<GLuint, std::unique_ptr<StreamedParticles>> m_streamed;
+
+	/**
+	 * Memory reused to interleave the velocities for the GPU simulation
+	 */
+	std::vector<GLfloat> m_velocities;
 };
@@ -1,11 +1,15 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <SpheresEngine/Log.h>
+#include <SpheresEngine/Util.h>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderBackend.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
 #include <SpheresEngine/RenderEngine/OpenGLInclude.h>
 #include <cstring>
 #include <ostream>
 
+constexpr GLint ShaderLocations::NotFound;
+
 std::vector<RendererVisualChange> ShaderBackend::checkReload() {
 	std::vector<RendererVisualChange> changes;
 
@@ -45,7 +49,8 @@ std::vector<RendererVisualChange> ShaderBackend::checkReload() {
 				}
 				changes.push_back(
 						RendererVisualChange::createShaderProgramReloaded(
-								loaded.getName(), loaded.getId()));
+								loaded.getName(), loaded.getId(),
+								loaded.shareLocations()));
 
 			}
 		}
@@ -106,7 +111,7 @@ ShaderProgram ShaderBackend::loadProgram(std::string name, bool ignoreCache,
 		fileNames.push_back(filename_shader.first);
 	}
 
-	auto linkedProg = linkProgram(compiledShaders);
+	auto linkedProg = linkProgram(compiledShaders, m_feedbackVaryings[name]);
 	linkedProg.setName(name);
 	std::for_each(fileNames.begin(), fileNames.end(),
 			[&linkedProg] ( std::string fn ) {linkedProg.addShaderFile(fn);});
@@ -114,13 +119,19 @@ ShaderProgram ShaderBackend::loadProgram(std::string name, bool ignoreCache,
 //std::for_each(fileWatchers.begin(), fileWatchers.end(),
 //			[&linkedProg]( FileWatcherPtr & pt ) {linkedProg.addWatcher(pt);});
 
-	if (!dontStore)
+	if (!dontStore) {
+		// the re-linked program replaces the old one
+		if (it != m_loadedPrograms.end()) {
+			m_locations.erase(it->second.getId());
+		}
 		m_loadedPrograms[name] = linkedProg;
+	}
 	return linkedProg;
 }
 
 Shader ShaderBackend::compileShader(std::string name, std::string src,
 		Shader::Type type) {
+	auto & gl = GLSupport::api();
 
 	GLint compile_ok = GL_FALSE;
 
@@ -136,22 +147,22 @@ Shader ShaderBackend::compileShader(std::string name, std::string src,
 		shaderType = GL_VERTEX_SHADER;
 	}
 
-	GLuint fs = glCreateShader(shaderType);
+	GLuint fs = gl.createShader(shaderType);
 
 	char * cstr = new char[src.length() + 1];
 	std::strcpy(cstr, src.c_str());
 
 	const char * cstrConst = cstr;
 
-	glShaderSource(fs, 1, &cstrConst, NULL);
+	gl.shaderSource(fs, 1, &cstrConst, NULL);
 	delete[] cstr;
 
-	glCompileShader(fs);
-	glGetShaderiv(fs, GL_COMPILE_STATUS, &compile_ok);
+	gl.compileShader(fs);
+	gl.getShaderiv(fs, GL_COMPILE_STATUS, &compile_ok);
 	if (!compile_ok) {
 		GLchar shaderLog[1024];
 		GLsizei actualLength = 0;
-		glGetShaderInfoLog(fs, 1023, &actualLength, shaderLog);
+		gl.getShaderInfoLog(fs, 1023, &actualLength, shaderLog);
 
 		logging::Error() << "Cannot compile shader '" << name
 				<< "' due to error: " << shaderLog;
@@ -163,8 +174,17 @@ Shader ShaderBackend::compileShader(std::string name, std::string src,
 
 }
 
-GLint ShaderProgram::getAttribLocation(std::string name) const {
-	GLint attribute_coord2d = glGetAttribLocation(getId(), name.c_str());
+GLint ShaderProgram::getAttribLocation(std::string const& name) const {
+	if (m_locations) {
+		const auto location = m_locations->findAttribute(
+				ShaderVariable::hashName(name.c_str()));
+		if (location != ShaderLocations::NotFound) {
+			return location;
+		}
+	}
+
+	GLint attribute_coord2d = GLSupport::api().getAttribLocation(getId(),
+			name.c_str());
 	if (attribute_coord2d == -1) {
 		logging::Fatal() << "Cannot find attribute " << name << " in program";
 		return 0;
@@ -172,12 +192,31 @@ GLint ShaderProgram::getAttribLocation(std::string name) const {
 	return attribute_coord2d;
 }
 
-GLint ShaderProgram::getUniformLocation(std::string name) const {
-	GLint attribute_coord2d = glGetUniformLocation(getId(), name.c_str());
+GLint ShaderProgram::getAttribLocation(ShaderVariable const& variable) const {
+	if (m_locations) {
+		const auto location = m_locations->findAttribute(variable.getHash());
+		if (location != ShaderLocations::NotFound) {
+			return location;
+		}
+	}
+	return getAttribLocation(std::string(variable.getName()));
+}
+
+GLint ShaderProgram::getUniformLocation(std::string const& name) const {
+	if (m_locations) {
+		const auto location = m_locations->findUniform(
+				ShaderVariable::hashName(name.c_str()));
+		if (location != ShaderLocations::NotFound) {
+			return location;
+		}
+	}
+
+	auto & gl = GLSupport::api();
+	GLint attribute_coord2d = gl.getUniformLocation(getId(), name.c_str());
 	if (attribute_coord2d == -1) {
 
 		GLint uniformNumber;
-		glGetProgramiv(getId(), GL_ACTIVE_UNIFORMS, &uniformNumber);
+		gl.getProgramiv(getId(), GL_ACTIVE_UNIFORMS, &uniformNumber);
 
 		logging::Info() << "Got " << uniformNumber << " active uniforms";
 		logging::Fatal() << "Cannot find uniform " << name << " in program";
@@ -186,27 +225,57 @@ GLint ShaderProgram::getUniformLocation(std::string name) const {
 	return attribute_coord2d;
 }
 
+GLint ShaderProgram::getUniformLocation(ShaderVariable const& variable) const {
+	if (m_locations) {
+		const auto location = m_locations->findUniform(variable.getHash());
+		if (location != ShaderLocations::NotFound) {
+			return location;
+		}
+	}
+	return getUniformLocation(std::string(variable.getName()));
+}
+
+void ShaderProgram::setUniform(ShaderVariable const& variable, GLint i) const {
+	GLSupport::api().uniform1i(getUniformLocation(variable), i);
+}
+
+void ShaderProgram::setUniform(ShaderVariable const& variable,
+		glm::mat4 const& m, GLboolean transpose) const {
+	GLSupport::api().uniformMatrix4fv(getUniformLocation(variable), 1,
+			transpose, glm::value_ptr(m));
+}
+
+void ShaderProgram::setUniform(ShaderVariable const& variable,
+		glm::vec3 const& v) const {
+	GLSupport::api().uniform3f(getUniformLocation(variable), v.x, v.y, v.z);
+}
+
+void ShaderProgram::setUniform(ShaderVariable const& variable, float v) const {
+	GLSupport::api().uniform1f(getUniformLocation(variable), v);
+}
+
 void ShaderProgram::setUniform(std::string name, GLint i) const {
-	glUniform1i(getUniformLocation(name), i);
+	GLSupport::api().uniform1i(getUniformLocation(name), i);
 }
 
 void ShaderProgram::setUniform(std::string name, glm::mat4 m,
 		GLboolean transpose) const {
-	glUniformMatrix4fv(getUniformLocation(name), 1, transpose,
+	GLSupport::api().uniformMatrix4fv(getUniformLocation(name), 1, transpose,
 			glm::value_ptr(m));
 }
 
 void ShaderProgram::setUniform(std::string name,
 		std::array<float, 16> mat4) const {
-	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, mat4.data());
+	GLSupport::api().uniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE,
+			mat4.data());
 }
 
 void ShaderProgram::setUniform(std::string name, float v) const {
-	glUniform1f(getUniformLocation(name), v);
+	GLSupport::api().uniform1f(getUniformLocation(name), v);
 }
 
 void ShaderProgram::setUniform(std::string name, glm::vec3 v) const {
-	glUniform3f(getUniformLocation(name), v.x, v.y, v.z);
+	GLSupport::api().uniform3f(getUniformLocation(name), v.x, v.y, v.z);
 }
 
 void ShaderProgram::setName(std::string name) {
@@ -217,10 +286,17 @@ std::string ShaderProgram::getName() const {
 	return m_programName;
 }
 
-void ShaderProgram::applyUserValues(ShaderUserDataContainer cont) const {
-	for (auto & user_float : cont.Floats) {
-		auto uniform_name = toVar(user_float.first);
-		setUniform(uniform_name, user_float.second);
+void ShaderProgram::applyUserValues(ShaderUserDataContainer const& cont) const {
+	for (auto const& user_float : cont.Floats) {
+		const auto location =
+				m_locations ?
+						m_locations->findUserValue(user_float.first) :
+						ShaderLocations::NotFound;
+		if (location != ShaderLocations::NotFound) {
+			GLSupport::api().uniform1f(location, user_float.second);
+		} else {
+			setUniform(toVar(user_float.first), user_float.second);
+		}
 	}
 }
 
@@ -228,21 +304,95 @@ void ShaderProgram::applyUserValues(ShaderUserDataContainer cont) const {
  m_watches.push_back(fw);
  }*/
 
-ShaderProgram ShaderBackend::linkProgram(std::vector<Shader> shaders) {
+ShaderProgram ShaderBackend::linkProgram(std::vector<Shader> shaders,
+		std::vector<std::string> const& feedbackVaryings) {
+	auto & gl = GLSupport::api();
 	GLint link_ok = GL_FALSE;
-	GLuint program = glCreateProgram();
+	GLuint program = gl.createProgram();
 
 	for (auto & shader : shaders) {
-		glAttachShader(program, shader.getId());
+		gl.attachShader(program, shader.getId());
 	}
 
-	glLinkProgram(program);
-	glGetProgramiv(program, GL_LINK_STATUS, &link_ok);
+	// the captured outputs need to be known before linking
+	if (!feedbackVaryings.empty()) {
+		std::vector<const GLchar *> varyings;
+		for (auto const& varying : feedbackVaryings) {
+			varyings.push_back(varying.c_str());
+		}
+		gl.transformFeedbackVaryings(program, GLsizei(varyings.size()),
+				varyings.data(), GL_SEPARATE_ATTRIBS);
+	}
+
+	gl.linkProgram(program);
+	gl.getProgramiv(program, GL_LINK_STATUS, &link_ok);
 	if (!link_ok) {
 		logging::Fatal() << "Cannot link OpenGL program";
 		return 0;
 	}
 
 	logging::Info() << "Shader program linked";
-	return ShaderProgram(program);
+	ShaderProgram linked(program);
+	linked.setLocations(resolveLocations(program));
+	return linked;
+}
+
+std::shared_ptr<const ShaderLocations> ShaderBackend::resolveLocations(
+		GLuint program) {
+	auto & gl = GLSupport::api();
+	auto locations = std::make_shared<ShaderLocations>();
+
+	GLint uniformCount = 0;
+	GLint attributeCount = 0;
+	GLint maxUniformLength = 0;
+	GLint maxAttributeLength = 0;
+	gl.getProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	gl.getProgramiv(program, GL_ACTIVE_ATTRIBUTES, &attributeCount);
+	gl.getProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxUniformLength);
+	gl.getProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH,
+			&maxAttributeLength);
+
+	std::vector<GLchar> name(
+			size_t(std::max(std::max(maxUniformLength, maxAttributeLength), 1)));
+	GLsizei length;
+	GLint size;
+	GLenum type;
+
+	for (GLint i = 0; i < uniformCount; i++) {
+		gl.getActiveUniform(program, GLuint(i), GLsizei(name.size()), &length,
+				&size, &type, name.data());
+		std::string uniformName(name.data(), size_t(length));
+		// arrays are reported by their first element, but set by their name
+		const std::string arraySuffix = "[0]";
+		if ((uniformName.size() > arraySuffix.size())
+				&& (uniformName.compare(uniformName.size() - arraySuffix.size(),
+						arraySuffix.size(), arraySuffix) == 0)) {
+			uniformName.resize(uniformName.size() - arraySuffix.size());
+		}
+		locations->addUniform(uniformName,
+				gl.getUniformLocation(program, uniformName.c_str()));
+	}
+
+	for (GLint i = 0; i < attributeCount; i++) {
+		gl.getActiveAttrib(program, GLuint(i), GLsizei(name.size()), &length,
+				&size, &type, name.data());
+		const std::string attributeName(name.data(), size_t(length));
+		locations->addAttribute(attributeName,
+				gl.getAttribLocation(program, attributeName.c_str()));
+	}
+
+	// the camera and projection are read from the buffer of the target
+	const auto blockIndex = gl.getUniformBlockIndex(program,
+			TargetDataBuffer::BlockName);
+	if (blockIndex != GL_INVALID_INDEX) {
+		gl.uniformBlockBinding(program, blockIndex,
+				TargetDataBuffer::BindingPoint);
+		locations->setUsesTargetData(true);
+	}
+
+	logging::Info() << "Resolved " << uniformCount << " uniforms and "
+			<< attributeCount << " attributes of the shader program";
+
+	m_locations[program] = locations;
+	return locations;
 }
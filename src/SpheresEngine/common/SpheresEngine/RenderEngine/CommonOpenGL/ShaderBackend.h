@@ -4,6 +4,8 @@
 #include <SpheresEngine/ResourceEngine/ResourceEngine.h>
 #include <SpheresEngine/RenderEngine/RendererVisualChange.h>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderUserData.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderLocations.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/TargetDataBuffer.h>
 
 #include <boost/lexical_cast.hpp>
 
@@ -12,6 +14,7 @@
 #include <algorithm>
 #include <unordered_map>
 #include <list>
+#include <memory>
 
 class ShaderBackend;
 
@@ -67,6 +70,10 @@ private:
  * shader program. This class also takes care of setting the
  * shader uniforms and attributes. Multiple Shader classes form
  * a ShaderProgram.
+ *
+ * Programs linked by the ShaderBackend know the locations of all their active
+ * uniforms and attributes, so setting a uniform does not query the driver.
+ * Only names which are not in this table are looked up by the driver.
  */
 class ShaderProgram: public GLIDBase {
 public:
@@ -90,12 +97,45 @@ public:
 	/**
 	 * Get the GL id for the location of the attribute with name
 	 */
-	GLint getAttribLocation(std::string name) const;
+	GLint getAttribLocation(std::string const& name) const;
+
+	/**
+	 * Get the GL id for the location of the attribute, without creating a
+	 * string
+	 */
+	GLint getAttribLocation(ShaderVariable const& variable) const;
 
 	/**
 	 * Return the GL id for the location of the uniform with name
 	 */
-	GLint getUniformLocation(std::string name) const;
+	GLint getUniformLocation(std::string const& name) const;
+
+	/**
+	 * Return the GL id for the location of the uniform, without creating a
+	 * string
+	 */
+	GLint getUniformLocation(ShaderVariable const& variable) const;
+
+	/**
+	 * Set the value of a uniform of type integer
+	 */
+	void setUniform(ShaderVariable const& variable, GLint i) const;
+
+	/**
+	 * Set the value of a uniform of type matrix
+	 */
+	void setUniform(ShaderVariable const& variable, glm::mat4 const& m,
+			GLboolean transpose = false) const;
+
+	/**
+	 * Set the value of a uniform of type vec3
+	 */
+	void setUniform(ShaderVariable const& variable, glm::vec3 const& v) const;
+
+	/**
+	 * Set the value of a uniform of type float
+	 */
+	void setUniform(ShaderVariable const& variable, float v) const;
 
 	/**
 	 * Set the value of a uniform of type integer
@@ -174,7 +214,38 @@ public:
 	/**
 	 * Update a list of user values within the shader
 	 */
-	void applyUserValues(ShaderUserDataContainer cont) const;
+	void applyUserValues(ShaderUserDataContainer const& cont) const;
+
+	/**
+	 * Set the locations resolved after linking
+	 */
+	void setLocations(std::shared_ptr<const ShaderLocations> locations) {
+		m_locations = std::move(locations);
+	}
+
+	/**
+	 * The locations resolved after linking, nullptr if this program has not
+	 * been linked by the ShaderBackend
+	 */
+	ShaderLocations const* getLocations() const {
+		return m_locations.get();
+	}
+
+	/**
+	 * The locations resolved after linking, to hand them to other copies of
+	 * this program
+	 */
+	std::shared_ptr<const ShaderLocations> const& shareLocations() const {
+		return m_locations;
+	}
+
+	/**
+	 * True if the program reads the camera and projection matrix from the
+	 * TargetDataBuffer, otherwise they need to be set as uniforms
+	 */
+	bool usesTargetData() const {
+		return m_locations && m_locations->usesTargetData();
+	}
 
 	/**
 	 * Gets the string which explains why the shader failed to compile
@@ -214,6 +285,13 @@ private:
 	 */
 	std::string m_programName;
 
+	/**
+	 * Locations of the active uniforms and attributes, shared by all copies
+	 * of the program. Released once the program has been re-linked and no
+	 * visual uses the old program anymore.
+	 */
+	std::shared_ptr<const ShaderLocations> m_locations;
+
 	/**
 	 * File names this shader has been loaded from. This is used to reload the shader
 	 * once a file changes on disk
@@ -327,11 +405,24 @@ public:
 
 	/**
 	 * Add program definition which allows to load a shader program (and all
-	 * required shaders) via the programName
+	 * required shaders) via the programName. The outputs of the vertex shader
+	 * listed in feedbackVaryings are captured with transform feedback, each
+	 * into a buffer of its own.
 	 */
 	void addProgramDefinition(std::string programName,
-			ProgramDefinitionList def) {
+			ProgramDefinitionList def,
+			std::vector<std::string> feedbackVaryings = { }) {
 		m_programDefinitions[programName] = def;
+		m_feedbackVaryings[programName] = feedbackVaryings;
+	}
+
+	/**
+	 * Returns true if a program definition with this name has been added,
+	 * allows renderers to use optional shader programs
+	 */
+	bool hasProgramDefinition(std::string const& programName) const {
+		return m_programDefinitions.find(programName)
+				!= m_programDefinitions.end();
 	}
 
 	/**
@@ -339,6 +430,15 @@ public:
 	 */
 	void clearProgramDefinition() {
 		m_programDefinitions.clear();
+		m_feedbackVaryings.clear();
+	}
+
+	/**
+	 * The uniform buffers holding the camera and projection of the render
+	 * targets
+	 */
+	TargetDataBuffer & getTargetDataBuffer() {
+		return m_targetDataBuffer;
 	}
 
 	/** This does not actually update the Shader (it is read only), but
@@ -358,9 +458,17 @@ private:
 	Shader compileShader(std::string name, std::string src, Shader::Type type);
 
 	/**
-	 * Link together a shader program from multiple loaded shaders
+	 * Link together a shader program from multiple loaded shaders, the
+	 * feedbackVaryings are captured with transform feedback
+	 */
+	ShaderProgram linkProgram(std::vector<Shader> shaders,
+			std::vector<std::string> const& feedbackVaryings = { });
+
+	/**
+	 * Query the locations of all active uniforms and attributes of a linked
+	 * program
 	 */
-	ShaderProgram linkProgram(std::vector<Shader> shaders);
+	std::shared_ptr<const ShaderLocations> resolveLocations(GLuint program);
 
 private:
 	/**
@@ -368,11 +476,29 @@ private:
 	 */
 	std::unordered_map<std::string, ShaderProgram> m_loadedPrograms;
 
+	/**
+	 * Locations of all linked programs by their program id. The entry of a
+	 * program is dropped when it is re-linked, the visuals still using the
+	 * old program keep its locations alive until they receive the reload.
+	 */
+	std::unordered_map<GLuint, std::shared_ptr<const ShaderLocations>> m_locations;
+
+	/**
+	 * Uniform buffers of the render targets, bound to the "TargetData"
+	 * block of the linked programs
+	 */
+	TargetDataBuffer m_targetDataBuffer;
+
 	/**
 	 * name and ProgamDefinitions of all shader program definitions declared
 	 */
 	std::unordered_map<std::string, ProgramDefinitionList> m_programDefinitions;
 
+	/**
+	 * name and transform feedback varyings of all shader program definitions
+	 */
+	std::unordered_map<std::string, std::vector<std::string>> m_feedbackVaryings;
+
 	/**
 	 * Reference to the resource engine which is nedded to load the shade source
 	 * code
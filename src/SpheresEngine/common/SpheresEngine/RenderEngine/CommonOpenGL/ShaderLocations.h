@@ -0,0 +1,261 @@
+#pragma once
+
+#include <SpheresEngine/RenderEngine/OpenGLInclude.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Name of a uniform or attribute of a shader program together with the hash
+ * of the name. For names known at compile time the hash is computed by the
+ * compiler, so looking up the location of the variable neither creates a
+ * string nor asks the driver.
+ */
+class ShaderVariable {
+public:
+
+	/**
+	 * Create the variable, the name must outlive this object. Best used with
+	 * string literals.
+	 */
+	constexpr explicit ShaderVariable(const char * name) :
+			m_name(name), m_hash(hashName(name)) {
+	}
+
+	/**
+	 * The name of the variable in the shader source
+	 */
+	constexpr const char * getName() const {
+		return m_name;
+	}
+
+	/**
+	 * The FNV-1a hash of the name
+	 */
+	constexpr uint32_t getHash() const {
+		return m_hash;
+	}
+
+	/**
+	 * Compute the FNV-1a hash of a null-terminated name
+	 */
+	static constexpr uint32_t hashName(const char * name,
+			uint32_t hash = 2166136261u) {
+		return (*name == 0) ?
+				hash :
+				hashName(name + 1,
+						(hash ^ uint32_t(uint8_t(*name))) * 16777619u);
+	}
+
+private:
+
+	/**
+	 * Name of the variable
+	 */
+	const char * m_name;
+
+	/**
+	 * Hash of the name
+	 */
+	uint32_t m_hash;
+};
+
+/**
+ * The variables used by the renderers of the engine
+ */
+namespace ShaderVariables {
+
+/** Projection matrix of the target */
+constexpr ShaderVariable Projection("projection");
+
+/** Camera matrix of the target */
+constexpr ShaderVariable Camera("camera");
+
+/** Model matrix of the drawn visual */
+constexpr ShaderVariable Model("model");
+
+/** Texture unit of the diffuse texture */
+constexpr ShaderVariable Texture("tex");
+
+/** Vertex position */
+constexpr ShaderVariable Vertex("vert");
+
+/** Texture coordinate of the vertex */
+constexpr ShaderVariable VertexTexCoord("vertTexCoord");
+
+/** Normal of the vertex in model space */
+constexpr ShaderVariable VertexNormal("normals_modelspace");
+
+/** Model matrix of an instance */
+constexpr ShaderVariable InstanceModel("instanceModel");
+
+/** Particle center and size of an instance */
+constexpr ShaderVariable InstanceCenter("vertInstanceCenter");
+
+/** Particle color of an instance */
+constexpr ShaderVariable InstanceColor("vertInstanceColor");
+
+/** Time step of a particle simulation program */
+constexpr ShaderVariable SimulationDeltaT("deltaT");
+
+/** Particle center and size read by a particle simulation program */
+constexpr ShaderVariable SimulationPositionSize("simPositionSize");
+
+/** Particle velocity and lifetime read by a particle simulation program */
+constexpr ShaderVariable SimulationVelocity("simVelocity");
+
+/** Particle center and size written by a particle simulation program */
+constexpr ShaderVariable FeedbackPositionSize("outPositionSize");
+
+/** Particle velocity and lifetime written by a particle simulation program */
+constexpr ShaderVariable FeedbackVelocity("outVelocity");
+
+}
+
+/**
+ * Locations of all active uniforms and attributes of a linked shader program,
+ * resolved once after linking. The locations are stored by the hash of their
+ * name in sorted arrays, so a lookup is a binary search over a few integers.
+ *
+ * Uniforms named "userN" are additionally stored by their slot N, these are
+ * set by ShaderProgram::applyUserValues().
+ *
+ * Programs declaring the "TargetData" uniform block read the camera and
+ * projection from the TargetDataBuffer instead of uniforms.
+ */
+class ShaderLocations {
+public:
+
+	/**
+	 * Returned for variables which are not active in the program
+	 */
+	static constexpr GLint NotFound = -1;
+
+	/**
+	 * Add an active uniform, arrays without the "[0]" suffix reported by
+	 * the driver
+	 */
+	void addUniform(std::string const& name, GLint location) {
+		add(m_uniforms, name, location);
+
+		if ((name.size() > 4) && (name.compare(0, 4, "user") == 0)
+				&& (name.find_first_not_of("0123456789", 4)
+						== std::string::npos)) {
+			const int slot = std::stoi(name.substr(4));
+			if (slot <= 127) {
+				m_userValues.push_back(std::make_pair(char(slot), location));
+			}
+		}
+	}
+
+	/**
+	 * Add an active attribute, the name as reported by the driver
+	 */
+	void addAttribute(std::string const& name, GLint location) {
+		add(m_attributes, name, location);
+	}
+
+	/**
+	 * Location of the uniform with the hashed name, NotFound if the program
+	 * has no such active uniform
+	 */
+	GLint findUniform(uint32_t hash) const {
+		return find(m_uniforms, hash);
+	}
+
+	/**
+	 * Location of the attribute with the hashed name, NotFound if the
+	 * program has no such active attribute
+	 */
+	GLint findAttribute(uint32_t hash) const {
+		return find(m_attributes, hash);
+	}
+
+	/**
+	 * Location of the uniform "userN" for slot N, NotFound if the program
+	 * has no such active uniform
+	 */
+	GLint findUserValue(char slot) const {
+		for (auto const& user : m_userValues) {
+			if (user.first == slot) {
+				return user.second;
+			}
+		}
+		return NotFound;
+	}
+
+	/**
+	 * Set if the program declares the "TargetData" uniform block
+	 */
+	void setUsesTargetData(bool usesTargetData) {
+		m_usesTargetData = usesTargetData;
+	}
+
+	/**
+	 * True if the program reads the camera and projection from the
+	 * "TargetData" uniform block
+	 */
+	bool usesTargetData() const {
+		return m_usesTargetData;
+	}
+
+private:
+
+	/**
+	 * Hash of the name and location of a variable, sorted by the hash
+	 */
+	typedef std::vector<std::pair<uint32_t, GLint>> LocationList;
+
+	/**
+	 * Insert the variable into the sorted list. Two names with the same
+	 * hash are both stored as NotFound, so they are resolved by name.
+	 */
+	static void add(LocationList & list, std::string const& name,
+			GLint location) {
+		const auto hash = ShaderVariable::hashName(name.c_str());
+		auto it = std::lower_bound(list.begin(), list.end(),
+				std::make_pair(hash, NotFound - 1));
+		if ((it != list.end()) && (it->first == hash)) {
+			if (it->second != location) {
+				it->second = NotFound;
+			}
+			return;
+		}
+		list.insert(it, std::make_pair(hash, location));
+	}
+
+	/**
+	 * Binary search for the hash in the sorted list
+	 */
+	static GLint find(LocationList const& list, uint32_t hash) {
+		auto it = std::lower_bound(list.begin(), list.end(),
+				std::make_pair(hash, NotFound - 1));
+		if ((it != list.end()) && (it->first == hash)) {
+			return it->second;
+		}
+		return NotFound;
+	}
+
+	/**
+	 * Locations of the active uniforms
+	 */
+	LocationList m_uniforms;
+
+	/**
+	 * Locations of the active attributes
+	 */
+	LocationList m_attributes;
+
+	/**
+	 * Locations of the "userN" uniforms by their slot
+	 */
+	std::vector<std::pair<char, GLint>> m_userValues;
+
+	/**
+	 * True if the program declares the "TargetData" uniform block
+	 */
+	bool m_usesTargetData = false;
+};
@@ -0,0 +1,117 @@
+#include <SpheresEngine/RenderEngine/CommonOpenGL/StreamingBuffer.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
+
+#include <cstring>
+
+constexpr size_t StreamingBuffer::RegionCount;
+
+namespace {
+
+/**
+ * Nanoseconds to wait for a fence before checking again
+ */
+constexpr GLuint64 FenceTimeout = 1000000;
+
+}
+
+void StreamingBuffer::reserve(size_t size) {
+	auto & gl = GLSupport::api();
+
+	if (m_buffer == 0) {
+		gl.genBuffers(1, &m_buffer);
+	}
+	if ((size <= m_regionSize) && (m_regionSize > 0)) {
+		return;
+	}
+
+	// new storage, the draw calls still reading the old one keep it alive
+	// until they are done
+	m_regionSize = size;
+	gl.bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	gl.bufferData(GL_ARRAY_BUFFER, RegionCount * m_regionSize, NULL,
+			GL_STREAM_DRAW);
+
+	for (auto & fence : m_fences) {
+		if (fence) {
+			gl.deleteSync(fence);
+			fence = 0;
+		}
+	}
+	m_region = RegionCount;
+}
+
+void StreamingBuffer::release() {
+	auto & gl = GLSupport::api();
+
+	for (auto & fence : m_fences) {
+		if (fence) {
+			gl.deleteSync(fence);
+			fence = 0;
+		}
+	}
+	if (m_buffer != 0) {
+		gl.deleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+	m_regionSize = 0;
+	m_region = RegionCount;
+}
+
+GLintptr StreamingBuffer::upload(const GLvoid * data, size_t size) {
+	auto & gl = GLSupport::api();
+
+	if (size > m_regionSize) {
+		reserve(size);
+	}
+
+	gl.bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	if (m_region == RegionCount) {
+		// nothing written to this storage yet
+		m_region = 0;
+	} else {
+		// all draw calls reading the current region have been issued by now
+		m_fences[m_region] = gl.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_fencesSupported = (m_fences[m_region] != 0);
+		m_region = (m_region + 1) % RegionCount;
+		waitForRegion();
+	}
+
+	const GLintptr offset = GLintptr(m_region * m_regionSize);
+	if (size == 0) {
+		return offset;
+	}
+
+	auto target = gl.mapBufferRange(GL_ARRAY_BUFFER, offset, size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+					| GL_MAP_UNSYNCHRONIZED_BIT);
+	if (target) {
+		std::memcpy(target, data, size);
+		if (gl.unmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE) {
+			return offset;
+		}
+	}
+
+	// mapping failed or the content got lost while mapped
+	gl.bufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	return offset;
+}
+
+void StreamingBuffer::waitForRegion() {
+	auto & gl = GLSupport::api();
+	auto & fence = m_fences[m_region];
+
+	if (fence) {
+		GLenum result;
+		do {
+			result = gl.clientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+					FenceTimeout);
+		} while (result == GL_TIMEOUT_EXPIRED);
+		gl.deleteSync(fence);
+		fence = 0;
+	} else if (!m_fencesSupported && (m_region == 0)) {
+		// without fences nothing tells if the GPU is done with the
+		// regions, start over on new storage
+		gl.bufferData(GL_ARRAY_BUFFER, RegionCount * m_regionSize, NULL,
+				GL_STREAM_DRAW);
+	}
+}
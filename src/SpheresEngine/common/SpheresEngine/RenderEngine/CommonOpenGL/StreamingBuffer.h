@@ -0,0 +1,101 @@
+#pragma once
+
+#include <SpheresEngine/RenderEngine/OpenGLInclude.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <array>
+#include <cstddef>
+
+/**
+ * Vertex buffer for data which is replaced frequently, for example the
+ * particle positions which change every logic step.
+ *
+ * The buffer is split into RegionCount regions which are written in turn,
+ * so new data never overwrites the region the draw calls of the last frames
+ * are still reading from. The data is written directly into the mapped
+ * region without synchronizing with the driver. Before a region is written
+ * again, the CPU waits for the fence placed after the last draw calls which
+ * used it, this wait is usually already signaled.
+ *
+ * If fences are not supported, the whole buffer is orphaned every time the
+ * ring starts over at the first region.
+ */
+class StreamingBuffer: boost::noncopyable {
+public:
+
+	/**
+	 * Number of regions in the ring, one for the frame which is written
+	 * and two for the frames which might still be rendered by the GPU
+	 */
+	static constexpr size_t RegionCount = 3;
+
+	/**
+	 * Create the OpenGL buffer, if not done yet, and make sure each region
+	 * can hold at least size bytes
+	 */
+	void reserve(size_t size);
+
+	/**
+	 * Copy size bytes of data to the next region. Returns the offset of
+	 * the data in the buffer, which must be passed to the vertex attribute
+	 * pointer. The buffer stays bound to GL_ARRAY_BUFFER.
+	 */
+	GLintptr upload(const GLvoid * data, size_t size);
+
+	/**
+	 * Delete the OpenGL buffer and the fences, the buffer is created again
+	 * by the next call to reserve() or upload()
+	 */
+	void release();
+
+	/**
+	 * Id of the OpenGL buffer, 0 until reserve() or upload() have been
+	 * called
+	 */
+	GLuint getId() const {
+		return m_buffer;
+	}
+
+	/**
+	 * Size in bytes of one region
+	 */
+	size_t getRegionSize() const {
+		return m_regionSize;
+	}
+
+private:
+
+	/**
+	 * Wait until the GPU does not read the current region anymore, or
+	 * orphan the storage if this can not be known
+	 */
+	void waitForRegion();
+
+	/**
+	 * Id of the OpenGL buffer holding all regions
+	 */
+	GLuint m_buffer = 0;
+
+	/**
+	 * Size in bytes of one region
+	 */
+	size_t m_regionSize = 0;
+
+	/**
+	 * Region written by the last upload, RegionCount if nothing has been
+	 * written since the storage was allocated
+	 */
+	size_t m_region = RegionCount;
+
+	/**
+	 * False once the driver returned no fence
+	 */
+	bool m_fencesSupported = true;
+
+	/**
+	 * Fence placed after the last draw calls reading each region, 0 if
+	 * the region is not in use or fences are not supported
+	 */
+	std::array<GLsync, RegionCount> m_fences { };
+};
@@ -0,0 +1,32 @@
+#include <SpheresEngine/RenderEngine/CommonOpenGL/TargetDataBuffer.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
+#include <SpheresEngine/RenderEngine/Targets/RenderTargetBase.h>
+
+constexpr GLuint TargetDataBuffer::BindingPoint;
+
+const char * const TargetDataBuffer::BlockName = "TargetData";
+
+void TargetDataBuffer::bind(size_t target, TargetData const& data) {
+	auto & gl = GLSupport::api();
+
+	if (m_buffers.size() <= target) {
+		m_buffers.resize(target + 1, 0);
+	}
+	auto & buffer = m_buffers[target];
+	if (buffer == 0) {
+		gl.genBuffers(1, &buffer);
+	}
+
+	TargetDataBlock block;
+	block.Camera = data.CameraMatrix;
+	block.Projection = data.ProjectionMatrix;
+
+	gl.bindBuffer(GL_UNIFORM_BUFFER, buffer);
+	// Buffer orphaning, the draw calls of the last frame might still read
+	// the old content
+	gl.bufferData(GL_UNIFORM_BUFFER, sizeof(block), NULL, GL_STREAM_DRAW);
+	gl.bufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+	gl.bindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	gl.bindBufferBase(GL_UNIFORM_BUFFER, BindingPoint, buffer);
+}
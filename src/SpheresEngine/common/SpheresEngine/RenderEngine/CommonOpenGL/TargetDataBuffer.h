@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SpheresEngine/RenderEngine/OpenGLInclude.h>
+
+#include <glm/mat4x4.hpp>
+
+#include <cstddef>
+#include <vector>
+
+class TargetData;
+
+/**
+ * Layout of the "TargetData" uniform block in the shaders, following the
+ * std140 rules. Shaders declare it as
+ *
+ *   layout(std140) uniform TargetData {
+ *       mat4 camera;
+ *       mat4 projection;
+ *   };
+ */
+struct TargetDataBlock {
+	/**
+	 * viewing matrix of the camera to render for
+	 */
+	glm::mat4 Camera;
+
+	/**
+	 * projection matrix for the render perspective
+	 */
+	glm::mat4 Projection;
+};
+
+/**
+ * Uniform buffers holding the data of each render target. The buffer of a
+ * target is filled and bound once before the renderers draw to the target,
+ * all shader programs declaring the "TargetData" block read from it, so the
+ * renderers only need to set the per-visual uniforms.
+ *
+ * Each target has its own buffer, so the draw calls of the previous target
+ * do not need to finish before the next target's data is uploaded.
+ */
+class TargetDataBuffer {
+public:
+
+	/**
+	 * The uniform buffer binding point the block is bound to
+	 */
+	static constexpr GLuint BindingPoint = 0;
+
+	/**
+	 * Name of the uniform block in the shaders
+	 */
+	static const char * const BlockName;
+
+	/**
+	 * Upload the data of the target to its buffer and bind the buffer to
+	 * the binding point
+	 */
+	void bind(size_t target, TargetData const& data);
+
+private:
+
+	/**
+	 * One uniform buffer per target, 0 until first used
+	 */
+	std::vector<GLuint> m_buffers;
+};
@@ -0,0 +1,71 @@
+#include <SpheresEngine/RenderEngine/Frustum.h>
+
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE__)
+#define SPHERES_FRUSTUM_X86 1
+#include <xmmintrin.h>
+#endif
+
+constexpr size_t Frustum::PlaneCount;
+
+Frustum::Frustum(glm::mat4 const& viewProjection) {
+	// glm stores the matrix by columns, the planes are the sum or difference
+	// of the last row with the other rows: left, right, bottom, top, near
+	// and far
+	glm::vec4 planes[PlaneCount];
+	for (int r = 0; r < 3; r++) {
+		for (int c = 0; c < 4; c++) {
+			planes[2 * r][c] = viewProjection[c][3] + viewProjection[c][r];
+			planes[2 * r + 1][c] = viewProjection[c][3] - viewProjection[c][r];
+		}
+	}
+
+	for (size_t p = 0; p < PlaneCount; p++) {
+		const float length = std::sqrt(
+				planes[p].x * planes[p].x + planes[p].y * planes[p].y
+						+ planes[p].z * planes[p].z);
+		m_normalX[p] = planes[p].x / length;
+		m_normalY[p] = planes[p].y / length;
+		m_normalZ[p] = planes[p].z / length;
+		m_distance[p] = planes[p].w / length;
+	}
+}
+
+void Frustum::cullSpheres(float const* x, float const* y, float const* z,
+		float const* radius, size_t count, uint8_t * visible) const {
+	size_t i = 0;
+
+#ifdef SPHERES_FRUSTUM_X86
+	for (; i + 4 <= count; i += 4) {
+		const __m128 cx = _mm_loadu_ps(x + i);
+		const __m128 cy = _mm_loadu_ps(y + i);
+		const __m128 cz = _mm_loadu_ps(z + i);
+		const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(),
+				_mm_loadu_ps(radius + i));
+
+		// all bits set for the spheres which are not outside of any plane
+		__m128 inside = _mm_cmpeq_ps(cx, cx);
+		for (size_t p = 0; p < PlaneCount; p++) {
+			__m128 distance = _mm_add_ps(
+					_mm_mul_ps(cx, _mm_set1_ps(m_normalX[p])),
+					_mm_mul_ps(cy, _mm_set1_ps(m_normalY[p])));
+			distance = _mm_add_ps(distance,
+					_mm_mul_ps(cz, _mm_set1_ps(m_normalZ[p])));
+			distance = _mm_add_ps(distance, _mm_set1_ps(m_distance[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+		}
+
+		const int mask = _mm_movemask_ps(inside);
+		visible[i + 0] = uint8_t(mask & 1);
+		visible[i + 1] = uint8_t((mask >> 1) & 1);
+		visible[i + 2] = uint8_t((mask >> 2) & 1);
+		visible[i + 3] = uint8_t((mask >> 3) & 1);
+	}
+#endif
+
+	for (; i < count; i++) {
+		visible[i] = isSphereVisible(glm::vec3(x[i], y[i], z[i]), radius[i]) ?
+				1 : 0;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/mat4x4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The six planes of the volume visible through a camera. Used to drop the
+ * visuals which are outside of the view before their draw calls are
+ * submitted.
+ *
+ * The planes are stored as structure of arrays, so cullSpheres() can test
+ * four spheres against one plane with one SSE instruction per component.
+ */
+class Frustum {
+public:
+
+	/**
+	 * Number of planes bounding the frustum
+	 */
+	static constexpr size_t PlaneCount = 6;
+
+	/**
+	 * Extract the planes from the combined projection * camera matrix. The
+	 * plane normals point into the frustum.
+	 */
+	explicit Frustum(glm::mat4 const& viewProjection);
+
+	/**
+	 * Returns true if the sphere is at least partially inside the frustum
+	 */
+	bool isSphereVisible(glm::vec3 const& center, float radius) const {
+		for (size_t p = 0; p < PlaneCount; p++) {
+			const float distance = m_normalX[p] * center.x
+					+ m_normalY[p] * center.y + m_normalZ[p] * center.z
+					+ m_distance[p];
+			if (distance < -radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Test count spheres given as structure of arrays and write 1 for each
+	 * sphere which is at least partially inside the frustum and 0 for the
+	 * others into visible. Uses SSE on x86.
+	 */
+	void cullSpheres(float const* x, float const* y, float const* z,
+			float const* radius, size_t count, uint8_t * visible) const;
+
+private:
+
+	/**
+	 * x component of the normalized plane normals
+	 */
+	float m_normalX[PlaneCount];
+
+	/**
+	 * y component of the normalized plane normals
+	 */
+	float m_normalY[PlaneCount];
+
+	/**
+	 * z component of the normalized plane normals
+	 */
+	float m_normalZ[PlaneCount];
+
+	/**
+	 * Distance of the planes to the origin along their normal
+	 */
+	float m_distance[PlaneCount];
+};
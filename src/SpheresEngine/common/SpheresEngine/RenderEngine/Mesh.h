@@ -2,6 +2,8 @@
 
 #include <SpheresEngine/RenderEngine/OpenGLInclude.h>
 
+#include <glm/vec3.hpp>
+
 /**
  * This class holds the OpenGL ids referencing the memory buffers of the mesh data
  */
@@ -21,6 +23,16 @@ public:
 
 	}
 
+	/**
+	 * Create a mesh with the sphere which contains all of its vertices
+	 */
+	Mesh(GLuint vaoId, GLsizei vertexCount, glm::vec3 boundsCenter,
+			float boundsRadius) :
+			m_vaoId(vaoId), m_vertexCount(vertexCount), m_boundsCenter(
+					boundsCenter), m_boundsRadius(boundsRadius) {
+
+	}
+
 	/**
 	 * return id to OpenGL buffer holding the vertex data
 	 */
@@ -35,6 +47,20 @@ public:
 		return m_vertexCount;
 	}
 
+	/**
+	 * Center of the bounding sphere in model coordinates
+	 */
+	glm::vec3 const& getBoundsCenter() const {
+		return m_boundsCenter;
+	}
+
+	/**
+	 * Radius of the bounding sphere, negative if unknown
+	 */
+	float getBoundsRadius() const {
+		return m_boundsRadius;
+	}
+
 private:
 	/**
 	 * OpenGL id referencing the memory buffer holding the mesh data
@@ -45,4 +71,14 @@ private:
 	 * Amount of vertices in this mesh
 	 */
 	GLsizei m_vertexCount = 0;
+
+	/**
+	 * Center of the sphere containing all vertices
+	 */
+	glm::vec3 m_boundsCenter = glm::vec3(0.0f);
+
+	/**
+	 * Radius of the sphere containing all vertices
+	 */
+	float m_boundsRadius = -1.0f;
 };
@@ -15,15 +15,38 @@ void RenderEngine::prepareVisual(VisualAbstract * va) {
 	logging::Fatal() << "No renderer which can prepare " << va->getType();
 }
 
+bool RenderEngine::dropPrepareVisual(PrepareVisualId id) {
+	std::lock_guard<std::mutex> lock(m_prepareAccess);
+	auto it = std::find_if(m_toPrepareVisuals.begin(), m_toPrepareVisuals.end(),
+			[id] (PrepareVisualList::value_type const& v) {
+				return v.first == id;
+			});
+	if (it == m_toPrepareVisuals.end()) {
+		return false;
+	}
+	m_preparedVisuals.push_back(*it);
+	m_toPrepareVisuals.erase(it);
+	return true;
+}
+
 void RenderEngine::render() {
 
-	// prepare all new visuals ...
-	for (auto & visual : m_toPrepareVisuals) {
+	// prepare all new visuals, the lock is not held while preparing so the
+	// logic thread can add more visuals in the meantime
+	PrepareVisualList preparing;
+	{
+		std::lock_guard<std::mutex> lock(m_prepareAccess);
+		preparing.swap(m_toPrepareVisuals);
+	}
+	for (auto & visual : preparing) {
 		this->prepareVisual(visual.second);
 	}
-	// all prepared, switch lists
-	m_preparedVisuals = m_toPrepareVisuals;
-	m_toPrepareVisuals.clear();
+	// all prepared, hand them over
+	if (!preparing.empty()) {
+		std::lock_guard<std::mutex> lock(m_prepareAccess);
+		m_preparedVisuals.insert(m_preparedVisuals.end(), preparing.begin(),
+				preparing.end());
+	}
 
 	// check which shaders to reload
 	auto visualChanges = m_renderBackend->getShaderBackend().checkReload();
@@ -33,15 +56,29 @@ void RenderEngine::render() {
 
 	auto renderBackendDetails = m_renderBackend->beforeRender();
 
+	// nothing has been extracted by the logic yet
+	if (!m_lastVisualData) {
+		m_renderBackend->present();
+		return;
+	}
+
+	// the interpolation between logic steps advances with every frame, even
+	// if no new data has been extracted
+	m_lastVisualData->updateInterpolation(std::chrono::steady_clock::now());
+
 	// targets can be for example right or left eye etc.
 	// the Visual renderers must decide when and how they want to render on a target
-	for (auto & t : m_targets) {
+	for (size_t target = 0; target < m_targets.size(); target++) {
+		auto & t = m_targets[target];
 
-		auto const targetData = t->beforeRenderToTarget(m_lastVisualData,
+		auto const targetData = t->beforeRenderToTarget(*m_lastVisualData,
 				renderBackendDetails);
+		// the camera and projection are uploaded once for all renderers
+		m_renderBackend->getShaderBackend().getTargetDataBuffer().bind(target,
+				targetData);
 		for (auto & r : m_renderers) {
 			auto visualChange = r->render(*m_renderBackend.get(),
-					m_lastVisualData, targetData);
+					*m_lastVisualData, targetData);
 
 			for (auto & vc : visualChange) {
 				logging::Info() << "Got a visual change :" << vc.toString();
@@ -50,7 +87,7 @@ void RenderEngine::render() {
 			m_visualChange.insert(m_visualChange.end(), visualChange.begin(),
 					visualChange.end());
 		}
-		t->afterRenderToTarget(m_lastVisualData);
+		t->afterRenderToTarget(*m_lastVisualData);
 	}
 
 	m_renderBackend->present();
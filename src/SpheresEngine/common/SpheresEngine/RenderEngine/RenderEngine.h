@@ -17,6 +17,7 @@
 #include <memory>
 #include <list>
 #include <algorithm>
+#include <mutex>
 
 class ResourceEngine;
 
@@ -109,17 +110,28 @@ public:
 	 * when this and popPreparedVisuals is called, make sure the RenderEngine is not rendering...
 	 */
 	PrepareVisualId addToPrepareVisual(OwningVisualAbstract v) {
+		std::lock_guard<std::mutex> lock(m_prepareAccess);
 		auto thisId = m_currentPrepareId++;
 
 		m_toPrepareVisuals.push_back(std::make_pair(thisId, v));
 		return thisId;
 	}
 
+	/**
+	 * The visual with the id does not need to be prepared anymore, for example
+	 * because its entity has been removed. If it has not been prepared yet, it
+	 * is handed back with the next popPreparedVisuals() without being
+	 * prepared, so the owner knows the render engine does not use it anymore.
+	 * Returns true if the visual was still waiting to be prepared.
+	 */
+	bool dropPrepareVisual(PrepareVisualId id);
+
 	/**
 	 * Return a list of visuals which have been prepared during the last iteration
 	 * of the render loop
 	 */
 	PrepareVisualList popPreparedVisuals() {
+		std::lock_guard<std::mutex> lock(m_prepareAccess);
 		auto tmpPreparedVisuals = m_preparedVisuals;
 		m_preparedVisuals.clear();
 		return tmpPreparedVisuals;
@@ -136,12 +148,11 @@ public:
 	}
 
 	/**
-	 * Update the visual data which is used to generate the next frame. A local
-	 * copy is created which makes the original available again to be
-	 * modified while the render thread is still running.
+	 * Update the visual data which is used to generate the next frame. No copy
+	 * is created, the caller must ensure the container is not modified by another
+	 * thread until the next call to this method.
 	 */
-	void updateVisualData(VisualDataExtractContainer & ext) {
-		// create a local copy
+	void updateVisualData(VisualDataExtractContainer * ext) {
 		m_lastVisualData = ext;
 	}
 
@@ -189,9 +200,10 @@ private:
 
 	/**
 	 * The visual data extract which contains all data to be rendered. This
-	 * can be updated by the game logic
+	 * can be updated by the game logic and is nullptr as long as no visual
+	 * data has been extracted yet
 	 */
-	VisualDataExtractContainer m_lastVisualData;
+	VisualDataExtractContainer * m_lastVisualData = nullptr;
 
 	/**
 	 * List of visual which need to be prepared
@@ -203,6 +215,12 @@ private:
 	 */
 	PrepareVisualList m_preparedVisuals;
 
+	/**
+	 * Protects the lists of visuals to prepare and prepared visuals, which
+	 * are accessed by the logic and the render thread
+	 */
+	std::mutex m_prepareAccess;
+
 	/**
 	 * Reference to the resource engine. Mainly used to load textures
 	 */
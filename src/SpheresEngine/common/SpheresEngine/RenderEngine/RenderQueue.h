@@ -0,0 +1,104 @@
+#pragma once
+
+#include <SpheresEngine/RenderEngine/OpenGLInclude.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * One draw call collected by a renderer before it is submitted
+ */
+struct DrawItem {
+	/**
+	 * Sort key, see RenderQueue::makeKey()
+	 */
+	uint64_t Key;
+
+	/**
+	 * Index of the visual in the extract container
+	 */
+	uint32_t Index;
+
+	/**
+	 * Vertex array to draw
+	 */
+	GLuint VertexArrayObjectId;
+
+	/**
+	 * Number of vertices to draw
+	 */
+	GLsizei VertexCount;
+
+	/**
+	 * Vertex array which reads the model matrix per instance, 0 if the
+	 * draw call can not be combined with others into an instanced one
+	 */
+	GLuint InstancedVertexArrayObjectId;
+};
+
+/**
+ * Collects the draw calls of one target and sorts them by the OpenGL state
+ * they need, so draw calls using the same shader program, texture and vertex
+ * array follow each other. The renderer then only changes the state when it
+ * differs from the one of the previous draw call.
+ *
+ * The state is packed into a 64 bit key with the most expensive state change
+ * in the highest bits. Ids which do not fit into their bits still work, as
+ * the renderer compares the actual ids, they only sort less well.
+ */
+class RenderQueue {
+public:
+
+	/**
+	 * Pack the state of a draw call into a sort key: 16 bits shader
+	 * program, 24 bits texture and 24 bits vertex array
+	 */
+	static uint64_t makeKey(GLuint shaderProgram, GLuint texture,
+			GLuint vertexArray) {
+		return (uint64_t(shaderProgram & 0xFFFF) << 48)
+				| (uint64_t(texture & 0xFFFFFF) << 24)
+				| uint64_t(vertexArray & 0xFFFFFF);
+	}
+
+	/**
+	 * Remove all draw calls, the memory is kept for the next frame
+	 */
+	void clear() {
+		m_items.clear();
+	}
+
+	/**
+	 * Add a draw call
+	 */
+	void add(DrawItem const& item) {
+		m_items.push_back(item);
+	}
+
+	/**
+	 * Sort the draw calls by their key. Draw calls with the same key are
+	 * ordered by their index, so the order does not depend on the sort
+	 * algorithm. Does not allocate, unlike std::stable_sort.
+	 */
+	void sort() {
+		std::sort(m_items.begin(), m_items.end(),
+				[] (DrawItem const& a, DrawItem const& b) {
+					return (a.Key < b.Key)
+					|| ((a.Key == b.Key) && (a.Index < b.Index));
+				});
+	}
+
+	/**
+	 * The draw calls, sorted after sort() has been called
+	 */
+	std::vector<DrawItem> const& getItems() const {
+		return m_items;
+	}
+
+private:
+
+	/**
+	 * The collected draw calls
+	 */
+	std::vector<DrawItem> m_items;
+};
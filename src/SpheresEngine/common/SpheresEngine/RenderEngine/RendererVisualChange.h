@@ -2,8 +2,11 @@
 
 #include <SpheresEngine/RenderEngine/OpenGLInclude.h>
 
+#include <memory>
 #include <string>
 
+class ShaderLocations;
+
 /** class to communicate changes done by one renderer
  * to some visual (for example reload texture or shader) back to
  * the Visual classes in the logic thread
@@ -16,8 +19,8 @@ public:
 	 */
 	enum class EventTypeEnum {
 		// shader program has been reloaded, the name of the
-		// reloaded shader is in ShaderProgramName and the GLId in
-		// ShaderProgramId
+		// reloaded shader is in ShaderProgramName, the GLId in
+		// ShaderProgramId and its locations in ShaderProgramLocations
 		ShaderProgramReload
 	};
 
@@ -26,11 +29,13 @@ public:
 	 * because the source code of a shader was changed on disk
 	 */
 	static RendererVisualChange createShaderProgramReloaded(std::string name,
-			GLuint id) {
+			GLuint id,
+			std::shared_ptr<const ShaderLocations> locations = nullptr) {
 		RendererVisualChange rv;
 		rv.EventType = EventTypeEnum::ShaderProgramReload;
 		rv.ShaderProgramName = name;
 		rv.ShaderProgramId = id;
+		rv.ShaderProgramLocations = locations;
 		return rv;
 	}
 
@@ -57,5 +62,12 @@ public:
 	 * case the EventType is  ShaderProgramReload
 	 */
 	GLuint ShaderProgramId;
+
+	/**
+	 * Uniform and attribute locations of the reloaded shader program, shared
+	 * with the ShaderBackend. Only set in case the EventType is
+	 * ShaderProgramReload
+	 */
+	std::shared_ptr<const ShaderLocations> ShaderProgramLocations;
 };
 
@@ -1,5 +1,6 @@
 #include <SpheresEngine/RenderEngine/Targets/CameraTarget.h>
 #include <SpheresEngine/RenderEngine/RenderBackendSDLDetails.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -12,8 +13,13 @@ TargetData CameraTarget::beforeRenderToTarget(VisualDataExtractContainer & vd,
 	auto * sdlDetails = extractBackendDetails<RenderBackendSDLDetails>(details);
 	m_lastResolution = sdlDetails->resolution;
 
-	td.CameraMatrix = glm::lookAt(vd.CameraData.Position.toGlm(),
-			vd.CameraData.LookAt.toGlm(), glm::vec3(0, 1, 0));
+	// blend between the last two logic steps
+	auto const& cam = vd.CameraData;
+	const auto position = glm::mix(cam.PreviousPosition.toGlm(),
+			cam.Position.toGlm(), vd.Interpolation);
+	const auto lookAt = glm::mix(cam.PreviousLookAt.toGlm(),
+			cam.LookAt.toGlm(), vd.Interpolation);
+	td.CameraMatrix = glm::lookAt(position, lookAt, glm::vec3(0, 1, 0));
 
 	// todo: depends on platform, aka android
 	td.ProjectionMatrix = glm::perspective(glm::radians(50.0f),
@@ -23,7 +29,7 @@ TargetData CameraTarget::beforeRenderToTarget(VisualDataExtractContainer & vd,
 			// far clipping plane
 			100.0f);
 
-	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+	GLSupport::api().clear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
 	return td;
 
@@ -36,7 +42,8 @@ void CameraTarget::afterRenderToTarget(VisualDataExtractContainer &) {
 		const int h = m_lastResolution.h();
 
 		std::vector <unsigned char *> pixels (w * h * 4); // 4 bytes for RGBA
-		glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		GLSupport::api().readPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE,
+				pixels.data());
 
 		SDL_Surface * surf = SDL_CreateRGBSurfaceFrom(pixels.data(), w, h, 8 * 4,
 				w * 4, 0, 0, 0, 0);
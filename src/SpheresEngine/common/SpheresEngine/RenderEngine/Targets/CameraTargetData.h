@@ -15,4 +15,14 @@ struct CameraTargetData {
 	 * The location the camera looks at
 	 */
 	Vector3 LookAt;
+
+	/**
+	 * The position of the camera after the previous logic step
+	 */
+	Vector3 PreviousPosition;
+
+	/**
+	 * The location the camera looked at after the previous logic step
+	 */
+	Vector3 PreviousLookAt;
 };
@@ -3,6 +3,7 @@
 
 // todo: this is pontenially dangerous if render engine runs on dedicated thread on Android ...
 void Texture::ensureOpenGLBind() {
+	auto & gl = GLSupport::api();
 	if (!m_glId.isValid()) {
 #ifdef SPHERES_USE_ANDROID_OPENGL
 		logging::Fatal() << "Texture bound was called on Android-compile code."
@@ -16,12 +17,12 @@ void Texture::ensureOpenGLBind() {
 				<< " to OpenGL";
 		{
 			GLuint glId;
-			GL_CHECK_ERROR(glGenTextures(1, &glId));
+			GL_CHECK_ERROR(gl.genTextures(1, &glId));
 			m_glId.setValue(glId);
 		}
 
 		// Bind the texture object
-		GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, m_glId.get()));
+		GL_CHECK_ERROR(gl.bindTexture(GL_TEXTURE_2D, m_glId.get()));
 
 		// Set the texture's stretching properties
 		//	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -30,13 +31,13 @@ void Texture::ensureOpenGLBind() {
 		// this will not use any kind of filtering to blur / anti-alise the textures
 		// setting when the texture is farther away than it's original size
 		GL_CHECK_ERROR(
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+				gl.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
 		// setting when the textre is closer than it's original size
 		GL_CHECK_ERROR(
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+				gl.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
 
 		// Edit the texture object's image data using the information SDL_Surface gives us
 		GL_CHECK_ERROR(
-				glTexImage2D(GL_TEXTURE_2D, 0, m_numberOfColors, m_width, m_height, 0, m_textureFormat, GL_UNSIGNED_BYTE, m_pixelPointer));
+				gl.texImage2D(GL_TEXTURE_2D, 0, m_numberOfColors, m_width, m_height, 0, m_textureFormat, GL_UNSIGNED_BYTE, m_pixelPointer));
 	}
 }
@@ -4,6 +4,9 @@
 #include <SpheresEngine/Log.h>
 
 #include <SpheresEngine/RenderEngine/OpenGLInclude.h>
+
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 /**
@@ -34,6 +37,39 @@ public:
 		return Position.size();
 	}
 
+	/**
+	 * Compute a sphere containing all vertices, centered in the middle of
+	 * their axis-aligned bounding box. The radius is negative for a mesh
+	 * without vertices.
+	 */
+	void computeBoundingSphere(Vector3 & center, float & radius) const {
+		center = Vector3::zero();
+		radius = -1.0f;
+		if (Position.empty()) {
+			return;
+		}
+
+		Vector3 low = Position.front();
+		Vector3 high = Position.front();
+		for (auto const& p : Position) {
+			low = Vector3(std::min(low.x(), p.x()), std::min(low.y(), p.y()),
+					std::min(low.z(), p.z()));
+			high = Vector3(std::max(high.x(), p.x()), std::max(high.y(), p.y()),
+					std::max(high.z(), p.z()));
+		}
+		center = Vector3(0.5f * (low.x() + high.x()), 0.5f * (low.y() + high.y()),
+				0.5f * (low.z() + high.z()));
+
+		float radiusSquared = 0.0f;
+		for (auto const& p : Position) {
+			const float dx = p.x() - center.x();
+			const float dy = p.y() - center.y();
+			const float dz = p.z() - center.z();
+			radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+		}
+		radius = std::sqrt(radiusSquared);
+	}
+
 	/**
 	 * Return one OpenGL-compatible version of the array packed with XYZ and UV
 	 * coordinates
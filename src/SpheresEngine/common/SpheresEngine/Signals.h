@@ -2,14 +2,16 @@
 
 #include <string>
 #include <map>
-#include <list>
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <array>
 #include <functional>
 
 #include <boost/noncopyable.hpp>
+#include <SpheresEngine/DataTypes/InplaceFunction.h>
 #include <SpheresEngine/Performance/SectionTimer.h>
+#include <SpheresEngine/Util.h>
 #include <SpheresEngine/Timing.h>
 
 // allows to optionally report the timing for each of the signal calls
@@ -17,11 +19,6 @@
 
 namespace slots {
 
-/**
- * List hold timings of signal calls
- */
-typedef std::list<float> TimingQueue;
-
 /**
  * Holds the slot name and the timing for the call
  */
@@ -55,42 +52,116 @@ public:
 /**
  * Class to create a Slot where users can subscribe to
  * and get notified once the signal() method is called
+ *
+ * The subscribed functions are stored in one contiguous list and called
+ * without copying them. Subscriptions added or removed while signal() is
+ * running take effect once the outermost signal() call is done: removed
+ * subscribers are not called anymore, added ones are called from the next
+ * signal on.
  */
-template<typename ... Args>
+template<class ... Args>
 class Slot: public SlotBase {
 public:
 
 	/**
 	 * type to store the lambda expression with a variable amount of
-	 * parameters.
+	 * parameters. Lambdas which capture a few pointers are stored without
+	 * heap allocation.
 	 */
-	typedef std::function<void(Args...)> func_type;
+	typedef InplaceFunction<void(Args...)> func_type;
+
+#ifdef DESCENT_SIGNAL_PROFILE
+	/**
+	 * Number of timings stored for each subscriber
+	 */
+	constexpr static size_t MaxTimingsCached = 10;
+#endif
 
 	/**
 	 * Call this method with your custom lambda expression to subscribe
 	 * to this signal slot.
 	 * Name will not be stored, if the signal profiling is not enabled
 	 */
-	subscribed_id subscribe(func_type f, std::string name = "") {
-		auto freeId = nextFreeId();
-		m_functions.emplace_back(SlotFunction(freeId, name, f));
+	template<class TFunc>
+	subscribed_id subscribe(TFunc && f, std::string const& name = "") {
+		const auto id = allocateId();
+		SlotFunction sf(id, name, func_type(std::forward<TFunc>(f)));
+		if (m_dispatchDepth > 0) {
+			m_addedFunctions.push_back(std::move(sf));
+		} else {
+			m_functions.push_back(std::move(sf));
+		}
 
 		// provide id to remove this subscribed
-		return freeId;
+		return id;
+	}
+
+	/**
+	 * Subscribe a member function of a receiver object. All receivers
+	 * subscribed with the same member function are stored in one batch and
+	 * called in a tight loop without indirection. Use this for slots with
+	 * many subscribers of the same kind, like the aspects of many entities
+	 * subscribing to EntityEngine::OnTimeStep. The batches are called after
+	 * the functions subscribed with subscribe(). Like the functions,
+	 * receivers subscribed during signal() are called from the next signal
+	 * on.
+	 */
+	template<class TReceiver, void (TReceiver::*TMethod)(Args...)>
+	subscribed_id subscribeBatched(TReceiver * receiver) {
+		const auto id = allocateId();
+		const auto key = &Batch<TReceiver, TMethod>::Key;
+
+		auto it = std::find_if(m_batches.begin(), m_batches.end(),
+				[key]( BatchEntry const& e ) {return e.first == key;});
+		if (it == m_batches.end()) {
+			m_batches.emplace_back(key,
+					uniq<BatchBase>(new Batch<TReceiver, TMethod>()));
+			it = m_batches.end() - 1;
+		}
+		static_cast<Batch<TReceiver, TMethod> *>(it->second.get())->add(id,
+				receiver, m_dispatchDepth > 0);
+		return id;
 	}
 
 	void unsubscribe(subscribed_id id) override {
-		m_functions.erase(
-				std::remove_if(m_functions.begin(), m_functions.end(),
-						[id]( SlotFunction & sf ) {return sf.getId() == id;}),
-				m_functions.end());
+		if (!removeSubscription(id)) {
+			return;
+		}
+		m_freeIds.push_back(id);
+		m_hasRemovals = true;
+		if (m_dispatchDepth == 0) {
+			applyDeferred();
+		}
+	}
+
+	/**
+	 * Returns the number of active subscriptions, including the ones waiting
+	 * to be added after the current signal
+	 */
+	size_t getSubscriberCount() const {
+		size_t count = m_addedFunctions.size();
+		for (auto const& f : m_functions) {
+			if (f.isActive()) {
+				count++;
+			}
+		}
+		for (auto const& b : m_batches) {
+			count += b.second->getReceiverCount();
+		}
+		return count;
 	}
 
 	/**
 	 * Call this method to send a signal to all lambdas registered to this slot
 	 */
 	void signal(Args ... args) {
-		for (auto const& f : m_functions) {
+		m_dispatchDepth++;
+
+		// m_functions is not changed during the dispatch
+		for (auto & f : m_functions) {
+			if (!f.isActive()) {
+				continue;
+			}
 			//logging::Debug() << "signaling";
 #ifdef DESCENT_SIGNAL_PROFILE
 			Timing t;
@@ -98,47 +169,96 @@ public:
 
 			{
 #ifdef DESCENT_SIGNAL_PROFILE
-				SectionTimer tm(GlobalTimingRepo::Rep, "signal." + f.getName());
+				SectionTimer tm(GlobalTimingRepo::Rep, f.getSection());
 #endif
 				f.getFunction()(args...);
 			}
 
 #ifdef DESCENT_SIGNAL_PROFILE
 
-			addTiming(f.getName(), t.end());
+			f.addTiming(t.end());
 #endif
 		}
+
+		// batches might be added during the dispatch, but their receivers
+		// are not called before the dispatch is done and the batch objects
+		// themselves stay at the same address
+		const auto batchCount = m_batches.size();
+		for (size_t i = 0; i < batchCount; i++) {
+			auto batch = m_batches[i].second.get();
+			batch->signal(args...);
+		}
+
+		m_dispatchDepth--;
+		if (m_dispatchDepth == 0) {
+			applyDeferred();
+		}
 	}
 
 private:
 
 	/**
-	 * Find the smallest free id
+	 * Return an id which is not in use, the ids of removed subscriptions
+	 * are reused
 	 */
-	subscribed_id nextFreeId() const {
-		subscribed_id smallestFree = 0;
-
-		bool didIncrease = true;
+	subscribed_id allocateId() {
+		if (m_freeIds.empty()) {
+			return m_nextId++;
+		}
+		const auto id = m_freeIds.back();
+		m_freeIds.pop_back();
+		return id;
+	}
 
-		// not the most optimal algorithm but will not fragment id space
-		// and works on unsorted lists
-		while (didIncrease) {
+	/**
+	 * Deactivate the subscription with the id, returns false if there is no
+	 * subscription with this id
+	 */
+	bool removeSubscription(subscribed_id id) {
+		for (auto & f : m_functions) {
+			if (f.isActive() && (f.getId() == id)) {
+				f.deactivate();
+				return true;
+			}
+		}
+		// not called yet, so it can be removed right away
+		for (auto it = m_addedFunctions.begin(); it != m_addedFunctions.end();
+				it++) {
+			if (it->getId() == id) {
+				m_addedFunctions.erase(it);
+				return true;
+			}
+		}
+		for (auto & b : m_batches) {
+			if (b.second->remove(id)) {
+				return true;
+			}
+		}
+		return false;
+	}
 
-			didIncrease = false;
-			for (auto const& f : m_functions) {
-				if (f.getId() == smallestFree) {
-					// check the next Id
-					smallestFree++;
-					didIncrease = true;
-					// exit for loop, but still stay in the while loop
-					break;
-				}
+	/**
+	 * Apply the subscriptions added and removed during the dispatch
+	 */
+	void applyDeferred() {
+		if (m_hasRemovals) {
+			m_functions.erase(
+					std::remove_if(m_functions.begin(), m_functions.end(),
+							[]( SlotFunction const& sf ) {return !sf.isActive();}),
+					m_functions.end());
+			for (auto & b : m_batches) {
+				b.second->compact();
 			}
-			// ok, all other entries checked and no coninue called ?
-			// while loop will exit
+			m_hasRemovals = false;
 		}
 
-		return smallestFree;
+		for (auto & sf : m_addedFunctions) {
+			m_functions.push_back(std::move(sf));
+		}
+		m_addedFunctions.clear();
+		for (auto & b : m_batches) {
+			b.second->applyAdded();
+		}
 	}
 
 	/**
@@ -152,19 +272,19 @@ private:
 		 * and the lambda expression
 		 */
 		SlotFunction(subscribed_id id, std::string const& name, func_type func) :
-				m_id(id), m_function(func)
+				m_function(std::move(func)), m_id(id)
 #ifdef DESCENT_SIGNAL_PROFILE
-		, m_name(name)
+		, m_name(name), m_section(GlobalTimingRepo::Rep.intern("signal." + name))
 #endif
 
 		{
-
+			(void) name;
 		}
 
 		/**
 		 * Return the stored lambda expression
 		 */
-		func_type getFunction() const {
+		func_type const& getFunction() const {
 			return m_function;
 		}
 
@@ -172,6 +292,21 @@ private:
 			return m_id;
 		}
 
+		/**
+		 * Returns false once the subscription has been removed
+		 */
+		bool isActive() const {
+			return m_active;
+		}
+
+		/**
+		 * Mark the subscription as removed, it is dropped from the list
+		 * after the current dispatch
+		 */
+		void deactivate() {
+			m_active = false;
+		}
+
 	private:
 
 		/**
@@ -181,64 +316,258 @@ private:
 
 		subscribed_id m_id;
 
+		/**
+		 * False once the subscription has been removed
+		 */
+		bool m_active = true;
+
 #ifdef DESCENT_SIGNAL_PROFILE
 	public:
 		std::string m_name;
+		SectionId m_section;
 		std::string const& getName() const
 		{
 			return m_name;
 		}
+		SectionId getSection() const
+		{
+			return m_section;
+		}
+
+		/**
+		 * Store the timing of one call, only the last MaxTimingsCached
+		 * timings are kept
+		 */
+		void addTiming(float t) {
+			m_timings[m_nextTiming] = t;
+			m_nextTiming = (m_nextTiming + 1) % MaxTimingsCached;
+			if (m_timingCount < MaxTimingsCached) {
+				m_timingCount++;
+			}
+		}
+
+		/**
+		 * Sum and number of the stored timings
+		 */
+		std::pair<float, size_t> getTimingSum() const {
+			float sum = 0.0f;
+			for (size_t i = 0; i < m_timingCount; i++) {
+				sum += m_timings[i];
+			}
+			return std::make_pair(sum, m_timingCount);
+		}
+
+	private:
+		/**
+		 * Ring buffer of the last timings, stored within the subscription
+		 * so profiling the calls does not allocate
+		 */
+		std::array<float, MaxTimingsCached> m_timings;
+		size_t m_nextTiming = 0;
+		size_t m_timingCount = 0;
 #endif
 
 	};
 
 	/**
-	 * List of all functions stored as subscribers to this signal
+	 * Non-templated interface of the receiver batches
 	 */
-	std::vector<SlotFunction> m_functions;
+	class BatchBase {
+	public:
+		virtual ~BatchBase() = default;
 
-#ifdef DESCENT_SIGNAL_PROFILE
+		/**
+		 * Call the member function of all receivers
+		 */
+		virtual void signal(Args ... args) = 0;
 
-public:
+		/**
+		 * Mark the receiver with the id as removed, returns false if the id
+		 * is not part of this batch
+		 */
+		virtual bool remove(subscribed_id id) = 0;
 
-	TimingResultList getTimingResultList() const {
-		TimingResultList timingRes;
+		/**
+		 * Drop the removed receivers
+		 */
+		virtual void compact() = 0;
+
+		/**
+		 * Call the receivers added during the dispatch from the next signal on
+		 */
+		virtual void applyAdded() = 0;
+
+		/**
+		 * Number of receivers which have not been removed, including the ones
+		 * waiting to be added after the current signal
+		 */
+		virtual size_t getReceiverCount() const = 0;
+	};
+
+	/**
+	 * All receivers subscribed with the same member function
+	 */
+	template<class TReceiver, void (TReceiver::*TMethod)(Args...)>
+	class Batch: public BatchBase {
+	public:
 
-		timingRes.reserve(m_timings.size());
+		/**
+		 * The address of this variable identifies the batch type
+		 */
+		static const char Key;
 
-		for (auto tPairIt = m_timings.begin(); tPairIt != m_timings.end(); tPairIt++) {
-			const float avg = average(tPairIt->second);
-			timingRes.push_back(TimingResult(tPairIt->first, avg));
+		/**
+		 * Add a receiver, if deferred it is only called once applyAdded()
+		 * has been called
+		 */
+		void add(subscribed_id id, TReceiver * receiver, bool deferred) {
+			if (deferred) {
+				m_addedReceivers.emplace_back(id, receiver);
+			} else {
+				m_receivers.emplace_back(id, receiver);
+			}
 		}
 
-		return timingRes;
-	}
+		void signal(Args ... args) override {
+			// m_receivers is not changed during the dispatch
+			for (auto const& r : m_receivers) {
+				if (r.second) {
+					(r.second->*TMethod)(args...);
+				}
+			}
+		}
 
-private:
+		bool remove(subscribed_id id) override {
+			for (auto & r : m_receivers) {
+				if (r.second && (r.first == id)) {
+					r.second = nullptr;
+					return true;
+				}
+			}
+			// not called yet, so it can be removed right away
+			for (auto it = m_addedReceivers.begin();
+					it != m_addedReceivers.end(); it++) {
+				if (it->first == id) {
+					m_addedReceivers.erase(it);
+					return true;
+				}
+			}
+			return false;
+		}
 
-	void addTiming(std::string name, float t) {
-		TimingQueue & tq = m_timings[name];
-		while (tq.size() > MaxTimingsCached) {
-			tq.pop_front();
+		void applyAdded() override {
+			m_receivers.insert(m_receivers.end(), m_addedReceivers.begin(),
+					m_addedReceivers.end());
+			m_addedReceivers.clear();
 		}
-		tq.push_back(t);
-	}
 
-	template<class TIterable>
-	float average(TIterable const & theList) const {
-		if (theList.size() == 0)
-		return 0.0f;
+		void compact() override {
+			m_receivers.erase(
+					std::remove_if(m_receivers.begin(), m_receivers.end(),
+							[]( std::pair<subscribed_id, TReceiver *> const& r ) {
+								return r.second == nullptr;}),
+					m_receivers.end());
+		}
+
+		size_t getReceiverCount() const override {
+			size_t count = m_addedReceivers.size();
+			for (auto const& r : m_receivers) {
+				if (r.second) {
+					count++;
+				}
+			}
+			return count;
+		}
+
+	private:
+
+		/**
+		 * Subscription id and receiver, the receiver is set to nullptr
+		 * when the subscription is removed
+		 */
+		std::vector<std::pair<subscribed_id, TReceiver *>> m_receivers;
+
+		/**
+		 * Receivers subscribed during the dispatch, added to m_receivers
+		 * once the dispatch is done
+		 */
+		std::vector<std::pair<subscribed_id, TReceiver *>> m_addedReceivers;
+	};
+
+	/**
+	 * Identifies the type of a batch and owns it
+	 */
+	typedef std::pair<char const*, uniq<BatchBase>> BatchEntry;
+
+	/**
+	 * List of all functions stored as subscribers to this signal
+	 */
+	std::vector<SlotFunction> m_functions;
+
+	/**
+	 * Functions subscribed during the dispatch, added to m_functions once
+	 * the dispatch is done
+	 */
+	std::vector<SlotFunction> m_addedFunctions;
+
+	/**
+	 * The batches of receivers subscribed with subscribeBatched()
+	 */
+	std::vector<BatchEntry> m_batches;
+
+	/**
+	 * Ids of removed subscriptions which can be reused
+	 */
+	std::vector<subscribed_id> m_freeIds;
+
+	/**
+	 * The next id which has never been used
+	 */
+	subscribed_id m_nextId = 0;
 
-		float sum = 0.0f;
-		for (auto it = theList.begin(); it != theList.end(); it++) {
-			sum += (*it);
+	/**
+	 * Number of signal() calls currently running on this slot
+	 */
+	size_t m_dispatchDepth = 0;
+
+	/**
+	 * True if subscriptions have been removed which are still in the lists
+	 */
+	bool m_hasRemovals = false;
+
+#ifdef DESCENT_SIGNAL_PROFILE
+
+public:
+
+	/**
+	 * Average timing of the last calls of the subscribers, summarized by the
+	 * name used when subscribing
+	 */
+	TimingResultList getTimingResultList() const {
+		std::map<std::string, std::pair<float, size_t>> sums;
+		for (auto const& f : m_functions) {
+			const auto fSum = f.getTimingSum();
+			auto & sum = sums[f.getName()];
+			sum.first += fSum.first;
+			sum.second += fSum.second;
+		}
+
+		TimingResultList timingRes;
+		timingRes.reserve(sums.size());
+		for (auto const& sum : sums) {
+			const float avg = (sum.second.second == 0) ?
+					0.0f : sum.second.first / float(sum.second.second);
+			timingRes.push_back(TimingResult(sum.first, avg));
 		}
-		return sum / theList.size();
+
+		return timingRes;
 	}
 
-	std::map<std::string, TimingQueue> m_timings;
-	constexpr static size_t MaxTimingsCached = 10;
 #endif
 };
 
+template<class ... Args>
+template<class TReceiver, void (TReceiver::*TMethod)(Args...)>
+const char Slot<Args...>::Batch<TReceiver, TMethod>::Key = 0;
+
 }
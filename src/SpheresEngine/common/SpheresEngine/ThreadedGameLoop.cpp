@@ -9,7 +9,8 @@
 #include <SpheresEngine/Pathfinding/Node.h>
 #include <SpheresEngine/PhysicsEngine/PhysicsEngine.h>
 #include <SpheresEngine/Performance/SectionTimer.h>
-#include <SpheresEngine/LimitedTiming.h>
+#include <SpheresEngine/Performance/AllocationCounter.h>
+#include <SpheresEngine/FramePacer.h>
 #include <SpheresEngine/Timing.h>
 
 #include <atomic>
@@ -19,13 +20,96 @@
 #include <SpheresEngine/InputEngine/SdlSource.h>
 #endif
 
+ThreadedGameLoop::~ThreadedGameLoop() {
+	m_entityEngine.OnEntityRemoved.unsubscribe(m_entityRemovedSubscription);
+	m_entityEngine.setJobSystem(nullptr);
+}
+
+void ThreadedGameLoop::connectEngines() {
+	m_jobSystem = std14::make_unique<JobSystem>();
+	m_entityEngine.setJobSystem(m_jobSystem.get());
+
+	m_entityRemovedSubscription = m_entityEngine.OnEntityRemoved.subscribe(
+			[this] (Entity * ent) {
+				m_physics.removeEntity(ent);
+			}, "physics_remove_entity");
+}
+
+void ThreadedGameLoop::setWorkerCount(size_t workerCount) {
+	// the entity engine must not use the old workers while they are joined
+	m_entityEngine.setJobSystem(nullptr);
+	m_jobSystem = std14::make_unique<JobSystem>(workerCount);
+	m_entityEngine.setJobSystem(m_jobSystem.get());
+}
+
+void ThreadedGameLoop::simulateStep(float timeDelta) {
+	{
+		static const auto section = GlobalTimingRepo::Rep.intern("input");
+		SectionTimer tm(GlobalTimingRepo::Rep, section);
+		m_inputEngine.process();
+	}
+
+	{
+		static const auto section = GlobalTimingRepo::Rep.intern("entities");
+		SectionTimer tm(GlobalTimingRepo::Rep, section);
+		m_entityEngine .step(timeDelta);
+	}
+
+	// if the aspects or entity engine did not use recent actions,
+	// they will now be cleared to not build up
+	m_inputEngine.clearInputActions();
+
+	{
+		static const auto section = GlobalTimingRepo::Rep.intern("animation");
+		SectionTimer tm(GlobalTimingRepo::Rep, section);
+		m_animationEngine .step(timeDelta);
+	}
+
+	{
+		static const auto section = GlobalTimingRepo::Rep.intern("physics");
+		SectionTimer tm(GlobalTimingRepo::Rep, section);
+		m_physics.step(timeDelta);
+	}
+}
+
+void ThreadedGameLoop::extractVisuals(float interpolation, float stepDuration) {
+	static const auto section = GlobalTimingRepo::Rep.intern("extract_visual");
+	SectionTimer tm(GlobalTimingRepo::Rep, section);
+
+	{
+		std::lock_guard<std::mutex> lg ( m_preparedVisualsAccess);
+		//std::cout << " Got " << m_preparedVisuals.size() <<" vis" << std::endl;
+		this->m_entityEngine.updatePreparedVisuals(m_preparedVisuals);
+		m_preparedVisuals.clear();
+	}
+	// visuals of removed entities which are still waiting to be prepared
+	// come back unprepared with the next render round
+	for (auto id : this->m_entityEngine.popDroppedPrepares()) {
+		m_renderEngine.dropPrepareVisual(id);
+	}
+	// update the visual which might have change in one of the last render rounds
+	{
+		std::lock_guard<std::mutex> lg ( m_rendererVisualChangesAccess);
+		this->m_entityEngine.updateVisuals(m_rendererVisualChanges);
+		m_rendererVisualChanges.clear();
+	}
+
+	// the back container is owned by this thread until it is published. It is
+	// not cleared, so only the entries which changed since this container was
+	// filled the last time are extracted
+	auto & exCont = m_extractBuffer.getBack();
+	this->m_entityEngine.extractVisualData(exCont);
+	exCont.ExtractInterpolation = interpolation;
+	exCont.StepDuration = stepDuration;
+	exCont.ExtractTime = std::chrono::steady_clock::now();
+	m_extractBuffer.publish();
+}
+
 std::function<void(float)> ThreadedGameLoop::getLogicLambda() {
 
 	auto lmdLogic = [this] (float timeDelta) {
-
-		// todo: might be better to keep this datastructer at a place
-		// where is not always allocated fresh (right now on stack)
-			VisualDataExtractContainer exCont;
+			static const auto section = GlobalTimingRepo::Rep.intern("logic::tick");
+			SectionTimer tm(GlobalTimingRepo::Rep, section);
 
 #ifdef USE_SDL
 			SDL_Event event;
@@ -37,53 +121,18 @@ std::function<void(float)> ThreadedGameLoop::getLogicLambda() {
 			}
 #endif
 
-			{
-				SectionTimer tm(GlobalTimingRepo::Rep, "input");
-				m_inputEngine.process();
-			}
-
-			{
-				SectionTimer tm(GlobalTimingRepo::Rep, "entities");
-				m_entityEngine .step(timeDelta);
-			}
-
-			// if the aspects or entity engine did not use recent actions,
-			// they will now be cleared to not build up
-			m_inputEngine.clearInputActions();
-
-			{
-				SectionTimer tm(GlobalTimingRepo::Rep, "animation");
-				m_animationEngine .step(timeDelta);
-			}
-
-			{
-				SectionTimer tm(GlobalTimingRepo::Rep, "physics");
-				m_physics.step(timeDelta);
-			}
-
-			{
-				SectionTimer tm(GlobalTimingRepo::Rep, "extract_visual");
-
-				{
-					std::lock_guard<std::mutex> lg ( m_preparedVisualsAccess);
-					//std::cout << " Got " << m_preparedVisuals.size() <<" vis" << std::endl;
-					this->m_entityEngine.updatePreparedVisuals(m_preparedVisuals);
-					m_preparedVisuals.clear();
+			if (m_fixedTimestep) {
+				// run as many fixed steps as fit in the passed time and let the
+				// renderer interpolate the remaining fraction of a step
+				const auto steps = m_fixedTimestep->advance(timeDelta);
+				for (size_t i = 0; i < steps; i++) {
+					simulateStep(m_fixedTimestep->getStepDuration());
 				}
-			}
-			// update the visual which might have change in one of the last render rounds
-			{
-				std::lock_guard<std::mutex> lg ( m_rendererVisualChangesAccess);
-				this->m_entityEngine.updateVisuals(m_rendererVisualChanges);
-				m_rendererVisualChanges.clear();
-			}
-
-			this->m_entityEngine.extractVisualData(exCont);
-
-			// update central instance
-			{
-				std::lock_guard<std::mutex> lg (m_extractContainerAccess);
-				m_extractContainer = exCont;
+				extractVisuals(m_fixedTimestep->getInterpolation(),
+						m_fixedTimestep->getStepDuration());
+			} else {
+				simulateStep(timeDelta);
+				extractVisuals(1.0f, 0.0f);
 			}
 		};
 
@@ -115,17 +164,18 @@ std::function<void(float)> ThreadedGameLoop::getRenderLambda() {
 
 	return [this]( float /*deltaTime*/) {
 		{
-			SectionTimer tm(GlobalTimingRepo::Rep, "render::update_visual_data");
-			VisualDataExtractContainer exCont;
-			{
-				std::lock_guard<std::mutex> lg (m_extractContainerAccess);
-				// should not take too long, as it is just creating a copy
-				m_renderEngine.updateVisualData(m_extractContainer);
+			static const auto section = GlobalTimingRepo::Rep.intern("render::update_visual_data");
+			SectionTimer tm(GlobalTimingRepo::Rep, section);
+			// if the logic thread did not publish a new frame yet, the
+			// previous one is rendered again
+			if (m_extractBuffer.acquire()) {
+				m_renderEngine.updateVisualData(&m_extractBuffer.getFront());
 			}
 		}
 
 		{
-			SectionTimer tm(GlobalTimingRepo::Rep, "render::render");
+			static const auto section = GlobalTimingRepo::Rep.intern("render::render");
+			SectionTimer tm(GlobalTimingRepo::Rep, section);
 			m_renderEngine.render();
 
 			{
@@ -164,37 +214,48 @@ void ThreadedGameLoop::run() {
 
 	auto lmdLogicThread = [this] () {
 		logging::Info() << "Started logic thread";
-		LimitedTiming timing(1.0f/m_maxGameloopRate);
+		GlobalTimingRepo::Rep.setThreadName("logic");
+		// with a fixed timestep, there is no need to run the loop more often
+		// than the steps are computed
+		FramePacer pacer(m_fixedTimestep ?
+				m_fixedTimestep->getStepDuration() : 1.0f/m_maxGameloopRate);
 
 		auto lmdLogic = getLogicLambda();
 		size_t count = 0;
 
 		m_terminate = false;
-		float timeDelta = timing.getMinimumWait( );
+		float timeDelta = pacer.getPeriod();
+		pacer.start();
 		while (!m_terminate) {
-			timing.start();
 			// todo: do not compute the logic loop too often, otherwise the rendering thread
 			// might lag behind
+			const auto allocationsBefore = AllocationCounter::threadAllocations();
 			lmdLogic(timeDelta);
+			const auto allocations = AllocationCounter::threadAllocations() - allocationsBefore;
+			if ((count >= m_allocationWarmupTicks) && (allocations > m_maxLogicTickAllocations)) {
+				m_maxLogicTickAllocations = allocations;
+			}
 			// is the sdl available, if yes, check for events...
 
-			timeDelta = timing.endWithWait();
+			timeDelta = pacer.waitForNextFrame();
 			count++;
 
 			if (m_exitAfterThreadIterations.isValid()) {
 				if (count >= m_exitAfterThreadIterations.get() ) {
 					logging::Info() << "Leaving logic thread because " << count << " done";
-					return;
+					break;
 				}
 			}
 		}
 
+		m_logicPacing = pacer.getStatistics();
 		logging::Info() << "Leaving logic thread";
 	};
 
 	auto lmdRenderThread = [this] {
 		logging::Info() << "Started render thread";
-		LimitedTiming timing(1.0f/m_maxFramerate);
+		GlobalTimingRepo::Rep.setThreadName("render");
+		FramePacer pacer(1.0f/m_maxFramerate);
 
 		// needs to be executed in the render thread, due to
 		// OpenGL's (non-existing) threading model
@@ -214,22 +275,22 @@ void ThreadedGameLoop::run() {
 			}
 			m_renderEngine.addTarget(std::move(cameraTarget));
 
-			float timeDelta = timing.getMinimumWait( );
+			float timeDelta = pacer.getPeriod();
+			pacer.start();
 			while (!m_terminate) {
-				timing.start();
-
 				lmdRenderLambda( timeDelta);
 
-				timeDelta = timing.endWithWait();
+				timeDelta = pacer.waitForNextFrame();
 				count++;
 
 				if (m_exitAfterThreadIterations.isValid()) {
 					if (count >= m_exitAfterThreadIterations.get() ) {
 						logging::Info() << "Leaving render thread because " << count << " done";
-						return;
+						break;
 					}
 				}
 			}
+			m_renderPacing = pacer.getStatistics();
 			logging::Info() << "Leaving render thread";
 		};
 
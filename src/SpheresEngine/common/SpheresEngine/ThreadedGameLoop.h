@@ -1,8 +1,12 @@
 #pragma once
 
 #include <boost/noncopyable.hpp>
-#include <SpheresEngine/Threading/AtomicDoubleBuffer.h>
+#include <SpheresEngine/Threading/JobSystem.h>
+#include <SpheresEngine/Threading/TripleBuffer.h>
+#include <SpheresEngine/FixedTimestep.h>
+#include <SpheresEngine/Performance/PacingStatistics.h>
 #include <SpheresEngine/RenderEngine/RenderEngine.h>
+#include <SpheresEngine/Signals.h>
 #include <SpheresEngine/Visuals/VisualDataExtract.h>
 
 #include <functional>
@@ -37,12 +41,14 @@ public:
 			m_physics(phys),	//
 			m_profile(profile),	//
 			m_profileFileName(profileFileName) {
+		connectEngines();
 	}
 
 	/**
-	 * virtual dtor to support inheritance
+	 * virtual dtor to support inheritance, removes the subscriptions to
+	 * the engines
 	 */
-	virtual ~ThreadedGameLoop() = default;
+	virtual ~ThreadedGameLoop();
 
 	/** can be used in an application which does not want to return control
 	 * this will be used for the linux compile
@@ -52,7 +58,10 @@ public:
 	virtual void run();
 
 	/**
-	 * Generates and return the lambda function containing the game logic
+	 * Generates and return the lambda function containing the game logic. The
+	 * lambda expects the wall time passed since its last call. If a fixed
+	 * timestep has been set, the passed time is converted to a number of
+	 * fixed logic steps, otherwise one step with the passed time is computed.
 	 */
 	std::function<void(float)> getLogicLambda();
 
@@ -71,6 +80,15 @@ public:
 	 */
 	std::function<void(float)> getRenderLambda();
 
+	/**
+	 * Replace the job system executing the parallel aspects of the entity
+	 * engine with one using the given number of worker threads. Must be
+	 * called before run().
+	 * @param workerCount number of worker threads, zero to execute all
+	 * aspects on the logic thread
+	 */
+	void setWorkerCount(size_t workerCount);
+
 	void setMaxIterations( size_t i ) {
 		m_exitAfterThreadIterations = i;
 	}
@@ -79,6 +97,43 @@ public:
 		m_screenshotFilename = f;
 	}
 
+	/**
+	 * Run the logic with a fixed timestep instead of the passed wall time. The
+	 * renderers will interpolate between the last two logic steps.
+	 * @param stepRate number of logic steps per second
+	 * @param maxStepsPerTick maximum number of steps computed to catch up if
+	 * the logic falls behind, all further time is dropped
+	 */
+	void setFixedTimestep(float stepRate, size_t maxStepsPerTick = 5) {
+		m_fixedTimestep = std14::make_unique<FixedTimestep>(stepRate,
+				maxStepsPerTick);
+	}
+
+	/**
+	 * Returns the highest number of heap allocations done in one logic tick
+	 * after the warm-up ticks. Only counted if the AllocationCounterHook.cpp
+	 * is compiled into the executable.
+	 */
+	size_t getMaxLogicTickAllocations() const {
+		return m_maxLogicTickAllocations;
+	}
+
+	/**
+	 * Returns the histogram of how late the logic ticks started compared to
+	 * their schedule. Available after run() has returned.
+	 */
+	PacingStatistics const& getLogicPacing() const {
+		return m_logicPacing;
+	}
+
+	/**
+	 * Returns the histogram of how late the rendered frames started compared
+	 * to their schedule. Available after run() has returned.
+	 */
+	PacingStatistics const& getRenderPacing() const {
+		return m_renderPacing;
+	}
+
 #ifdef USE_SDL
 	/**
 	 * If SDL is used, this method needs to be used to set the input source
@@ -90,6 +145,25 @@ public:
 
 private:
 
+	/**
+	 * Run one step of input, entity, animation and physics computations
+	 */
+	void simulateStep(float timeDelta);
+
+	/**
+	 * Extract the visual data and hand it over to the render thread
+	 * @param interpolation the blend factor between the last two logic steps
+	 * @param stepDuration the duration of a fixed logic step, zero if
+	 * not running with a fixed timestep
+	 */
+	void extractVisuals(float interpolation, float stepDuration);
+
+	/**
+	 * Subscribe to the entity removal, so removed entities are unregistered
+	 * from the physics engine
+	 */
+	void connectEngines();
+
 	/**
 	 * Reference to the render engine
 	 */
@@ -116,15 +190,21 @@ private:
 	PhysicsEngine &m_physics;
 
 	/**
-	 * This mutex needs to be locked when accessing the
-	 * m_extractContainer member
+	 * Subscription to the removal of entities in the entity engine
+	 */
+	slots::SlotBase::subscribed_id m_entityRemovedSubscription = 0;
+
+	/**
+	 * Worker threads which execute the parallel aspects of the entity engine
 	 */
-	std::mutex m_extractContainerAccess;
+	uniq<JobSystem> m_jobSystem;
 
 	/**
-	 * Contains the visual data which has been extracted for rendering
+	 * Contains the visual data which has been extracted for rendering. The
+	 * logic thread fills the back container in place and the render thread
+	 * acquires the most recent one without copying or locking.
 	 */
-	VisualDataExtractContainer m_extractContainer;
+	TripleBuffer<VisualDataExtractContainer> m_extractBuffer;
 
 	/**
 	 * This mutex needs to be locked when accessing the
@@ -151,6 +231,11 @@ private:
 	 */
 	std::vector<RendererVisualChange> m_rendererVisualChanges;
 
+	/**
+	 * If set, the logic is run with fixed time steps
+	 */
+	uniq<FixedTimestep> m_fixedTimestep;
+
 	/**
 	 * Maximum frame rate in frames / second
 	 */
@@ -186,6 +271,28 @@ private:
 	 */
 	const size_t m_profileDumpRate = 100;
 
+	/**
+	 * Number of logic ticks which are not considered for the allocation
+	 * count, because containers and visuals are still filled up
+	 */
+	const size_t m_allocationWarmupTicks = 10;
+
+	/**
+	 * Highest number of heap allocations done by one logic tick after
+	 * the warm-up ticks
+	 */
+	std::atomic<size_t> m_maxLogicTickAllocations { 0 };
+
+	/**
+	 * Pacing errors of the logic thread, written when the thread terminates
+	 */
+	PacingStatistics m_logicPacing;
+
+	/**
+	 * Pacing errors of the render thread, written when the thread terminates
+	 */
+	PacingStatistics m_renderPacing;
+
 	/**
 	 * Set to true to signal render and logic thread to terminate
 	 */
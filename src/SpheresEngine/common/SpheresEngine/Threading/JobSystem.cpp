@@ -0,0 +1,163 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+/**
+ * The job system the current thread is a worker of, if any
+ */
+thread_local JobSystem const* t_workerOf = nullptr;
+
+/**
+ * The queue index of the current thread, if it is a worker
+ */
+thread_local size_t t_workerQueueIndex = 0;
+
+}
+
+JobSystem::JobSystem(size_t workerCount) {
+	// one additional queue for all threads which are not workers
+	for (size_t i = 0; i < workerCount + 1; i++) {
+		m_queues.push_back(std14::make_unique<TaskQueue>());
+	}
+
+	for (size_t i = 0; i < workerCount; i++) {
+		m_workers.emplace_back([this, i] () {workerLoop(i);});
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lg(m_sleepAccess);
+		m_terminate = true;
+	}
+	m_wakeUp.notify_all();
+
+	for (auto & w : m_workers) {
+		w.join();
+	}
+}
+
+size_t JobSystem::defaultWorkerCount() {
+	const size_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t chunkSize,
+		ChunkFunction const& func) {
+	assert(chunkSize > 0);
+	if (begin >= end)
+		return;
+
+	const size_t chunkCount = (end - begin + chunkSize - 1) / chunkSize;
+
+	// no need to involve other threads
+	if ((chunkCount == 1) || m_workers.empty()) {
+		for (size_t b = begin; b < end; b += chunkSize) {
+			func(b, std::min(end, b + chunkSize));
+		}
+		return;
+	}
+
+	LoopState loop;
+	loop.Func = &func;
+	loop.RemainingChunks = chunkCount;
+
+	// counted before the chunks become visible, so workers which take
+	// them right away never decrement the counter below zero
+	{
+		std::lock_guard<std::mutex> lg(m_sleepAccess);
+		m_queuedTasks += chunkCount;
+	}
+
+	// distribute continuous blocks of chunks over all queues
+	const size_t queueCount = m_queues.size();
+	for (size_t q = 0; q < queueCount; q++) {
+		const size_t firstChunk = (chunkCount * q) / queueCount;
+		const size_t lastChunk = (chunkCount * (q + 1)) / queueCount;
+
+		auto & queue = *m_queues[q];
+		std::lock_guard<std::mutex> lg(queue.Access);
+		// pushed in reverse, so the owner which takes from the back
+		// processes its chunks in ascending order
+		for (size_t c = lastChunk; c > firstChunk; c--) {
+			const size_t chunkBegin = begin + (c - 1) * chunkSize;
+			queue.Tasks.push_back(
+					Task { &loop, chunkBegin, std::min(end, chunkBegin + chunkSize) });
+		}
+	}
+
+	m_wakeUp.notify_all();
+
+	// help processing until all chunks of this loop are done, this
+	// might also process chunks of other loops
+	const auto queueIndex = getQueueIndex();
+	Task task;
+	while (loop.RemainingChunks.load(std::memory_order_acquire) > 0) {
+		if (takeTask(queueIndex, task)) {
+			runTask(task);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::workerLoop(size_t queueIndex) {
+	t_workerOf = this;
+	t_workerQueueIndex = queueIndex;
+
+	Task task;
+	while (true) {
+		if (takeTask(queueIndex, task)) {
+			runTask(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lk(m_sleepAccess);
+		m_wakeUp.wait(lk, [this] () {return m_terminate || (m_queuedTasks > 0);});
+		if (m_terminate)
+			return;
+	}
+}
+
+bool JobSystem::takeTask(size_t queueIndex, Task & task) {
+	{
+		auto & own = *m_queues[queueIndex];
+		std::lock_guard<std::mutex> lg(own.Access);
+		if (!own.Tasks.empty()) {
+			task = own.Tasks.back();
+			own.Tasks.pop_back();
+			m_queuedTasks--;
+			return true;
+		}
+	}
+
+	// steal from the other queues
+	for (size_t i = 1; i < m_queues.size(); i++) {
+		auto & other = *m_queues[(queueIndex + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lg(other.Access);
+		if (!other.Tasks.empty()) {
+			task = other.Tasks.front();
+			other.Tasks.pop_front();
+			m_queuedTasks--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::runTask(Task const& task) {
+	(*task.Loop->Func)(task.Begin, task.End);
+	// the loop state must not be accessed after this, the thread
+	// waiting for the loop might return right away
+	task.Loop->RemainingChunks.fetch_sub(1, std::memory_order_release);
+}
+
+size_t JobSystem::getQueueIndex() const {
+	if (t_workerOf == this)
+		return t_workerQueueIndex;
+	return m_queues.size() - 1;
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <SpheresEngine/Util.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed pool of worker threads which executes parallel-for loops.
+ *
+ * Each worker owns a task deque. The tasks of one parallelFor call are
+ * distributed over all deques; a worker first processes its own tasks from
+ * the back and steals from the front of the other deques once its own deque
+ * is empty. The calling thread of parallelFor participates in the work until
+ * the loop is complete.
+ *
+ * The chunk boundaries only depend on the chunk size and never on the
+ * number of workers, so loops which write disjoint ranges produce the same
+ * results independent of the thread count.
+ */
+class JobSystem: boost::noncopyable {
+public:
+
+	/**
+	 * Function executed for one chunk of a parallel-for loop, it gets the first
+	 * and one-past-the-last index of the chunk
+	 */
+	typedef std::function<void(size_t, size_t)> ChunkFunction;
+
+	/**
+	 * Start the worker threads
+	 * @param workerCount number of worker threads to start. Can be zero, then
+	 * all work is done by the thread calling parallelFor.
+	 */
+	explicit JobSystem(size_t workerCount = defaultWorkerCount());
+
+	/**
+	 * Stops and joins all worker threads
+	 */
+	~JobSystem();
+
+	/**
+	 * Returns the number of worker threads, which does not include the
+	 * threads calling parallelFor
+	 */
+	size_t getWorkerCount() const {
+		return m_workers.size();
+	}
+
+	/**
+	 * Execute func for all chunks of the range [begin, end) and return once all
+	 * chunks have been processed. All chunks have the size chunkSize, except
+	 * the last one which can be smaller. Can be called from worker threads
+	 * to run nested loops.
+	 */
+	void parallelFor(size_t begin, size_t end, size_t chunkSize,
+			ChunkFunction const& func);
+
+	/**
+	 * Number of workers which keeps all cores busy together with the
+	 * thread calling parallelFor
+	 */
+	static size_t defaultWorkerCount();
+
+private:
+
+	/**
+	 * Book keeping of one parallelFor call
+	 */
+	struct LoopState {
+		/**
+		 * Function to execute for each chunk
+		 */
+		ChunkFunction const* Func;
+
+		/**
+		 * Number of chunks which have not been completed yet
+		 */
+		std::atomic<size_t> RemainingChunks;
+	};
+
+	/**
+	 * One chunk of a parallelFor loop
+	 */
+	struct Task {
+		/**
+		 * The loop this chunk belongs to
+		 */
+		LoopState * Loop;
+
+		/**
+		 * First index of the chunk
+		 */
+		size_t Begin;
+
+		/**
+		 * One-past-the-last index of the chunk
+		 */
+		size_t End;
+	};
+
+	/**
+	 * Deque of tasks which is filled by parallelFor, processed by its owner
+	 * from the back and can be stolen from by other threads at the front
+	 */
+	struct TaskQueue {
+		/**
+		 * Protects the tasks
+		 */
+		std::mutex Access;
+
+		/**
+		 * Tasks which still need to be processed
+		 */
+		std::deque<Task> Tasks;
+	};
+
+	/**
+	 * Main loop of each worker thread
+	 */
+	void workerLoop(size_t queueIndex);
+
+	/**
+	 * Take one task from the own queue or steal one from another queue.
+	 * Returns false if no task was available in any queue.
+	 */
+	bool takeTask(size_t queueIndex, Task & task);
+
+	/**
+	 * Execute one task and mark it as done
+	 */
+	void runTask(Task const& task);
+
+	/**
+	 * Return the queue index of the calling thread. Threads which are not
+	 * workers of this job system share the last queue.
+	 */
+	size_t getQueueIndex() const;
+
+	/**
+	 * One queue per worker and one queue for all other threads
+	 */
+	std::vector<uniq<TaskQueue>> m_queues;
+
+	/**
+	 * The worker threads
+	 */
+	std::vector<std::thread> m_workers;
+
+	/**
+	 * Number of tasks in all queues. Only increased while holding m_sleepAccess
+	 * so no wake up of the workers is lost.
+	 */
+	std::atomic<size_t> m_queuedTasks { 0 };
+
+	/**
+	 * Set to true to terminate the worker threads
+	 */
+	std::atomic<bool> m_terminate { false };
+
+	/**
+	 * Protects the sleeping of idle workers
+	 */
+	std::mutex m_sleepAccess;
+
+	/**
+	 * Idle workers wait on this condition for new tasks
+	 */
+	std::condition_variable m_wakeUp;
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free triple buffer to hand over a payload object from exactly one
+ * writing thread to exactly one reading thread.
+ *
+ * The writer fills the back object in place and publishes it with publish().
+ * The reader calls acquire() to swap the most recently published object to
+ * the front and then reads it via getFront(). Both sides only exchange an
+ * index, so no payload is ever copied and no thread ever blocks. If the writer
+ * publishes faster than the reader acquires, the older objects are skipped
+ * and reused by the writer.
+ */
+template<class TPayload>
+class TripleBuffer: boost::noncopyable {
+public:
+
+	/**
+	 * Can be called by the writing thread to get access to the object
+	 * which can be safely written to
+	 */
+	TPayload & getBack() {
+		return m_payload[m_backIndex];
+	}
+
+	/**
+	 * Called by the writing thread once the back object is complete. The
+	 * back object is handed to the reader and the writer gets a new back
+	 * object which is not in use by the reader.
+	 */
+	void publish() {
+		const auto oldMiddle = m_middle.exchange(
+				std::uint8_t(m_backIndex | FreshBit), std::memory_order_acq_rel);
+		m_backIndex = oldMiddle & IndexMask;
+	}
+
+	/**
+	 * Called by the reading thread to retrieve the most recently published
+	 * object. Returns true if a new object is available at the front and false
+	 * if nothing has been published since the last call. In this case, the
+	 * front object is unchanged.
+	 */
+	bool acquire() {
+		if ((m_middle.load(std::memory_order_relaxed) & FreshBit) == 0)
+			return false;
+
+		const auto oldMiddle = m_middle.exchange(m_frontIndex,
+				std::memory_order_acq_rel);
+		m_frontIndex = oldMiddle & IndexMask;
+		return true;
+	}
+
+	/**
+	 * Can be called by the reading thread to access the object which
+	 * was acquired last
+	 */
+	TPayload & getFront() {
+		return m_payload[m_frontIndex];
+	}
+
+	/**
+	 * Const version to access the object which was acquired last
+	 */
+	TPayload const& getFront() const {
+		return m_payload[m_frontIndex];
+	}
+
+private:
+
+	/**
+	 * Set in the middle index if the middle object has been published but
+	 * not yet been acquired by the reader
+	 */
+	static constexpr std::uint8_t FreshBit = 0x4;
+
+	/**
+	 * Mask to extract the payload index from the middle index
+	 */
+	static constexpr std::uint8_t IndexMask = 0x3;
+
+	/**
+	 * This array contains the three payloads of the triple buffer
+	 */
+	std::array<TPayload, 3> m_payload;
+
+	/**
+	 * Index of the object currently owned by the writing thread. Only
+	 * accessed by the writer.
+	 */
+	std::uint8_t m_backIndex = 0;
+
+	/**
+	 * Index of the object currently owned by the reading thread. Only
+	 * accessed by the reader.
+	 */
+	std::uint8_t m_frontIndex = 1;
+
+	/**
+	 * Index of the object which is exchanged between the two threads,
+	 * including the FreshBit flag
+	 */
+	std::atomic<std::uint8_t> m_middle { 2 };
+};
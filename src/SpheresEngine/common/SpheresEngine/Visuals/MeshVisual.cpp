@@ -2,15 +2,65 @@
 
 #include <SpheresEngine/Visuals/VisualDataExtract.h>
 
+#include <algorithm>
+
+constexpr size_t MeshVisualData::MaxLevelsOfDetail;
+
 void MeshVisual::extractData(VisualDataExtractContainer & cont,
 		ExtractOffset const& eo) {
-	auto data = getData();
+	// copy into a slot of the container which is reused every tick to
+	// prevent heap allocations
+	extractDataTo(cont.MeshVisuals.next());
+	extractTransformTo(cont.MeshTransforms.next(), eo);
+}
+
+void MeshVisual::extractDataTo(MeshVisualData & data) const {
+	data = getData();
+}
 
+void MeshVisual::extractTransformTo(VisualTransform & transform,
+		ExtractOffset const& eo) {
 	// apply the existing offset position of the Entity
-	data.Center = eo.Position.toGlm();
+	transform.Center = eo.Position.toGlm();
 
 	// combine rotations of the entity with this mesh
-	data.Rotation = eo.Rotation;
+	transform.Rotation = eo.Rotation;
+
+	transform.PreviousCenter = eo.PreviousPosition.toGlm();
+	transform.PreviousRotation = eo.PreviousRotation;
+}
+
+void MeshVisual::update(RendererVisualChange const& vc) {
+	if (vc.EventType
+			== RendererVisualChange::EventTypeEnum::ShaderProgramReload) {
+		// is this our shader ?
+		if (vc.ShaderProgramName == getShaderProgramName()) {
+			// update id of shader program
+			this->getData().Shader.setId(vc.ShaderProgramId);
+			this->getData().Shader.setLocations(vc.ShaderProgramLocations);
+			logging::Info() << "Update shader program " << vc.ShaderProgramName
+					<< " in visual data";
+		}
+		if (vc.ShaderProgramName == getData().InstancedShader.getName()) {
+			this->getData().InstancedShader.setId(vc.ShaderProgramId);
+			this->getData().InstancedShader.setLocations(
+					vc.ShaderProgramLocations);
+			logging::Info() << "Update instanced shader program "
+					<< vc.ShaderProgramName << " in visual data";
+		}
+	}
+}
 
-	cont.MeshVisuals.push_back(data);
+void MeshVisual::addLevelOfDetail(std::string meshName, float maxScreenSize) {
+	if (m_levelsOfDetail.size() >= MeshVisualData::MaxLevelsOfDetail) {
+		logging::Error() << "Mesh " << m_meshName << " already has "
+				<< m_levelsOfDetail.size() << " levels of detail, "
+				<< meshName << " is ignored";
+		return;
+	}
+	auto it = std::find_if(m_levelsOfDetail.begin(), m_levelsOfDetail.end(),
+			[maxScreenSize] (LevelOfDetail const& lod) {
+				return lod.MaxScreenSize < maxScreenSize;
+			});
+	m_levelsOfDetail.insert(it, LevelOfDetail { meshName, maxScreenSize });
 }
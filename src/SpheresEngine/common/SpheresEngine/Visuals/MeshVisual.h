@@ -7,6 +7,9 @@
 
 #include <glm/vec3.hpp> // glm::vec3
 
+#include <string>
+#include <vector>
+
 struct VisualDataExtractContainer;
 
 /**
@@ -33,6 +36,18 @@ public:
 		return "MeshVisual";
 	}
 
+	/**
+	 * return the name of the shader program set when the mesh was prepared
+	 */
+	std::string getShaderProgramName() const override {
+		return getData().Shader.getName();
+	}
+
+	/**
+	 * Checks if the shader has been reloaded and the shader id needs to be updated
+	 */
+	void update(RendererVisualChange const& vc) override;
+
 	/**
 	 * Extracts the render information of this mesh to be
 	 * used in the render thread
@@ -40,6 +55,19 @@ public:
 	void extractData(VisualDataExtractContainer & cont, ExtractOffset const& eo)
 			override;
 
+	/**
+	 * Write the render information of this mesh, without the position and
+	 * rotation, to an existing entry of the extract container
+	 */
+	void extractDataTo(MeshVisualData & data) const;
+
+	/**
+	 * Write the position and rotation of the entity to an existing transform
+	 * entry of the extract container
+	 */
+	static void extractTransformTo(VisualTransform & transform,
+			ExtractOffset const& eo);
+
 	/**
 	 * The name of the mesh, mostly useful for debugging
 	 */
@@ -54,6 +82,37 @@ public:
 		return m_texture;
 	}
 
+	/**
+	 * A simplified mesh and the screen size below which it is drawn
+	 */
+	struct LevelOfDetail {
+		/**
+		 * Name of the simplified mesh
+		 */
+		std::string MeshName;
+
+		/**
+		 * The mesh is drawn if the visual covers less than this fraction of
+		 * the screen height
+		 */
+		float MaxScreenSize;
+	};
+
+	/**
+	 * Add a simplified mesh which is drawn instead of the full mesh once the
+	 * bounding sphere of the visual covers less than maxScreenSize of the
+	 * screen height. Must be called before the visual is prepared, at most
+	 * MeshVisualData::MaxLevelsOfDetail meshes can be added.
+	 */
+	void addLevelOfDetail(std::string meshName, float maxScreenSize);
+
+	/**
+	 * The simplified meshes, ordered by decreasing screen size
+	 */
+	std::vector<LevelOfDetail> const& getLevelsOfDetail() const {
+		return m_levelsOfDetail;
+	}
+
 private:
 	/**
 	 * holds the mesh name
@@ -65,4 +124,9 @@ private:
 	 */
 	std::string m_texture;
 
+	/**
+	 * The simplified meshes, ordered by decreasing screen size
+	 */
+	std::vector<LevelOfDetail> m_levelsOfDetail;
+
 };
@@ -2,12 +2,49 @@
 
 #include <SpheresEngine/RenderEngine/OpenGLInclude.h>
 
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstdint>
+
 /**
- * The data used to render a mesh
+ * A simplified version of a mesh, drawn once the visual becomes small on the
+ * screen
  */
-struct MeshVisualData: VisualDataBase,
-		LocatedVisualDataBase,
-		ShadedVisualDataBase {
+struct MeshLevelOfDetail {
+	/**
+	 * The OpenGL id of the Vertex Array of the simplified mesh
+	 */
+	GLuint VertexArrayObjectId = 0;
+
+	/**
+	 * The vertex count of the simplified mesh
+	 */
+	GLsizei VertexCount = 0;
+
+	/**
+	 * The instanced Vertex Array of the simplified mesh, 0 if the mesh can
+	 * not be drawn instanced
+	 */
+	GLuint InstancedVertexArrayObjectId = 0;
+
+	/**
+	 * The simplified mesh is drawn if the bounding sphere of the visual
+	 * covers less than this fraction of the screen height
+	 */
+	float MaxScreenSize = 0.0f;
+};
+
+/**
+ * The data used to render a mesh. The position and rotation are extracted
+ * separately as a VisualTransform, they change much more often.
+ */
+struct MeshVisualData: VisualDataBase, ShadedVisualDataBase {
+	/**
+	 * Maximum number of simplified meshes of one visual
+	 */
+	static constexpr size_t MaxLevelsOfDetail = 3;
+
 	/**
 	 * The OpneGL id of the Vertex Array
 	 */
@@ -22,4 +59,37 @@ struct MeshVisualData: VisualDataBase,
 	 * The openGL texture id to use for the diffuse part of this Mesh
 	 */
 	GLuint TextureId;
+
+	/**
+	 * The OpenGL id of the Vertex Array which reads the model matrix per
+	 * instance, 0 if this mesh can not be drawn instanced
+	 */
+	GLuint InstancedVertexArrayObjectId = 0;
+
+	/**
+	 * Shader Program used if multiple copies of this mesh are drawn with
+	 * one instanced draw call
+	 */
+	ShaderProgram InstancedShader;
+
+	/**
+	 * Center of the bounding sphere of the mesh in model coordinates
+	 */
+	glm::vec3 BoundsCenter = glm::vec3(0.0f);
+
+	/**
+	 * Radius of the bounding sphere of the mesh. Visuals with a negative
+	 * radius are never culled.
+	 */
+	float BoundsRadius = -1.0f;
+
+	/**
+	 * The simplified meshes, ordered by decreasing MaxScreenSize
+	 */
+	std::array<MeshLevelOfDetail, MaxLevelsOfDetail> LevelsOfDetail;
+
+	/**
+	 * Number of entries used in LevelsOfDetail
+	 */
+	uint8_t LevelOfDetailCount = 0;
 };
@@ -0,0 +1,217 @@
+#include "ParticleKernels.h"
+
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+
+#include <cassert>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE__)
+#define SPHERES_PARTICLE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ParticleKernels {
+
+namespace {
+
+/**
+ * Pointers to the arrays of a particle buffer which are used by the
+ * integration kernels
+ */
+struct IntegrationArrays {
+	float * X;
+	float * Y;
+	float * Z;
+	float const* Size;
+	float const* VelocityX;
+	float * VelocityY;
+	float const* VelocityZ;
+	float * PositionSizes;
+};
+
+/**
+ * Scalar integration of the particles in the range [begin, end)
+ */
+void integrateScalar(IntegrationArrays const& a, size_t begin, size_t end,
+		float gravityDt, float dt) {
+	for (size_t i = begin; i < end; i++) {
+		// work on local copies, the compiler can not know that the
+		// arrays do not alias
+		const float vy = a.VelocityY[i] - gravityDt;
+		const float x = a.X[i] + a.VelocityX[i] * dt;
+		const float y = a.Y[i] + vy * dt;
+		const float z = a.Z[i] + a.VelocityZ[i] * dt;
+
+		a.VelocityY[i] = vy;
+		a.X[i] = x;
+		a.Y[i] = y;
+		a.Z[i] = z;
+
+		a.PositionSizes[4 * i + 0] = x;
+		a.PositionSizes[4 * i + 1] = y;
+		a.PositionSizes[4 * i + 2] = z;
+		a.PositionSizes[4 * i + 3] = a.Size[i];
+	}
+}
+
+#ifdef SPHERES_PARTICLE_KERNELS_X86
+
+/**
+ * Integrates four particles per iteration with SSE and returns the index
+ * of the first particle which has not been processed
+ */
+size_t integrateSSE(IntegrationArrays const& a, size_t count,
+		float gravityDt, float dt) {
+	const __m128 vDt = _mm_set1_ps(dt);
+	const __m128 vGravityDt = _mm_set1_ps(gravityDt);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 vy = _mm_sub_ps(_mm_load_ps(a.VelocityY + i), vGravityDt);
+		_mm_store_ps(a.VelocityY + i, vy);
+
+		__m128 x = _mm_add_ps(_mm_load_ps(a.X + i),
+				_mm_mul_ps(_mm_load_ps(a.VelocityX + i), vDt));
+		__m128 y = _mm_add_ps(_mm_load_ps(a.Y + i), _mm_mul_ps(vy, vDt));
+		__m128 z = _mm_add_ps(_mm_load_ps(a.Z + i),
+				_mm_mul_ps(_mm_load_ps(a.VelocityZ + i), vDt));
+		__m128 s = _mm_load_ps(a.Size + i);
+
+		_mm_store_ps(a.X + i, x);
+		_mm_store_ps(a.Y + i, y);
+		_mm_store_ps(a.Z + i, z);
+
+		// convert to the interleaved x,y,z,size layout
+		_MM_TRANSPOSE4_PS(x, y, z, s);
+		float * out = a.PositionSizes + 4 * i;
+		_mm_storeu_ps(out + 0, x);
+		_mm_storeu_ps(out + 4, y);
+		_mm_storeu_ps(out + 8, z);
+		_mm_storeu_ps(out + 12, s);
+	}
+	return i;
+}
+
+/**
+ * Integrates eight particles per iteration with AVX2 and returns the index
+ * of the first particle which has not been processed
+ */
+__attribute__((target("avx2")))
+size_t integrateAVX2(IntegrationArrays const& a, size_t count,
+		float gravityDt, float dt) {
+	const __m256 vDt = _mm256_set1_ps(dt);
+	const __m256 vGravityDt = _mm256_set1_ps(gravityDt);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256 vy = _mm256_sub_ps(_mm256_load_ps(a.VelocityY + i),
+				vGravityDt);
+		_mm256_store_ps(a.VelocityY + i, vy);
+
+		const __m256 x = _mm256_add_ps(_mm256_load_ps(a.X + i),
+				_mm256_mul_ps(_mm256_load_ps(a.VelocityX + i), vDt));
+		const __m256 y = _mm256_add_ps(_mm256_load_ps(a.Y + i),
+				_mm256_mul_ps(vy, vDt));
+		const __m256 z = _mm256_add_ps(_mm256_load_ps(a.Z + i),
+				_mm256_mul_ps(_mm256_load_ps(a.VelocityZ + i), vDt));
+		const __m256 s = _mm256_load_ps(a.Size + i);
+
+		_mm256_store_ps(a.X + i, x);
+		_mm256_store_ps(a.Y + i, y);
+		_mm256_store_ps(a.Z + i, z);
+
+		// convert to the interleaved x,y,z,size layout, the unpack and
+		// shuffle instructions work within the 128-bit lanes, so each
+		// qN holds particle N in the lower and N+4 in the upper lane
+		const __m256 xy0 = _mm256_unpacklo_ps(x, y);
+		const __m256 xy1 = _mm256_unpackhi_ps(x, y);
+		const __m256 zs0 = _mm256_unpacklo_ps(z, s);
+		const __m256 zs1 = _mm256_unpackhi_ps(z, s);
+
+		const __m256 q0 = _mm256_shuffle_ps(xy0, zs0, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 q1 = _mm256_shuffle_ps(xy0, zs0, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 q2 = _mm256_shuffle_ps(xy1, zs1, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 q3 = _mm256_shuffle_ps(xy1, zs1, _MM_SHUFFLE(3, 2, 3, 2));
+
+		float * out = a.PositionSizes + 4 * i;
+		_mm256_storeu_ps(out + 0, _mm256_permute2f128_ps(q0, q1, 0x20));
+		_mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(q2, q3, 0x20));
+		_mm256_storeu_ps(out + 16, _mm256_permute2f128_ps(q0, q1, 0x31));
+		_mm256_storeu_ps(out + 24, _mm256_permute2f128_ps(q2, q3, 0x31));
+	}
+	return i;
+}
+
+#endif
+
+}
+
+bool isAvailable(InstructionSet is) {
+	switch (is) {
+	case InstructionSet::Scalar:
+		return true;
+#ifdef SPHERES_PARTICLE_KERNELS_X86
+	case InstructionSet::SSE:
+		return true;
+	case InstructionSet::AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+	default:
+		return false;
+	}
+}
+
+InstructionSet bestAvailable() {
+	if (isAvailable(InstructionSet::AVX2))
+		return InstructionSet::AVX2;
+	if (isAvailable(InstructionSet::SSE))
+		return InstructionSet::SSE;
+	return InstructionSet::Scalar;
+}
+
+std::string getName(InstructionSet is) {
+	switch (is) {
+	case InstructionSet::SSE:
+		return "SSE";
+	case InstructionSet::AVX2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+void integrateNewtonWithGravity(ParticleBuffer & pb, float gravity, float dt,
+		InstructionSet is) {
+	integrateNewtonWithGravity(pb, gravity, dt, 0, pb.getParticleCount(), is);
+}
+
+void integrateNewtonWithGravity(ParticleBuffer & pb, float gravity, float dt,
+		size_t begin, size_t end, InstructionSet is) {
+	assert(isAvailable(is));
+	assert(begin % RangeAlignment == 0);
+	assert(end <= pb.getParticleCount());
+	assert(pb.X.size() == pb.getParticleCount());
+	assert(pb.VelocityX.size() == pb.getParticleCount());
+
+	if (begin >= end)
+		return;
+
+	IntegrationArrays a { pb.X.data() + begin, pb.Y.data() + begin,
+			pb.Z.data() + begin, pb.Size.data() + begin, pb.VelocityX.data()
+					+ begin, pb.VelocityY.data() + begin, pb.VelocityZ.data()
+					+ begin, pb.getPosSizeBuffer() + 4 * begin };
+	const size_t count = end - begin;
+	const float gravityDt = gravity * dt;
+
+	size_t done = 0;
+#ifdef SPHERES_PARTICLE_KERNELS_X86
+	if (is == InstructionSet::AVX2) {
+		done = integrateAVX2(a, count, gravityDt, dt);
+	} else if (is == InstructionSet::SSE) {
+		done = integrateSSE(a, count, gravityDt, dt);
+	}
+#endif
+	// the remaining particles which do not fill a complete SIMD register
+	integrateScalar(a, done, count, gravityDt, dt);
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+struct ParticleBuffer;
+
+/**
+ * Simulation kernels which operate on the structure-of-arrays storage of
+ * a ParticleBuffer. Each kernel is available as scalar version and, on x86,
+ * as SSE and AVX2 version. The best version supported by the CPU is selected
+ * at runtime.
+ */
+namespace ParticleKernels {
+
+/**
+ * Instruction sets the kernels have been implemented for
+ */
+enum class InstructionSet {
+	Scalar, SSE, AVX2
+};
+
+/**
+ * The first particle of a range passed to the kernels must be a multiple
+ * of this number, so the SIMD versions can use aligned loads
+ */
+constexpr size_t RangeAlignment = 8;
+
+/**
+ * Returns true if the kernels for this instruction set have been compiled
+ * in and the CPU supports the instruction set
+ */
+bool isAvailable(InstructionSet is);
+
+/**
+ * Returns the fastest instruction set which is available on this machine
+ */
+InstructionSet bestAvailable();
+
+/**
+ * Returns the name of the instruction set, for logging
+ */
+std::string getName(InstructionSet is);
+
+/**
+ * Integrate the newtonian motion of all particles, including a gravity
+ * acceleration in negative y direction, and update the interleaved
+ * PositionSizes array used by the renderer
+ */
+void integrateNewtonWithGravity(ParticleBuffer & pb, float gravity, float dt,
+		InstructionSet is = bestAvailable());
+
+/**
+ * Integrate only the particles in the range [begin, end). Different ranges
+ * can be processed by different threads at the same time.
+ * @param begin first particle, must be a multiple of RangeAlignment
+ * @param end one-past-the-last particle
+ */
+void integrateNewtonWithGravity(ParticleBuffer & pb, float gravity, float dt,
+		size_t begin, size_t end, InstructionSet is = bestAvailable());
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ParticleSystemVisual.h"
+#include "ParticleKernels.h"
+#include <SpheresEngine/Threading/JobSystem.h>
 
 #include <boost/range/irange.hpp>
 #include <random>
@@ -51,25 +53,29 @@ inline ParticleModelLambda nop() {
 inline ParticleModelLambda plainNewtonWithGravity() {
 	auto model =
 			[](ParticleSystemVisualData & pv, float dt) -> void {
+				const float grav = 1.0f;
+				ParticleKernels::integrateNewtonWithGravity(pv.editPositions(), grav, dt);
+			};
+	return model;
+}
 
-				assert(pv.PositionSizes.size() == pv.SimulationExtra.size());
-
-				for ( auto i[[gnu::unused]] : boost::irange(size_t(0), pv.PositionSizes.size() )) {
-					auto & pos = pv.PositionSizes[i];
-					auto & sim = pv.SimulationExtra[i];
-
-					float grav = 1.0f;
-
-					sim.Velocity.setY( sim.Velocity.y() -grav * dt);
-
-					auto dx = sim.Velocity.x() * dt;
-					auto dy = sim.Velocity.y() * dt;
-					auto dz = sim.Velocity.z() * dt;
+/**
+ * Same model as plainNewtonWithGravity, but the particles are split into
+ * chunks which are simulated in parallel by the job system. The job system
+ * must outlive the returned model.
+ */
+inline ParticleModelLambda plainNewtonWithGravity(JobSystem & jobs,
+		size_t chunkSize = 16 * 1024) {
+	assert(chunkSize % ParticleKernels::RangeAlignment == 0);
 
-					pos.setX( pos.x() + dx );
-					pos.setY( pos.y() + dy );
-					pos.setZ( pos.z() + dz );
-				}
+	auto model =
+			[&jobs, chunkSize](ParticleSystemVisualData & pv, float dt) -> void {
+				const float grav = 1.0f;
+				auto & particles = pv.editPositions();
+				jobs.parallelFor(0, particles.getParticleCount(), chunkSize,
+						[&particles, grav, dt] (size_t begin, size_t end) {
+							ParticleKernels::integrateNewtonWithGravity(particles, grav, dt, begin, end);
+						});
 			};
 	return model;
 }
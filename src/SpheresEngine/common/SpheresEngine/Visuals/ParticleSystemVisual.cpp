@@ -2,44 +2,147 @@
 
 #include <SpheresEngine/Visuals/VisualDataExtract.h>
 
-//#include "../../../SpheresEngine/src/Visuals/VisualDataExtract.h"
+#include <algorithm>
+
+ParticleBuffer & ParticleSystemVisualData::editParticles() {
+	ColorVersion++;
+	return editPositions();
+}
+
+constexpr size_t ParticleSystemVisualData::MaxSpareBuffers;
+
+ParticleBuffer & ParticleSystemVisualData::editPositions() {
+	if (Extracted) {
+		// the current buffer might be rendered right now, continue on a
+		// buffer of a version the renderer does not read anymore
+		const size_t rendered = Handoff->RenderedVersion.load(
+				std::memory_order_acquire);
+		auto itSpare = std::find_if(SpareParticles.begin(), SpareParticles.end(),
+				[rendered](SpareBuffer const& b) {return b.Version < rendered;});
+
+		if (itSpare != SpareParticles.end()) {
+			std::swap(itSpare->Buffer, Particles);
+			itSpare->Version = Version;
+			// the spare buffer keeps its capacity, no allocation needed
+			*Particles = *itSpare->Buffer;
+		} else {
+			if (SpareParticles.size() >= MaxSpareBuffers) {
+				// freeing is safe, the buffers are only reused once rendered
+				SpareParticles.erase(
+						std::remove_if(SpareParticles.begin(),
+								SpareParticles.end(),
+								[](SpareBuffer const& b) {return b.Buffer.use_count() == 1;}),
+						SpareParticles.end());
+			}
+			SpareParticles.push_back(SpareBuffer { Particles, Version });
+			Particles = std::make_shared<ParticleBuffer>(*Particles);
+		}
+		Extracted = false;
+	}
+
+	Version++;
+	return *Particles;
+}
 
 void ParticleSystemVisual::extractData(VisualDataExtractContainer & cont,
 		ExtractOffset const& eo) {
+	extractDataTo(cont.ParticleSystems.next(), eo);
+}
+
+void ParticleSystemVisual::extractDataTo(ParticleSystemExtractData & data,
+		ExtractOffset const& eo) const {
+
+	auto const& source = getData();
 
-	// todo: use ExtractOffset
+	// only the reference to the particles is copied and not the
+	// particles themselves
+	data.Particles = source.Particles;
+	data.Version = source.Version;
+	data.ColorVersion = source.ColorVersion;
+	data.Shader = source.Shader;
+	data.UserData = source.UserData;
+	data.vertexPositionBuffer = source.vertexPositionBuffer;
+	data.vertexColorBuffer = source.vertexColorBuffer;
+	data.SimulationShader = source.SimulationShader;
+	data.SimulationTime = source.SimulationTime;
+	data.Readback = source.Readback;
+	data.Handoff = source.Handoff;
+	source.Extracted = true;
 
-	auto data = getData();
 	// recenter on entity Position
 	data.Center = eo.Position.toGlm();
 	data.Rotation = eo.Rotation;
+	data.PreviousCenter = eo.PreviousPosition.toGlm();
+	data.PreviousRotation = eo.PreviousRotation;
+}
 
-	cont.ParticleSystems.emplace_back(data);
+void ParticleSystemVisual::setGpuSimulation(std::string programName) {
+	getData().SimulationProgramName = programName;
+	getData().Readback = std::make_shared<ParticleReadback>();
+}
 
-	// mark that there is no pending update on the particles
-	// data (yet), because no modifications form the CPU side have
-	// been performed on the particle position/color
-	getData().Updated = false;
+void ParticleSystemVisual::requestReadback() {
+	// requesting does not change the visual data, use the const accessor
+	auto & readback = *constData().Readback;
+	std::lock_guard<std::mutex> lock(readback.Mutex);
+	readback.Requested = true;
 }
 
 void ParticleSystemVisual::step(float deltaT) {
+	// the non-const getData() marks the visual changed, only use it if the
+	// data is modified
+	if (constData().hasGpuSimulation()) {
+		// the renderer advances the particles on the GPU
+		getData().SimulationTime += deltaT;
+		applyReadback();
+		return;
+	}
+
 	// recompute positions and stuff
 
 	/*for (auto & p : getData().Particles) {
 	 // compute equation of motion etc.
 	 }*/
-	m_model(getData(), deltaT);
+	if (m_model) {
+		m_model(getData(), deltaT);
+	}
+}
+
+void ParticleSystemVisual::applyReadback() {
+	auto & readback = *constData().Readback;
+	std::lock_guard<std::mutex> lock(readback.Mutex);
+	if (!readback.Completed) {
+		return;
+	}
+	readback.Completed = false;
+
+	const auto valueCount = 4 * getParticleCount();
+	if ((readback.PositionSizes.size() != valueCount)
+			|| (readback.Velocities.size() != valueCount)) {
+		// particles have been added since the readback was requested
+		return;
+	}
+
+	// the GPU owns the positions, editPositions() does not upload them
+	getData().editPositions().deinterleave(readback.PositionSizes.data(),
+			readback.Velocities.data());
 }
 
 void ParticleSystemVisual::update(RendererVisualChange const& vc) {
 	if (vc.EventType
 			== RendererVisualChange::EventTypeEnum::ShaderProgramReload) {
 		// is this our shader ?
-		if (vc.ShaderProgramName == this->getData().Shader.getName()) {
+		if (vc.ShaderProgramName == getShaderProgramName()) {
 			// update id of shader program
 			this->getData().Shader.setId(vc.ShaderProgramId);
+			this->getData().Shader.setLocations(vc.ShaderProgramLocations);
 			logging::Info() << "Update shader program " << vc.ShaderProgramName
 					<< " in visual data";
 		}
+		if (vc.ShaderProgramName == getData().SimulationShader.getName()) {
+			this->getData().SimulationShader.setId(vc.ShaderProgramId);
+			this->getData().SimulationShader.setLocations(
+					vc.ShaderProgramLocations);
+		}
 	}
 }
@@ -5,6 +5,11 @@
 #include <SpheresEngine/VectorTypes.h>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderBackend.h>
 
+#include <boost/align/aligned_allocator.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -98,9 +103,17 @@ struct ParticleColor {
 };
 
 /**
- * Visual data extracted for particle system rendering
+ * Holds the payload of all particles of one particle system. The buffer is
+ * shared between the particle system visual and the extracted visual data,
+ * so the particles do not need to be copied for each logic tick.
+ *
+ * The simulation state is stored as structure-of-arrays with aligned
+ * storage so it can be processed by the SIMD kernels in ParticleKernels.h.
+ * PositionSizes holds the interleaved x,y,z,size values which are uploaded
+ * by the renderer and needs to be refreshed after the simulation state
+ * has been modified.
  */
-struct ParticleSystemVisualData: LocatedVisualDataBase, ShadedVisualDataBase {
+struct ParticleBuffer {
 
 	/**
 	 * Typedef for a 3d-vector which also stores the payload particle size,
@@ -108,16 +121,132 @@ struct ParticleSystemVisualData: LocatedVisualDataBase, ShadedVisualDataBase {
 	 */
 	typedef Vector3PayloadBase<float> Vector3WithSize;
 
-	/** if this is true, the three std::vectors below
-	 * contain entries and the Renderer must download the
-	 * new position to the GPU. This happens for example
-	 * when a CPU-based animation of the particle system is computed
-	 * otherwise no download will be performed (much faster)
+	/**
+	 * Alignment in bytes of the structure-of-array storage, large enough
+	 * for AVX loads and stores
+	 */
+	static constexpr size_t Alignment = 32;
+
+	/**
+	 * Vector of floats with the alignment required by the SIMD kernels
+	 */
+	typedef std::vector<float, boost::alignment::aligned_allocator<float, Alignment>> AlignedFloats;
+
+	/**
+	 * Add a new particle to the end of all arrays
+	 */
+	void addParticle(ParticleState const& ps, ParticleColor pc,
+			float size = 0.1f) {
+		X.push_back(ps.Position.x());
+		Y.push_back(ps.Position.y());
+		Z.push_back(ps.Position.z());
+		Size.push_back(size);
+		VelocityX.push_back(ps.Velocity.x());
+		VelocityY.push_back(ps.Velocity.y());
+		VelocityZ.push_back(ps.Velocity.z());
+		Mass.push_back(ps.Mass);
+		Lifetime.push_back(ps.Lifetime);
+
+		PositionSizes.emplace_back(ps.Position.x(), ps.Position.y(),
+				ps.Position.z(), size);
+		Color.push_back(pc);
+	}
+
+	/**
+	 * Copy the positions and sizes of the simulation state to the interleaved
+	 * PositionSizes array
+	 */
+	void interleavePositionSizes() {
+		for (size_t i = 0; i < X.size(); i++) {
+			PositionSizes[i] = Vector3WithSize(X[i], Y[i], Z[i], Size[i]);
+		}
+	}
+
+	/**
+	 * Write the velocities and lifetimes of the particles from begin on as
+	 * interleaved x,y,z,lifetime values to target, the format of the GPU
+	 * simulation
+	 */
+	void interleaveVelocities(std::vector<GLfloat> & target,
+			size_t begin = 0) const {
+		target.resize(4 * (X.size() - begin));
+		for (size_t i = begin; i < X.size(); i++) {
+			const size_t t = 4 * (i - begin);
+			target[t + 0] = VelocityX[i];
+			target[t + 1] = VelocityY[i];
+			target[t + 2] = VelocityZ[i];
+			target[t + 3] = Lifetime[i];
+		}
+	}
+
+	/**
+	 * Set the simulation state from the interleaved x,y,z,size and
+	 * x,y,z,lifetime values of the GPU simulation, the particle count does
+	 * not change
+	 */
+	void deinterleave(GLfloat const* positionSizes, GLfloat const* velocities) {
+		for (size_t i = 0; i < X.size(); i++) {
+			X[i] = positionSizes[4 * i + 0];
+			Y[i] = positionSizes[4 * i + 1];
+			Z[i] = positionSizes[4 * i + 2];
+			Size[i] = positionSizes[4 * i + 3];
+			VelocityX[i] = velocities[4 * i + 0];
+			VelocityY[i] = velocities[4 * i + 1];
+			VelocityZ[i] = velocities[4 * i + 2];
+			Lifetime[i] = velocities[4 * i + 3];
+		}
+		interleavePositionSizes();
+	}
+
+	/**
+	 * x component of the particle positions
+	 */
+	AlignedFloats X;
+
+	/**
+	 * y component of the particle positions
+	 */
+	AlignedFloats Y;
+
+	/**
+	 * z component of the particle positions
+	 */
+	AlignedFloats Z;
+
+	/**
+	 * Size of the particles
+	 */
+	AlignedFloats Size;
+
+	/**
+	 * x component of the particle velocities
+	 */
+	AlignedFloats VelocityX;
+
+	/**
+	 * y component of the particle velocities
+	 */
+	AlignedFloats VelocityY;
+
+	/**
+	 * z component of the particle velocities
+	 */
+	AlignedFloats VelocityZ;
+
+	/**
+	 * Mass of the particles
+	 */
+	AlignedFloats Mass;
+
+	/**
+	 * Lifetime is seconds to simulate particle decay
+	 * can be negative, if a particle does not exist atm.
 	 */
-	bool Updated = false;
+	AlignedFloats Lifetime;
 
 	/**
-	 * Stores the 3d position and the size of all Particles
+	 * Stores the interleaved 3d position and the size of all Particles, this
+	 * is the format uploaded by the renderer
 	 */
 	std::vector<Vector3WithSize> PositionSizes;
 
@@ -127,16 +256,268 @@ struct ParticleSystemVisualData: LocatedVisualDataBase, ShadedVisualDataBase {
 	std::vector<ParticleColor> Color;
 
 	/**
-	 * Stores additional simulation data for each particle
+	 * Return a pointer to the buffer which holds the position and size
+	 * of the particles
+	 */
+	GLfloat * getPosSizeBuffer() const {
+		return (GLfloat *) PositionSizes.data();
+	}
+
+	/**
+	 * Return a pointer to the buffer which holds the color code
+	 * of each particle
+	 */
+	GLubyte* getColorBuffer() const {
+		return (GLubyte *) Color.data();
+	}
+
+	/**
+	 * Return the number of particles in the this particle buffer
+	 */
+	size_t getParticleCount() const {
+		return PositionSizes.size();
+	}
+};
+
+/**
+ * True if the particles are advanced by this simulation program on the GPU.
+ * The renderer only sets the program if it could be loaded, otherwise the
+ * model simulates the particles on the CPU. The logic and the render thread
+ * both use this, so exactly one of them simulates the particles.
+ */
+inline bool simulatesOnGpu(ShaderProgram const& simulationShader) {
+	return simulationShader.isValid() && (simulationShader.getId() != 0);
+}
+
+/**
+ * State of a GPU simulated particle system copied back to the CPU. It is
+ * shared between the visual and the extracted data: the logic thread
+ * requests the copy and the renderer fills it in on the render thread.
+ */
+struct ParticleReadback {
+
+	/**
+	 * Guards all other members
+	 */
+	std::mutex Mutex;
+
+	/**
+	 * Set by the logic thread, the renderer copies the particles with the
+	 * next frame
+	 */
+	bool Requested = false;
+
+	/**
+	 * Set by the renderer once the particles have been copied
+	 */
+	bool Completed = false;
+
+	/**
+	 * Interleaved x,y,z,size values of all particles
+	 */
+	std::vector<GLfloat> PositionSizes;
+
+	/**
+	 * Interleaved velocity x,y,z and lifetime values of all particles
+	 */
+	std::vector<GLfloat> Velocities;
+};
+
+/**
+ * Hands the particle buffers back from the renderer to the logic thread. It
+ * is shared between the visual and the extracted data.
+ */
+struct ParticleHandoff {
+
+	/**
+	 * Version of the particles the renderer read last. The renderer only
+	 * reads the particles of the frame acquired last, so it does not read
+	 * any buffer of an older version anymore. Stored with release semantics
+	 * after the particles have been read, the logic thread must load it with
+	 * acquire semantics before writing to such a buffer again.
+	 */
+	std::atomic<size_t> RenderedVersion { 0 };
+};
+
+/**
+ * Visual data of a particle system, owned by the ParticleSystemVisual and
+ * modified by the particle system model
+ */
+struct ParticleSystemVisualData: LocatedVisualDataBase, ShadedVisualDataBase {
+
+	/**
+	 * Typedef for a 3d-vector which also stores the payload particle size,
+	 * which is of type float
+	 */
+	typedef ParticleBuffer::Vector3WithSize Vector3WithSize;
+
+	/**
+	 * Return the particle payload for read-only access
+	 */
+	ParticleBuffer const& getParticles() const {
+		return *Particles;
+	}
+
+	/**
+	 * Return the particle payload to modify it. This increments the version of
+	 * the particles, so the renderer will upload them again. If the
+	 * current buffer has been extracted since the last modification, the
+	 * particles are first copied to a buffer the renderer does not read
+	 * anymore (copy-on-write). Models which do not change the particles must
+	 * not call this method.
+	 */
+	ParticleBuffer & editParticles();
+
+	/**
+	 * Same as editParticles(), but only the simulation state and the
+	 * positions and sizes may be modified. The colors are not uploaded again
+	 * and particles must not be added or removed. If the particles are
+	 * simulated on the GPU, the positions are not uploaded either.
 	 */
-	std::vector<ParticleSimulationExtra> SimulationExtra;
+	ParticleBuffer & editPositions();
+
+	/**
+	 * Return the number of particles in the this particle system
+	 */
+	size_t getParticleCount() const {
+		return Particles->getParticleCount();
+	}
+
+	/**
+	 * The buffer holding the current state of all particles
+	 */
+	std::shared_ptr<ParticleBuffer> Particles = std::make_shared<ParticleBuffer>();
+
+	/**
+	 * A buffer which has been current before
+	 */
+	struct SpareBuffer {
+		/**
+		 * The particles, might still be read by the renderer
+		 */
+		std::shared_ptr<ParticleBuffer> Buffer;
+
+		/**
+		 * Version of the particles when the buffer was extracted last
+		 */
+		size_t Version;
+	};
+
+	/**
+	 * Number of spare buffers kept before the ones no extracted data
+	 * references anymore are freed. Only reached if the renderer does not
+	 * hand the buffers back, for example because nothing is rendered.
+	 */
+	static constexpr size_t MaxSpareBuffers = 4;
+
+	/**
+	 * Buffers which have been current before and might still be read by the
+	 * renderer. They are reused once the renderer read a newer version.
+	 */
+	std::vector<SpareBuffer> SpareParticles;
+
+	/**
+	 * Version of the particles read by the renderer, shared with the
+	 * extracted data
+	 */
+	std::shared_ptr<ParticleHandoff> Handoff = std::make_shared<
+			ParticleHandoff>();
+
+	/**
+	 * True if the current buffer has been extracted since the last
+	 * modification, set by the const extraction
+	 */
+	mutable bool Extracted = false;
+
+	/**
+	 * Only referenced by this data and never extracted, the renderer frees
+	 * the GPU buffers of the particles once it expired
+	 */
+	std::shared_ptr<const bool> Lifetime = std::make_shared<const bool>(true);
+
+	/**
+	 * Incremented every time the particles are modified
+	 */
+	size_t Version = 0;
+
+	/**
+	 * Incremented every time the colors of the particles might have been
+	 * modified
+	 */
+	size_t ColorVersion = 0;
+
+	/**
+	 * Id of the buffer holding the particle position, 0 until the renderer
+	 * prepared the particles
+	 */
+	GLuint vertexPositionBuffer = 0;
+
+	/**
+	 * Id of the buffer holding the color for all particles
+	 */
+	GLuint vertexColorBuffer = 0;
+
+	/**
+	 * Name of the shader program which simulates the particles on the GPU,
+	 * empty if the particles are simulated on the CPU by the model
+	 */
+	std::string SimulationProgramName;
+
+	/**
+	 * The simulation program, loaded when the particles are prepared
+	 */
+	ShaderProgram SimulationShader;
+
+	/**
+	 * True if the particles are simulated on the GPU, see simulatesOnGpu()
+	 */
+	bool hasGpuSimulation() const {
+		return simulatesOnGpu(SimulationShader);
+	}
+
+	/**
+	 * Seconds simulated so far, the renderer advances the GPU simulation
+	 * by the time passed since the last frame
+	 */
+	double SimulationTime = 0.0;
+
+	/**
+	 * Copy of the GPU simulation state, only set if the particles are
+	 * simulated on the GPU
+	 */
+	std::shared_ptr<ParticleReadback> Readback;
+};
+
+/**
+ * Visual data extracted for particle system rendering. The particles are
+ * only referenced and not copied.
+ */
+struct ParticleSystemExtractData: LocatedVisualDataBase, ShadedVisualDataBase {
+
+	/**
+	 * Shared particle buffer of the particle system, which is not modified
+	 * as long as it is referenced here
+	 */
+	std::shared_ptr<const ParticleBuffer> Particles;
+
+	/**
+	 * Version of the particles, the renderer needs to upload them to the GPU
+	 * if it changed since the last upload
+	 */
+	size_t Version = 0;
+
+	/**
+	 * Version of the particle colors, the renderer only uploads the colors
+	 * again if this changed
+	 */
+	size_t ColorVersion = 0;
 
 	/**
 	 * Return a pointer to the buffer which holds the position and size
 	 * of the particles
 	 */
 	GLfloat * getPosSizeBuffer() const {
-		return (GLfloat *) PositionSizes.data();
+		return Particles->getPosSizeBuffer();
 	}
 
 	/**
@@ -144,25 +525,65 @@ struct ParticleSystemVisualData: LocatedVisualDataBase, ShadedVisualDataBase {
 	 * of each particle
 	 */
 	GLubyte* getColorBuffer() const {
-		return (GLubyte *) Color.data();
+		return Particles->getColorBuffer();
 	}
 
 	/**
 	 * Return the number of particles in the this particle system
 	 */
 	size_t getParticleCount() const {
-		return PositionSizes.size();
+		return Particles->getParticleCount();
 	}
 
 	/**
-	 * Id of the buffer holding the particle position
+	 * Id of the buffer holding the particle position, 0 until the renderer
+	 * prepared the particles
 	 */
-	GLuint vertexPositionBuffer;
+	GLuint vertexPositionBuffer = 0;
 
 	/**
 	 * Id of the buffer holding the color for all particles
 	 */
-	GLuint vertexColorBuffer;
+	GLuint vertexColorBuffer = 0;
+
+	/**
+	 * The program simulating the particles on the GPU, id 0 if they are
+	 * simulated on the CPU
+	 */
+	ShaderProgram SimulationShader;
+
+	/**
+	 * Seconds simulated so far
+	 */
+	double SimulationTime = 0.0;
+
+	/**
+	 * Copy of the GPU simulation state requested by the logic thread
+	 */
+	std::shared_ptr<ParticleReadback> Readback;
+
+	/**
+	 * Version of the particles read by the renderer, shared with the visual
+	 */
+	std::shared_ptr<ParticleHandoff> Handoff;
+
+	/**
+	 * Called by the renderer once it read the particles, the buffers of
+	 * older versions can be written by the logic thread again
+	 */
+	void markRendered() const {
+		if (Handoff) {
+			Handoff->RenderedVersion.store(Version, std::memory_order_release);
+		}
+	}
+
+	/**
+	 * True if the particles are simulated on the GPU, their positions are
+	 * then only uploaded when particles have been added
+	 */
+	bool hasGpuSimulation() const {
+		return simulatesOnGpu(SimulationShader);
+	}
 };
 
 /**
@@ -176,6 +597,11 @@ typedef std::function<void(ParticleSystemVisualData & pv, float dt)> ParticleMod
 class ParticleSystemVisual: public VisualBase<ParticleSystemVisualData> {
 public:
 
+	/**
+	 * The extracted data only references the particles of this visual
+	 */
+	typedef ParticleSystemExtractData ExtractData;
+
 	/**
 	 * default constructor, wilth no particles and simulation model
 	 */
@@ -196,6 +622,14 @@ public:
 		return "ParticleSystemVisual";
 	}
 
+	/**
+	 * return the name of the shader program set when the particles were
+	 * prepared
+	 */
+	std::string getShaderProgramName() const override {
+		return getData().Shader.getName();
+	}
+
 	/**
 	 * Checks if the shader has been reloaded and the shader id needs to be updated
 	 */
@@ -205,17 +639,7 @@ public:
 	 * Add a new particle to this particle system
 	 */
 	void addParticle(ParticleState ps, ParticleColor pc = ParticleColor()) {
-		auto p = ParticleSystemVisualData::Vector3WithSize(ps.Position.x(),
-				ps.Position.y(), ps.Position.z(), 0.1f);
-
-		getData().PositionSizes.emplace_back(p);
-
-		auto sim = ParticleSimulationExtra(ps.Velocity, ps.Mass);
-
-		getData().SimulationExtra.emplace_back(sim);
-
-		getData().Color.push_back(pc);
-		getData().Updated = true;
+		getData().editParticles().addParticle(ps, pc);
 	}
 
 	/**
@@ -226,7 +650,28 @@ public:
 	}
 
 	/**
-	 * Executes one simulation step with the registered particle system model
+	 * Simulate the particles on the GPU with the shader program instead of
+	 * the model. The program is loaded when the particles are prepared and
+	 * must write the outputs "outPositionSize" and "outVelocity", which are
+	 * registered as feedback varyings of the program definition. The
+	 * particles returned by getData() are only updated on request, see
+	 * requestReadback(). Particles added later are appended to the GPU
+	 * state, changes to the particles simulated so far are not uploaded.
+	 * If the renderer cannot load the program, the particles are simulated
+	 * by the model.
+	 */
+	void setGpuSimulation(std::string programName);
+
+	/**
+	 * Request a copy of the particles simulated on the GPU. The renderer
+	 * copies them with the next frame and a later call to step() writes
+	 * them to the particles of this visual.
+	 */
+	void requestReadback();
+
+	/**
+	 * Executes one simulation step with the registered particle system model,
+	 * or advances the time of the GPU simulation
 	 */
 	void step(float deltaT);
 
@@ -236,7 +681,26 @@ public:
 	void extractData(VisualDataExtractContainer & cont, ExtractOffset const& eo)
 			override;
 
+	/**
+	 * Write the data used for rendering all particles to an existing entry of
+	 * the extract container
+	 */
+	void extractDataTo(ParticleSystemExtractData & data,
+			ExtractOffset const& eo) const;
+
 private:
+	/**
+	 * Write a completed readback of the GPU simulation to the particles
+	 */
+	void applyReadback();
+
+	/**
+	 * Read the visual data without marking the visual as changed
+	 */
+	ParticleSystemVisualData const& constData() const {
+		return getData();
+	}
+
 	/**
 	 * Holds the lambda function which can execute the particle system's model
 	 */
@@ -4,6 +4,7 @@
 #include <SpheresEngine/RenderEngine/RendererVisualChange.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <utility>
 #include <tuple>
 #include <vector>
@@ -34,6 +35,35 @@ struct ExtractOffset {
 	 * Rotation offset as quaternion
 	 */
 	Quaternion Rotation = Quaternion(glm::vec3(0.0f, 0.0f, 0.0f));
+
+	/**
+	 * Position offset after the previous logic step, used to interpolate
+	 * between the last two logic states
+	 */
+	Vector3 PreviousPosition = Vector3::zero();
+
+	/**
+	 * Rotation offset after the previous logic step
+	 */
+	Quaternion PreviousRotation = Quaternion(glm::vec3(0.0f, 0.0f, 0.0f));
+};
+
+/**
+ * Interface which is notified when the data of a visual is accessed for
+ * writing. Used to track which visuals need to be extracted again.
+ */
+class VisualChangeListener {
+public:
+
+	/**
+	 * Virtual dtor to support inheritance
+	 */
+	virtual ~VisualChangeListener() = default;
+
+	/**
+	 * The data of the visual registered with this key might have changed
+	 */
+	virtual void visualChanged(uint32_t key) = 0;
 };
 
 /**
@@ -48,11 +78,29 @@ public:
 	 */
 	virtual ~VisualAbstract() = default;
 
+	/**
+	 * Notify the listener with the key whenever the data of this visual is
+	 * accessed for writing. Only one listener is supported, nullptr removes
+	 * the listener.
+	 */
+	void setChangeListener(VisualChangeListener * listener, uint32_t key) {
+		m_changeListener = listener;
+		m_changeKey = key;
+	}
+
 	/**
 	 * Return the type of the visual as string
 	 */
 	virtual std::string getType() const = 0;
 
+	/**
+	 * Name of the shader program used to render this visual, empty if the
+	 * visual does not use one
+	 */
+	virtual std::string getShaderProgramName() const {
+		return std::string();
+	}
+
 	/**
 	 * Extract the render data contained in a visual
 	 */
@@ -66,6 +114,29 @@ public:
 	virtual void update(RendererVisualChange const&) {
 		// ignore in this generic version, can be implemented by concrete visual classes
 	}
+
+protected:
+
+	/**
+	 * Inform the change listener, if there is one
+	 */
+	void notifyChanged() {
+		if (m_changeListener) {
+			m_changeListener->visualChanged(m_changeKey);
+		}
+	}
+
+private:
+
+	/**
+	 * Listener informed about changes to the visual data
+	 */
+	VisualChangeListener * m_changeListener = nullptr;
+
+	/**
+	 * Key passed to the change listener
+	 */
+	uint32_t m_changeKey = 0;
 };
 
 /**
@@ -82,9 +153,11 @@ public:
 	typedef TData ExtractData;
 
 	/**
-	 * Return the Visual data hold by this visual
+	 * Return the Visual data hold by this visual. The visual is marked as
+	 * changed, use the const version if the data is only read.
 	 */
 	TData & getData() {
+		notifyChanged();
 		return m_data;
 	}
 
@@ -3,6 +3,7 @@
 #include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderBackend.h>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderUserData.h>
 
+#include <glm/glm.hpp>
 #include <glm/vec3.hpp>
 #include <glm/gtc/quaternion.hpp>
 
@@ -20,10 +21,10 @@ struct VisualDataBase {
 };
 
 /**
- * Mixin struct for visuals which have a 3d location in the
- * game world
+ * Position and rotation of a visual in the game world, for the current and
+ * the previous logic step
  */
-struct LocatedVisualDataBase {
+struct VisualTransform {
 	/**
 	 * Center position of the visual in the game world
 	 */
@@ -33,6 +34,39 @@ struct LocatedVisualDataBase {
 	 * Rotation of the visual
 	 */
 	glm::quat Rotation;
+
+	/**
+	 * Center position of the visual after the previous logic step
+	 */
+	glm::vec3 PreviousCenter;
+
+	/**
+	 * Rotation of the visual after the previous logic step
+	 */
+	glm::quat PreviousRotation;
+
+	/**
+	 * Blend between the center of the previous (0.0) and the current (1.0)
+	 * logic step
+	 */
+	glm::vec3 interpolateCenter(float interpolation) const {
+		return glm::mix(PreviousCenter, Center, interpolation);
+	}
+
+	/**
+	 * Blend between the rotation of the previous (0.0) and the current (1.0)
+	 * logic step
+	 */
+	glm::quat interpolateRotation(float interpolation) const {
+		return glm::slerp(PreviousRotation, Rotation, interpolation);
+	}
+};
+
+/**
+ * Mixin struct for visuals which have a 3d location in the
+ * game world
+ */
+struct LocatedVisualDataBase: VisualTransform {
 };
 
 /**
@@ -4,11 +4,25 @@
 #include <SpheresEngine/Visuals/MeshVisual.h>
 #include <SpheresEngine/Visuals/ParticleSystemVisual.h>
 #include <SpheresEngine/RenderEngine/Targets/CameraTargetData.h>
+#include <SpheresEngine/DataTypes/RecycleVector.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 
 /**
  * Container which brings together all the visual data to pass it
  * to the render engine
+ *
+ * The container is meant to be kept alive and refilled every logic tick. The
+ * visual data lists keep their entries when cleared, so once the container has
+ * been filled for the first time, refilling it does not allocate heap memory.
+ *
+ * If the container is not cleared, the EntityEngine only rewrites the entries
+ * which changed since the container was filled the last time. The entries of
+ * the entities in the component storage come first and keep their position,
+ * the change ticks tell the render thread which of them changed.
  */
 struct VisualDataExtractContainer {
 
@@ -17,22 +31,102 @@ struct VisualDataExtractContainer {
 	 */
 	CameraTargetData CameraData;
 
+	/**
+	 * Blend factor between the previous (0.0) and the current (1.0) logic
+	 * step at the time this container was filled
+	 */
+	float ExtractInterpolation = 1.0f;
+
+	/**
+	 * Duration of one logic step in seconds. Zero if the logic does not
+	 * run with fixed time steps, then no interpolation is performed
+	 */
+	float StepDuration = 0.0f;
+
+	/**
+	 * Time when this container was filled
+	 */
+	std::chrono::steady_clock::time_point ExtractTime;
+
+	/**
+	 * Blend factor between the previous and the current logic step to be
+	 * used by the renderers. Updated by the RenderEngine before each frame
+	 * with updateInterpolation()
+	 */
+	float Interpolation = 1.0f;
+
+	/**
+	 * Compute the blend factor for a frame rendered at the time point now,
+	 * by advancing the extracted factor with the time passed since the
+	 * extraction
+	 */
+	void updateInterpolation(std::chrono::steady_clock::time_point now) {
+		if (StepDuration <= 0.0f) {
+			Interpolation = 1.0f;
+			return;
+		}
+
+		const float sinceExtract =
+				std::chrono::duration<float>(now - ExtractTime).count();
+		Interpolation = std::min(1.0f,
+				ExtractInterpolation + sinceExtract / StepDuration);
+	}
+
 	/**
 	 * All mesh data to render
 	 */
-	std::vector<MeshVisual::ExtractData> MeshVisuals;
+	RecycleVector<MeshVisual::ExtractData> MeshVisuals;
+
+	/**
+	 * Position and rotation of each entry in MeshVisuals. Kept in their own
+	 * dense array, because the transforms change with every move while the
+	 * rest of the mesh data rarely changes.
+	 */
+	RecycleVector<VisualTransform> MeshTransforms;
 
 	/**
 	 * All particle system visuals data to render
 	 */
-	std::vector<ParticleSystemVisual::ExtractData> ParticleSystems;
+	RecycleVector<ParticleSystemVisual::ExtractData> ParticleSystems;
+
+	/**
+	 * Number of the extraction which filled this container, zero if the
+	 * container has been cleared
+	 */
+	uint64_t ExtractTick = 0;
+
+	/**
+	 * For the first entries of MeshVisuals, the number of the extraction in
+	 * which the entry changed the last time. The entries behind are rewritten
+	 * by every extraction.
+	 */
+	std::vector<uint64_t> MeshVisualChangeTicks;
+
+	/**
+	 * Number of entries written by the last extraction
+	 */
+	size_t ChangedEntries = 0;
+
+	/**
+	 * Returns true if the mesh entry changed after the extraction with the
+	 * number tick, for example the one of the previously rendered container
+	 */
+	bool meshVisualChangedSince(size_t index, uint64_t tick) const {
+		return (index >= MeshVisualChangeTicks.size())
+				|| (MeshVisualChangeTicks[index] > tick);
+	}
 
 	/**
-	 * removes all content in this container
+	 * removes all content in this container, the memory held by the
+	 * entries is kept for the next fill
 	 */
 	void clear() {
 		MeshVisuals.clear();
+		MeshTransforms.clear();
 		ParticleSystems.clear();
+		ExtractTick = 0;
+		MeshVisualChangeTicks.clear();
+		ChangedEntries = 0;
 	}
 };
 
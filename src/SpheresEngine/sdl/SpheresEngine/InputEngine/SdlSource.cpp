@@ -2,10 +2,9 @@
 
 #include <SpheresEngine/Log.h>
 
-std::vector<InputSource::UserInputPair> SdlSource::readInput() {
-	auto tmpInput = m_inputs;
+void SdlSource::readInput(std::vector<UserInputPair> & inputs) {
+	inputs.insert(inputs.end(), m_inputs.begin(), m_inputs.end());
 	m_inputs.clear();
-	return tmpInput;
 }
 
 void SdlSource::notifyEvent(SDL_Event evt) {
@@ -26,7 +26,7 @@ public:
 	/**
 	 * Will return SDL Keyboard and mouse input
 	 */
-	std::vector<UserInputPair> readInput() override;
+	void readInput(std::vector<UserInputPair> & inputs) override;
 
 	/**
 	 * This method is called by the game loop to pass on SDL events
@@ -0,0 +1,44 @@
+#include "RenderBackendHeadless.h"
+
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
+#include <SpheresEngine/RenderEngine/RenderBackendSDLDetails.h>
+#include <SpheresEngine/Log.h>
+
+RenderBackendHeadless::RenderBackendHeadless(ResourceEngine & re,
+		Resolution res) :
+		m_shaderBackend(re, "#version 130"), m_meshBackend(re, *this), m_resolution(
+				res) {
+}
+
+ShaderBackend & RenderBackendHeadless::getShaderBackend() {
+	return m_shaderBackend;
+}
+
+MeshBackend & RenderBackendHeadless::getMeshBackend() {
+	return m_meshBackend;
+}
+
+void RenderBackendHeadless::initRenderer() {
+	logging::Info() << "Initializing headless renderer, OpenGL calls are recorded";
+	GLSupport::makeCurrent(&m_recorder);
+}
+
+void RenderBackendHeadless::closeRenderer() {
+	GLSupport::makeCurrent(nullptr);
+}
+
+std::vector<std::shared_ptr<RenderBackendDetails>> RenderBackendHeadless::beforeRender() {
+	return {std::make_shared< RenderBackendSDLDetails >( m_resolution )};
+}
+
+void RenderBackendHeadless::ext_glGenVertexArrays(GLuint i, GLuint * vaoid) {
+	m_recorder.genVertexArrays(i, vaoid);
+}
+
+void RenderBackendHeadless::ext_glBindVertexArray(GLuint vao) {
+	m_recorder.bindVertexArray(vao);
+}
+
+void RenderBackendHeadless::present() {
+	m_recorder.recordFrame();
+}
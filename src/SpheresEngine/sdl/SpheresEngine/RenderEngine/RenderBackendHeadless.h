@@ -0,0 +1,111 @@
+#pragma once
+
+#include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderBackend.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/MeshBackend.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLApiRecorder.h>
+#include <SpheresEngine/RenderEngine/RenderBackendBase.h>
+#include <SpheresEngine/DataTypes/Resolution.h>
+
+class ResourceEngine;
+
+/**
+ * Render backend which needs neither a display nor a GPU. All OpenGL calls
+ * of the renderers and targets are recorded by a GLApiRecorder, which allows
+ * to run and benchmark the complete render code on build machines and to
+ * track the number of draw calls, state changes and uploads.
+ *
+ * The recorder is made current on the thread which calls initRenderer(),
+ * so this must be the render thread.
+ */
+class RenderBackendHeadless: public RenderBackendBase {
+public:
+
+	/**
+	 * Create the backend, the resolution is forwarded to the render targets
+	 */
+	RenderBackendHeadless(ResourceEngine &, Resolution);
+
+	/**
+	 * Override virtual dtor to clean up local objects
+	 */
+	virtual ~RenderBackendHeadless() = default;
+
+	/**
+	 * Make the recorder the current GLApi of the calling thread
+	 */
+	void initRenderer() override;
+
+	/**
+	 * Forward the OpenGL calls of the calling thread to the driver again
+	 */
+	void closeRenderer() override;
+
+	/**
+	 * Count the frame
+	 */
+	void present() override;
+
+	/**
+	 * Provide the resolution to the render targets
+	 */
+	std::vector<std::shared_ptr<RenderBackendDetails>> beforeRender() override;
+
+	/**
+	 * Record the vertex array creation
+	 */
+	void ext_glGenVertexArrays(GLuint, GLuint *) override;
+
+	/**
+	 * Record the vertex array binding
+	 */
+	void ext_glBindVertexArray(GLuint) override;
+
+	/**
+	 * Return a reference to the shader backend provided by this
+	 * renderer
+	 */
+	ShaderBackend & getShaderBackend() override;
+
+	/**
+	 * Return a reference to the mesh backend of this renderer
+	 */
+	MeshBackend & getMeshBackend() override;
+
+	/**
+	 * Counters of all OpenGL calls recorded so far. Must only be read while
+	 * the render thread is not running.
+	 */
+	GLRecordingStats const& getStats() const {
+		return m_recorder.getStats();
+	}
+
+	/**
+	 * The recorder of the OpenGL calls, to inspect the recorded state. Must
+	 * only be read while the render thread is not running.
+	 */
+	GLApiRecorder const& getRecorder() const {
+		return m_recorder;
+	}
+
+private:
+
+	/**
+	 * Records all OpenGL calls instead of executing them
+	 */
+	GLApiRecorder m_recorder;
+
+	/**
+	 * Instance of the shader backend
+	 */
+	ShaderBackend m_shaderBackend;
+
+	/**
+	 * Instance of the mesh backend
+	 */
+	MeshBackend m_meshBackend;
+
+	/**
+	 * Resolution reported to the render targets
+	 */
+	Resolution m_resolution;
+};
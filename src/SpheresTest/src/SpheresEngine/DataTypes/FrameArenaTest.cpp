@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/DataTypes/FrameArena.h>
+#include <SpheresEngine/Performance/AllocationCounter.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+class ArenaBase {
+public:
+	virtual ~ArenaBase() = default;
+};
+
+class ArenaObject: public ArenaBase {
+public:
+	ArenaObject(int & destroyed, double value) :
+			Destroyed(destroyed), Value(value) {
+	}
+
+	~ArenaObject() {
+		Destroyed++;
+	}
+
+	int & Destroyed;
+
+	double Value;
+};
+
+}
+
+TEST(FrameArenaTest, allocationsAligned) {
+	FrameArena arena(256);
+
+	auto a = arena.allocate(1, 1);
+	auto b = arena.allocate(8, 8);
+	auto c = arena.allocate(3, 32);
+	ASSERT_NE(a, b);
+	ASSERT_EQ(uintptr_t(0), reinterpret_cast<uintptr_t>(b) % 8);
+	ASSERT_EQ(uintptr_t(0), reinterpret_cast<uintptr_t>(c) % 32);
+	ASSERT_EQ(size_t(256), arena.getCapacity());
+
+	// memory is handed out again after the reset
+	arena.reset();
+	ASSERT_EQ(a, arena.allocate(1, 1));
+}
+
+TEST(FrameArenaTest, objectsDestroyed) {
+	FrameArena arena;
+	int destroyed = 0;
+
+	{
+		ArenaPtr<ArenaBase> base = arena.create<ArenaObject>(destroyed, 2.0);
+		ASSERT_EQ(size_t(1), arena.getLiveObjects());
+		ASSERT_DOUBLE_EQ(2.0, static_cast<ArenaObject *>(base.get())->Value);
+	}
+
+	// destroyed via the virtual destructor of the base class
+	ASSERT_EQ(1, destroyed);
+	ASSERT_EQ(size_t(0), arena.getLiveObjects());
+	arena.reset();
+}
+
+TEST(FrameArenaTest, blocksMergedOnReset) {
+	FrameArena arena(64);
+
+	for (size_t i = 0; i < 10; i++) {
+		arena.allocate(32);
+	}
+	const auto capacity = arena.getCapacity();
+	ASSERT_GE(capacity, size_t(320));
+
+	// the merged block holds all allocations of the last tick
+	arena.reset();
+	ASSERT_EQ(capacity, arena.getCapacity());
+
+	const auto allocationsBefore = AllocationCounter::threadAllocations();
+	for (size_t i = 0; i < 10; i++) {
+		arena.allocate(32);
+	}
+	ASSERT_EQ(size_t(0),
+			AllocationCounter::threadAllocations() - allocationsBefore);
+	ASSERT_EQ(capacity, arena.getCapacity());
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/DataTypes/InplaceFunction.h>
+#include <SpheresEngine/Util.h>
+
+#include <array>
+#include <memory>
+#include <utility>
+
+TEST(InplaceFunctionTest, smallCallableInline) {
+	int calls = 0;
+	InplaceFunction<int(int)> f([&calls](int v) {
+		calls++;
+		return v * 2;
+	});
+
+	ASSERT_TRUE(bool(f));
+	ASSERT_TRUE(f.isInline());
+	ASSERT_EQ(6, f(3));
+	ASSERT_EQ(1, calls);
+
+	// moved functions keep working, the source is empty afterwards
+	auto moved = std::move(f);
+	ASSERT_FALSE(bool(f));
+	ASSERT_EQ(8, moved(4));
+	ASSERT_EQ(2, calls);
+}
+
+TEST(InplaceFunctionTest, largeCallableOnHeap) {
+	std::array<double, 16> payload;
+	payload.fill(1.0);
+	InplaceFunction<double()> f([payload]() {
+		return payload[15];
+	});
+
+	ASSERT_FALSE(f.isInline());
+	ASSERT_DOUBLE_EQ(1.0, f());
+
+	InplaceFunction<double()> other;
+	other = std::move(f);
+	ASSERT_DOUBLE_EQ(1.0, other());
+}
+
+TEST(InplaceFunctionTest, moveOnlyCallableDestroyed) {
+	auto counter = std::make_shared<int>(5);
+	{
+		auto owned = std14::make_unique<std::shared_ptr<int>>(counter);
+		InplaceFunction<int()> f(
+				std::bind([](uniq<std::shared_ptr<int>> const& p) {
+					return **p;
+				}, std::move(owned)));
+		ASSERT_EQ(5, f());
+		ASSERT_EQ(2, counter.use_count());
+	}
+	ASSERT_EQ(1, counter.use_count());
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/DataTypes/PoolAllocated.h>
+#include <SpheresEngine/Util.h>
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+class PooledBase {
+public:
+	virtual ~PooledBase() = default;
+};
+
+class Pooled: public PooledBase, public PoolAllocated<Pooled> {
+public:
+	double Payload[3];
+};
+
+class PooledDerived: public Pooled {
+public:
+	double MorePayload[8];
+};
+
+}
+
+TEST(PoolAllocatedTest, blocksReused) {
+	FixedSizePool pool(24);
+	ASSERT_EQ(size_t(0), pool.getBlockSize() % alignof(std::max_align_t));
+
+	auto a = pool.allocate();
+	auto b = pool.allocate();
+	ASSERT_NE(a, b);
+	ASSERT_EQ(size_t(2), pool.getBlocksInUse());
+	ASSERT_EQ(size_t(FixedSizePool::BlocksPerChunk), pool.getCapacity());
+
+	pool.free(a);
+	ASSERT_EQ(a, pool.allocate());
+
+	std::vector<void *> blocks;
+	for (size_t i = 0; i < FixedSizePool::BlocksPerChunk; i++) {
+		blocks.push_back(pool.allocate());
+	}
+	ASSERT_EQ(2 * FixedSizePool::BlocksPerChunk, pool.getCapacity());
+}
+
+TEST(PoolAllocatedTest, ownedByBasePointer) {
+	auto & pool = PoolAllocated<Pooled>::getPool();
+	const auto inUse = pool.getBlocksInUse();
+
+	std::vector<uniq<PooledBase>> objects;
+	for (size_t i = 0; i < 10; i++) {
+		objects.push_back(std14::make_unique<Pooled>());
+	}
+	// larger subclasses use the regular heap
+	objects.push_back(std14::make_unique<PooledDerived>());
+	ASSERT_EQ(inUse + 10, pool.getBlocksInUse());
+
+	objects.clear();
+	ASSERT_EQ(inUse, pool.getBlocksInUse());
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/DataTypes/SpatialHashGrid.h>
+#include <SpheresEngine/Performance/AllocationCounter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+float distanceSquared(Vector3 const& a, Vector3 const& b) {
+	const float dx = a.x() - b.x();
+	const float dy = a.y() - b.y();
+	const float dz = a.z() - b.z();
+	return dx * dx + dy * dy + dz * dz;
+}
+
+std::vector<Vector3> randomPositions(size_t count, float extent) {
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> dist(-extent, extent);
+	std::vector<Vector3> positions;
+	for (size_t i = 0; i < count; i++) {
+		positions.emplace_back(dist(rng), dist(rng), dist(rng));
+	}
+	return positions;
+}
+
+}
+
+TEST(SpatialHashGridTest, radiusMatchesLinearScan) {
+	const auto positions = randomPositions(2000, 50.0f);
+	SpatialHashGrid grid(4.0f);
+	for (size_t i = 0; i < positions.size(); i++) {
+		grid.insert(SpatialHashGrid::Id(i), positions[i]);
+	}
+	ASSERT_EQ(positions.size(), grid.size());
+
+	for (auto const& center : { Vector3(0, 0, 0), Vector3(-49, 12, 30),
+			Vector3(7.5f, -3, 0.1f) }) {
+		for (auto radius : { 0.5f, 3.0f, 11.0f }) {
+			std::vector<SpatialHashGrid::Id> found;
+			grid.queryRadius(center, radius, found);
+			std::sort(found.begin(), found.end());
+
+			std::vector<SpatialHashGrid::Id> expected;
+			for (size_t i = 0; i < positions.size(); i++) {
+				if (distanceSquared(positions[i], center) <= radius * radius) {
+					expected.push_back(SpatialHashGrid::Id(i));
+				}
+			}
+			ASSERT_EQ(expected, found);
+		}
+	}
+}
+
+TEST(SpatialHashGridTest, boxMatchesLinearScan) {
+	const auto positions = randomPositions(2000, 50.0f);
+	SpatialHashGrid grid(4.0f);
+	for (size_t i = 0; i < positions.size(); i++) {
+		grid.insert(SpatialHashGrid::Id(i), positions[i]);
+	}
+
+	const Vector3 min(-10, -5, 3);
+	const Vector3 max(12, 0, 20);
+	std::vector<SpatialHashGrid::Id> found;
+	grid.queryBox(min, max, found);
+	std::sort(found.begin(), found.end());
+
+	std::vector<SpatialHashGrid::Id> expected;
+	for (size_t i = 0; i < positions.size(); i++) {
+		auto const& p = positions[i];
+		if ((p.x() >= min.x()) && (p.x() <= max.x()) && (p.y() >= min.y())
+				&& (p.y() <= max.y()) && (p.z() >= min.z())
+				&& (p.z() <= max.z())) {
+			expected.push_back(SpatialHashGrid::Id(i));
+		}
+	}
+	ASSERT_FALSE(expected.empty());
+	ASSERT_EQ(expected, found);
+}
+
+TEST(SpatialHashGridTest, nearestMatchesLinearScan) {
+	const auto positions = randomPositions(2000, 50.0f);
+	SpatialHashGrid grid(4.0f);
+	for (size_t i = 0; i < positions.size(); i++) {
+		grid.insert(SpatialHashGrid::Id(i), positions[i]);
+	}
+
+	// the last center is far outside, so most cells need to be searched
+	for (auto const& center : { Vector3(0, 0, 0), Vector3(-49, 12, 30),
+			Vector3(500, 500, 500) }) {
+		std::vector<SpatialHashGrid::Id> expected;
+		for (size_t i = 0; i < positions.size(); i++) {
+			expected.push_back(SpatialHashGrid::Id(i));
+		}
+		std::sort(expected.begin(), expected.end(),
+				[&] (SpatialHashGrid::Id a, SpatialHashGrid::Id b) {
+					return distanceSquared(positions[a], center)
+					< distanceSquared(positions[b], center);
+				});
+		expected.resize(10);
+
+		// existing entries of the result are kept
+		std::vector<SpatialHashGrid::Id> found = { 12345 };
+		grid.queryNearest(center, 10, found);
+		ASSERT_EQ(size_t(11), found.size());
+		ASSERT_EQ(SpatialHashGrid::Id(12345), found[0]);
+		found.erase(found.begin());
+		ASSERT_EQ(expected, found);
+	}
+
+	// fewer points than requested
+	SpatialHashGrid small(1.0f);
+	small.insert(3, Vector3(10, 0, 0));
+	small.insert(7, Vector3(-2, 0, 0));
+	std::vector<SpatialHashGrid::Id> found;
+	small.queryNearest(Vector3(0, 0, 0), 5, found);
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 7, 3 }), found);
+}
+
+TEST(SpatialHashGridTest, moveAndRemove) {
+	SpatialHashGrid grid(1.0f);
+	grid.insert(0, Vector3(0.5f, 0.5f, 0.5f));
+	grid.insert(1, Vector3(0.6f, 0.5f, 0.5f));
+	grid.insert(2, Vector3(0.7f, 0.5f, 0.5f));
+
+	// moving into another cell fills the gap in the old one
+	grid.insert(0, Vector3(5.5f, 0.5f, 0.5f));
+	ASSERT_EQ(size_t(3), grid.size());
+	ASSERT_FLOAT_EQ(5.5f, grid.getPosition(0).x());
+
+	std::vector<SpatialHashGrid::Id> found;
+	grid.queryRadius(Vector3(0.5f, 0.5f, 0.5f), 0.5f, found);
+	std::sort(found.begin(), found.end());
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 1, 2 }), found);
+
+	grid.remove(1);
+	grid.remove(1);
+	ASSERT_FALSE(grid.contains(1));
+	ASSERT_EQ(size_t(2), grid.size());
+
+	found.clear();
+	grid.queryRadius(Vector3(0.5f, 0.5f, 0.5f), 0.5f, found);
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 2 }), found);
+
+	// negative coordinates are in their own cells
+	grid.insert(1, Vector3(-0.5f, 0.5f, 0.5f));
+	found.clear();
+	grid.queryBox(Vector3(-1, 0, 0), Vector3(-0.1f, 1, 1), found);
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 1 }), found);
+}
+
+TEST(SpatialHashGridTest, positionsOutsideOfKeyRange) {
+	SpatialHashGrid grid(1.0f);
+	grid.insert(0, Vector3(1e30f, 0, 0));
+	grid.insert(1, Vector3(3.5f, 0, 0));
+	// would wrap around into the cell of the point above
+	grid.insert(2, Vector3(2097155.5f, 0, 0));
+	grid.insert(3, Vector3(std::nanf(""), 0, 0));
+	ASSERT_EQ(size_t(4), grid.size());
+
+	std::vector<SpatialHashGrid::Id> found;
+	grid.queryRadius(Vector3(1e30f, 0, 0), 1.0f, found);
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 0 }), found);
+
+	found.clear();
+	grid.queryRadius(Vector3(3.5f, 0, 0), 1.0f, found);
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 1 }), found);
+
+	found.clear();
+	grid.queryRadius(Vector3(2097155.5f, 0, 0), 1.0f, found);
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 2 }), found);
+
+	grid.remove(3);
+	ASSERT_EQ(size_t(3), grid.size());
+}
+
+TEST(SpatialHashGridTest, largeQueriesCheckOccupiedCells) {
+	SpatialHashGrid grid(1.0f);
+	grid.insert(0, Vector3(-5000.5f, 20.5f, -3.5f));
+	grid.insert(1, Vector3(0.5f, 0.5f, 0.5f));
+	grid.insert(2, Vector3(5000.5f, -20.5f, 3.5f));
+
+	// both queries overlap far more cells than could be visited one by one
+	std::vector<SpatialHashGrid::Id> found;
+	grid.queryRadius(Vector3(0, 0, 0), 6000.0f, found);
+	std::sort(found.begin(), found.end());
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 0, 1, 2 }), found);
+
+	found.clear();
+	grid.queryBox(Vector3(-1e30f, -1e30f, -1e30f), Vector3(1, 1e30f, 1e30f),
+			found);
+	std::sort(found.begin(), found.end());
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 0, 1 }), found);
+
+	// the box excludes the cells on the other side of the origin
+	found.clear();
+	grid.queryBox(Vector3(1, -1e30f, -1e30f), Vector3(1e30f, 1e30f, 1e30f),
+			found);
+	ASSERT_EQ(std::vector<SpatialHashGrid::Id>( { 2 }), found);
+}
+
+TEST(SpatialHashGridTest, queriesWithoutAllocations) {
+	const auto positions = randomPositions(1000, 20.0f);
+	SpatialHashGrid grid(4.0f);
+	for (size_t i = 0; i < positions.size(); i++) {
+		grid.insert(SpatialHashGrid::Id(i), positions[i]);
+	}
+
+	std::vector<SpatialHashGrid::Id> found;
+	found.reserve(positions.size());
+	auto lmdQueryAndMove = [&grid, &positions, &found] () {
+		for (size_t i = 0; i < 100; i++) {
+			found.clear();
+			grid.queryRadius(positions[i], 5.0f, found);
+			found.clear();
+			grid.queryNearest(positions[i], 8, found);
+			grid.insert(SpatialHashGrid::Id(i), positions[i + 1]);
+			grid.insert(SpatialHashGrid::Id(i), positions[i]);
+		}
+	};
+
+	// the first round grows the id lists of the cells
+	lmdQueryAndMove();
+
+	const auto allocationsBefore = AllocationCounter::threadAllocations();
+	lmdQueryAndMove();
+	ASSERT_EQ(size_t(0),
+			AllocationCounter::threadAllocations() - allocationsBefore);
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/EntityEngine/EntityEngine.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/PositionedEntity.h>
+#include <SpheresEngine/Threading/JobSystem.h>
+#include <SpheresEngine/Visuals/MeshVisual.h>
+#include <SpheresEngine/Visuals/VisualDataExtract.h>
+#include <SpheresEngine/Util.h>
+
+#include <vector>
+
+namespace {
+
+/**
+ * Add positioned entities with one mesh visual each
+ */
+std::vector<PositionedEntity *> addMeshEntities(EntityEngine & ee,
+		std::vector<uniq<MeshVisual>> & visuals, size_t count) {
+	std::vector<PositionedEntity *> entities;
+	for (size_t i = 0; i < count; i++) {
+		auto ent = std14::make_unique<PositionedEntity>();
+		ent->setPosition(Vector3(float(i), 0, 0));
+		visuals.emplace_back(
+				std14::make_unique<MeshVisual>("mesh_name", "text_name"));
+		ent->addVisual(visuals.back().get());
+		entities.push_back(ent.get());
+		ee.addEntity(std::move(ent));
+	}
+	return entities;
+}
+
+}
+
+TEST(AspectSchedulerTest, phasesFromConflicts) {
+	EntityEngine ee;
+	std::vector<uniq<MeshVisual>> visuals;
+	auto entities = addMeshEntities(ee, visuals, 2);
+	auto & sched = ee.ParallelTimeStep;
+
+	std::vector<int> order;
+	// different entities, same phase
+	sched.subscribe(entities[0], DataAccess().writesEntity(EntityData::Transform),
+			[&order](float) {order.push_back(0);});
+	sched.subscribe(entities[1], DataAccess().writesEntity(EntityData::Transform),
+			[&order](float) {order.push_back(1);});
+	// reads what the first one wrote
+	sched.subscribe(entities[0], DataAccess().readsEntity(EntityData::Transform),
+			[&order](float) {order.push_back(2);});
+	// other data of the first entity, no conflict
+	sched.subscribe(entities[0], DataAccess().writesEntity(EntityData::Physics),
+			[&order](float) {order.push_back(3);});
+	ASSERT_EQ(size_t(2), sched.getPhaseCount());
+
+	// readers of shared data run together after the writer
+	sched.subscribe(nullptr, DataAccess().writesShared(SharedData::Input),
+			[&order](float) {order.push_back(4);});
+	sched.subscribe(entities[1], DataAccess().readsShared(SharedData::Input),
+			[&order](float) {order.push_back(5);});
+	sched.subscribe(entities[0], DataAccess().readsShared(SharedData::Input),
+			[&order](float) {order.push_back(6);});
+	ASSERT_EQ(size_t(2), sched.getPhaseCount());
+
+	// might touch any entity, so it runs alone after all others
+	sched.subscribe(nullptr, DataAccess().readsEntity(EntityData::Visuals),
+			[&order](float) {order.push_back(7);});
+	sched.subscribe(entities[1], DataAccess().readsEntity(EntityData::Animation),
+			[&order](float) {order.push_back(8);});
+	ASSERT_EQ(size_t(4), sched.getPhaseCount());
+	ASSERT_EQ(size_t(9), sched.getTaskCount());
+
+	ee.step(0.1f);
+	ASSERT_EQ(std::vector<int>( { 0, 1, 3, 4, 2, 5, 6, 7, 8 }), order);
+}
+
+TEST(AspectSchedulerTest, parallelResultsDeterministic) {
+	const size_t entityCount = 1000;
+	std::vector<std::vector<float>> results;
+
+	for (size_t workers : { 0, 3 }) {
+		JobSystem jobs(workers);
+		EntityEngine ee;
+		ee.setJobSystem(&jobs);
+		std::vector<uniq<MeshVisual>> visuals;
+		auto entities = addMeshEntities(ee, visuals, entityCount);
+
+		for (auto ent : entities) {
+			// moves its own entity
+			ee.ParallelTimeStep.subscribe(ent,
+					DataAccess().writesEntity(EntityData::Transform),
+					[ent] (float dt) {ent->move(Vector3(0, dt, 0));});
+			// conflicting functions run in the order of subscription
+			ee.ParallelTimeStep.subscribe(ent,
+					DataAccess().writesEntity(EntityData::Transform),
+					[ent] (float) {
+						ent->setPosition(ent->getPosition() * 2.0f);
+					});
+		}
+		ASSERT_EQ(size_t(2), ee.ParallelTimeStep.getPhaseCount());
+
+		VisualDataExtractContainer exCon;
+		ee.extractVisualData(exCon);
+
+		ee.step(1.0f);
+		ee.extractVisualData(exCon);
+
+		// the changes done in parallel are extracted
+		ASSERT_EQ(entityCount, exCon.ChangedEntries);
+		std::vector<float> ys;
+		for (auto const& m : exCon.MeshTransforms) {
+			ys.push_back(m.Center.y);
+		}
+		results.push_back(ys);
+		ASSERT_FLOAT_EQ(2.0f, entities[entityCount - 1]->getPosition().y());
+		ASSERT_FLOAT_EQ(float(2 * (entityCount - 1)),
+				entities[entityCount - 1]->getPosition().x());
+	}
+
+	ASSERT_EQ(results[0], results[1]);
+}
+
+TEST(AspectSchedulerTest, subscriptionsChangedDuringRun) {
+	EntityEngine ee;
+	std::vector<uniq<MeshVisual>> visuals;
+	auto entities = addMeshEntities(ee, visuals, 1);
+	auto & sched = ee.ParallelTimeStep;
+
+	int removedCalls = 0;
+	int addedCalls = 0;
+	const auto removedId = sched.subscribe(entities[0], DataAccess(),
+			[&removedCalls](float) {removedCalls++;});
+	sched.subscribe(nullptr, DataAccess().writesShared(SharedData::Scene),
+			[&] (float) {
+				if (removedCalls == 1) {
+					sched.unsubscribe(removedId);
+					sched.subscribe(nullptr, DataAccess(),
+							[&addedCalls](float) {addedCalls++;});
+				}
+			});
+
+	ee.step(0.1f);
+	ASSERT_EQ(1, removedCalls);
+	ASSERT_EQ(0, addedCalls);
+	ASSERT_EQ(size_t(2), sched.getTaskCount());
+
+	ee.step(0.1f);
+	ASSERT_EQ(1, removedCalls);
+	ASSERT_EQ(1, addedCalls);
+}
+
+TEST(AspectSchedulerTest, taskCountWithRepeatedUnsubscribe) {
+	EntityEngine ee;
+	auto & sched = ee.ParallelTimeStep;
+
+	const auto removedId = sched.subscribe(nullptr, DataAccess(),
+			[](float) {});
+	size_t countDuringRun = 0;
+	sched.subscribe(nullptr, DataAccess().writesShared(SharedData::Scene),
+			[&] (float) {
+				sched.unsubscribe(removedId);
+				sched.unsubscribe(removedId);
+				sched.unsubscribe(removedId + 100);
+				countDuringRun = sched.getTaskCount();
+			});
+
+	ee.step(0.1f);
+	ASSERT_EQ(size_t(1), countDuringRun);
+	ASSERT_EQ(size_t(1), sched.getTaskCount());
+}
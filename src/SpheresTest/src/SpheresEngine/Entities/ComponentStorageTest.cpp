@@ -0,0 +1,307 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/EntityEngine/EntityEngine.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/PositionedEntity.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/CameraEntity.h>
+#include <SpheresEngine/Visuals/MeshVisual.h>
+#include <SpheresEngine/Visuals/VisualDataExtract.h>
+#include <SpheresEngine/Util.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+TEST(ComponentStorageTest, positionedEntityBinds) {
+	EntityEngine ee;
+	auto ms = std14::make_unique<MeshVisual>("mesh_name", "text_name");
+	auto pe = std14::make_unique<PositionedEntity>();
+	auto pePtr = pe.get();
+	pe->setPosition(Vector3(5, 0, 0));
+	pe->addVisual(ms.get());
+	ee.addEntity(std::move(pe));
+
+	// the position set before binding is moved to the storage
+	ASSERT_EQ(size_t(1), ee.getComponents().size());
+	ASSERT_FLOAT_EQ(5, ee.getComponents().getPosition(0).x());
+
+	pePtr->move(Vector3(1, 0, 0));
+	ASSERT_FLOAT_EQ(6, ee.getComponents().getPosition(0).x());
+	ASSERT_FLOAT_EQ(6, pePtr->getPosition().x());
+
+	// visuals added after binding are extracted as well
+	auto ms2 = std14::make_unique<MeshVisual>("mesh_name", "text_name");
+	pePtr->addVisual(ms2.get());
+
+	VisualDataExtractContainer exCon;
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(2), exCon.MeshVisuals.size());
+	ASSERT_FLOAT_EQ(6, exCon.MeshTransforms[0].Center.x);
+	ASSERT_FLOAT_EQ(6, exCon.MeshTransforms[1].Center.x);
+
+	// direct extraction of a bound entity gives the same result
+	VisualDataExtractContainer exConDirect;
+	pePtr->extractData(exConDirect);
+	ASSERT_EQ(size_t(2), exConDirect.MeshVisuals.size());
+	ASSERT_FLOAT_EQ(6, exConDirect.MeshTransforms[0].Center.x);
+}
+
+TEST(ComponentStorageTest, unboundEntityExtracted) {
+	EntityEngine ee;
+	auto cam = std14::make_unique<CameraEntity>();
+	cam->setPosition(Vector3(1, 2, 3));
+	ee.addEntity(std::move(cam));
+
+	ASSERT_EQ(size_t(0), ee.getComponents().size());
+
+	VisualDataExtractContainer exCon;
+	ee.extractVisualData(exCon);
+	ASSERT_FLOAT_EQ(2, exCon.CameraData.Position.y());
+}
+
+TEST(ComponentStorageTest, extractManyEntities) {
+	const size_t entityCount = 100000;
+	EntityEngine ee;
+	std::vector<uniq<MeshVisual>> visuals;
+	std::vector<PositionedEntity *> entities;
+	for (size_t i = 0; i < entityCount; i++) {
+		auto ent = std14::make_unique<PositionedEntity>();
+		ent->setPosition(Vector3(float(i), 0, 0));
+		visuals.emplace_back(
+				std14::make_unique<MeshVisual>("mesh_name", "text_name"));
+		ent->addVisual(visuals.back().get());
+		entities.push_back(ent.get());
+		ee.addEntity(std::move(ent));
+	}
+
+	VisualDataExtractContainer exCon;
+	// fill the slots of the container once
+	ee.extractVisualData(exCon);
+
+	// all entities move and the container missed more extractions than the
+	// storage remembers, so all entries are rewritten
+	VisualDataExtractContainer other;
+	for (size_t i = 0; i < ComponentStorage::HistoryLength; i++) {
+		ee.step(0.1f);
+		for (auto ent : entities) {
+			ent->move(Vector3(0, 1, 0));
+		}
+		ee.extractVisualData(other);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	ee.extractVisualData(exCon);
+	const auto duration = std::chrono::duration<float, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	logging::Info() << "Extracted " << entityCount << " entities in "
+			<< duration << " ms";
+	ASSERT_EQ(entityCount, exCon.ChangedEntries);
+
+	ASSERT_EQ(entityCount, exCon.MeshVisuals.size());
+	ASSERT_FLOAT_EQ(float(entityCount - 1),
+			exCon.MeshTransforms[entityCount - 1].Center.x);
+	ASSERT_FLOAT_EQ(float(ComponentStorage::HistoryLength),
+			exCon.MeshTransforms[entityCount - 1].Center.y);
+}
+
+namespace {
+
+/**
+ * Add a positioned entity with one mesh visual at an x position
+ */
+PositionedEntity * addMeshEntity(EntityEngine & ee,
+		std::vector<uniq<MeshVisual>> & visuals, float x) {
+	auto ent = std14::make_unique<PositionedEntity>();
+	auto entPtr = ent.get();
+	ent->setPosition(Vector3(x, 0, 0));
+	visuals.emplace_back(
+			std14::make_unique<MeshVisual>("mesh_name", "text_name"));
+	ent->addVisual(visuals.back().get());
+	ee.addEntity(std::move(ent));
+	return entPtr;
+}
+
+}
+
+TEST(ComponentStorageTest, onlyChangedEntriesRewritten) {
+	EntityEngine ee;
+	std::vector<uniq<MeshVisual>> visuals;
+	std::vector<PositionedEntity *> entities;
+	for (size_t i = 0; i < 10; i++) {
+		entities.push_back(addMeshEntity(ee, visuals, float(i)));
+	}
+
+	VisualDataExtractContainer exCon;
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(10), exCon.ChangedEntries);
+	const auto firstTick = exCon.ExtractTick;
+
+	// nothing changed
+	ee.step(0.1f);
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(0), exCon.ChangedEntries);
+	ASSERT_EQ(size_t(10), exCon.MeshVisuals.size());
+
+	entities[3]->move(Vector3(10, 0, 0));
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(1), exCon.ChangedEntries);
+	ASSERT_FLOAT_EQ(13, exCon.MeshTransforms[3].Center.x);
+	ASSERT_TRUE(exCon.meshVisualChangedSince(3, firstTick));
+	ASSERT_FALSE(exCon.meshVisualChangedSince(4, firstTick));
+
+	// the previous state is stored with the next step, which changes the
+	// interpolation once more
+	ee.step(0.1f);
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(1), exCon.ChangedEntries);
+	ASSERT_FLOAT_EQ(13, exCon.MeshTransforms[3].PreviousCenter.x);
+
+	ee.step(0.1f);
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(0), exCon.ChangedEntries);
+
+	// write access to the visual data marks the visual as changed
+	visuals[7]->getData().Visible = false;
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(1), exCon.ChangedEntries);
+	ASSERT_FALSE(exCon.MeshVisuals[7].Visible);
+}
+
+TEST(ComponentStorageTest, containersFilledAtDifferentTicks) {
+	EntityEngine ee;
+	std::vector<uniq<MeshVisual>> visuals;
+	auto moving = addMeshEntity(ee, visuals, 0);
+	addMeshEntity(ee, visuals, 1);
+	auto cam = std14::make_unique<CameraEntity>();
+	ee.addEntity(std::move(cam));
+
+	// the same rotation as in the triple buffer of the game loop
+	std::vector<VisualDataExtractContainer> containers(3);
+	for (size_t i = 0; i < 12; i++) {
+		moving->move(Vector3(1, 0, 0));
+		auto & exCon = containers[i % containers.size()];
+		ee.extractVisualData(exCon);
+
+		ASSERT_EQ(size_t(2), exCon.MeshVisuals.size());
+		ASSERT_FLOAT_EQ(float(i + 1), exCon.MeshTransforms[0].Center.x);
+		ASSERT_FLOAT_EQ(1, exCon.MeshTransforms[1].Center.x);
+		if (i >= containers.size()) {
+			ASSERT_EQ(size_t(1), exCon.ChangedEntries);
+		}
+		ee.step(0.1f);
+	}
+
+	// a container older than the change history is rewritten completely
+	VisualDataExtractContainer & stale = containers[0];
+	for (size_t i = 0; i < ComponentStorage::HistoryLength + 1; i++) {
+		ee.extractVisualData(containers[1]);
+	}
+	moving->move(Vector3(1, 0, 0));
+	ee.extractVisualData(stale);
+	ASSERT_EQ(size_t(2), stale.ChangedEntries);
+	ASSERT_FLOAT_EQ(13, stale.MeshTransforms[0].Center.x);
+
+	// new visuals are added to the existing entries
+	addMeshEntity(ee, visuals, 5);
+	ee.extractVisualData(stale);
+	ASSERT_EQ(size_t(1), stale.ChangedEntries);
+	ASSERT_EQ(size_t(3), stale.MeshVisuals.size());
+	ASSERT_FLOAT_EQ(5, stale.MeshTransforms[2].Center.x);
+}
+
+TEST(ComponentStorageTest, extractFewChangesInLargeScene) {
+	const size_t entityCount = 100000;
+	EntityEngine ee;
+	std::vector<uniq<MeshVisual>> visuals;
+	std::vector<PositionedEntity *> entities;
+	for (size_t i = 0; i < entityCount; i++) {
+		entities.push_back(addMeshEntity(ee, visuals, float(i)));
+	}
+
+	VisualDataExtractContainer exCon;
+	ee.extractVisualData(exCon);
+
+	// one percent of the entities move
+	const auto start = std::chrono::steady_clock::now();
+	ee.step(0.1f);
+	for (size_t i = 0; i < entityCount; i += 100) {
+		entities[i]->move(Vector3(0, 1, 0));
+	}
+	ee.extractVisualData(exCon);
+	const auto duration = std::chrono::duration<float, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	logging::Info() << "Extracted " << exCon.ChangedEntries << " changes of "
+			<< entityCount << " entities in " << duration << " ms";
+
+	ASSERT_EQ(entityCount / 100, exCon.ChangedEntries);
+	ASSERT_FLOAT_EQ(1, exCon.MeshTransforms[entityCount - 100].Center.y);
+	ASSERT_FLOAT_EQ(0, exCon.MeshTransforms[entityCount - 99].Center.y);
+}
+
+TEST(ComponentStorageTest, visualDataCopiedWhenChanged) {
+	EntityEngine ee;
+	std::vector<uniq<MeshVisual>> visuals;
+	std::vector<PositionedEntity *> entities;
+	for (size_t i = 0; i < 2; i++) {
+		entities.push_back(addMeshEntity(ee, visuals, float(i)));
+	}
+
+	VisualDataExtractContainer exCon;
+	VisualDataExtractContainer stale;
+	ee.extractVisualData(exCon);
+	ee.extractVisualData(stale);
+
+	// a moved entry only gets its new transform, a changed one all data
+	visuals[0]->getData().VertexCount = 7;
+	entities[1]->move(Vector3(10, 0, 0));
+	// marks the mesh data of the moved entry, it must not be rewritten
+	exCon.MeshVisuals[1].VertexCount = 3;
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(7, exCon.MeshVisuals[0].VertexCount);
+	ASSERT_EQ(3, exCon.MeshVisuals[1].VertexCount);
+	ASSERT_FLOAT_EQ(11, exCon.MeshTransforms[1].Center.x);
+
+	// the changes are copied into a container rewritten completely
+	visuals[1]->getData().VertexCount = 9;
+	for (size_t i = 0; i < ComponentStorage::HistoryLength; i++) {
+		ee.step(0.1f);
+		ee.extractVisualData(exCon);
+	}
+	ee.extractVisualData(stale);
+	ASSERT_EQ(7, stale.MeshVisuals[0].VertexCount);
+	ASSERT_EQ(9, stale.MeshVisuals[1].VertexCount);
+	ASSERT_FLOAT_EQ(11, stale.MeshTransforms[1].Center.x);
+}
+
+TEST(ComponentStorageTest, releasedSlotsKeepEntriesDense) {
+	EntityEngine ee;
+	std::vector<uniq<MeshVisual>> visuals;
+	std::vector<EntityHandle> handles;
+	for (size_t i = 0; i < 5; i++) {
+		handles.push_back(addMeshEntity(ee, visuals, float(i))->getHandle());
+	}
+
+	std::vector<VisualDataExtractContainer> containers(3);
+	for (auto & exCon : containers) {
+		ee.extractVisualData(exCon);
+	}
+
+	// the last entry is moved into the gap of the removed one
+	ee.removeEntity(handles[1]);
+	ee.flushRemovals();
+	addMeshEntity(ee, visuals, 10);
+	ASSERT_EQ(size_t(5), ee.getComponents().size());
+
+	for (auto & exCon : containers) {
+		ee.extractVisualData(exCon);
+		ASSERT_EQ(size_t(5), exCon.MeshVisuals.size());
+		ASSERT_EQ(size_t(2), exCon.ChangedEntries);
+
+		std::vector<float> centers;
+		for (auto const& m : exCon.MeshTransforms) {
+			centers.push_back(m.Center.x);
+		}
+		std::sort(centers.begin(), centers.end());
+		ASSERT_EQ(std::vector<float>( { 0, 2, 3, 4, 10 }), centers);
+	}
+}
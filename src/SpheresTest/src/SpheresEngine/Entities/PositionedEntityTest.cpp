@@ -38,7 +38,7 @@ TEST(PositionedEntityTest, positionOnVisual) {
 
 	pe.extractData(exCon);
 
-	ASSERT_FLOAT_EQ(50, exCon.MeshVisuals[0].Center.x);
+	ASSERT_FLOAT_EQ(50, exCon.MeshTransforms[0].Center.x);
 
 }
 
@@ -53,7 +53,7 @@ TEST(PositionedEntityTest, rotationOnVisual) {
 
 	pe.extractData(exCon);
 
-	ASSERT_FLOAT_EQ(0, glm::yaw(exCon.MeshVisuals[0].Rotation));
+	ASSERT_FLOAT_EQ(0, glm::yaw(exCon.MeshTransforms[0].Rotation));
 
 	// rotate around the roll axis by 90 degrees
 	pe.rotate(Vector3(0.0, 0.0, 20.0),
@@ -61,7 +61,7 @@ TEST(PositionedEntityTest, rotationOnVisual) {
 	exCon.clear();
 	pe.extractData(exCon);
 
-	ASSERT_FLOAT_EQ(0, glm::pitch(exCon.MeshVisuals[0].Rotation));
-	ASSERT_GE(glm::roll(exCon.MeshVisuals[0].Rotation), 0.1f);
-	ASSERT_FLOAT_EQ(0, glm::yaw(exCon.MeshVisuals[0].Rotation));
+	ASSERT_FLOAT_EQ(0, glm::pitch(exCon.MeshTransforms[0].Rotation));
+	ASSERT_GE(glm::roll(exCon.MeshTransforms[0].Rotation), 0.1f);
+	ASSERT_FLOAT_EQ(0, glm::yaw(exCon.MeshTransforms[0].Rotation));
 }
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/EntityEngine/EntityEngine.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/PositionedEntity.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/CameraEntity.h>
+#include <SpheresEngine/Util.h>
+
+#include <vector>
+
+namespace {
+
+PositionedEntity * addAt(EntityEngine & ee, Vector3 const& position) {
+	auto pe = std14::make_unique<PositionedEntity>();
+	auto pePtr = pe.get();
+	pe->setPosition(position);
+	ee.addEntity(std::move(pe));
+	return pePtr;
+}
+
+}
+
+TEST(SpatialIndexTest, entitiesIndexedWhenAdded) {
+	EntityEngine ee;
+	auto near = addAt(ee, Vector3(1, 0, 0));
+	addAt(ee, Vector3(20, 0, 0));
+
+	// entities which are not bound to the storage are not indexed
+	auto cam = std14::make_unique<CameraEntity>();
+	cam->setPosition(Vector3(0, 0, 0));
+	ee.addEntity(std::move(cam));
+	ASSERT_EQ(size_t(2), ee.getSpatialIndex().size());
+
+	std::vector<Entity *> found;
+	ee.getSpatialIndex().queryRadius(Vector3(0, 0, 0), 5.0f, found);
+	ASSERT_EQ(std::vector<Entity *>( { near }), found);
+}
+
+TEST(SpatialIndexTest, movedEntitiesFollowed) {
+	EntityEngine ee;
+	auto moving = addAt(ee, Vector3(0, 0, 0));
+	auto other = addAt(ee, Vector3(3, 0, 0));
+
+	// aspects see the positions of the step's beginning
+	std::vector<Entity *> foundInStep;
+	ee.OnTimeStep.subscribe([&] (float) {
+		moving->setPosition(Vector3(50, 0, 0));
+		foundInStep.clear();
+		ee.getSpatialIndex().queryRadius(Vector3(0, 0, 0), 1.0f, foundInStep);
+	});
+	ee.step(0.1f);
+	ASSERT_EQ(std::vector<Entity *>( { moving }), foundInStep);
+
+	// after the step the new position is indexed
+	std::vector<Entity *> found;
+	ee.getSpatialIndex().queryNearest(Vector3(49, 0, 0), 2, found);
+	ASSERT_EQ(std::vector<Entity *>( { moving, other }), found);
+
+	found.clear();
+	ee.getSpatialIndex().queryBox(Vector3(-1, -1, -1), Vector3(4, 1, 1),
+			found);
+	ASSERT_EQ(std::vector<Entity *>( { other }), found);
+}
+
+TEST(SpatialIndexTest, removedEntitiesDropped) {
+	EntityEngine ee;
+	auto first = addAt(ee, Vector3(0, 0, 0));
+	addAt(ee, Vector3(1, 0, 0));
+
+	// the entity moves and is removed within the same step
+	ee.OnTimeStep.subscribe([&] (float) {
+		if (ee.getEntity(first->getHandle())) {
+			first->setPosition(Vector3(0.5f, 0, 0));
+			ee.removeEntity(first->getHandle());
+		}
+	});
+	ee.step(0.1f);
+	ASSERT_EQ(size_t(1), ee.getSpatialIndex().size());
+
+	// the released slot is reused by a new entity at another position
+	auto added = addAt(ee, Vector3(-10, 0, 0));
+	std::vector<Entity *> found;
+	ee.getSpatialIndex().queryRadius(Vector3(-10, 0, 0), 1.0f, found);
+	ASSERT_EQ(std::vector<Entity *>( { added }), found);
+
+	found.clear();
+	ee.getSpatialIndex().queryRadius(Vector3(0, 0, 0), 0.6f, found);
+	ASSERT_TRUE(found.empty());
+}
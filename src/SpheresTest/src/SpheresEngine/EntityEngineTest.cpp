@@ -1,6 +1,12 @@
 #include <SpheresEngine/EntityEngine/Entity.h>
 #include <SpheresEngine/EntityEngine/EntityEngine.h>
 #include <SpheresEngine/Signals.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/PositionedEntity.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/CollisionMixin.h>
+#include <SpheresEngine/DataTypes/PoolAllocated.h>
+#include <SpheresEngine/Performance/AllocationCounter.h>
+#include <SpheresEngine/Visuals/MeshVisual.h>
+#include <SpheresEngine/Visuals/VisualDataExtract.h>
 
 #include <gtest/gtest.h>
 
@@ -48,3 +54,241 @@ TEST(EntityEngineTest, entityWithAspect) {
 			size_t(1));
 
 }
+
+TEST(EntityEngineTest, preparedVisualsDispatched) {
+	EntityEngine ee;
+	auto first = std14::make_unique<TestEntity>();
+	auto firstPtr = first.get();
+	first->addVisualPlaceholder(1);
+	first->addVisualPlaceholder(2);
+	ee.addEntity(std::move(first));
+
+	// placeholders added after the entity was added are registered as well
+	auto second = std14::make_unique<TestEntity>();
+	auto secondPtr = second.get();
+	ee.addEntity(std::move(second));
+	secondPtr->addVisualPlaceholder(3);
+	ASSERT_EQ(size_t(3), ee.getVisualIndex().getPlaceholderCount());
+
+	MeshVisual mv1("mesh_name", "text_name");
+	MeshVisual mv3("mesh_name", "text_name");
+	MeshVisual unknown("mesh_name", "text_name");
+	ee.updatePreparedVisuals( { { 3, &mv3 }, { 1, &mv1 }, { 42, &unknown } });
+
+	ASSERT_EQ(size_t(1), firstPtr->getVisuals().size());
+	ASSERT_EQ(&mv1, firstPtr->getVisuals()[0]);
+	ASSERT_EQ(size_t(1), firstPtr->getVisualPlaceholders().size());
+	ASSERT_EQ(PrepareVisualId(2), firstPtr->getVisualPlaceholders()[0]);
+	ASSERT_EQ(size_t(1), secondPtr->getVisuals().size());
+	ASSERT_EQ(&mv3, secondPtr->getVisuals()[0]);
+	ASSERT_EQ(size_t(1), ee.getVisualIndex().getPlaceholderCount());
+}
+
+TEST(EntityEngineTest, shaderReloadDispatched) {
+	EntityEngine ee;
+	MeshVisual defaultShader("mesh_name", "text_name");
+	defaultShader.getData().Shader = ShaderProgram(1);
+	defaultShader.getData().Shader.setName("default");
+	MeshVisual otherShader("mesh_name", "text_name");
+	otherShader.getData().Shader = ShaderProgram(2);
+	otherShader.getData().Shader.setName("other");
+
+	auto ent = std14::make_unique<TestEntity>();
+	ent->addVisual(&defaultShader);
+	ee.addEntity(std::move(ent));
+	ee.getEntities()[0]->addVisual(&otherShader);
+
+	ASSERT_EQ(size_t(1),
+			ee.getVisualIndex().getVisualsWithShader("default").size());
+	ASSERT_EQ(size_t(0),
+			ee.getVisualIndex().getVisualsWithShader("unused").size());
+
+	ee.updateVisuals( {
+			RendererVisualChange::createShaderProgramReloaded("default", 5) });
+	ASSERT_EQ(GLuint(5), defaultShader.getData().Shader.getId());
+	ASSERT_EQ(GLuint(2), otherShader.getData().Shader.getId());
+}
+
+namespace {
+
+/**
+ * Entity which is spawned and removed often, allocated from a pool
+ */
+class ProjectileEntity: public PositionedEntity,
+		public PoolAllocated<ProjectileEntity> {
+};
+
+/**
+ * Moves its entity every step
+ */
+class MoveAspect: public Aspect<ProjectileEntity>, public PoolAllocated<
+		MoveAspect> {
+public:
+	void init(Engines & engines, ProjectileEntity * ent) override {
+		auto id = engines.entity.OnTimeStep.subscribe(
+				[ent] (float dt) {ent->move(Vector3(dt, 0, 0));});
+		addManagedSubscription(&engines.entity.OnTimeStep, id);
+	}
+};
+
+/**
+ * Entity which can be added to the physics engine
+ */
+class CollisionEntity: public Entity, public CollisionMixin {
+};
+
+}
+
+TEST(EntityEngineTest, removeAtEndOfStep) {
+	EntityEngine ee;
+	auto first = ee.addEntity(std14::make_unique<TestEntity>());
+	auto second = ee.addEntity(std14::make_unique<TestEntity>());
+	auto third = ee.addEntity(std14::make_unique<TestEntity>());
+	ASSERT_NE(first, second);
+
+	// removal requested during the step is deferred to its end
+	ee.OnTimeStep.subscribe([&ee, second] (float) {
+		ee.removeEntity(second);
+		ASSERT_NE(nullptr, ee.getEntity(second));
+	});
+	ee.step(0.1f);
+
+	ASSERT_EQ(nullptr, ee.getEntity(second));
+	ASSERT_EQ(size_t(2), ee.getEntities().size());
+	ASSERT_EQ(third, ee.getEntity(third)->getHandle());
+
+	// the record is reused, but the old handle stays invalid
+	auto fourth = ee.addEntity(std14::make_unique<TestEntity>());
+	ASSERT_EQ(second.Index, fourth.Index);
+	ASSERT_EQ(nullptr, ee.getEntity(second));
+	ASSERT_NE(nullptr, ee.getEntity(fourth));
+
+	// removing twice or with an outdated handle is ignored
+	ee.removeEntity(first);
+	ee.removeEntity(first);
+	ee.removeEntity(second);
+	ee.flushRemovals();
+	ASSERT_EQ(size_t(2), ee.getEntities().size());
+	ASSERT_EQ(nullptr, ee.getEntity(first));
+}
+
+TEST(EntityEngineTest, removedEntityDetached) {
+	TestEngines testEngines;
+	auto engines = testEngines.getEngines();
+	auto & ee = testEngines.m_entity;
+
+	MeshVisual kept("mesh_name", "text_name");
+	MeshVisual removed("mesh_name", "text_name");
+	auto keptEnt = std14::make_unique<ProjectileEntity>();
+	auto keptPtr = keptEnt.get();
+	keptEnt->addVisual(&kept);
+	keptEnt->addAspect(engines, std14::make_unique<MoveAspect>());
+	auto removedEnt = std14::make_unique<ProjectileEntity>();
+	removedEnt->addVisual(&removed);
+	removedEnt->addAspect(engines, std14::make_unique<MoveAspect>());
+	ee.addEntity(std::move(keptEnt));
+	auto removedHandle = ee.addEntity(std::move(removedEnt));
+
+	VisualDataExtractContainer exCon;
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(2), exCon.MeshVisuals.size());
+
+	ee.removeEntity(removedHandle);
+	ee.step(1.0f);
+
+	// the aspect of the removed entity unsubscribed from the time step
+	ee.step(1.0f);
+	ASSERT_FLOAT_EQ(2.0f, keptPtr->getPosition().x());
+	ASSERT_EQ(size_t(1), ee.getComponents().getVisualCount());
+	ASSERT_EQ(size_t(1), ee.getComponents().getReleasedCount());
+
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(1), exCon.MeshVisuals.size());
+	ASSERT_FLOAT_EQ(2.0f, exCon.MeshTransforms[0].Center.x);
+
+	// the visual of the removed entity is not tracked anymore
+	removed.getData().Visible = false;
+	ee.extractVisualData(exCon);
+	ASSERT_EQ(size_t(0), exCon.ChangedEntries);
+}
+
+TEST(EntityEngineTest, pendingPreparesDropped) {
+	EntityEngine ee;
+	auto owned = std14::make_unique<MeshVisual>("mesh_name", "text_name");
+	auto ownedPtr = owned.get();
+	auto ent = std14::make_unique<TestEntity>();
+	ent->addVisualPlaceholder(7);
+	ent->addVisualPlaceholder(8);
+	ent->takeVisualOwnership(std::move(owned));
+	auto handle = ee.addEntity(std::move(ent));
+
+	ee.removeEntity(handle);
+	ee.flushRemovals();
+	const auto dropped = ee.popDroppedPrepares();
+	ASSERT_EQ(size_t(2), dropped.size());
+	ASSERT_EQ(size_t(0), ee.popDroppedPrepares().size());
+	ASSERT_EQ(size_t(0), ee.getVisualIndex().getPlaceholderCount());
+
+	// the owned visuals are destroyed once all of them came back from the
+	// render engine
+	ee.updatePreparedVisuals( { { 7, ownedPtr } });
+	MeshVisual other("mesh_name", "text_name");
+	ee.updatePreparedVisuals( { { 8, &other } });
+}
+
+TEST(EntityEngineTest, removedEntityLeavesPhysics) {
+	TestEngines testEngines;
+	auto & ee = testEngines.m_entity;
+	auto & physics = testEngines.m_physics;
+	ee.OnEntityRemoved.subscribe([&physics] (Entity * ent) {
+		physics.removeEntity(ent);
+	});
+
+	auto ent = std14::make_unique<CollisionEntity>();
+	ent->setShapeSource(CollisionMixin::ShapeSource::Box);
+	ent->setBoxSize(Vector3(1, 1, 1));
+	physics.addEntity(ent.get());
+	auto handle = ee.addEntity(std::move(ent));
+	ASSERT_EQ(size_t(1), physics.getEntityCount());
+
+	ee.removeEntity(handle);
+	ee.step(0.1f);
+	ASSERT_EQ(size_t(0), physics.getEntityCount());
+}
+
+TEST(EntityEngineTest, spawnWithoutAllocations) {
+	TestEngines testEngines;
+	auto engines = testEngines.getEngines();
+	auto & ee = testEngines.m_entity;
+
+	auto lmdSpawnAndRemove = [&ee] () {
+		std::vector<EntityHandle> handles;
+		handles.reserve(10);
+		for (size_t i = 0; i < 10; i++) {
+			handles.push_back(ee.addEntity(std14::make_unique<ProjectileEntity>()));
+		}
+		for (auto h : handles) {
+			ee.removeEntity(h);
+		}
+		ee.step(0.1f);
+	};
+
+	// the first round fills the pools and engine containers
+	lmdSpawnAndRemove();
+
+	const auto allocationsBefore = AllocationCounter::threadAllocations();
+	for (size_t round = 0; round < 5; round++) {
+		lmdSpawnAndRemove();
+	}
+	// only the handle vector of each round
+	ASSERT_EQ(size_t(5), AllocationCounter::threadAllocations() - allocationsBefore);
+	ASSERT_EQ(size_t(0), ee.getEntities().size());
+	ASSERT_EQ(size_t(0), PoolAllocated<ProjectileEntity>::getPool().getBlocksInUse());
+
+	// aspects come from their pool as well
+	auto ent = std14::make_unique<ProjectileEntity>();
+	ent->addAspect(engines, std14::make_unique<MoveAspect>());
+	ASSERT_EQ(size_t(1), PoolAllocated<MoveAspect>::getPool().getBlocksInUse());
+	ent.reset();
+	ASSERT_EQ(size_t(0), PoolAllocated<MoveAspect>::getPool().getBlocksInUse());
+}
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/FixedTimestep.h>
+
+TEST(FixedTimestepTest, accumulateSteps) {
+	FixedTimestep fts(10.0f);
+	ASSERT_FLOAT_EQ(0.1f, fts.getStepDuration());
+
+	// not enough for one step yet
+	ASSERT_EQ(size_t(0), fts.advance(0.05f));
+	ASSERT_NEAR(0.5f, fts.getInterpolation(), 0.001f);
+
+	// the remaining time of the last call is kept
+	ASSERT_EQ(size_t(1), fts.advance(0.06f));
+	ASSERT_NEAR(0.1f, fts.getInterpolation(), 0.001f);
+
+	ASSERT_EQ(size_t(2), fts.advance(0.2f));
+	ASSERT_NEAR(0.1f, fts.getInterpolation(), 0.001f);
+	ASSERT_EQ(size_t(0), fts.getDroppedSteps());
+}
+
+TEST(FixedTimestepTest, limitCatchUp) {
+	FixedTimestep fts(10.0f, 3);
+
+	// a very long stall must not result in a huge number of steps
+	ASSERT_EQ(size_t(3), fts.advance(1.05f));
+	ASSERT_EQ(size_t(7), fts.getDroppedSteps());
+	ASSERT_NEAR(0.5f, fts.getInterpolation(), 0.001f);
+
+	// back to normal afterwards
+	ASSERT_EQ(size_t(1), fts.advance(0.1f));
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/FramePacer.h>
+
+#include <thread>
+
+TEST(FramePacerTest, histogramPercentiles) {
+	PacingStatistics stats;
+	ASSERT_EQ(size_t(0), stats.getCount());
+	ASSERT_FLOAT_EQ(0.0f, stats.getPercentile(0.99f));
+
+	for (size_t i = 0; i < 98; i++) {
+		stats.add(5e-6f);
+	}
+	stats.add(300e-6f);
+	stats.add(20e-3f);
+
+	ASSERT_EQ(size_t(100), stats.getCount());
+	ASSERT_EQ(size_t(98), stats.getBucket(0));
+	ASSERT_EQ(size_t(1), stats.getBucket(5));
+	ASSERT_EQ(size_t(1), stats.getBucket(PacingStatistics::BucketCount - 1));
+
+	ASSERT_FLOAT_EQ(10e-6f, stats.getPercentile(0.5f));
+	ASSERT_FLOAT_EQ(500e-6f, stats.getPercentile(0.99f));
+	ASSERT_FLOAT_EQ(20e-3f, stats.getPercentile(1.0f));
+	ASSERT_FLOAT_EQ(20e-3f, stats.getMax());
+
+	stats.clear();
+	ASSERT_EQ(size_t(0), stats.getCount());
+}
+
+TEST(FramePacerTest, noDrift) {
+	const float period = 0.005f;
+	const size_t frames = 20;
+	FramePacer pacer(period);
+
+	const auto startTime = FramePacer::Clock::now();
+	pacer.start();
+	float passedSum = 0.0f;
+	for (size_t i = 0; i < frames; i++) {
+		// the work done in each frame must not delay the following deadlines
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		passedSum += pacer.waitForNextFrame();
+	}
+	const float total = std::chrono::duration<float>(
+			FramePacer::Clock::now() - startTime).count();
+
+	// the deadlines are never earlier than scheduled
+	ASSERT_GE(total, period * frames);
+	ASSERT_NEAR(total, passedSum, 0.001f);
+	ASSERT_EQ(frames, pacer.getStatistics().getCount());
+}
+
+TEST(FramePacerTest, resyncWhenBehind) {
+	const float period = 0.002f;
+	FramePacer pacer(period);
+
+	pacer.start();
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	pacer.waitForNextFrame();
+
+	// the missed deadlines are not caught up with a burst of frames
+	const float passed = pacer.waitForNextFrame();
+	ASSERT_GE(passed, period * 0.99f);
+}
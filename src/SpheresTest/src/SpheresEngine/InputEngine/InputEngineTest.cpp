@@ -1,4 +1,5 @@
 #include <SpheresEngine/InputEngine/InputEngine.h>
+#include <SpheresEngine/Performance/AllocationCounter.h>
 #include <SpheresEngine/Util.h>
 
 #include <gtest/gtest.h>
@@ -18,8 +19,9 @@ public:
 
 class TestInputTransformer: public InputTransformer {
 public:
-	std::unique_ptr<InputAction> transform(Input) override {
-		return std14::make_unique<TestInputAction>();
+	ArenaPtr<InputAction> transform(Input const&, FrameArena & arena)
+			override {
+		return arena.create<TestInputAction>();
 	}
 };
 
@@ -27,12 +29,12 @@ class TestSource: public InputSource {
 public:
 	virtual ~TestSource() = default;
 
-	std::vector<std::pair<UserId, Input> > readInput() override {
+	void readInput(std::vector<UserInputPair> & inputs) override {
 
 		Input ip = Input::createDirection(Input::Device::Keyboard,
 				Vector2(1.0, -1.0));
 
-		return {std::make_pair( UserId(), ip )};
+		inputs.push_back(std::make_pair(UserId(), ip));
 
 	}
 
@@ -45,7 +47,7 @@ class NullInputTransformer: public InputTransformer {
 public:
 	virtual ~NullInputTransformer() = default;
 
-	std::unique_ptr<InputAction> transform(Input) override {
+	ArenaPtr<InputAction> transform(Input const&, FrameArena &) override {
 		return nullptr;
 	}
 };
@@ -82,3 +84,38 @@ TEST(InputEngineTest, transformInputNullTransformer) {
 	ASSERT_EQ(size_t(0), ie.getInputActions().size());
 }
 
+
+TEST(InputEngineTest, actionsKeptInFrameArena) {
+	InputEngine ie;
+
+	ie.addSource(std14::make_unique<TestSource>());
+	ie.addTransformer(std14::make_unique<TestInputTransformer>());
+
+	ie.process();
+	ASSERT_EQ(size_t(1), ie.getFrameArena().getLiveObjects());
+	ASSERT_EQ(size_t(1), ie.getInputActions()[0]->getUserCount());
+
+	ie.clearInputActions();
+	ASSERT_EQ(size_t(0), ie.getFrameArena().getLiveObjects());
+}
+
+TEST(InputEngineTest, noAllocationsPerTick) {
+	InputEngine ie;
+
+	ie.addSource(std14::make_unique<TestSource>());
+	ie.addTransformer(std14::make_unique<TestInputTransformer>());
+	ie.addTransformer(std14::make_unique<NullInputTransformer>());
+
+	// the first tick sizes the lists and the arena
+	ie.process();
+	ie.clearInputActions();
+
+	for (size_t tick = 0; tick < 5; tick++) {
+		const auto allocationsBefore = AllocationCounter::threadAllocations();
+		ie.process();
+		ASSERT_EQ(size_t(1), ie.getInputActions().size());
+		ie.clearInputActions();
+		ASSERT_EQ(size_t(0),
+				AllocationCounter::threadAllocations() - allocationsBefore);
+	}
+}
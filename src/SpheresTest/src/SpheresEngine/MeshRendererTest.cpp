@@ -22,6 +22,12 @@
 #include <SpheresEngine/Visuals/MeshVisual.h>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/MeshRenderer.h>
 #include <SpheresEngine/Visuals/MeshVisual.h>
+#include <SpheresEngine/Visuals/VisualDataExtract.h>
+#include <SpheresEngine/RenderEngine/RenderBackendHeadless.h>
+#include <SpheresEngine/RenderEngine/Targets/RenderTargetBase.h>
+#include <SpheresEngine/ResourceEngine/ResourceEngineTesting.h>
+
+#include <glm/gtc/matrix_transform.hpp>
 
 TEST(MeshRendererTest, prepare) {
 	MeshRenderer mrender;
@@ -31,3 +37,263 @@ TEST(MeshRendererTest, prepare) {
 
 }
 
+
+namespace {
+
+/**
+ * Add a mesh with a bounding sphere of radius one at the position. The
+ * model matrix translates by the negative center of the visual.
+ */
+MeshVisualData & addMesh(VisualDataExtractContainer & cont,
+		glm::vec3 const& position, GLsizei vertexCount) {
+	auto & t = cont.MeshTransforms.next();
+	t = VisualTransform();
+	t.Center = -position;
+	t.PreviousCenter = -position;
+	auto & m = cont.MeshVisuals.next();
+	m = MeshVisualData();
+	m.VertexArrayObjectId = 1;
+	m.VertexCount = vertexCount;
+	m.TextureId = 1;
+	m.BoundsRadius = 1.0f;
+	return m;
+}
+
+/**
+ * Camera at the origin looking along the negative z axis
+ */
+TargetData lookAlongNegativeZ() {
+	TargetData td;
+	td.CameraMatrix = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1),
+			glm::vec3(0, 1, 0));
+	td.ProjectionMatrix = glm::perspective(glm::radians(50.0f), 1.0f, 0.1f,
+			100.0f);
+	return td;
+}
+
+}
+
+TEST(MeshRendererTest, meshesOutsideOfFrustumCulled) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	VisualDataExtractContainer cont;
+	addMesh(cont, glm::vec3(0, 0, -10), 36);
+	// behind the camera
+	addMesh(cont, glm::vec3(0, 0, 10), 36);
+	// beyond the far plane
+	addMesh(cont, glm::vec3(0, 0, -200), 36);
+	// far to the side, but the sphere reaches into the view
+	addMesh(cont, glm::vec3(-10.3f, 0, -20), 36);
+	// without bounds it is always drawn
+	addMesh(cont, glm::vec3(0, 0, 10), 36).BoundsRadius = -1.0f;
+	// invisible meshes are not counted as culled
+	addMesh(cont, glm::vec3(0, 50, 0), 36).Visible = false;
+
+	MeshRenderer renderer;
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, lookAlongNegativeZ());
+	ASSERT_EQ(before.DrawCalls + 3, backend.getStats().DrawCalls);
+	ASSERT_EQ(size_t(2), renderer.getCulledCount());
+
+	backend.closeRenderer();
+}
+
+TEST(MeshRendererTest, unchangedStaticMeshesNotRecomputed) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	// filled by an extraction, both entries changed with it
+	VisualDataExtractContainer cont;
+	addMesh(cont, glm::vec3(0, 0, -10), 36);
+	addMesh(cont, glm::vec3(0, 0, -10), 36);
+	cont.ExtractTick = 1;
+	cont.MeshVisualChangeTicks = { 1, 1 };
+
+	MeshRenderer renderer;
+	renderer.render(backend, cont, lookAlongNegativeZ());
+	ASSERT_EQ(size_t(0), renderer.getCulledCount());
+
+	// the next extraction only changed the second entry, so the modified
+	// first one must still have its previous position
+	cont.ExtractTick = 2;
+	cont.MeshVisualChangeTicks = { 1, 2 };
+	cont.MeshTransforms[0].Center = -glm::vec3(0, 0, 10);
+	cont.MeshTransforms[0].PreviousCenter = -glm::vec3(0, 0, 10);
+	cont.MeshTransforms[1].Center = -glm::vec3(0, 0, 10);
+	cont.MeshTransforms[1].PreviousCenter = -glm::vec3(0, 0, 10);
+	renderer.render(backend, cont, lookAlongNegativeZ());
+	ASSERT_EQ(size_t(1), renderer.getCulledCount());
+
+	// without extraction numbers all meshes are computed
+	cont.ExtractTick = 0;
+	cont.MeshVisualChangeTicks.clear();
+	renderer.render(backend, cont, lookAlongNegativeZ());
+	ASSERT_EQ(size_t(2), renderer.getCulledCount());
+
+	backend.closeRenderer();
+}
+
+TEST(MeshRendererTest, levelOfDetailByScreenSize) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	VisualDataExtractContainer cont;
+	for (auto distance : { 2.0f, 20.0f, 80.0f }) {
+		auto & m = addMesh(cont, glm::vec3(0, 0, -distance), 1000);
+		m.LevelOfDetailCount = 2;
+		m.LevelsOfDetail[0].VertexArrayObjectId = 2;
+		m.LevelsOfDetail[0].VertexCount = 100;
+		m.LevelsOfDetail[0].MaxScreenSize = 0.1f;
+		m.LevelsOfDetail[1].VertexArrayObjectId = 3;
+		m.LevelsOfDetail[1].VertexCount = 10;
+		m.LevelsOfDetail[1].MaxScreenSize = 0.05f;
+	}
+
+	// the screen sizes are about 1.07, 0.107 and 0.027
+	MeshRenderer renderer;
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, lookAlongNegativeZ());
+	ASSERT_EQ(before.DrawCalls + 3, backend.getStats().DrawCalls);
+	ASSERT_EQ(before.DrawnVertices + 1000 + 1000 + 10,
+			backend.getStats().DrawnVertices);
+
+	backend.closeRenderer();
+}
+
+TEST(MeshVisualTest, levelsOfDetailOrdered) {
+	MeshVisual mvisual("mesh_name", "texture_name");
+	mvisual.addLevelOfDetail("mesh_low", 0.05f);
+	mvisual.addLevelOfDetail("mesh_mid", 0.2f);
+	mvisual.addLevelOfDetail("mesh_lower", 0.01f);
+	// more levels than supported are ignored
+	mvisual.addLevelOfDetail("mesh_lowest", 0.001f);
+
+	auto const& lods = mvisual.getLevelsOfDetail();
+	ASSERT_EQ(size_t(3), lods.size());
+	ASSERT_EQ("mesh_mid", lods[0].MeshName);
+	ASSERT_EQ("mesh_low", lods[1].MeshName);
+	ASSERT_EQ("mesh_lower", lods[2].MeshName);
+}
+
+TEST(MeshRendererTest, stateChangesOnlyBetweenSortedGroups) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	// 10k cubes in view, alternating between two textures and two meshes
+	VisualDataExtractContainer cont;
+	const size_t count = 10000;
+	for (size_t i = 0; i < count; i++) {
+		auto & m = addMesh(cont,
+				glm::vec3(float(i % 100) * 0.2f - 10.0f,
+						float(i / 100) * 0.2f - 10.0f, -50.0f), 36);
+		m.TextureId = GLuint(1 + i % 2);
+		m.VertexArrayObjectId = GLuint(1 + (i / 2) % 2);
+		m.BoundsRadius = 0.1f;
+	}
+
+	MeshRenderer renderer;
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, lookAlongNegativeZ());
+	const auto after = backend.getStats();
+
+	ASSERT_EQ(size_t(0), renderer.getCulledCount());
+	ASSERT_EQ(before.DrawCalls + count, after.DrawCalls);
+	// one program, one texture unit, two textures, four vertex array binds
+	// plus the unbinds at the end. Unsorted, each cube needed six changes.
+	ASSERT_EQ(before.StateChanges + 10, after.StateChanges);
+	// the camera uniforms are set once, the model matrix for every cube
+	ASSERT_EQ(before.UniformUpdates + 3 + count, after.UniformUpdates);
+
+	backend.closeRenderer();
+}
+
+TEST(MeshRendererTest, repeatedMeshesDrawnInstanced) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	// 10k cubes in view, alternating between two textures and two meshes
+	VisualDataExtractContainer cont;
+	const size_t count = 10000;
+	for (size_t i = 0; i < count; i++) {
+		auto & m = addMesh(cont,
+				glm::vec3(float(i % 100) * 0.2f - 10.0f,
+						float(i / 100) * 0.2f - 10.0f, -50.0f), 36);
+		m.TextureId = GLuint(1 + i % 2);
+		m.VertexArrayObjectId = GLuint(1 + (i / 2) % 2);
+		m.InstancedVertexArrayObjectId = m.VertexArrayObjectId + 10;
+		m.InstancedShader = ShaderProgram(2);
+		m.BoundsRadius = 0.1f;
+	}
+	// too few copies of this mesh to be worth an instanced draw call
+	for (size_t i = 0; i < MeshRenderer::MinInstanceCount - 1; i++) {
+		auto & m = addMesh(cont, glm::vec3(0, 0, -10), 36);
+		m.TextureId = 3;
+		m.VertexArrayObjectId = 5;
+		m.InstancedVertexArrayObjectId = 15;
+		m.InstancedShader = ShaderProgram(2);
+	}
+
+	MeshRenderer renderer;
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, lookAlongNegativeZ());
+	const auto after = backend.getStats();
+
+	// one instanced draw call per mesh and texture combination
+	const size_t single = MeshRenderer::MinInstanceCount - 1;
+	ASSERT_EQ(before.DrawCalls + 4 + single, after.DrawCalls);
+	ASSERT_EQ(before.DrawnInstances + count + single, after.DrawnInstances);
+	ASSERT_EQ(before.DrawnVertices + (count + single) * 36,
+			after.DrawnVertices);
+	// the camera uniforms are set for the instanced and the regular program,
+	// the model matrices only for the single draw calls
+	ASSERT_EQ(before.UniformUpdates + 2 * 3 + single, after.UniformUpdates);
+
+	backend.closeRenderer();
+}
+
+TEST(MeshRendererTest, targetDataReadFromUniformBuffer) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	re.addTestShader("vtx",
+			"layout(std140) uniform TargetData {\n"
+					"mat4 camera;\n"
+					"mat4 projection;\n"
+					"};\n"
+					"uniform mat4 model;\n"
+					"void main(void) {}");
+	re.addTestShader("fs", "uniform sampler2D tex;\n"
+			"void main(void) {}");
+	auto & sb = backend.getShaderBackend();
+	sb.clearProgramDefinition();
+	sb.addProgramDefinition("default",
+			{ { { "vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } });
+	const auto program = sb.loadProgram("default");
+	ASSERT_TRUE(program.usesTargetData());
+
+	VisualDataExtractContainer cont;
+	const size_t count = 100;
+	for (size_t i = 0; i < count; i++) {
+		addMesh(cont, glm::vec3(float(i) * 0.1f, 0, -50.0f), 36).Shader =
+				program;
+	}
+
+	MeshRenderer renderer;
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, lookAlongNegativeZ());
+	const auto after = backend.getStats();
+
+	// the texture unit once, the model matrix for every cube
+	ASSERT_EQ(before.UniformUpdates + 1 + count, after.UniformUpdates);
+	ASSERT_EQ(before.Queries, after.Queries);
+
+	backend.closeRenderer();
+}
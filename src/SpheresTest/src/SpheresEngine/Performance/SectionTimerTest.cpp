@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/Performance/SectionTimer.h>
+#include <SpheresEngine/Performance/JsonQuote.h>
+
+#include <thread>
+
+TEST(SectionTimerTest, quoteJson) {
+	ASSERT_EQ("\"plain\"", util::quoteJson("plain"));
+	ASSERT_EQ("\"a\\\"b\\\\c\"", util::quoteJson("a\"b\\c"));
+	ASSERT_EQ("\"\\n\\r\\t\\b\\f\"", util::quoteJson("\n\r\t\b\f"));
+	// remaining control characters use the unicode escape
+	ASSERT_EQ("\"\\u0001\\u001f\"", util::quoteJson("\x01\x1f"));
+}
+
+#ifdef DESCENT_PROFILE
+
+namespace {
+
+/**
+ * Store a duration in microseconds
+ */
+void storeMicro(SectionRepo & repo, SectionId id, int micro) {
+	repo.storeResult(id, SectionRepo::Clock::now(),
+			std::chrono::microseconds(micro));
+}
+
+}
+
+TEST(SectionTimerTest, intern) {
+	SectionRepo repo;
+	const auto a = repo.intern("a");
+	const auto b = repo.intern("b");
+
+	ASSERT_NE(a, b);
+	ASSERT_EQ(a, repo.intern("a"));
+	ASSERT_EQ("b", repo.sectionName(b));
+}
+
+TEST(SectionTimerTest, internBeyondMaxSections) {
+	SectionRepo repo;
+	for (size_t i = 0; i < SectionThreadLog::MaxSections - 1; i++) {
+		repo.intern("section" + std::to_string(i));
+	}
+
+	// all further names share the last id
+	const auto overflow = repo.intern("a");
+	ASSERT_EQ(SectionId(SectionThreadLog::MaxSections - 1), overflow);
+	ASSERT_EQ(overflow, repo.intern("b"));
+	ASSERT_EQ(overflow, repo.intern("a"));
+	ASSERT_EQ(SectionRepo::OverflowSectionName, repo.sectionName(overflow));
+	ASSERT_EQ(SectionId(0), repo.intern("section0"));
+}
+
+TEST(SectionTimerTest, statisticsWithWarmup) {
+	SectionRepo repo;
+	repo.setWarmupSamples(2);
+	const auto a = repo.intern("a");
+	const auto b = repo.intern("b");
+
+	// the warm-up samples are dropped
+	storeMicro(repo, b, 10000);
+	storeMicro(repo, b, 10000);
+	for (int i = 1; i <= 100; i++) {
+		storeMicro(repo, b, i);
+	}
+	storeMicro(repo, a, 5);
+
+	const auto stats = repo.statistics();
+	ASSERT_EQ(size_t(1), stats.size());
+
+	storeMicro(repo, a, 5);
+	storeMicro(repo, a, 7);
+	const auto allStats = repo.statistics();
+	ASSERT_EQ(size_t(2), allStats.size());
+
+	// sorted by name
+	ASSERT_EQ("a", allStats[0].Name);
+	ASSERT_EQ(size_t(1), allStats[0].Count);
+	ASSERT_FLOAT_EQ(7.0f, allStats[0].Max);
+
+	auto const& stB = allStats[1];
+	ASSERT_EQ("b", stB.Name);
+	ASSERT_EQ(size_t(100), stB.Count);
+	ASSERT_FLOAT_EQ(1.0f, stB.Min);
+	ASSERT_FLOAT_EQ(50.5f, stB.Mean);
+	ASSERT_FLOAT_EQ(50.0f, stB.P50);
+	ASSERT_FLOAT_EQ(99.0f, stB.P99);
+	ASSERT_FLOAT_EQ(100.0f, stB.Max);
+
+	repo.clear();
+	ASSERT_EQ(size_t(0), repo.statistics().size());
+}
+
+TEST(SectionTimerTest, oldestEventsOverwritten) {
+	SectionRepo repo;
+	const auto a = repo.intern("a");
+
+	for (size_t i = 0; i < SectionThreadLog::Capacity + 10; i++) {
+		storeMicro(repo, a, 1);
+	}
+	storeMicro(repo, a, 2);
+
+	// the oldest slot is skipped, it could be written by the owning thread
+	// while the snapshot is taken
+	const auto events = repo.threadLog().snapshot();
+	ASSERT_EQ(SectionThreadLog::Capacity - 1, events.size());
+	ASSERT_EQ(int64_t(2000), events.back().Duration);
+	ASSERT_EQ(uint32_t(SectionThreadLog::Capacity + 10),
+			events.back().Occurrence);
+}
+
+TEST(SectionTimerTest, nestingAndThreads) {
+	SectionRepo repo;
+	const auto outer = repo.intern("outer");
+	const auto inner = repo.intern("inner");
+
+	auto lmdWork = [&repo, outer, inner] (std::string const& name) {
+		repo.setThreadName(name);
+		SectionTimer tmOuter(repo, outer);
+		SectionTimer tmInner(repo, inner);
+	};
+	std::thread logic(lmdWork, "logic");
+	std::thread render(lmdWork, "render");
+	logic.join();
+	render.join();
+
+	const auto stats = repo.statistics();
+	ASSERT_EQ(size_t(2), stats.size());
+	ASSERT_EQ(size_t(2), stats[0].Count);
+	ASSERT_EQ(size_t(2), stats[1].Count);
+
+	// the inner section is closed first and nested in the outer one
+	const auto trace = repo.chromeTrace();
+	ASSERT_NE(std::string::npos, trace.find("\"thread_name\""));
+	ASSERT_NE(std::string::npos, trace.find("\"logic\""));
+	ASSERT_NE(std::string::npos, trace.find("\"render\""));
+	ASSERT_NE(std::string::npos,
+			trace.find("{\"name\":\"inner\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"));
+	ASSERT_NE(std::string::npos,
+			trace.find("{\"name\":\"outer\",\"ph\":\"X\",\"pid\":1,\"tid\":2,"));
+	ASSERT_NE(std::string::npos, trace.find("\"args\":{\"depth\":1}"));
+	ASSERT_NE(std::string::npos, trace.find("\"args\":{\"depth\":0}"));
+}
+
+TEST(SectionTimerTest, overhead) {
+	SectionRepo repo;
+	const auto section = repo.intern("overhead");
+	const size_t iterations = 100000;
+
+	const auto start = SectionRepo::Clock::now();
+	for (size_t i = 0; i < iterations; i++) {
+		SectionTimer tm(repo, section);
+	}
+	const auto perSection = std::chrono::duration<double, std::nano>(
+			SectionRepo::Clock::now() - start).count() / iterations;
+
+	// generous bound so the test is stable on loaded and debug builds
+	logging::Info() << "SectionTimer overhead " << perSection << " ns";
+	ASSERT_LT(perSection, 1000.0);
+}
+
+#endif
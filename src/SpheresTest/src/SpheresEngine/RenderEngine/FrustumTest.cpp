@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/RenderEngine/Frustum.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+/**
+ * Camera at the origin looking along the negative z axis
+ */
+Frustum lookAlongNegativeZ() {
+	const auto camera = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0, 0, -1),
+			glm::vec3(0, 1, 0));
+	const auto projection = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f,
+			100.0f);
+	return Frustum(projection * camera);
+}
+
+}
+
+TEST(FrustumTest, sphereVisibility) {
+	const auto frustum = lookAlongNegativeZ();
+
+	ASSERT_TRUE(frustum.isSphereVisible(glm::vec3(0, 0, -10), 1.0f));
+	ASSERT_FALSE(frustum.isSphereVisible(glm::vec3(0, 0, 10), 1.0f));
+	// in front of the near plane, but reaching through it
+	ASSERT_FALSE(frustum.isSphereVisible(glm::vec3(0, 0, -0.5f), 0.4f));
+	ASSERT_TRUE(frustum.isSphereVisible(glm::vec3(0, 0, -0.5f), 0.6f));
+	// beyond the far plane
+	ASSERT_FALSE(frustum.isSphereVisible(glm::vec3(0, 0, -102), 1.0f));
+	// with 90 degrees the side planes are at x = -z
+	ASSERT_TRUE(frustum.isSphereVisible(glm::vec3(10.5f, 0, -10), 1.0f));
+	ASSERT_FALSE(frustum.isSphereVisible(glm::vec3(12, 0, -10), 1.0f));
+	ASSERT_FALSE(frustum.isSphereVisible(glm::vec3(0, -12, -10), 1.0f));
+}
+
+TEST(FrustumTest, batchMatchesSingleTests) {
+	const auto frustum = lookAlongNegativeZ();
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+	std::uniform_real_distribution<float> radius(0.0f, 10.0f);
+
+	// not a multiple of the SIMD width, so the remainder is tested as well
+	const size_t count = 1003;
+	std::vector<float> x, y, z, r;
+	for (size_t i = 0; i < count; i++) {
+		x.push_back(position(rng));
+		y.push_back(position(rng));
+		z.push_back(position(rng));
+		r.push_back(radius(rng));
+	}
+
+	std::vector<uint8_t> visible(count, 2);
+	frustum.cullSpheres(x.data(), y.data(), z.data(), r.data(), count,
+			visible.data());
+
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < count; i++) {
+		const bool expected = frustum.isSphereVisible(
+				glm::vec3(x[i], y[i], z[i]), r[i]);
+		ASSERT_EQ(expected ? 1 : 0, visible[i]);
+		visibleCount += visible[i];
+	}
+	ASSERT_GT(visibleCount, size_t(0));
+	ASSERT_LT(visibleCount, count);
+}
@@ -0,0 +1,122 @@
+#include <SpheresEngine/RenderEngine/RenderBackendSDLTesting.h>
+#include <SpheresEngine/RenderEngine/RenderBackendHeadless.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/ParticlesRenderer.h>
+#include <SpheresEngine/RenderEngine/Targets/RenderTargetBase.h>
+#include <SpheresEngine/ResourceEngine/ResourceEngineTesting.h>
+#include <SpheresEngine/Visuals/ParticleSystemModels.h>
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+#include <SpheresEngine/Visuals/VisualDataExtract.h>
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+TEST(ParticlesRendererTest, gpuSimulationMatchesModel) {
+
+	RenderBackendSDLTesting testingBackend;
+
+	testingBackend.openDisplay();
+	testingBackend.initRenderer();
+
+	if (!testingBackend.isValid()) {
+		std::cerr
+				<< "Skipping OpenGL test because required features not supported by driver"
+				<< std::endl;
+		return;
+	}
+
+	ResourceEngineTesting reTest;
+
+	reTest.addTestShader("vtx",
+			"uniform mat4 projection;\
+			uniform mat4 camera;\
+			uniform mat4 model;\
+			in vec3 vert;\
+			in vec4 vertInstanceCenter;\
+			in vec4 vertInstanceColor;\
+			out vec4 fragColor;\
+			void main(void) {\
+			fragColor = vertInstanceColor;\
+			gl_Position = projection * camera * model\
+			* vec4(vert * vertInstanceCenter.w + vertInstanceCenter.xyz, 1);}");
+
+	reTest.addTestShader("fs",
+			"in vec4 fragColor;\
+			out vec4 finalColor;\
+			void main() { finalColor = fragColor; }");
+
+	// same motion as ParticleSystemModels::plainNewtonWithGravity
+	reTest.addTestShader("sim_vtx",
+			"uniform float deltaT;\
+			in vec4 simPositionSize;\
+			in vec4 simVelocity;\
+			out vec4 outPositionSize;\
+			out vec4 outVelocity;\
+			void main(void) {\
+			vec3 velocity = simVelocity.xyz - vec3(0.0, deltaT, 0.0);\
+			outPositionSize = vec4(simPositionSize.xyz + velocity * deltaT,\
+			simPositionSize.w);\
+			outVelocity = vec4(velocity, simVelocity.w);}");
+
+	// the OpenGL calls are not recorded, only the shader backend is used
+	RenderBackendHeadless backend(reTest, Resolution(800, 600));
+	auto & shBackend = backend.getShaderBackend();
+	shBackend.clearProgramDefinition();
+	shBackend.addProgramDefinition("particles",
+			{ { { "vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } });
+	shBackend.addProgramDefinition("particles_sim",
+			{ { { "sim_vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } },
+			{ ShaderVariables::FeedbackPositionSize.getName(),
+					ShaderVariables::FeedbackVelocity.getName() });
+
+	// the core profile can only draw with a bound vertex array
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	ParticleSystemVisual gpuParticles;
+	gpuParticles.setGpuSimulation("particles_sim");
+	ParticleSystemVisual cpuParticles(
+			ParticleSystemModels::plainNewtonWithGravity());
+	for (size_t i = 0; i < 100; i++) {
+		const ParticleState state(Vector3(float(i), 0, 0),
+				Vector3(0.1f * i, 1.0f, -0.5f), 1.0f);
+		gpuParticles.addParticle(state);
+		cpuParticles.addParticle(state);
+	}
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(gpuParticles, backend, reTest));
+	ASSERT_TRUE(gpuParticles.getData().hasGpuSimulation());
+
+	VisualDataExtractContainer cont;
+	for (size_t i = 0; i < 10; i++) {
+		gpuParticles.step(0.1f);
+		cpuParticles.step(0.1f);
+		cont.clear();
+		gpuParticles.extractData(cont, ExtractOffset());
+		renderer.render(backend, cont, TargetData());
+	}
+
+	// no time passes, the GPU state is only read back
+	gpuParticles.requestReadback();
+	cont.clear();
+	gpuParticles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+	gpuParticles.step(0.0f);
+	ASSERT_EQ(GLenum(GL_NO_ERROR), glGetError());
+
+	auto const& gpu = gpuParticles.getData().getParticles();
+	auto const& cpu = cpuParticles.getData().getParticles();
+	for (size_t i = 0; i < 100; i++) {
+		ASSERT_NEAR(cpu.X[i], gpu.X[i], 0.0001f);
+		ASSERT_NEAR(cpu.Y[i], gpu.Y[i], 0.0001f);
+		ASSERT_NEAR(cpu.Z[i], gpu.Z[i], 0.0001f);
+		ASSERT_NEAR(cpu.VelocityY[i], gpu.VelocityY[i], 0.0001f);
+	}
+
+	glDeleteVertexArrays(1, &vao);
+	testingBackend.closeDisplay();
+}
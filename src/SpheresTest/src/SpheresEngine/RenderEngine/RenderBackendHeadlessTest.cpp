@@ -0,0 +1,457 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/RenderEngine/RenderBackendHeadless.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/GLSupport.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/ParticlesRenderer.h>
+#include <SpheresEngine/RenderEngine/Targets/RenderTargetBase.h>
+#include <SpheresEngine/ResourceEngine/ResourceEngineTesting.h>
+#include <SpheresEngine/Visuals/ParticleSystemModels.h>
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+#include <SpheresEngine/Visuals/VisualDataExtract.h>
+
+namespace {
+
+/**
+ * Register a particles shader program which can be loaded by the
+ * ParticlesRenderer
+ */
+void addParticlesShader(ResourceEngineTesting & re, ShaderBackend & sb) {
+	re.addTestShader("vtx",
+			"uniform mat4 projection;\n"
+					"uniform mat4 camera;\n"
+					"uniform mat4 model;\n"
+					"in vec3 vert;\n"
+					"in vec4 vertInstanceCenter;\n"
+					"in vec4 vertInstanceColor;\n"
+					"void main(void) {}\n");
+	re.addTestShader("fs", "void main(void) {}");
+	sb.clearProgramDefinition();
+	sb.addProgramDefinition("particles",
+			{ { { "vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } });
+}
+
+/**
+ * Register a particle simulation program which advances the particles
+ * with transform feedback
+ */
+void addSimulationShader(ResourceEngineTesting & re, ShaderBackend & sb) {
+	re.addTestShader("sim_vtx",
+			"uniform float deltaT;\n"
+					"in vec4 simPositionSize;\n"
+					"in vec4 simVelocity;\n"
+					"out vec4 outPositionSize;\n"
+					"out vec4 outVelocity;\n"
+					"void main(void) {\n"
+					"    outPositionSize = simPositionSize + vec4(simVelocity.xyz * deltaT, 0.0);\n"
+					"    outVelocity = simVelocity;\n"
+					"}\n");
+	sb.addProgramDefinition("particles_sim",
+			{ { { "sim_vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } },
+			{ ShaderVariables::FeedbackPositionSize.getName(),
+					ShaderVariables::FeedbackVelocity.getName() });
+}
+
+}
+
+TEST(RenderBackendHeadlessTest, recordsCalls) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	addParticlesShader(re, backend.getShaderBackend());
+
+	ParticleSystemVisual particles;
+	for (size_t i = 0; i < 100; i++) {
+		particles.addParticle(
+				ParticleState(Vector3(float(i), 0, 0), Vector3::zero(), 1.0f));
+	}
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(particles, backend, re));
+	ASSERT_TRUE(particles.getData().Shader.isValid());
+
+	VisualDataExtractContainer cont;
+	particles.extractData(cont, ExtractOffset());
+
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, TargetData());
+	backend.present();
+
+	const auto firstFrame = backend.getStats();
+	ASSERT_EQ(size_t(1), firstFrame.Frames);
+	ASSERT_EQ(before.DrawCalls + 1, firstFrame.DrawCalls);
+	ASSERT_EQ(before.DrawnInstances + 100, firstFrame.DrawnInstances);
+	// position and color buffer
+	ASSERT_EQ(before.Uploads + 2, firstFrame.Uploads);
+	ASSERT_EQ(before.UploadedBytes + 100 * (4 * sizeof(float) + 4),
+			firstFrame.UploadedBytes);
+	ASSERT_GT(firstFrame.StateChanges, before.StateChanges);
+
+	// unchanged particles are not uploaded again
+	renderer.render(backend, cont, TargetData());
+	backend.present();
+	ASSERT_EQ(firstFrame.DrawCalls + 1, backend.getStats().DrawCalls);
+	ASSERT_EQ(firstFrame.Uploads, backend.getStats().Uploads);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, attributesSetAtResolvedLocations) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	// the color is not declared last, so it is not located at 2
+	re.addTestShader("vtx", "uniform mat4 model;\n"
+			"in vec4 vertInstanceColor;\n"
+			"in vec3 vert;\n"
+			"in vec4 vertInstanceCenter;\n"
+			"void main(void) {}\n");
+	re.addTestShader("fs", "void main(void) {}");
+	auto & sb = backend.getShaderBackend();
+	sb.clearProgramDefinition();
+	sb.addProgramDefinition("particles",
+			{ { { "vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } });
+
+	ParticleSystemVisual particles;
+	particles.addParticle(
+			ParticleState(Vector3(1, 0, 0), Vector3::zero(), 1.0f));
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(particles, backend, re));
+	VisualDataExtractContainer cont;
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+
+	auto const& shader = particles.getData().Shader;
+	const auto color = shader.getAttribLocation(ShaderVariables::InstanceColor);
+	const auto center = shader.getAttribLocation(
+			ShaderVariables::InstanceCenter);
+	const auto vertex = shader.getAttribLocation(ShaderVariables::Vertex);
+	ASSERT_EQ(0, color);
+
+	auto const& recorder = backend.getRecorder();
+	for (auto location : { color, center, vertex }) {
+		ASSERT_TRUE(recorder.getAttribute(GLuint(location)).Enabled);
+		ASSERT_TRUE(recorder.getAttribute(GLuint(location)).PointerSet);
+	}
+	ASSERT_EQ(GLenum(GL_UNSIGNED_BYTE),
+			recorder.getAttribute(GLuint(color)).Type);
+	ASSERT_EQ(GLenum(GL_FLOAT), recorder.getAttribute(GLuint(center)).Type);
+	ASSERT_EQ(GLuint(1), recorder.getAttribute(GLuint(color)).Divisor);
+	ASSERT_EQ(GLuint(1), recorder.getAttribute(GLuint(center)).Divisor);
+	ASSERT_EQ(GLuint(0), recorder.getAttribute(GLuint(vertex)).Divisor);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, colorsOnlyUploadedWhenChanged) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	addParticlesShader(re, backend.getShaderBackend());
+
+	ParticleSystemVisual particles;
+	for (size_t i = 0; i < 100; i++) {
+		particles.addParticle(
+				ParticleState(Vector3(float(i), 0, 0), Vector3::zero(), 1.0f));
+	}
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(particles, backend, re));
+
+	VisualDataExtractContainer cont;
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+	backend.present();
+	const auto firstFrame = backend.getStats();
+
+	// a simulation step only moves the particles
+	particles.getData().editPositions().X[0] = 5.0f;
+	cont.clear();
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+	backend.present();
+
+	const auto secondFrame = backend.getStats();
+	ASSERT_EQ(firstFrame.Uploads + 1, secondFrame.Uploads);
+	ASSERT_EQ(firstFrame.UploadedBytes + 100 * 4 * sizeof(float),
+			secondFrame.UploadedBytes);
+	// the ring buffer is not orphaned
+	ASSERT_EQ(firstFrame.BufferAllocations, secondFrame.BufferAllocations);
+
+	particles.getData().editParticles();
+	cont.clear();
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+	backend.present();
+	ASSERT_EQ(secondFrame.Uploads + 2, backend.getStats().Uploads);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, skipsUnpreparedParticles) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	addParticlesShader(re, backend.getShaderBackend());
+
+	ParticleSystemVisual prepared;
+	ParticleSystemVisual unprepared;
+	for (size_t i = 0; i < 100; i++) {
+		prepared.addParticle(
+				ParticleState(Vector3(float(i), 0, 0), Vector3::zero(), 1.0f));
+		unprepared.addParticle(
+				ParticleState(Vector3(float(i), 0, 0), Vector3::zero(), 1.0f));
+	}
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(prepared, backend, re));
+
+	VisualDataExtractContainer cont;
+	unprepared.extractData(cont, ExtractOffset());
+	prepared.extractData(cont, ExtractOffset());
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, TargetData());
+
+	// only the prepared particles are drawn
+	ASSERT_EQ(before.DrawCalls + 1, backend.getStats().DrawCalls);
+
+	// and the unprepared ones stay unknown
+	cont.clear();
+	unprepared.extractData(cont, ExtractOffset());
+	const auto second = backend.getStats();
+	renderer.render(backend, cont, TargetData());
+	ASSERT_EQ(second.DrawCalls, backend.getStats().DrawCalls);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, releasesDestroyedParticles) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	addParticlesShader(re, backend.getShaderBackend());
+
+	auto particles = std14::make_unique<ParticleSystemVisual>();
+	for (size_t i = 0; i < 100; i++) {
+		particles->addParticle(
+				ParticleState(Vector3(float(i), 0, 0), Vector3::zero(), 1.0f));
+	}
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(*particles, backend, re));
+
+	VisualDataExtractContainer cont;
+	particles->extractData(cont, ExtractOffset());
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, TargetData());
+	ASSERT_EQ(before.DrawCalls + 1, backend.getStats().DrawCalls);
+
+	// the extracted data outlives the particle system
+	particles.reset();
+	const auto destroyed = backend.getStats();
+	renderer.render(backend, cont, TargetData());
+
+	// the buffers are deleted and the stale data is not drawn
+	ASSERT_EQ(destroyed.DrawCalls, backend.getStats().DrawCalls);
+	ASSERT_GT(backend.getStats().OtherCalls, destroyed.OtherCalls);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, gpuSimulationWithoutUploads) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	addParticlesShader(re, backend.getShaderBackend());
+	addSimulationShader(re, backend.getShaderBackend());
+
+	ParticleSystemVisual particles;
+	particles.setGpuSimulation("particles_sim");
+	for (size_t i = 0; i < 100; i++) {
+		particles.addParticle(
+				ParticleState(Vector3(float(i), 0, 0), Vector3::zero(), 1.0f));
+	}
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(particles, backend, re));
+	ASSERT_TRUE(particles.getData().SimulationShader.isValid());
+
+	VisualDataExtractContainer cont;
+	particles.extractData(cont, ExtractOffset());
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, TargetData());
+	backend.present();
+
+	// initial state: positions and velocities, the colors are streamed
+	const auto firstFrame = backend.getStats();
+	ASSERT_EQ(before.Uploads + 3, firstFrame.Uploads);
+	ASSERT_EQ(before.UploadedBytes + 100 * (2 * 4 * sizeof(float) + 4),
+			firstFrame.UploadedBytes);
+	// no time has been simulated yet
+	ASSERT_EQ(before.DrawCalls + 1, firstFrame.DrawCalls);
+
+	// a logic step is simulated on the GPU, nothing is uploaded
+	particles.step(0.1f);
+	cont.clear();
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+	backend.present();
+
+	const auto secondFrame = backend.getStats();
+	ASSERT_EQ(firstFrame.Uploads, secondFrame.Uploads);
+	// simulation and particle draw call
+	ASSERT_EQ(firstFrame.DrawCalls + 2, secondFrame.DrawCalls);
+	ASSERT_EQ(firstFrame.DrawnVertices + 100 + 4 * 100,
+			secondFrame.DrawnVertices);
+	ASSERT_EQ(firstFrame.Queries, secondFrame.Queries);
+
+	// the CPU copy of the particles is not touched
+	ASSERT_FLOAT_EQ(99.0f, particles.getData().getParticles().X[99]);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, gpuSimulationReadBackOnRequest) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	addParticlesShader(re, backend.getShaderBackend());
+	addSimulationShader(re, backend.getShaderBackend());
+
+	ParticleSystemVisual particles;
+	particles.setGpuSimulation("particles_sim");
+	for (size_t i = 0; i < 100; i++) {
+		particles.addParticle(
+				ParticleState(Vector3(float(i), 0, 0), Vector3::zero(), 1.0f));
+	}
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(particles, backend, re));
+
+	VisualDataExtractContainer cont;
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+	const auto firstFrame = backend.getStats();
+
+	particles.requestReadback();
+	particles.step(0.1f);
+	cont.clear();
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+
+	// positions and velocities are read, the recorder returns zeros
+	ASSERT_EQ(firstFrame.Queries + 2, backend.getStats().Queries);
+	ASSERT_FLOAT_EQ(99.0f, particles.getData().getParticles().X[99]);
+
+	// the readback is written to the particles with the next logic step
+	const auto version = particles.getData().Version;
+	particles.step(0.1f);
+	ASSERT_FLOAT_EQ(0.0f, particles.getData().getParticles().X[99]);
+	ASSERT_FLOAT_EQ(0.0f,
+			particles.getData().getParticles().PositionSizes[99].x());
+	ASSERT_GT(particles.getData().Version, version);
+
+	// only read once
+	cont.clear();
+	particles.extractData(cont, ExtractOffset());
+	const auto secondFrame = backend.getStats();
+	renderer.render(backend, cont, TargetData());
+	ASSERT_EQ(secondFrame.Queries, backend.getStats().Queries);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, gpuSimulationKeepsStateWhenParticlesAdded) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	addParticlesShader(re, backend.getShaderBackend());
+	addSimulationShader(re, backend.getShaderBackend());
+
+	ParticleSystemVisual particles;
+	particles.setGpuSimulation("particles_sim");
+	for (size_t i = 0; i < 100; i++) {
+		particles.addParticle(
+				ParticleState(Vector3(float(i), 0, 0), Vector3::zero(), 1.0f));
+	}
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(particles, backend, re));
+
+	VisualDataExtractContainer cont;
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+	particles.step(0.1f);
+	cont.clear();
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+	const auto simulated = backend.getStats();
+
+	particles.addParticle(
+			ParticleState(Vector3::zero(), Vector3::zero(), 1.0f));
+	cont.clear();
+	particles.extractData(cont, ExtractOffset());
+	renderer.render(backend, cont, TargetData());
+
+	// the simulated particles are copied on the GPU, only the added one is
+	// uploaded together with all colors
+	const auto added = backend.getStats();
+	ASSERT_EQ(simulated.Uploads + 3, added.Uploads);
+	ASSERT_EQ(simulated.UploadedBytes + 2 * 4 * sizeof(float) + 101 * 4,
+			added.UploadedBytes);
+	// positions and velocities
+	ASSERT_EQ(simulated.OtherCalls + 2, added.OtherCalls);
+	// no time passed, so only the particles are drawn
+	ASSERT_EQ(simulated.DrawCalls + 1, added.DrawCalls);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, gpuSimulationFallsBackToModel) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	// no simulation program registered
+	addParticlesShader(re, backend.getShaderBackend());
+
+	ParticleSystemVisual particles(
+			ParticleSystemModels::plainNewtonWithGravity());
+	particles.setGpuSimulation("particles_sim");
+	particles.addParticle(
+			ParticleState(Vector3::zero(), Vector3(1, 0, 0), 1.0f));
+
+	ParticlesRenderer renderer;
+	ASSERT_TRUE(renderer.prepare(particles, backend, re));
+	ASSERT_FALSE(particles.getData().hasGpuSimulation());
+
+	// the model moves the particles on the CPU
+	particles.step(0.5f);
+	ASSERT_FLOAT_EQ(0.5f, particles.getData().getParticles().X[0]);
+
+	VisualDataExtractContainer cont;
+	particles.extractData(cont, ExtractOffset());
+	ASSERT_FALSE(cont.ParticleSystems[0].hasGpuSimulation());
+	const auto before = backend.getStats();
+	renderer.render(backend, cont, TargetData());
+	// positions and colors are streamed, only the particles are drawn
+	ASSERT_EQ(before.Uploads + 2, backend.getStats().Uploads);
+	ASSERT_EQ(before.DrawCalls + 1, backend.getStats().DrawCalls);
+
+	backend.closeRenderer();
+}
+
+TEST(RenderBackendHeadlessTest, currentApiPerThread) {
+	GLApiRecorder recorder;
+	GLSupport::makeCurrent(&recorder);
+	ASSERT_EQ(&recorder, &GLSupport::api());
+
+	GLSupport::api().drawArrays(GL_TRIANGLES, 0, 3);
+	ASSERT_EQ(size_t(1), recorder.getStats().DrawCalls);
+
+	GLSupport::makeCurrent(nullptr);
+	ASSERT_NE(&recorder, &GLSupport::api());
+}
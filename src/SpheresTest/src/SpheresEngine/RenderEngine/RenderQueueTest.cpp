@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/RenderEngine/RenderQueue.h>
+
+#include <vector>
+
+TEST(RenderQueueTest, sortedByProgramTextureAndVertexArray) {
+	RenderQueue queue;
+	const std::vector<std::vector<GLuint>> states = { { 2, 1, 1 },
+			{ 1, 2, 1 }, { 1, 1, 2 }, { 1, 1, 1 }, { 2, 1, 1 }, { 1, 2, 1 } };
+	for (uint32_t i = 0; i < states.size(); i++) {
+		DrawItem item;
+		item.Key = RenderQueue::makeKey(states[i][0], states[i][1],
+				states[i][2]);
+		item.Index = i;
+		item.VertexArrayObjectId = states[i][2];
+		item.VertexCount = 3;
+		queue.add(item);
+	}
+	queue.sort();
+
+	std::vector<uint32_t> order;
+	for (auto const& item : queue.getItems()) {
+		order.push_back(item.Index);
+	}
+	// equal states stay in the order they were added
+	ASSERT_EQ(std::vector<uint32_t>( { 3, 2, 1, 5, 0, 4 }), order);
+
+	queue.clear();
+	ASSERT_TRUE(queue.getItems().empty());
+}
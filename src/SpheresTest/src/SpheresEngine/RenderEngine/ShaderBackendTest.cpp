@@ -1,6 +1,8 @@
 #include <SpheresEngine/RenderEngine/RenderBackendSDLTesting.h>
+#include <SpheresEngine/RenderEngine/RenderBackendHeadless.h>
 #include <SpheresEngine/RenderEngine/CommonOpenGL/ShaderBackend.h>
 #include <SpheresEngine/ResourceEngine/ResourceEngineTesting.h>
+#include <SpheresEngine/Visuals/MeshVisual.h>
 
 #include <gtest/gtest.h>
 
@@ -83,3 +85,153 @@ TEST(ShaderBackendTest, loadCompileShader) {
 	testingBackend.closeDisplay();
 }
 
+
+namespace {
+
+/**
+ * Register a program with a few uniforms and attributes
+ */
+void addTestProgram(ResourceEngineTesting & re, ShaderBackend & sb) {
+	re.addTestShader("vtx",
+			"uniform mat4 projection;\n"
+					"uniform mat4 camera;\n"
+					"uniform mat4 model;\n"
+					"uniform float user0;\n"
+					"in vec3 vert;\n"
+					"in vec2 vertTexCoord;\n"
+					"void main(void) {}");
+	re.addTestShader("fs", "uniform sampler2D tex;\n"
+			"void main(void) {}");
+	sb.clearProgramDefinition();
+	sb.addProgramDefinition("default",
+			{ { { "vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } });
+}
+
+}
+
+TEST(ShaderBackendTest, variableHashComputedAtCompileTime) {
+	static_assert(ShaderVariables::Model.getHash()
+			== ShaderVariable::hashName("model"), "hash is constexpr");
+	ASSERT_NE(ShaderVariables::Model.getHash(),
+			ShaderVariables::Camera.getHash());
+	ASSERT_STREQ("model", ShaderVariables::Model.getName());
+}
+
+TEST(ShaderBackendTest, arrayUniformsResolvedByName) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	auto & sb = backend.getShaderBackend();
+	re.addTestShader("vtx", "uniform vec4 lights[4];\n"
+			"uniform float user2[3];\n"
+			"in vec3 vert;\n"
+			"void main(void) {}");
+	re.addTestShader("fs", "void main(void) {}");
+	sb.clearProgramDefinition();
+	sb.addProgramDefinition("arrays",
+			{ { { "vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } });
+
+	auto program = sb.loadProgram("arrays");
+	ASSERT_NE(nullptr, program.getLocations());
+	auto const& locations = *program.getLocations();
+	ASSERT_NE(ShaderLocations::NotFound,
+			locations.findUniform(ShaderVariable::hashName("lights")));
+	ASSERT_EQ(ShaderLocations::NotFound,
+			locations.findUniform(ShaderVariable::hashName("lights[0]")));
+	ASSERT_NE(ShaderLocations::NotFound, locations.findUserValue(2));
+
+	backend.closeRenderer();
+}
+
+TEST(ShaderBackendTest, locationsResolvedWhenLinked) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	auto & sb = backend.getShaderBackend();
+	addTestProgram(re, sb);
+
+	auto program = sb.loadProgram("default");
+	ASSERT_NE(nullptr, program.getLocations());
+	auto const& locations = *program.getLocations();
+	ASSERT_NE(ShaderLocations::NotFound,
+			locations.findUniform(ShaderVariables::Projection.getHash()));
+	ASSERT_NE(ShaderLocations::NotFound,
+			locations.findUniform(ShaderVariables::Texture.getHash()));
+	ASSERT_NE(ShaderLocations::NotFound, locations.findUserValue(0));
+	ASSERT_EQ(ShaderLocations::NotFound, locations.findUserValue(1));
+	ASSERT_NE(ShaderLocations::NotFound,
+			locations.findAttribute(ShaderVariables::Vertex.getHash()));
+	ASSERT_EQ(ShaderLocations::NotFound,
+			locations.findAttribute(ShaderVariables::Model.getHash()));
+
+	ShaderUserDataContainer userData;
+	userData.Floats[0] = 1.0f;
+
+	// none of the calls needs to ask the driver for a location
+	const auto before = backend.getStats();
+	program.setUniform(ShaderVariables::Texture, 0);
+	program.setUniform(ShaderVariables::Model, glm::mat4());
+	program.setUniform("camera", glm::mat4());
+	program.applyUserValues(userData);
+	program.getAttribLocation(ShaderVariables::VertexTexCoord);
+	const auto after = backend.getStats();
+	ASSERT_EQ(before.Queries, after.Queries);
+	ASSERT_EQ(before.UniformUpdates + 4, after.UniformUpdates);
+
+	backend.closeRenderer();
+}
+
+TEST(ShaderBackendTest, locationsReplacedOnReload) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	auto & sb = backend.getShaderBackend();
+	addTestProgram(re, sb);
+
+	MeshVisual visual("mesh_name", "texture_name");
+	visual.getData().Shader = sb.loadProgram("default");
+	std::weak_ptr<const ShaderLocations> oldLocations =
+			visual.getData().Shader.shareLocations();
+
+	auto reloaded = sb.loadProgram("default", true);
+	ASSERT_NE(visual.getData().Shader.getId(), reloaded.getId());
+	ASSERT_NE(visual.getData().Shader.getLocations(), reloaded.getLocations());
+
+	visual.update(
+			RendererVisualChange::createShaderProgramReloaded("default",
+					reloaded.getId(), reloaded.shareLocations()));
+	ASSERT_EQ(reloaded.getId(), visual.getData().Shader.getId());
+	ASSERT_EQ(reloaded.getLocations(),
+			visual.getData().Shader.getLocations());
+
+	// nothing uses the old program anymore
+	ASSERT_TRUE(oldLocations.expired());
+
+	backend.closeRenderer();
+}
+
+TEST(ShaderBackendTest, targetDataBlockDetected) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+	auto & sb = backend.getShaderBackend();
+	addTestProgram(re, sb);
+	ASSERT_FALSE(sb.loadProgram("default").usesTargetData());
+
+	re.addTestShader("block_vtx",
+			"layout(std140) uniform TargetData {\n"
+					"mat4 camera;\n"
+					"mat4 projection;\n"
+					"};\n"
+					"uniform mat4 model;\n"
+					"in vec3 vert;\n"
+					"void main(void) {}");
+	sb.addProgramDefinition("block",
+			{ { { "block_vtx", Shader::Type::Vertex },
+					{ "fs", Shader::Type::Fragment } } });
+	ASSERT_TRUE(sb.loadProgram("block").usesTargetData());
+
+	backend.closeRenderer();
+}
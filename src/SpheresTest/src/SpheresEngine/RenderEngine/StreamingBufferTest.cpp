@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/RenderEngine/RenderBackendHeadless.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/StreamingBuffer.h>
+#include <SpheresEngine/ResourceEngine/ResourceEngineTesting.h>
+
+#include <vector>
+
+TEST(StreamingBufferTest, regionsWrittenInTurn) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	StreamingBuffer buffer;
+	buffer.reserve(64);
+	ASSERT_NE(GLuint(0), buffer.getId());
+	ASSERT_EQ(size_t(64), buffer.getRegionSize());
+
+	const std::vector<char> data(64, 1);
+	const auto before = backend.getStats();
+	ASSERT_EQ(GLintptr(0), buffer.upload(data.data(), data.size()));
+	ASSERT_EQ(GLintptr(64), buffer.upload(data.data(), data.size()));
+	ASSERT_EQ(GLintptr(128), buffer.upload(data.data(), data.size()));
+	// no fence to wait for while the ring is filled the first time
+	ASSERT_EQ(before.Queries, backend.getStats().Queries);
+
+	// back at the first region, which the GPU might still read
+	ASSERT_EQ(GLintptr(0), buffer.upload(data.data(), data.size()));
+	const auto afterWrap = backend.getStats();
+	ASSERT_EQ(before.Queries + 1, afterWrap.Queries);
+	ASSERT_EQ(before.Uploads + 4, afterWrap.Uploads);
+	ASSERT_EQ(before.UploadedBytes + 4 * data.size(), afterWrap.UploadedBytes);
+	// the storage is neither orphaned nor reallocated
+	ASSERT_EQ(before.BufferAllocations, afterWrap.BufferAllocations);
+
+	backend.closeRenderer();
+}
+
+TEST(StreamingBufferTest, growsForLargerData) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	StreamingBuffer buffer;
+	const std::vector<char> small(16, 1);
+	ASSERT_EQ(GLintptr(0), buffer.upload(small.data(), small.size()));
+	ASSERT_EQ(GLintptr(16), buffer.upload(small.data(), small.size()));
+	const auto id = buffer.getId();
+
+	const auto before = backend.getStats();
+	const std::vector<char> large(100, 1);
+	// new storage, so the data starts at the first region again
+	ASSERT_EQ(GLintptr(0), buffer.upload(large.data(), large.size()));
+	ASSERT_EQ(before.BufferAllocations + 1,
+			backend.getStats().BufferAllocations);
+	ASSERT_EQ(size_t(100), buffer.getRegionSize());
+	ASSERT_EQ(id, buffer.getId());
+
+	ASSERT_EQ(GLintptr(100), buffer.upload(small.data(), small.size()));
+
+	backend.closeRenderer();
+}
@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/RenderEngine/RenderBackendHeadless.h>
+#include <SpheresEngine/RenderEngine/CommonOpenGL/TargetDataBuffer.h>
+#include <SpheresEngine/RenderEngine/Targets/RenderTargetBase.h>
+#include <SpheresEngine/ResourceEngine/ResourceEngineTesting.h>
+
+TEST(TargetDataBufferTest, blockLayout) {
+	// std140 stores a mat4 as four vec4 columns without padding
+	ASSERT_EQ(size_t(2 * 16 * sizeof(float)), sizeof(TargetDataBlock));
+}
+
+TEST(TargetDataBufferTest, oneBufferPerTarget) {
+	ResourceEngineTesting re;
+	RenderBackendHeadless backend(re, Resolution(800, 600));
+	backend.initRenderer();
+
+	TargetDataBuffer buffer;
+	TargetData td;
+
+	const auto before = backend.getStats();
+	buffer.bind(0, td);
+	buffer.bind(1, td);
+	const auto firstFrame = backend.getStats();
+	ASSERT_EQ(before.ObjectsCreated + 2, firstFrame.ObjectsCreated);
+	ASSERT_EQ(before.Uploads + 2, firstFrame.Uploads);
+	ASSERT_EQ(before.UploadedBytes + 2 * sizeof(TargetDataBlock),
+			firstFrame.UploadedBytes);
+
+	// the buffers are reused in the next frame
+	buffer.bind(0, td);
+	buffer.bind(1, td);
+	const auto secondFrame = backend.getStats();
+	ASSERT_EQ(firstFrame.ObjectsCreated, secondFrame.ObjectsCreated);
+	ASSERT_EQ(firstFrame.Uploads + 2, secondFrame.Uploads);
+	ASSERT_EQ(firstFrame.UniformUpdates, secondFrame.UniformUpdates);
+
+	backend.closeRenderer();
+}
@@ -1,6 +1,25 @@
 #include <gtest/gtest.h>
 
 #include <SpheresEngine/Signals.h>
+#include <SpheresEngine/Performance/AllocationCounter.h>
+
+#include <vector>
+
+namespace {
+
+/**
+ * Receiver for batched subscriptions which counts its calls
+ */
+class CountingReceiver {
+public:
+	void onSignal(int value) {
+		Sum += value;
+	}
+
+	int Sum = 0;
+};
+
+}
 
 TEST(Signals, subscribe_unsubscibe) {
 
@@ -26,3 +45,145 @@ TEST(Signals, subscribe_unsubscibe) {
 	testSlot.unsubscribe( sub2id);
 }
 
+
+TEST(Signals, unsubscribe_during_signal) {
+	slots::Slot<int> testSlot;
+
+	int firstCalls = 0;
+	int secondCalls = 0;
+	slots::SlotBase::subscribed_id firstId = 0;
+	slots::SlotBase::subscribed_id secondId = 0;
+
+	firstId = testSlot.subscribe(
+			[&]( int ) {
+				firstCalls++;
+				// removes itself and the next subscriber
+				testSlot.unsubscribe(firstId);
+				testSlot.unsubscribe(secondId);
+			});
+	secondId = testSlot.subscribe([&secondCalls](int) {secondCalls++;});
+
+	testSlot.signal(1);
+	ASSERT_EQ(1, firstCalls);
+	ASSERT_EQ(0, secondCalls);
+	ASSERT_EQ(size_t(0), testSlot.getSubscriberCount());
+
+	testSlot.signal(1);
+	ASSERT_EQ(1, firstCalls);
+}
+
+TEST(Signals, subscribe_during_signal) {
+	slots::Slot<int> testSlot;
+
+	int addedCalls = 0;
+	bool added = false;
+	testSlot.subscribe([&](int) {
+		if (!added) {
+			added = true;
+			testSlot.subscribe([&addedCalls](int) {addedCalls++;});
+		}
+	});
+
+	// the new subscriber is called from the next signal on
+	testSlot.signal(1);
+	ASSERT_EQ(0, addedCalls);
+	ASSERT_EQ(size_t(2), testSlot.getSubscriberCount());
+
+	testSlot.signal(1);
+	ASSERT_EQ(1, addedCalls);
+}
+
+TEST(Signals, ids_reused) {
+	slots::Slot<int> testSlot;
+
+	auto sub1id = testSlot.subscribe([](int) {});
+	auto sub2id = testSlot.subscribe([](int) {});
+	ASSERT_NE(sub1id, sub2id);
+
+	testSlot.unsubscribe(sub1id);
+	ASSERT_EQ(sub1id, testSlot.subscribe([](int) {}));
+
+	// unknown ids are ignored
+	testSlot.unsubscribe(1000);
+	ASSERT_EQ(size_t(2), testSlot.getSubscriberCount());
+}
+
+TEST(Signals, batched_receivers) {
+	slots::Slot<int> testSlot;
+
+	std::vector<CountingReceiver> receivers(3);
+	std::vector<slots::SlotBase::subscribed_id> ids;
+	for (auto & r : receivers) {
+		ids.push_back(
+				testSlot.subscribeBatched<CountingReceiver,
+						&CountingReceiver::onSignal>(&r));
+	}
+	int lambdaCalls = 0;
+	testSlot.subscribe([&lambdaCalls](int) {lambdaCalls++;});
+	ASSERT_EQ(size_t(4), testSlot.getSubscriberCount());
+
+	testSlot.signal(2);
+	ASSERT_EQ(1, lambdaCalls);
+	for (auto const& r : receivers) {
+		ASSERT_EQ(2, r.Sum);
+	}
+
+	testSlot.unsubscribe(ids[1]);
+	testSlot.signal(3);
+	ASSERT_EQ(5, receivers[0].Sum);
+	ASSERT_EQ(2, receivers[1].Sum);
+	ASSERT_EQ(5, receivers[2].Sum);
+}
+
+TEST(Signals, batched_subscribe_during_signal) {
+	slots::Slot<int> testSlot;
+
+	CountingReceiver existing;
+	CountingReceiver added;
+	CountingReceiver removed;
+	testSlot.subscribeBatched<CountingReceiver, &CountingReceiver::onSignal>(
+			&existing);
+
+	bool subscribed = false;
+	testSlot.subscribe([&](int) {
+		if (!subscribed) {
+			subscribed = true;
+			testSlot.subscribeBatched<CountingReceiver,
+					&CountingReceiver::onSignal>(&added);
+			// removed before it was ever called
+			testSlot.unsubscribe(
+					testSlot.subscribeBatched<CountingReceiver,
+							&CountingReceiver::onSignal>(&removed));
+		}
+	});
+
+	// the new receiver is called from the next signal on
+	testSlot.signal(1);
+	ASSERT_EQ(1, existing.Sum);
+	ASSERT_EQ(0, added.Sum);
+	ASSERT_EQ(size_t(3), testSlot.getSubscriberCount());
+
+	testSlot.signal(1);
+	ASSERT_EQ(2, existing.Sum);
+	ASSERT_EQ(1, added.Sum);
+	ASSERT_EQ(0, removed.Sum);
+}
+
+TEST(Signals, no_allocations_during_signal) {
+	slots::Slot<int> testSlot;
+
+	int sum = 0;
+	std::vector<CountingReceiver> receivers(10);
+	for (size_t i = 0; i < 10; i++) {
+		testSlot.subscribe([&sum, i](int v) {sum += v + int(i);});
+		testSlot.subscribeBatched<CountingReceiver, &CountingReceiver::onSignal>(
+				&receivers[i]);
+	}
+
+	const auto allocationsBefore = AllocationCounter::threadAllocations();
+	testSlot.signal(1);
+	ASSERT_EQ(size_t(0),
+			AllocationCounter::threadAllocations() - allocationsBefore);
+	ASSERT_EQ(10 + 45, sum);
+	ASSERT_EQ(1, receivers[9].Sum);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/Threading/JobSystem.h>
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+#include <SpheresEngine/Visuals/ParticleSystemModels.h>
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+TEST(JobSystemTest, allIndicesProcessedOnce) {
+	for (size_t workers : { 0, 1, 3 }) {
+		JobSystem js(workers);
+		ASSERT_EQ(workers, js.getWorkerCount());
+
+		std::vector<std::atomic<int>> visits(1003);
+		for (auto & v : visits) {
+			v = 0;
+		}
+
+		js.parallelFor(0, visits.size(), 10, [&visits] (size_t begin, size_t end) {
+			ASSERT_LE(end - begin, size_t(10));
+			for (size_t i = begin; i < end; i++) {
+				visits[i]++;
+			}
+		});
+
+		for (auto & v : visits) {
+			ASSERT_EQ(1, v);
+		}
+	}
+}
+
+TEST(JobSystemTest, nestedLoops) {
+	JobSystem js(2);
+	std::atomic<size_t> count(0);
+
+	js.parallelFor(0, 8, 1, [&js, &count] (size_t, size_t) {
+		js.parallelFor(0, 100, 7, [&count] (size_t begin, size_t end) {
+			count += end - begin;
+		});
+	});
+
+	ASSERT_EQ(size_t(800), count);
+}
+
+TEST(JobSystemTest, emptyRange) {
+	JobSystem js(2);
+	bool called = false;
+	js.parallelFor(5, 5, 1, [&called] (size_t, size_t) {called = true;});
+	ASSERT_FALSE(called);
+}
+
+TEST(JobSystemTest, deterministicParticleSimulation) {
+	std::vector<ParticleBuffer> results;
+
+	for (size_t workers : { 0, 1, 3 }) {
+		JobSystem js(workers);
+		ParticleSystemVisual pv(ParticleSystemModels::plainNewtonWithGravity(js, 64));
+		for (size_t i = 0; i < 1001; i++) {
+			const float f = float(i);
+			pv.addParticle(ParticleState(Vector3(f, 0, -f),
+					Vector3(0.1f * f, 1.0f, 0.2f), 1.0f));
+		}
+
+		for (size_t step = 0; step < 10; step++) {
+			pv.step(0.016f);
+		}
+		results.push_back(pv.getData().getParticles());
+	}
+
+	// bitwise identical results, independent of the thread count
+	for (auto const& r : results) {
+		ASSERT_EQ(results[0].getParticleCount(), r.getParticleCount());
+		ASSERT_EQ(0,
+				std::memcmp(results[0].getPosSizeBuffer(), r.getPosSizeBuffer(),
+						r.getParticleCount() * 4 * sizeof(float)));
+		ASSERT_EQ(0,
+				std::memcmp(results[0].VelocityY.data(), r.VelocityY.data(),
+						r.getParticleCount() * sizeof(float)));
+	}
+}
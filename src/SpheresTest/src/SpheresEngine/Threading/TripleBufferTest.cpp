@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/Threading/TripleBuffer.h>
+
+#include <thread>
+
+TEST(TripleBufferTest, publishAndAcquire) {
+	TripleBuffer<int> tb;
+
+	// nothing published yet
+	ASSERT_FALSE(tb.acquire());
+
+	tb.getBack() = 23;
+	tb.publish();
+
+	// the writer must get a fresh object to write to
+	tb.getBack() = 5;
+
+	ASSERT_TRUE(tb.acquire());
+	ASSERT_EQ(23, tb.getFront());
+
+	// no new object, front stays the same
+	ASSERT_FALSE(tb.acquire());
+	ASSERT_EQ(23, tb.getFront());
+}
+
+TEST(TripleBufferTest, skipOldObjects) {
+	TripleBuffer<int> tb;
+
+	tb.getBack() = 1;
+	tb.publish();
+	tb.getBack() = 2;
+	tb.publish();
+	tb.getBack() = 3;
+	tb.publish();
+
+	// only the most recent object is visible to the reader
+	ASSERT_TRUE(tb.acquire());
+	ASSERT_EQ(3, tb.getFront());
+	ASSERT_FALSE(tb.acquire());
+}
+
+TEST(TripleBufferTest, concurrentHandover) {
+	// the payload holds the same value twice, a torn read
+	// would show up as a mismatch
+	typedef std::pair<size_t, size_t> Payload;
+	TripleBuffer<Payload> tb;
+	const size_t iterations = 100000;
+
+	std::thread writer([&tb, iterations] () {
+		for (size_t i = 1; i <= iterations; i++) {
+			tb.getBack().first = i;
+			tb.getBack().second = i;
+			tb.publish();
+		}
+	});
+
+	size_t lastSeen = 0;
+	while (lastSeen < iterations) {
+		if (tb.acquire()) {
+			auto const& front = tb.getFront();
+			ASSERT_EQ(front.first, front.second);
+			// objects must never arrive out of order
+			ASSERT_GT(front.first, lastSeen);
+			lastSeen = front.first;
+		}
+	}
+
+	writer.join();
+}
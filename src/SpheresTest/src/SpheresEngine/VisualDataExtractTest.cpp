@@ -18,12 +18,276 @@ You should have received a copy of the GNU General Public License
 along with Kung Foo Barracuda.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-
 #include <gtest/gtest.h>
 
+#include <SpheresEngine/EntityEngine/EntityEngine.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/PositionedEntity.h>
+#include <SpheresEngine/Visuals/MeshVisual.h>
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+#include <SpheresEngine/Visuals/VisualDataExtract.h>
+#include <SpheresEngine/Performance/AllocationCounter.h>
+#include <SpheresEngine/Util.h>
+
+#include <memory>
+#include <vector>
+
 TEST(RingBufferTest, addAndRead) {
 
 	// can never be bigger than 4. It's a ring buffer baby
 	//EXPECT_EQ(23,24);
 }
 
+namespace {
+
+/**
+ * Creates an entity engine with some mesh and particle visuals, the visuals
+ * contain long names and user data so the extraction would need heap memory
+ * if the slots were not reused
+ */
+void setupScene(EntityEngine & ee, std::vector<uniq<VisualAbstract>> & visuals) {
+	for (size_t i = 0; i < 10; i++) {
+		auto ent = std14::make_unique<PositionedEntity>();
+		ent->setPosition(Vector3(float(i), 0, 0));
+
+		auto mesh = std14::make_unique<MeshVisual>("mesh_name", "text_name");
+		mesh->getData().Shader.setName("a_shader_name_longer_than_the_sso_buffer");
+		mesh->getData().UserData.Floats['a'] = 1.0f;
+		ent->addVisual(mesh.get());
+		visuals.push_back(std::move(mesh));
+
+		auto particles = std14::make_unique<ParticleSystemVisual>();
+		for (size_t p = 0; p < 100; p++) {
+			particles->addParticle(
+					ParticleState(Vector3(float(p), 0, 0), Vector3::zero(),
+							1.0f));
+		}
+		ent->addVisual(particles.get());
+		visuals.push_back(std::move(particles));
+
+		ee.addEntity(std::move(ent));
+	}
+}
+
+}
+
+TEST(VisualDataExtractTest, reuseSlots) {
+	VisualDataExtractContainer exCon;
+	auto ms = std14::make_unique<MeshVisual>("mesh_name", "text_name");
+	PositionedEntity pe;
+	pe.addVisual(ms.get());
+
+	pe.extractData(exCon);
+	ASSERT_EQ(size_t(1), exCon.MeshVisuals.size());
+
+	exCon.clear();
+	ASSERT_EQ(size_t(0), exCon.MeshVisuals.size());
+	ASSERT_TRUE(exCon.MeshVisuals.empty());
+	// the slot itself is kept for the next round
+	ASSERT_EQ(size_t(1), exCon.MeshVisuals.capacity());
+
+	pe.setPosition(Vector3(23, 0, 0));
+	pe.extractData(exCon);
+	ASSERT_EQ(size_t(1), exCon.MeshVisuals.size());
+	ASSERT_EQ(size_t(1), exCon.MeshVisuals.capacity());
+	ASSERT_FLOAT_EQ(23, exCon.MeshTransforms[0].Center.x);
+}
+
+TEST(VisualDataExtractTest, noAllocationsPerFrame) {
+	// make sure the allocation counter hook is compiled in, otherwise
+	// this test would be meaningless
+	const auto allocationsHookTest = AllocationCounter::threadAllocations();
+	auto hookTest = std14::make_unique<int>(5);
+	ASSERT_GT(AllocationCounter::threadAllocations(), allocationsHookTest);
+
+	EntityEngine ee;
+	std::vector<uniq<VisualAbstract>> visuals;
+	setupScene(ee, visuals);
+
+	VisualDataExtractContainer exCon;
+
+	// first frame fills the slots of the container
+	exCon.clear();
+	ee.extractVisualData(exCon);
+
+	for (size_t frame = 0; frame < 5; frame++) {
+		const auto allocationsBefore = AllocationCounter::threadAllocations();
+		exCon.clear();
+		ee.extractVisualData(exCon);
+		ASSERT_EQ(size_t(0),
+				AllocationCounter::threadAllocations() - allocationsBefore);
+	}
+
+	ASSERT_EQ(size_t(10), exCon.MeshVisuals.size());
+	ASSERT_EQ(size_t(10), exCon.ParticleSystems.size());
+	ASSERT_EQ(size_t(100), exCon.ParticleSystems[0].getParticleCount());
+}
+
+TEST(VisualDataExtractTest, particlesNotCopied) {
+	VisualDataExtractContainer exCon;
+	auto particles = std14::make_unique<ParticleSystemVisual>();
+	particles->addParticle(
+			ParticleState(Vector3(1, 2, 3), Vector3::zero(), 1.0f));
+	PositionedEntity pe;
+	pe.addVisual(particles.get());
+
+	pe.extractData(exCon);
+	const auto version = exCon.ParticleSystems[0].Version;
+	ASSERT_EQ(particles->getData().Particles.get(),
+			exCon.ParticleSystems[0].Particles.get());
+
+	// no change to the particles, the version stays the same
+	exCon.clear();
+	pe.extractData(exCon);
+	ASSERT_EQ(version, exCon.ParticleSystems[0].Version);
+	ASSERT_EQ(particles->getData().Particles.get(),
+			exCon.ParticleSystems[0].Particles.get());
+}
+
+TEST(VisualDataExtractTest, particlesCopyOnWrite) {
+	VisualDataExtractContainer exCon;
+	auto particles = std14::make_unique<ParticleSystemVisual>();
+	particles->addParticle(
+			ParticleState(Vector3(1, 2, 3), Vector3::zero(), 1.0f));
+	PositionedEntity pe;
+	pe.addVisual(particles.get());
+
+	pe.extractData(exCon);
+	const auto version = exCon.ParticleSystems[0].Version;
+
+	// modify the particles while the extracted data still references them
+	particles->getData().editParticles().PositionSizes[0].setX(23.0f);
+
+	ASSERT_GT(particles->getData().Version, version);
+	ASSERT_FLOAT_EQ(23.0f,
+			particles->getData().getParticles().PositionSizes[0].x());
+	// the extracted data still sees the old state
+	ASSERT_FLOAT_EQ(1.0f,
+			exCon.ParticleSystems[0].Particles->PositionSizes[0].x());
+
+	exCon.clear();
+	pe.extractData(exCon);
+	ASSERT_EQ(particles->getData().Version, exCon.ParticleSystems[0].Version);
+	ASSERT_FLOAT_EQ(23.0f,
+			exCon.ParticleSystems[0].Particles->PositionSizes[0].x());
+}
+
+TEST(VisualDataExtractTest, interpolatePreviousState) {
+	EntityEngine ee;
+	auto ms = std14::make_unique<MeshVisual>("mesh_name", "text_name");
+	auto pe = std14::make_unique<PositionedEntity>();
+	auto pePtr = pe.get();
+	pe->addVisual(ms.get());
+	ee.addEntity(std::move(pe));
+
+	VisualDataExtractContainer exCon;
+
+	// no step so far, previous and current state are the same
+	ee.extractVisualData(exCon);
+	ASSERT_FLOAT_EQ(0, exCon.MeshTransforms[0].PreviousCenter.x);
+	ASSERT_FLOAT_EQ(0, exCon.MeshTransforms[0].Center.x);
+
+	ee.step(0.1f);
+	pePtr->setPosition(Vector3(10, 0, 0));
+
+	exCon.clear();
+	ee.extractVisualData(exCon);
+	ASSERT_FLOAT_EQ(0, exCon.MeshTransforms[0].PreviousCenter.x);
+	ASSERT_FLOAT_EQ(10, exCon.MeshTransforms[0].Center.x);
+	ASSERT_FLOAT_EQ(2.5f, exCon.MeshTransforms[0].interpolateCenter(0.25f).x);
+}
+
+TEST(VisualDataExtractTest, advanceInterpolation) {
+	VisualDataExtractContainer exCon;
+
+	// no fixed timestep, always render the current state
+	exCon.updateInterpolation(std::chrono::steady_clock::now());
+	ASSERT_FLOAT_EQ(1.0f, exCon.Interpolation);
+
+	exCon.ExtractTime = std::chrono::steady_clock::now();
+	exCon.ExtractInterpolation = 0.25f;
+	exCon.StepDuration = 0.1f;
+
+	exCon.updateInterpolation(exCon.ExtractTime);
+	ASSERT_FLOAT_EQ(0.25f, exCon.Interpolation);
+
+	exCon.updateInterpolation(exCon.ExtractTime + std::chrono::milliseconds(50));
+	ASSERT_NEAR(0.75f, exCon.Interpolation, 0.001f);
+
+	// never extrapolate beyond the current state
+	exCon.updateInterpolation(exCon.ExtractTime + std::chrono::milliseconds(500));
+	ASSERT_FLOAT_EQ(1.0f, exCon.Interpolation);
+}
+
+TEST(VisualDataExtractTest, particlesReusedOnceRendered) {
+	VisualDataExtractContainer exCon;
+	auto particles = std14::make_unique<ParticleSystemVisual>();
+	particles->addParticle(
+			ParticleState(Vector3(1, 2, 3), Vector3::zero(), 1.0f));
+	PositionedEntity pe;
+	pe.addVisual(particles.get());
+
+	// not extracted yet, modified in place
+	const auto first = particles->getData().Particles.get();
+	particles->getData().editPositions();
+	ASSERT_EQ(first, particles->getData().Particles.get());
+
+	pe.extractData(exCon);
+	particles->getData().editPositions();
+	const auto second = particles->getData().Particles.get();
+	ASSERT_NE(first, second);
+
+	// the renderer has not read a newer version, so the first buffer
+	// can not be written yet
+	exCon.clear();
+	pe.extractData(exCon);
+	particles->getData().editPositions();
+	ASSERT_NE(first, particles->getData().Particles.get());
+	ASSERT_NE(second, particles->getData().Particles.get());
+
+	exCon.clear();
+	pe.extractData(exCon);
+	exCon.ParticleSystems[0].markRendered();
+	particles->getData().editPositions();
+	ASSERT_EQ(first, particles->getData().Particles.get());
+	ASSERT_FLOAT_EQ(1.0f,
+			particles->getData().getParticles().PositionSizes[0].x());
+}
+
+/**
+ * Counts the change notifications of visuals
+ */
+class CountingChangeListener: public VisualChangeListener {
+public:
+	void visualChanged(uint32_t) override {
+		Changes++;
+	}
+
+	size_t Changes = 0;
+};
+
+TEST(VisualDataExtractTest, particlesChangedOnlyWhenModified) {
+	CountingChangeListener listener;
+	ParticleSystemVisual particles;
+	particles.addParticle(
+			ParticleState(Vector3(1, 2, 3), Vector3::zero(), 1.0f));
+	particles.setChangeListener(&listener, 0);
+
+	// no model and no GPU simulation, nothing changes
+	particles.step(0.1f);
+	ASSERT_EQ(size_t(0), listener.Changes);
+
+	ParticleSystemVisual simulated(
+			[](ParticleSystemVisualData &, float) {});
+	simulated.setChangeListener(&listener, 0);
+	simulated.step(0.1f);
+	ASSERT_EQ(size_t(1), listener.Changes);
+
+	// requesting a readback does not modify the visual, neither does a step
+	// while the simulation program has not been loaded by the renderer
+	ParticleSystemVisual gpuParticles;
+	gpuParticles.setGpuSimulation("particle_simulation");
+	gpuParticles.setChangeListener(&listener, 0);
+	gpuParticles.requestReadback();
+	gpuParticles.step(0.1f);
+	ASSERT_EQ(size_t(1), listener.Changes);
+}
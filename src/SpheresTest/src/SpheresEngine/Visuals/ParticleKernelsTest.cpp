@@ -0,0 +1,93 @@
+/*
+Copyright (C) 2016 Thomas Hauth. All Rights Reserved.
+* Written by Thomas Hauth (Thomas.Hauth@web.de)
+
+This file is part of Kung Foo Barracuda.
+
+Kung Foo Barracuda is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Kung Foo Barracuda is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kung Foo Barracuda.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+#include <SpheresEngine/Visuals/ParticleKernels.h>
+
+#include <vector>
+
+namespace {
+
+/**
+ * Fill a particle buffer with a particle count which is no multiple of the
+ * SIMD width, so the remainder handling is tested, too
+ */
+ParticleBuffer createParticles() {
+	ParticleBuffer pb;
+	for (size_t i = 0; i < 37; i++) {
+		const float f = float(i);
+		pb.addParticle(
+				ParticleState(Vector3(f, 2.0f * f, -f),
+						Vector3(0.5f * f, 1.0f, -0.25f * f), 1.0f),
+				ParticleColor(), 0.1f * f);
+	}
+	return pb;
+}
+
+}
+
+TEST(ParticleKernelsTest, scalarAlwaysAvailable) {
+	ASSERT_TRUE(ParticleKernels::isAvailable(ParticleKernels::InstructionSet::Scalar));
+	ASSERT_TRUE(ParticleKernels::isAvailable(ParticleKernels::bestAvailable()));
+}
+
+TEST(ParticleKernelsTest, integrateNewtonWithGravity) {
+	const float dt = 0.1f;
+	const float gravity = 1.0f;
+
+	for (auto is : { ParticleKernels::InstructionSet::Scalar,
+			ParticleKernels::InstructionSet::SSE,
+			ParticleKernels::InstructionSet::AVX2 }) {
+		if (!ParticleKernels::isAvailable(is))
+			continue;
+
+		auto pb = createParticles();
+		ParticleKernels::integrateNewtonWithGravity(pb, gravity, dt, is);
+		ParticleKernels::integrateNewtonWithGravity(pb, gravity, dt, is);
+
+		for (size_t i = 0; i < pb.getParticleCount(); i++) {
+			const float f = float(i);
+			// two steps computed the same way as the original AoS model
+			float vy = 1.0f;
+			float y = 2.0f * f;
+			vy -= gravity * dt;
+			y += vy * dt;
+			vy -= gravity * dt;
+			y += vy * dt;
+
+			const float x = f + 2.0f * (0.5f * f * dt);
+			const float z = -f + 2.0f * (-0.25f * f * dt);
+
+			SCOPED_TRACE(ParticleKernels::getName(is));
+			ASSERT_FLOAT_EQ(vy, pb.VelocityY[i]);
+			ASSERT_FLOAT_EQ(x, pb.X[i]);
+			ASSERT_FLOAT_EQ(y, pb.Y[i]);
+			ASSERT_FLOAT_EQ(z, pb.Z[i]);
+
+			// interleaved output for the renderer
+			ASSERT_FLOAT_EQ(pb.X[i], pb.PositionSizes[i].x());
+			ASSERT_FLOAT_EQ(pb.Y[i], pb.PositionSizes[i].y());
+			ASSERT_FLOAT_EQ(pb.Z[i], pb.PositionSizes[i].z());
+			ASSERT_FLOAT_EQ(0.1f * f, pb.PositionSizes[i].getPayload());
+		}
+	}
+}
@@ -32,6 +32,32 @@ public:
 
 };
 
+/**
+ * Scaling parameters which can be set on the command line. A value of zero
+ * selects the default of the specific benchmark.
+ */
+struct BenchmarkParameters {
+	/**
+	 * Number of entities in the scene
+	 */
+	size_t Entities = 0;
+
+	/**
+	 * Number of particles per particle system
+	 */
+	size_t Particles = 0;
+
+	/**
+	 * Number of worker threads used to simulate the scene
+	 */
+	size_t Threads = 0;
+
+	/**
+	 * Simulate the particles on the GPU instead of the CPU
+	 */
+	bool GpuSimulation = false;
+};
+
 /**
  * Base class for Benchmark implementations. All specific benchmarks
  * need to derive from this class to implement their benchmark scenario.
@@ -65,9 +91,18 @@ public:
 		re.getRenderBackend()->getShaderBackend().addProgramDefinition(
 				"default", { { { "vtx", Shader::Type::Vertex }, { "fs",
 						Shader::Type::Fragment } } });
+		re.getRenderBackend()->getShaderBackend().addProgramDefinition(
+				"default_instanced", { { { "instanced_vtx",
+						Shader::Type::Vertex }, { "fs", Shader::Type::Fragment } } });
 		re.getRenderBackend()->getShaderBackend().addProgramDefinition(
 				"particles", { { { "particles_vtx", Shader::Type::Vertex }, {
 						"particles_fs", Shader::Type::Fragment } } });
+		re.getRenderBackend()->getShaderBackend().addProgramDefinition(
+				"particles_sim", { { { "particles_sim_vtx",
+						Shader::Type::Vertex }, { "particles_sim_fs",
+						Shader::Type::Fragment } } }, {
+						ShaderVariables::FeedbackPositionSize.getName(),
+						ShaderVariables::FeedbackVelocity.getName() });
 	}
 
 	/**
@@ -87,4 +122,26 @@ public:
 	 * Returns the name of the benchmark implementation.
 	 */
 	virtual std::string name() const = 0;
+
+	/**
+	 * Set the scaling parameters, must be called before setupScene()
+	 */
+	void setParameters(BenchmarkParameters const& parameters) {
+		m_parameters = parameters;
+	}
+
+protected:
+
+	/**
+	 * Returns the requested parameter value or the benchmark's default
+	 * if the parameter was not set
+	 */
+	static size_t valueOrDefault(size_t value, size_t defaultValue) {
+		return (value == 0) ? defaultValue : value;
+	}
+
+	/**
+	 * Scaling parameters of this run
+	 */
+	BenchmarkParameters m_parameters;
 };
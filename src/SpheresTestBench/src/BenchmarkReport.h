@@ -0,0 +1,184 @@
+#pragma once
+
+#include <SpheresEngine/Performance/SectionTimer.h>
+#include <SpheresEngine/Performance/PacingStatistics.h>
+#include <SpheresEngine/Performance/JsonQuote.h>
+#include <SpheresEngine/Log.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Collects the results of one benchmark run and writes them in a machine
+ * readable format, so runs can be compared by scripts. All times are given
+ * in microseconds.
+ */
+class BenchmarkReport {
+public:
+
+	/**
+	 * Create a report for the benchmark with the given name
+	 */
+	explicit BenchmarkReport(std::string const& benchmark) :
+			m_benchmark(benchmark) {
+	}
+
+	/**
+	 * Add a parameter of the run, for example the entity count
+	 */
+	void addParameter(std::string const& name, std::string const& value) {
+		m_parameters.emplace_back(name, value);
+	}
+
+	/**
+	 * Add a parameter of the run with a numeric value
+	 */
+	void addParameter(std::string const& name, size_t value) {
+		addParameter(name, std::to_string(value));
+	}
+
+	/**
+	 * Add the timing statistics of one profiling section
+	 */
+	void addSection(SectionStatistics const& stats) {
+		m_metrics.push_back(stats);
+	}
+
+	/**
+	 * Add the pacing error of a frame loop. The percentiles are the upper
+	 * bounds of the histogram buckets.
+	 */
+	void addPacing(std::string const& name, PacingStatistics const& pacing) {
+		SectionStatistics stats;
+		stats.Name = name;
+		stats.Count = pacing.getCount();
+		stats.Mean = toMicro(pacing.getMean());
+		stats.P50 = toMicro(pacing.getPercentile(0.5f));
+		stats.P99 = toMicro(pacing.getPercentile(0.99f));
+		stats.Max = toMicro(pacing.getMax());
+		m_metrics.push_back(stats);
+	}
+
+	/**
+	 * Add a counter which has no distribution, like the number of draw calls
+	 */
+	void addCounter(std::string const& name, double value) {
+		m_counters.emplace_back(name, value);
+	}
+
+	/**
+	 * Write the report to a file. Files ending with .csv are written as CSV,
+	 * all others as JSON. Returns false if the file could not be written.
+	 */
+	bool write(std::string const& filename) const {
+		std::ofstream ofs(filename, std::ofstream::out | std::ofstream::trunc);
+		if (!ofs) {
+			logging::Error() << "Cannot open file " << filename
+					<< " to write the benchmark report";
+			return false;
+		}
+
+		const std::string csvExtension = ".csv";
+		const bool csv = (filename.size() >= csvExtension.size())
+				&& (filename.compare(filename.size() - csvExtension.size(),
+						csvExtension.size(), csvExtension) == 0);
+		ofs << (csv ? toCsv() : toJson());
+		return bool(ofs);
+	}
+
+	/**
+	 * Format the report as JSON object
+	 */
+	std::string toJson() const {
+		std::stringstream sout;
+		sout << "{" << std::endl;
+		sout << "  \"benchmark\": " << util::quoteJson(m_benchmark) << ","
+				<< std::endl;
+
+		sout << "  \"parameters\": {";
+		for (size_t i = 0; i < m_parameters.size(); i++) {
+			sout << ((i == 0) ? "" : ",") << std::endl << "    "
+					<< util::quoteJson(m_parameters[i].first) << ": "
+					<< util::quoteJson(m_parameters[i].second);
+		}
+		sout << std::endl << "  }," << std::endl;
+
+		sout << "  \"metrics\": [";
+		for (size_t i = 0; i < m_metrics.size(); i++) {
+			auto const& m = m_metrics[i];
+			sout << ((i == 0) ? "" : ",") << std::endl << "    { \"name\": "
+					<< util::quoteJson(m.Name) << ", \"count\": " << m.Count
+					<< ", \"min_us\": " << m.Min << ", \"mean_us\": " << m.Mean
+					<< ", \"p50_us\": " << m.P50 << ", \"p99_us\": " << m.P99
+					<< ", \"max_us\": " << m.Max << " }";
+		}
+		sout << std::endl << "  ]," << std::endl;
+
+		sout << "  \"counters\": {";
+		for (size_t i = 0; i < m_counters.size(); i++) {
+			sout << ((i == 0) ? "" : ",") << std::endl << "    "
+					<< util::quoteJson(m_counters[i].first) << ": "
+					<< m_counters[i].second;
+		}
+		sout << std::endl << "  }" << std::endl;
+		sout << "}" << std::endl;
+		return sout.str();
+	}
+
+	/**
+	 * Format the report as CSV with one row per metric. The parameters are
+	 * written as comment lines and counters have only a value in the mean
+	 * column.
+	 */
+	std::string toCsv() const {
+		std::stringstream sout;
+		for (auto const& p : m_parameters) {
+			sout << "# " << p.first << "=" << p.second << std::endl;
+		}
+		sout << "benchmark,metric,count,min_us,mean_us,p50_us,p99_us,max_us"
+				<< std::endl;
+		for (auto const& m : m_metrics) {
+			sout << m_benchmark << "," << m.Name << "," << m.Count << ","
+					<< m.Min << "," << m.Mean << "," << m.P50 << "," << m.P99
+					<< "," << m.Max << std::endl;
+		}
+		for (auto const& c : m_counters) {
+			sout << m_benchmark << "," << c.first << ",1,," << c.second
+					<< ",,," << std::endl;
+		}
+		return sout.str();
+	}
+
+private:
+
+	/**
+	 * Convert seconds to microseconds
+	 */
+	static float toMicro(float seconds) {
+		return seconds * 1.0e6f;
+	}
+
+
+	/**
+	 * Name of the benchmark
+	 */
+	std::string m_benchmark;
+
+	/**
+	 * Parameters of the run as name and value
+	 */
+	std::vector<std::pair<std::string, std::string>> m_parameters;
+
+	/**
+	 * Statistics of the profiling sections and the frame pacing
+	 */
+	std::vector<SectionStatistics> m_metrics;
+
+	/**
+	 * Counters as name and value
+	 */
+	std::vector<std::pair<std::string, double>> m_counters;
+};
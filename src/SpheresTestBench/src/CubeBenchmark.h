@@ -18,6 +18,7 @@
 
 #include "RotateCubeTransform.h"
 
+#include <cmath>
 #include <random>
 #include <iostream>
 
@@ -50,23 +51,35 @@ public:
 							}
 						}));
 
-		this->addManagedSubscription(&engines.entity.OnTimeStep,
-				engines.entity.OnTimeStep.subscribe(
-						[engines, ent, this] (float timeDelta) {
-
-							// rotate by timeslice
-							if ( m_lastAxis.length()) {
-								ent->rotate( m_lastAxis ,
-										m_lastAngle * timeDelta);
+		// only the own cube is rotated, so all cubes are rotated in parallel
+		m_entity = ent;
+		this->addManagedSubscription(&engines.entity.ParallelTimeStep,
+				engines.entity.ParallelTimeStep.subscribe(ent,
+						DataAccess().writesEntity(EntityData::Transform),
+						[this] (float timeDelta) {onTimeStep(timeDelta);}));
+	}
 
-								// degrade rotation angle
-								m_lastAngle = m_lastAngle - (m_lastAngle * 1.5f *timeDelta);
-							}
-						}));
+	/**
+	 * Continue the rotation of the cube
+	 */
+	void onTimeStep(float timeDelta) {
+		// rotate by timeslice
+		if ( m_lastAxis.length()) {
+			m_entity->rotate( m_lastAxis ,
+					m_lastAngle * timeDelta);
+
+			// degrade rotation angle
+			m_lastAngle = m_lastAngle - (m_lastAngle * 1.5f *timeDelta);
+		}
 	}
 
 private:
 
+	/**
+	 * The cube rotated by this aspect
+	 */
+	PositionedEntity * m_entity = nullptr;
+
 	/**
 	 * The last axis used for rotation
 	 */
@@ -92,7 +105,9 @@ public:
 	}
 
 	/**
-	 * Insert the cube and install the aspects which perform the rotation
+	 * Insert the cubes and install the aspects which perform the rotation.
+	 * The number of cubes can be set with the entity count, they are placed
+	 * on a square grid.
 	 */
 	void setupScene(Engines & engines) override {
 		installShaderProgramDefinitions(engines.render);
@@ -100,19 +115,29 @@ public:
 
 		engines.input.addTransformer(std14::make_unique<RotateCubeTransform>());
 
-		auto mv1 = new MeshVisual("debugbox_box", "debug-texture-cube");
-		mv1->getData().Center = glm::vec3(0, 0, 0.5);
-		auto prepId = engines.render.addToPrepareVisual(mv1);
-
-		auto boxEntity = std14::make_unique<PositionedEntity>();
-		auto boxEntityPtr = boxEntity.get();
-		boxEntity->addVisualPlaceholder(prepId);
-		boxEntity->addAspect(engines, std14::make_unique<RotateCubeAspect>());
-		// rotate 45 degrees
-		boxEntity->setRotation( Quaternion(glm::vec3(0.0f,
-										             boost::math::constants::pi<float>() * 0.25,
-													 0.0f)));
-		engines.entity.addEntity(std::move(boxEntity));
+		const size_t cubeCount = valueOrDefault(m_parameters.Entities, 1);
+		const size_t gridSize = size_t(std::ceil(std::sqrt(float(cubeCount))));
+		const float spacing = 2.0f;
+		const float gridOffset = 0.5f * spacing * float(gridSize - 1);
+
+		for (size_t i = 0; i < cubeCount; i++) {
+			auto mv1 = std14::make_unique<MeshVisual>("debugbox_box",
+					"debug-texture-cube");
+			auto prepId = engines.render.addToPrepareVisual(mv1.get());
+
+			auto boxEntity = std14::make_unique<PositionedEntity>();
+			boxEntity->setPosition(
+					Vector3(spacing * float(i % gridSize) - gridOffset, 0,
+							spacing * float(i / gridSize) - gridOffset));
+			boxEntity->addVisualPlaceholder(prepId);
+			boxEntity->takeVisualOwnership(std::move(mv1));
+			boxEntity->addAspect(engines, std14::make_unique<RotateCubeAspect>());
+			// rotate 45 degrees
+			boxEntity->setRotation( Quaternion(glm::vec3(0.0f,
+											             boost::math::constants::pi<float>() * 0.25,
+														 0.0f)));
+			engines.entity.addEntity(std::move(boxEntity));
+		}
 
 		auto cameraEntity = std14::make_unique<CameraEntity>();
 		cameraEntity->lookAt(Vector3::zero());
@@ -49,11 +49,12 @@ public:
 	/**
 	 * Transform pressing of esc-button to an terminate action
 	 */
-	std::unique_ptr<InputAction> transform(Input ip) override {
+	ArenaPtr<InputAction> transform(Input const& ip, FrameArena & arena)
+			override {
 		if (ip.type() == Input::Type::ButtonDown) {
 			if (ip.buttonType() == Input::ButtonType::Escape) {
 				// still hardwired, will be done by an aspect later
-				return std14::make_unique<BenchmarkInputAction>(
+				return arena.create<BenchmarkInputAction>(
 						BenchmarkInputAction::ActionType::Terminate);
 			}
 		}
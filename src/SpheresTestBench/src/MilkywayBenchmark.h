@@ -52,7 +52,8 @@ public:
 		// so the particle positions do not need to be downloaded to GPU buffers
 		m_particleVisual = std14::make_unique<ParticleSystemVisual>(
 				ParticleSystemModels::nop());
-		milkyway::createMilkyway(*m_particleVisual.get(), 5000);
+		milkyway::createMilkyway(*m_particleVisual.get(),
+				valueOrDefault(m_parameters.Particles, 5000));
 
 		// some one needs to own this visual objects here !
 		//re.prepareVisual(*m_particleVisual.get());
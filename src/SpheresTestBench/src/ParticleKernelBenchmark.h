@@ -0,0 +1,155 @@
+#pragma once
+
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+#include <SpheresEngine/Visuals/ParticleKernels.h>
+#include <SpheresEngine/Visuals/ParticleSystemModels.h>
+#include <SpheresEngine/Threading/JobSystem.h>
+#include <SpheresEngine/Log.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Microbenchmark which measures how many particles per second can be simulated
+ * by the particle integration kernels. It does not need a display and runs
+ * without the game loop.
+ */
+class ParticleKernelBenchmark {
+public:
+
+	/**
+	 * Setup the benchmark
+	 * @param particleCount the number of particles simulated in one step
+	 * @param steps the number of steps to simulate for each implementation
+	 */
+	ParticleKernelBenchmark(size_t particleCount = 1000000, size_t steps = 50) :
+			m_particleCount(particleCount), m_steps(steps) {
+	}
+
+	/**
+	 * Runs the array-of-structs implementation which was used before the
+	 * structure-of-arrays kernels and all kernels available on this machine,
+	 * and logs the particles per second for each of them
+	 */
+	void run() {
+		logging::Info() << "Particle kernel benchmark with " << m_particleCount
+				<< " particles and " << m_steps << " steps";
+
+		report("AoS (old)", measureArrayOfStructs());
+
+		for (auto is : { ParticleKernels::InstructionSet::Scalar,
+				ParticleKernels::InstructionSet::SSE,
+				ParticleKernels::InstructionSet::AVX2 }) {
+			if (ParticleKernels::isAvailable(is)) {
+				report("SoA " + ParticleKernels::getName(is),
+						measureKernel(is));
+			}
+		}
+
+		JobSystem jobs;
+		report("SoA " + ParticleKernels::getName(ParticleKernels::bestAvailable())
+				+ " on " + std::to_string(jobs.getWorkerCount() + 1) + " threads",
+				measureJobSystem(jobs));
+	}
+
+private:
+
+	/**
+	 * Log the result of one implementation, the target is one million
+	 * particles within one 16 ms tick
+	 */
+	void report(std::string const& name, double seconds) {
+		const double particlesPerSecond = double(m_particleCount * m_steps)
+				/ seconds;
+		const double msPerMillion = 1000.0 * 1000000.0 / particlesPerSecond;
+		logging::Info() << name << ": " << particlesPerSecond
+				<< " particles/s, " << msPerMillion << " ms per 1M particles";
+	}
+
+	/**
+	 * Run the functor m_steps times and return the elapsed seconds
+	 */
+	double measure(std::function<void()> step) {
+		// one warm-up step to fault in all memory
+		step();
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < m_steps; i++) {
+			step();
+		}
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	/**
+	 * The original implementation, which updates the particles one at a time
+	 * via the Vector3 accessors
+	 */
+	double measureArrayOfStructs() {
+		std::vector<ParticleBuffer::Vector3WithSize> positionSizes(
+				m_particleCount, ParticleBuffer::Vector3WithSize(0, 0, 0, 0.1f));
+		std::vector<ParticleSimulationExtra> simulationExtra(m_particleCount,
+				ParticleSimulationExtra(Vector3(1.0f, 2.0f, 3.0f), 1.0f));
+
+		return measure([&positionSizes, &simulationExtra] () {
+			const float dt = 0.016f;
+			const float grav = 1.0f;
+			for (size_t i = 0; i < positionSizes.size(); i++) {
+				auto & pos = positionSizes[i];
+				auto & sim = simulationExtra[i];
+
+				sim.Velocity.setY( sim.Velocity.y() -grav * dt);
+
+				pos.setX( pos.x() + sim.Velocity.x() * dt );
+				pos.setY( pos.y() + sim.Velocity.y() * dt );
+				pos.setZ( pos.z() + sim.Velocity.z() * dt );
+			}
+		});
+	}
+
+	/**
+	 * Structure-of-arrays implementation with one of the kernels
+	 */
+	double measureKernel(ParticleKernels::InstructionSet is) {
+		ParticleBuffer pb;
+		for (size_t i = 0; i < m_particleCount; i++) {
+			pb.addParticle(
+					ParticleState(Vector3::zero(), Vector3(1.0f, 2.0f, 3.0f),
+							1.0f), ParticleColor());
+		}
+
+		return measure([&pb, is] () {
+			ParticleKernels::integrateNewtonWithGravity(pb, 1.0f, 0.016f, is);
+		});
+	}
+
+	/**
+	 * Structure-of-arrays implementation with the best kernel, distributed
+	 * over all cores by the job system
+	 */
+	double measureJobSystem(JobSystem & jobs) {
+		ParticleSystemVisual pv(
+				ParticleSystemModels::plainNewtonWithGravity(jobs));
+		for (size_t i = 0; i < m_particleCount; i++) {
+			pv.addParticle(
+					ParticleState(Vector3::zero(), Vector3(1.0f, 2.0f, 3.0f),
+							1.0f), ParticleColor());
+		}
+
+		return measure([&pv] () {
+			pv.step(0.016f);
+		});
+	}
+
+	/**
+	 * Number of particles simulated in each step
+	 */
+	const size_t m_particleCount;
+
+	/**
+	 * Number of steps measured for each implementation
+	 */
+	const size_t m_steps;
+};
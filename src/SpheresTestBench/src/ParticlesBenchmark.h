@@ -0,0 +1,99 @@
+#pragma once
+
+#include "BenchmarkBase.h"
+
+#include <SpheresEngine/Util.h>
+#include <SpheresEngine/Threading/JobSystem.h>
+#include <SpheresEngine/Visuals/ParticleSystemVisual.h>
+#include <SpheresEngine/Visuals/ParticleSystemModels.h>
+#include <SpheresEngine/RenderEngine/RenderEngine.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/PositionedEntity.h>
+#include <SpheresEngine/EntityEngine/CommonEntities/CameraEntity.h>
+
+#include <cmath>
+#include <vector>
+
+/**
+ * Benchmark class which simulates a number of particle fountains. The entity
+ * count sets the number of fountains, the particle count the size of each
+ * fountain and with a thread count the particles are simulated by a job
+ * system. With the GPU simulation the particles are advanced by a shader
+ * program instead.
+ */
+class ParticlesBenchmark final: public BenchmarkBase {
+public:
+
+	/**
+	 * Nothing special needed. Default renderer are setup by the ThreadedGameLoop
+	 */
+	void setupRenderer(RenderEngine &) override {
+	}
+
+	/**
+	 * Generate the particle fountains and place them on a square grid
+	 */
+	void setupScene(Engines & engines) override {
+		installShaderProgramDefinitions(engines.render);
+		installCommonEntities(engines);
+
+		if (m_parameters.Threads > 0) {
+			m_jobs = std14::make_unique<JobSystem>(m_parameters.Threads);
+		}
+
+		const size_t fountainCount = valueOrDefault(m_parameters.Entities, 10);
+		const size_t particleCount = valueOrDefault(m_parameters.Particles,
+				10000);
+		const size_t gridSize = size_t(
+				std::ceil(std::sqrt(float(fountainCount))));
+		const float spacing = 2.0f;
+		const float gridOffset = 0.5f * spacing * float(gridSize - 1);
+
+		for (size_t i = 0; i < fountainCount; i++) {
+			auto model = m_jobs ?
+					ParticleSystemModels::plainNewtonWithGravity(*m_jobs) :
+					ParticleSystemModels::plainNewtonWithGravity();
+			m_particleVisuals.emplace_back(
+					std14::make_unique<ParticleSystemVisual>(model));
+			auto & visual = *m_particleVisuals.back();
+			if (m_parameters.GpuSimulation) {
+				visual.setGpuSimulation("particles_sim");
+			}
+			ParticleSystemModels::createFountain(visual, particleCount,
+					std::make_pair(1.0f, 3.0f), Vector3(0, 0, 1));
+
+			auto prepId = engines.render.addToPrepareVisual(&visual);
+
+			auto fountainEntity = std14::make_unique<PositionedEntity>();
+			fountainEntity->setPosition(
+					Vector3(spacing * float(i % gridSize) - gridOffset,
+							spacing * float(i / gridSize) - gridOffset, 0));
+			fountainEntity->addVisualPlaceholder(prepId);
+			engines.entity.addEntity(std::move(fountainEntity));
+		}
+
+		auto cameraEntity = std14::make_unique<CameraEntity>();
+		cameraEntity->lookAt(Vector3::zero());
+		cameraEntity->setPosition(Vector3(8, -8, 8));
+		engines.entity.addEntity(std::move(cameraEntity));
+	}
+
+	/**
+	 * return name of this benchmark
+	 */
+	std::string name() const override {
+		return "particles";
+	}
+
+private:
+
+	/**
+	 * Job system used by the particle models if a thread count was set,
+	 * needs to outlive the particle visuals
+	 */
+	uniq<JobSystem> m_jobs;
+
+	/**
+	 * Stores the particle systems of all fountains
+	 */
+	std::vector<uniq<ParticleSystemVisual>> m_particleVisuals;
+};
@@ -44,23 +44,24 @@ public:
 	/**
 	 * check for button down and create an rotation action accordingly
 	 */
-	std::unique_ptr<InputAction> transform(Input ip) override {
+	ArenaPtr<InputAction> transform(Input const& ip, FrameArena & arena)
+			override {
 		if (ip.type() == Input::Type::ButtonDown) {
 			if (ip.buttonType() == Input::ButtonType::Left) {
 				// still hardwired, will be done by an aspect later
-				return std14::make_unique<RotateAction>(Vector3::unitY(), 1.0f);
+				return arena.create<RotateAction>(Vector3::unitY(), 1.0f);
 			}
 			if (ip.buttonType() == Input::ButtonType::Right) {
 				// still hardwired, will be done by an aspect later
-				return std14::make_unique<RotateAction>(Vector3::unitY(), -1.0f);
+				return arena.create<RotateAction>(Vector3::unitY(), -1.0f);
 			}
 			if (ip.buttonType() == Input::ButtonType::Up) {
 				// still hardwired, will be done by an aspect later
-				return std14::make_unique<RotateAction>(Vector3::unitZ(), 1.0f);
+				return arena.create<RotateAction>(Vector3::unitZ(), 1.0f);
 			}
 			if (ip.buttonType() == Input::ButtonType::Down) {
 				// still hardwired, will be done by an aspect later
-				return std14::make_unique<RotateAction>(Vector3::unitZ(), -1.0f);
+				return arena.create<RotateAction>(Vector3::unitZ(), -1.0f);
 			}
 		}
 		// nothing to report
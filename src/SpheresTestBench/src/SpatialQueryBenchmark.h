@@ -0,0 +1,149 @@
+#pragma once
+
+#include <SpheresEngine/DataTypes/SpatialHashGrid.h>
+#include <SpheresEngine/VectorTypes.h>
+#include <SpheresEngine/Log.h>
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Microbenchmark which compares the proximity queries of the SpatialHashGrid
+ * with a linear scan over all positions. The entities are placed with the
+ * same density for every entity count, so each query finds about the same
+ * number of entities and the grid's query time should not grow with the
+ * entity count. It does not need a display and runs without the game loop.
+ */
+class SpatialQueryBenchmark {
+public:
+
+	/**
+	 * Setup the benchmark
+	 * @param queries the number of queries measured for each entity count
+	 */
+	explicit SpatialQueryBenchmark(size_t queries = 2000) :
+			m_queries(queries) {
+	}
+
+	/**
+	 * Runs the radius and nearest queries for 1k, 10k and 100k entities and
+	 * logs the time per query for the grid and the linear scan
+	 */
+	void run() {
+		logging::Info() << "Spatial query benchmark with " << m_queries
+				<< " queries, radius " << float(QueryRadius) << ", "
+				<< size_t(NearestCount) << " nearest";
+
+		for (size_t count : { 1000, 10000, 100000 }) {
+			runEntityCount(count);
+		}
+	}
+
+private:
+
+	/**
+	 * Entities per cubic unit
+	 */
+	static constexpr float Density = 0.05f;
+
+	/**
+	 * Radius of the radius queries
+	 */
+	static constexpr float QueryRadius = 4.0f;
+
+	/**
+	 * Number of entities returned by the nearest queries
+	 */
+	static constexpr size_t NearestCount = 8;
+
+	/**
+	 * Measure all queries for one entity count
+	 */
+	void runEntityCount(size_t count) {
+		const float extent = std::cbrt(float(count) / Density);
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> dist(0.0f, extent);
+
+		std::vector<Vector3> positions;
+		SpatialHashGrid grid(QueryRadius);
+		for (size_t i = 0; i < count; i++) {
+			positions.emplace_back(dist(rng), dist(rng), dist(rng));
+			grid.insert(SpatialHashGrid::Id(i), positions.back());
+		}
+		std::vector<Vector3> centers;
+		for (size_t i = 0; i < m_queries; i++) {
+			centers.emplace_back(dist(rng), dist(rng), dist(rng));
+		}
+
+		std::vector<SpatialHashGrid::Id> found;
+		size_t foundTotal = 0;
+
+		const auto gridRadius = measure([&] () {
+			for (auto const& c : centers) {
+				found.clear();
+				grid.queryRadius(c, QueryRadius, found);
+				foundTotal += found.size();
+			}
+		});
+		const auto scanRadius = measure([&] () {
+			const float radiusSquared = QueryRadius * QueryRadius;
+			for (auto const& c : centers) {
+				found.clear();
+				for (size_t i = 0; i < positions.size(); i++) {
+					if (distanceSquared(positions[i], c) <= radiusSquared) {
+						found.push_back(SpatialHashGrid::Id(i));
+					}
+				}
+			}
+		});
+		const auto gridNearest = measure([&] () {
+			for (auto const& c : centers) {
+				found.clear();
+				grid.queryNearest(c, NearestCount, found);
+			}
+		});
+
+		logging::Info() << count << " entities, " << double(foundTotal) / double(m_queries)
+				<< " found per radius query";
+		report("radius grid", gridRadius);
+		report("radius linear scan", scanRadius);
+		report("nearest grid", gridNearest);
+	}
+
+	/**
+	 * Squared distance between two positions
+	 */
+	static float distanceSquared(Vector3 const& a, Vector3 const& b) {
+		const float dx = a.x() - b.x();
+		const float dy = a.y() - b.y();
+		const float dz = a.z() - b.z();
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	/**
+	 * Log the time per query of one implementation
+	 */
+	void report(std::string const& name, double seconds) {
+		logging::Info() << "  " << name << ": "
+				<< seconds * 1000000.0 / double(m_queries) << " us per query";
+	}
+
+	/**
+	 * Run all queries once and return the elapsed seconds
+	 */
+	double measure(std::function<void()> queries) {
+		const auto start = std::chrono::steady_clock::now();
+		queries();
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(end - start).count();
+	}
+
+	/**
+	 * Number of queries measured for each entity count
+	 */
+	const size_t m_queries;
+};
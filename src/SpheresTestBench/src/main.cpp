@@ -1,5 +1,9 @@
 #include "MilkywayBenchmark.h"
 #include "CubeBenchmark.h"
+#include "ParticlesBenchmark.h"
+#include "BenchmarkReport.h"
+#include "ParticleKernelBenchmark.h"
+#include "SpatialQueryBenchmark.h"
 #include "ExitBenchmarkInputTransform.h"
 
 #include <SpheresEngine/InputEngine/InputEngine.h>
@@ -9,10 +13,12 @@
 #include <SpheresEngine/PhysicsEngine/PhysicsEngine.h>
 #include <SpheresEngine/ResourceEngine/ResourceEngineAbstract.h>
 #include <SpheresEngine/RenderEngine/RenderBackendSDL.h>
+#include <SpheresEngine/RenderEngine/RenderBackendHeadless.h>
 #include <SpheresEngine/ThreadedGameLoop.h>
 #include <SpheresEngine/Timing.h>
 #include <SpheresEngine/Util.h>
 #include <SpheresEngine/DataTypes/Resolution.h>
+#include <SpheresEngine/Performance/SectionTimer.h>
 
 #include <SpheresEngine/InputEngine/SdlSource.h>
 
@@ -23,9 +29,67 @@
 #include <algorithm>
 #include <iostream>
 #include <iterator>
+#include <string>
+
+namespace {
+
+/**
+ * Returns true if the flag is contained in the command line arguments
+ */
+bool hasFlag(std::vector<std::string> const& args, std::string const& flag) {
+	return std::find(args.begin(), args.end(), flag) != args.end();
+}
+
+/**
+ * Returns the value of an argument in the form --name=value or an empty
+ * string if the argument was not given
+ */
+std::string argumentValue(std::vector<std::string> const& args,
+		std::string const& name) {
+	const std::string prefix = name + "=";
+	for (auto const& arg : args) {
+		if (arg.compare(0, prefix.size(), prefix) == 0) {
+			return arg.substr(prefix.size());
+		}
+	}
+	return "";
+}
+
+/**
+ * Returns the numeric value of an argument in the form --name=value or
+ * defaultValue if the argument was not given or is not a number
+ */
+size_t argumentCount(std::vector<std::string> const& args,
+		std::string const& name, size_t defaultValue) {
+	const auto value = argumentValue(args, name);
+	if (value.empty()) {
+		return defaultValue;
+	}
+	try {
+		return std::stoul(value);
+	} catch (std::exception const&) {
+		logging::Error() << "Value " << value << " of " << name
+				<< " is not a number, using " << defaultValue;
+		return defaultValue;
+	}
+}
+
+}
 
 /**
  * Instantiate one Benchmark and start the threaded game loop to render it.
+ *
+ * The benchmark is selected with --benchmark=<name>, --list shows all
+ * available benchmarks. The scene can be scaled with --entities=N,
+ * --particles=N and --threads=N, --gpu-simulation simulates the particles
+ * on the GPU. --step-rate=N computes N fixed logic steps per second, which
+ * are interpolated by the renderers. With --iterations=N the game loop exits
+ * after N measured iterations, the first --warmup=N iterations are not
+ * included in the timing statistics. The results are written to the file
+ * given with --report=<file>, as CSV if the filename ends with .csv and as
+ * JSON otherwise. --trace=<file> writes the timeline of all profiling sections
+ * in the Chrome trace event format. --automate writes a screenshot and
+ * always exits, after 40 measured iterations if --iterations is not given.
  */
 int main(int argc, char *argv[]) {
 
@@ -34,15 +98,64 @@ int main(int argc, char *argv[]) {
 		args.emplace_back(std::string(argv[i]));
 	}
 
-	bool automated = std::any_of(args.begin(), args.end(),
-			[] (std::string & s) {return s == "--automate";});
+	bool automated = hasFlag(args, "--automate");
+
+	// record the OpenGL calls instead of rendering to a display
+	bool headless = hasFlag(args, "--headless");
+
+	// microbenchmarks which do not need the display
+	if (hasFlag(args, "--particle-kernels")) {
+		ParticleKernelBenchmark().run();
+		return 0;
+	}
+	if (hasFlag(args, "--spatial-queries")) {
+		SpatialQueryBenchmark().run();
+		return 0;
+	}
 
 	std::vector<uniq<BenchmarkBase>> benchmarks;
 	benchmarks.push_back(std14::make_unique<MilkywayBenchmark>());
 	benchmarks.push_back(std14::make_unique<CubeBenchmark>());
+	benchmarks.push_back(std14::make_unique<ParticlesBenchmark>());
+
+	if (hasFlag(args, "--list")) {
+		for (auto const& b : benchmarks) {
+			std::cout << b->name() << std::endl;
+		}
+		return 0;
+	}
 
-	// todo: select via command line
-	auto selectedBenchmark = benchmarks[1].get();
+	auto benchmarkName = argumentValue(args, "--benchmark");
+	if (benchmarkName.empty()) {
+		benchmarkName = "cube";
+	}
+	auto selectedIt = std::find_if(benchmarks.begin(), benchmarks.end(),
+			[&benchmarkName] (uniq<BenchmarkBase> const& b) {
+				return b->name() == benchmarkName;
+			});
+	if (selectedIt == benchmarks.end()) {
+		logging::Error() << "Unknown benchmark " << benchmarkName
+				<< ", available benchmarks are:";
+		for (auto const& b : benchmarks) {
+			logging::Error() << "  " << b->name();
+		}
+		return 1;
+	}
+	auto selectedBenchmark = selectedIt->get();
+
+	BenchmarkParameters parameters;
+	parameters.Entities = argumentCount(args, "--entities", 0);
+	parameters.Particles = argumentCount(args, "--particles", 0);
+	parameters.Threads = argumentCount(args, "--threads", 0);
+	parameters.GpuSimulation = hasFlag(args, "--gpu-simulation");
+	selectedBenchmark->setParameters(parameters);
+
+	const size_t warmup = argumentCount(args, "--warmup", 0);
+	const size_t iterations = argumentCount(args, "--iterations", 0);
+	const size_t stepRate = argumentCount(args, "--step-rate", 0);
+	const auto reportFilename = argumentValue(args, "--report");
+	const auto traceFilename = argumentValue(args, "--trace");
+	GlobalTimingRepo::Rep.setWarmupSamples(warmup);
 
 	Resolution resolution(800, 600);
 
@@ -51,7 +164,18 @@ int main(int argc, char *argv[]) {
 	AnimationEngine animationEngine;
 	PhysicsEngine physicsEngine;
 	InputEngine inputEngine;
-	RenderEngine re(std14::make_unique<RenderBackendSDL>(resourceE, resolution), resourceE);
+	RenderBackendHeadless * headlessBackend = nullptr;
+	uniq<RenderBackendBase> renderBackend;
+	if (headless) {
+		auto uniqueHeadless = std14::make_unique<RenderBackendHeadless>(
+				resourceE, resolution);
+		headlessBackend = uniqueHeadless.get();
+		renderBackend = std::move(uniqueHeadless);
+	} else {
+		renderBackend = std14::make_unique<RenderBackendSDL>(resourceE,
+				resolution);
+	}
+	RenderEngine re(std::move(renderBackend), resourceE);
 
 	Engines engines(entityEngine, inputEngine, re, animationEngine,
 			physicsEngine);
@@ -69,13 +193,75 @@ int main(int argc, char *argv[]) {
 	ThreadedGameLoop gameLoop(re, entityEngine, animationEngine, inputEngine,
 			physicsEngine);
 	gameLoop.setSdlSource(ptrSdlSource);
+	if (parameters.Threads > 0) {
+		gameLoop.setWorkerCount(parameters.Threads);
+	}
+	if (stepRate > 0) {
+		gameLoop.setFixedTimestep(float(stepRate));
+	}
 
 	if (automated) {
-		gameLoop.setMaxIterations(40);
+		// automated runs always terminate, by default after 40 iterations
+		gameLoop.setMaxIterations(warmup + ((iterations > 0) ? iterations : 40));
 		gameLoop.setScreenshotFilename("benchmark_out.bmp");
+	} else if (iterations > 0) {
+		gameLoop.setMaxIterations(warmup + iterations);
 	}
 
 	gameLoop.run();
+	logging::Info() << "Maximum heap allocations per logic tick: "
+			<< gameLoop.getMaxLogicTickAllocations();
+	logging::Info() << "Logic thread pacing error: "
+			<< gameLoop.getLogicPacing().toString();
+	logging::Info() << "Render thread pacing error: "
+			<< gameLoop.getRenderPacing().toString();
+	if (headlessBackend) {
+		logging::Info() << "Recorded OpenGL calls: "
+				<< headlessBackend->getStats().toString();
+	}
+
+	if (!traceFilename.empty()
+			&& GlobalTimingRepo::Rep.writeChromeTrace(traceFilename)) {
+		logging::Info() << "Section trace written to " << traceFilename;
+	}
+
+	if (!reportFilename.empty()) {
+		BenchmarkReport report(selectedBenchmark->name());
+		report.addParameter("entities", parameters.Entities);
+		report.addParameter("particles", parameters.Particles);
+		report.addParameter("threads", parameters.Threads);
+		report.addParameter("gpu-simulation",
+				parameters.GpuSimulation ? "yes" : "no");
+		report.addParameter("warmup", warmup);
+		report.addParameter("iterations", iterations);
+		report.addParameter("step-rate", stepRate);
+		report.addParameter("backend", headless ? "headless" : "sdl");
+
+		for (auto const& section : GlobalTimingRepo::Rep.statistics()) {
+			report.addSection(section);
+		}
+		report.addPacing("pacing::logic", gameLoop.getLogicPacing());
+		report.addPacing("pacing::render", gameLoop.getRenderPacing());
+		report.addCounter("logic::max_tick_allocations",
+				double(gameLoop.getMaxLogicTickAllocations()));
+		if (headlessBackend) {
+			auto const& gl = headlessBackend->getStats();
+			const double frames = (gl.Frames == 0) ? 1.0 : double(gl.Frames);
+			report.addCounter("gl::frames", double(gl.Frames));
+			report.addCounter("gl::draw_calls_per_frame",
+					double(gl.DrawCalls) / frames);
+			report.addCounter("gl::state_changes_per_frame",
+					double(gl.StateChanges) / frames);
+			report.addCounter("gl::uniform_updates_per_frame",
+					double(gl.UniformUpdates) / frames);
+			report.addCounter("gl::uploaded_bytes_per_frame",
+					double(gl.UploadedBytes) / frames);
+		}
+
+		if (report.write(reportFilename)) {
+			logging::Info() << "Benchmark report written to " << reportFilename;
+		}
+	}
 	re.closeRenderer();
 	re.closeDisplay();
 